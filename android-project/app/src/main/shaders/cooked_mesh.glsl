@@ -0,0 +1,16 @@
+// Vertex inputs of CookedMesh, see mesh_format.hpp. Positions still need the mesh's dequantize matrix,
+// which goes into the model matrix.
+
+layout (location = 0) in vec4 in_position;
+layout (location = 1) in vec2 in_normal;
+layout (location = 2) in vec2 in_uv;
+
+// Inverse of the cooker's octahedral encoding: the unit normal was projected onto the octahedron
+// |x| + |y| + |z| = 1, and the lower half folded over the diagonals.
+vec3 decodeOctahedral(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
@@ -0,0 +1,45 @@
+// Layouts shared by the GpuScene shaders, they match the structs in render/gpu_scene.hpp
+
+#define NO_MESH 0xffffffffu
+
+struct Instance {
+    mat4 transform;
+    uint mesh;
+    uint padding0;
+    uint padding1;
+    uint padding2;
+};
+
+struct Mesh {
+    vec4 sphere;
+    uint first_slot;
+    uint lod_count;
+    uint padding0;
+    uint padding1;
+};
+
+struct DrawCommand {
+    uint index_count;
+    uint instance_count;
+    uint first_index;
+    int vertex_offset;
+    uint first_instance;
+};
+
+layout (set = 0, binding = 0) uniform Params {
+    mat4 view_projection;
+    mat4 previous_view_projection;
+    vec4 planes[6];
+    // xyz is the camera position, w the lod distance
+    vec4 camera;
+    uint instance_count;
+    uint slot_count;
+    uint pyramid_width;
+    uint pyramid_height;
+    uint pyramid_levels;
+    uint occlusion;
+} params;
+
+layout (std430, set = 0, binding = 1) readonly buffer Instances {
+    Instance instances[];
+};
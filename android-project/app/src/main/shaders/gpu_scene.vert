@@ -0,0 +1,28 @@
+#version 450
+
+#extension GL_GOOGLE_include_directive : enable
+
+#include "gpu_scene.glsl"
+
+layout (std430, set = 0, binding = 5) readonly buffer Visible {
+    uint visible[];
+};
+
+// 0 when the draws carry their first instance, the slot's base otherwise
+layout (push_constant) uniform Draw {
+    uint base;
+} draw;
+
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec3 normal;
+layout (location = 2) in vec2 uv;
+
+layout (location = 0) out vec3 out_normal;
+layout (location = 1) out vec2 out_uv;
+
+void main() {
+    mat4 transform = instances[visible[draw.base + gl_InstanceIndex]].transform;
+    gl_Position = params.view_projection * transform * vec4(position, 1.0);
+    out_normal = mat3(transform) * normal;
+    out_uv = uv;
+}
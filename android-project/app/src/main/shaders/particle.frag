@@ -0,0 +1,12 @@
+#version 450
+
+layout (location = 0) in vec2 uv;
+layout (location = 1) in vec4 color;
+
+layout (location = 0) out vec4 out_color;
+
+// a soft round particle
+void main() {
+    float falloff = max(1.0 - dot(uv, uv), 0.0);
+    out_color = vec4(color.rgb, color.a * falloff * falloff);
+}
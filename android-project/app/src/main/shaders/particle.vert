@@ -0,0 +1,25 @@
+#version 450
+
+#extension GL_GOOGLE_include_directive : enable
+
+#include "particles.glsl"
+
+layout (location = 0) out vec2 out_uv;
+layout (location = 1) out vec4 out_color;
+
+// A camera facing quad per instance from the list the last simulation wrote, or from the sorted keys
+void main() {
+    uint next = 1u - params.current;
+    uint index = params.sorted != 0u ? keys[gl_InstanceIndex].y : alive[next * params.max_particles + gl_InstanceIndex];
+    Particle particle = particles[index];
+
+    float t = clamp(particle.age / particle.life, 0.0, 1.0);
+    float size = mix(particle.size_start, particle.size_end, t);
+    vec2 corner = vec2(gl_VertexIndex & 1, gl_VertexIndex >> 1);
+    vec2 local = (corner - 0.5) * size;
+    vec3 position = particle.position + params.right.xyz * local.x + params.up.xyz * local.y;
+
+    gl_Position = params.view_projection * vec4(position, 1.0);
+    out_uv = corner * 2.0 - 1.0;
+    out_color = mix(unpackUnorm4x8(particle.color_start), unpackUnorm4x8(particle.color_end), t);
+}
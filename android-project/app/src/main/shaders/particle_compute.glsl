@@ -0,0 +1,62 @@
+// Bindings only the particle compute passes use
+
+#extension GL_GOOGLE_include_directive : enable
+
+#define PARTICLE_ACCESS
+#include "particles.glsl"
+
+struct Emitter {
+    vec3 position;
+    float radius;
+    vec3 velocity;
+    float spread;
+    float life_min;
+    float life_max;
+    float size_start;
+    float size_end;
+    uint color_start;
+    uint color_end;
+    uint first;
+    uint count;
+};
+
+layout (std430, set = 0, binding = 1) readonly buffer Emitters {
+    Emitter emitters[];
+};
+
+layout (std430, set = 0, binding = 4) buffer Dead {
+    uint dead[];
+};
+
+layout (std430, set = 0, binding = 5) buffer Counters {
+    uint alive_count[2];
+    int dead_count;
+    // the alive count rounded up to a power of two and at least one sort block
+    uint sort_size;
+    uint simulate_args[3];
+    uint sort_args[3];
+    uint draw_args[4];
+};
+
+// sort passes, and the mode of particle_args.comp in local
+layout (push_constant) uniform Pass {
+    uint k;
+    uint j;
+    uint k_last;
+    uint local;
+} pass;
+
+uint hash(uint x) {
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+// uniform in [0, 1), advances the state
+float random(inout uint state) {
+    state = hash(state);
+    return float(state >> 8) * (1.0 / 16777216.0);
+}
@@ -0,0 +1,48 @@
+// Layouts shared by the particle shaders, they match render/particle_system.hpp and .cpp
+
+// only the compute passes write, vertex shaders can't without vertexPipelineStoresAndAtomics
+#ifndef PARTICLE_ACCESS
+#define PARTICLE_ACCESS readonly
+#endif
+
+struct Particle {
+    vec3 position;
+    float age;
+    vec3 velocity;
+    float life;
+    uint color_start;
+    uint color_end;
+    float size_start;
+    float size_end;
+};
+
+layout (set = 0, binding = 0) uniform Params {
+    mat4 view_projection;
+    vec4 camera;
+    vec4 right;
+    vec4 up;
+    // xyz gravity, w the time step
+    vec4 gravity;
+    uint max_particles;
+    uint emit_count;
+    uint emitter_count;
+    uint seed;
+    // the alive list emit and simulate read, simulate writes the other one
+    uint current;
+    float drag;
+    uint sorted;
+} params;
+
+layout (std430, set = 0, binding = 2) PARTICLE_ACCESS buffer Particles {
+    Particle particles[];
+};
+
+// two lists of max_particles indices, list i starts at i * max_particles
+layout (std430, set = 0, binding = 3) PARTICLE_ACCESS buffer Alive {
+    uint alive[];
+};
+
+// x is the sort key, y the particle index
+layout (std430, set = 0, binding = 6) PARTICLE_ACCESS buffer Keys {
+    uvec2 keys[];
+};
@@ -0,0 +1,12 @@
+#version 450
+
+layout (set = 1, binding = 0) uniform sampler2D atlas;
+
+layout (location = 0) in vec2 uv;
+layout (location = 1) in vec4 color;
+
+layout (location = 0) out vec4 out_color;
+
+void main() {
+    out_color = texture(atlas, uv) * color;
+}
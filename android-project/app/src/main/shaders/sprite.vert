@@ -0,0 +1,41 @@
+#version 450
+
+struct Sprite {
+    vec2 position;
+    vec2 size;
+    uint uv_min;
+    uint uv_max;
+    uint color;
+    float rotation;
+};
+
+layout (std430, set = 0, binding = 0) readonly buffer Sprites {
+    Sprite sprites[];
+};
+
+layout (std430, set = 0, binding = 1) readonly buffer Order {
+    uint order[];
+};
+
+layout (push_constant) uniform Constants {
+    vec2 scale;
+    uint indirect;
+} constants;
+
+layout (location = 0) out vec2 out_uv;
+layout (location = 1) out vec4 out_color;
+
+// A triangle strip quad per instance, corners come from gl_VertexIndex
+void main() {
+    Sprite sprite = sprites[constants.indirect != 0 ? order[gl_InstanceIndex] : gl_InstanceIndex];
+
+    vec2 corner = vec2(gl_VertexIndex & 1, gl_VertexIndex >> 1);
+    vec2 local = (corner - 0.5) * sprite.size;
+    float c = cos(sprite.rotation);
+    float s = sin(sprite.rotation);
+    vec2 position = sprite.position + 0.5 * sprite.size + vec2(c * local.x - s * local.y, s * local.x + c * local.y);
+
+    gl_Position = vec4(position * constants.scale - 1.0, 0.0, 1.0);
+    out_uv = mix(unpackUnorm2x16(sprite.uv_min), unpackUnorm2x16(sprite.uv_max), corner);
+    out_color = unpackUnorm4x8(sprite.color);
+}
@@ -1,20 +1,25 @@
 #include <jni.h>
 
+#include <cmath>
 #include <cerrno>
 #include <cstdlib>
 #include <cstring>
+#include <dlfcn.h>
 #include <unistd.h>
 #include <sys/resource.h>
 
+#include <span>
 #include <array>
 #include <queue>
 #include <array>
+#include <chrono>
 #include <thread>
 #include <memory>
+#include <vector>
 #include <optional>
+#include <functional>
 
 #include <debug.hpp>
-#include <fmt/format.h>
 #include <vulkan/vulkan.hpp>
 #include <android/configuration.h>
 #include <android/native_activity.h>
@@ -38,7 +43,7 @@ enum {
 //    APP_CMD_LOW_MEMORY,
 //    APP_CMD_START,
 //    APP_CMD_RESUME,
-//    APP_CMD_SAVE_STATE,
+    APP_CMD_SAVE_STATE,
 //    APP_CMD_PAUSE,
 //    APP_CMD_STOP,
     APP_CMD_DESTROY,
@@ -67,6 +72,14 @@ struct AndroidPlatform {
 
         bool destroyRequested = false;
 
+        // state handed to onCreate by a previous instance, and the handler that produces the next one
+        std::vector<std::byte> savedState;
+        std::function<std::vector<std::byte>()> saveStateHandler;
+        std::vector<std::byte> pendingState;
+        // every save request gets a number, the state is taken only if it answers the request waiting for it
+        uint64_t saveRequested = 0;
+        uint64_t saveAnswered = 0;
+
         std::mutex mutex;
         std::condition_variable signal;
 
@@ -82,7 +95,7 @@ struct AndroidPlatform {
         AConfiguration_fromAssetManager(self.config, self.assets);
 
         if (pipe(self.pipes.data())) {
-            self.log.error(fmt::format("could not create pipe: {}", strerror(errno)));
+            self.log.error("could not create pipe: {}", strerror(errno));
         }
     }
 
@@ -119,7 +132,7 @@ struct AndroidPlatform {
                     AInputEvent *event = nullptr;
                     while (AInputQueue_getEvent(self.inputQueue, &event) >= 0) {
                         const auto type = AInputEvent_getType(event);
-                        self.log.verbose(fmt::format("InputEvent: type = {}", type));
+                        self.log.verbose("InputEvent: type = {}", type);
                         if (!AInputQueue_preDispatchEvent(self.inputQueue, event)) {
                             AInputQueue_finishEvent(self.inputQueue, event, _handleInput(event));
                         }
@@ -136,7 +149,7 @@ struct AndroidPlatform {
 private:
     void _writeEvent(uint8_t cmd) {
         if (write(self.pipes[1], &cmd, sizeof(uint8_t)) != sizeof(uint8_t)) {
-            self.log.error(fmt::format("Failure writing AndroidPlatform cmd: {}", strerror(errno)));
+            self.log.error("Failure writing AndroidPlatform cmd: {}", strerror(errno));
         }
     }
 
@@ -214,6 +227,43 @@ private:
 
     void _onNativeWindowDestroyed(ANativeActivity* activity, ANativeWindow* window) {}
 
+    // The state is produced on the render thread, so the UI thread waits for it, but not long enough to trigger an ANR
+    auto _onSaveInstanceState(ANativeActivity* activity, size_t* outSize) -> void* {
+        *outSize = 0;
+        if (!self.renderThread.has_value()) {
+            return nullptr;
+        }
+
+        auto request = uint64_t{};
+        {
+            std::lock_guard lock{self.mutex};
+            request = ++self.saveRequested;
+        }
+        _writeEvent(APP_CMD_SAVE_STATE);
+
+        // a reply to an earlier request that timed out doesn't count
+        std::unique_lock lock{self.mutex};
+        const auto saved = self.signal.wait_for(lock, std::chrono::seconds(2), [this, request] {
+            return self.saveAnswered == request;
+        });
+        if (!saved) {
+            self.log.error("render thread did not save state in time");
+            return nullptr;
+        }
+        if (self.pendingState.empty()) {
+            return nullptr;
+        }
+
+        // the activity frees the state with free()
+        const auto state = malloc(self.pendingState.size());
+        if (state != nullptr) {
+            memcpy(state, self.pendingState.data(), self.pendingState.size());
+            *outSize = self.pendingState.size();
+        }
+        self.pendingState = {};
+        return state;
+    }
+
 public:
     void _handleEvent(uint8_t cmd) {
         switch (cmd) {
@@ -247,6 +297,20 @@ public:
             case APP_CMD_CONFIG_CHANGED:
                 AConfiguration_fromAssetManager(self.config, self.assets);
                 break;
+            case APP_CMD_SAVE_STATE: {
+                // the newest request, the state is made now, so it answers that one even for an older event
+                auto request = uint64_t{};
+                {
+                    std::lock_guard lock{self.mutex};
+                    request = self.saveRequested;
+                }
+                auto state = self.saveStateHandler ? self.saveStateHandler() : std::vector<std::byte>{};
+
+                std::lock_guard lock{self.mutex};
+                self.pendingState = std::move(state);
+                self.saveAnswered = request;
+                self.signal.notify_all();
+            } break;
             case APP_CMD_DESTROY:
                 self.destroyRequested = true;
                 break;
@@ -280,9 +344,51 @@ auto AndroidPlatform_shouldClose() -> bool {
     return m_AndroidPlatform->shouldClose();
 }
 
+auto AndroidPlatform_savedState() -> std::span<const std::byte> {
+    return m_AndroidPlatform->self.savedState;
+}
+
+void AndroidPlatform_setSaveStateHandler(std::function<std::vector<std::byte>()> handler) {
+    m_AndroidPlatform->self.saveStateHandler = std::move(handler);
+}
+
+// AThermal is only there from API 30 on while the app goes down to 21, so it is looked up at runtime
+auto AndroidPlatform_thermalHeadroom() -> std::optional<float> {
+    using AcquireManager = void* (*)();
+    using GetHeadroom = float (*)(void*, int);
+
+    static const auto thermal = [] {
+        auto result = std::pair<void*, GetHeadroom>{nullptr, nullptr};
+        auto library = dlopen("libandroid.so", RTLD_NOW | RTLD_LOCAL);
+        if (library == nullptr) {
+            return result;
+        }
+        const auto acquire = reinterpret_cast<AcquireManager>(dlsym(library, "AThermal_acquireManager"));
+        const auto headroom = reinterpret_cast<GetHeadroom>(dlsym(library, "AThermal_getThermalHeadroom"));
+        if (acquire != nullptr && headroom != nullptr) {
+            result = {acquire(), headroom};
+        }
+        return result;
+    }();
+    if (thermal.first == nullptr) {
+        return std::nullopt;
+    }
+
+    // a second ahead, so that the governor reacts before the platform throttles; NaN when called too often
+    const auto headroom = thermal.second(thermal.first, 1);
+    if (std::isnan(headroom)) {
+        return std::nullopt;
+    }
+    return headroom;
+}
+
 [[maybe_unused]]
 JNIEXPORT void ANativeActivity_onCreate(ANativeActivity* activity, void* _savedState, size_t _savedStateLen) {
     m_AndroidPlatform = std::make_unique<AndroidPlatform>(activity->assetManager);
+    if (_savedState != nullptr && _savedStateLen != 0) {
+        const auto state = static_cast<const std::byte*>(_savedState);
+        m_AndroidPlatform->self.savedState.assign(state, state + _savedStateLen);
+    }
 
     activity->callbacks->onDestroy = [](ANativeActivity* activity) {
 
@@ -294,7 +400,7 @@ JNIEXPORT void ANativeActivity_onCreate(ANativeActivity* activity, void* _savedS
 
     };
     activity->callbacks->onSaveInstanceState = [](ANativeActivity* activity, size_t* outSize) -> void* {
-        return nullptr;
+        return m_AndroidPlatform->_onSaveInstanceState(activity, outSize);
     };
     activity->callbacks->onPause = [](ANativeActivity* activity) {
 
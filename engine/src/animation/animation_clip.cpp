@@ -0,0 +1,207 @@
+#include "animation_clip.hpp"
+
+#include <debug.hpp>
+
+#include <array>
+#include <cmath>
+#include <algorithm>
+
+namespace {
+    constexpr auto SQRT2 = 1.41421356f;
+    constexpr auto ROTATION_MAX = 32767.0f;
+
+    // The largest component is dropped and rebuilt from the unit length, its sign is made positive since
+    // q and -q are the same rotation. The other three lie within +-1/sqrt(2) and get 15 bits each, with
+    // the index of the dropped one in the lowest 2 bits.
+    auto packRotation(const Quat& q) noexcept -> std::array<uint16_t, 3> {
+        auto c = std::array{q.x, q.y, q.z, q.w};
+        auto largest = size_t{0};
+        for (size_t i = 1; i < 4; i++) {
+            if (std::abs(c[i]) > std::abs(c[largest])) {
+                largest = i;
+            }
+        }
+        const auto flip = c[largest] < 0.0f ? -1.0f : 1.0f;
+
+        auto bits = uint64_t{largest};
+        auto shift = 2;
+        for (size_t i = 0; i < 4; i++) {
+            if (i == largest) {
+                continue;
+            }
+            const auto unit = std::clamp(c[i] * flip * SQRT2 * 0.5f + 0.5f, 0.0f, 1.0f);
+            bits |= static_cast<uint64_t>(std::lround(unit * ROTATION_MAX)) << shift;
+            shift += 15;
+        }
+        return {static_cast<uint16_t>(bits), static_cast<uint16_t>(bits >> 16), static_cast<uint16_t>(bits >> 32)};
+    }
+
+    auto unpackRotation(const uint16_t* packed) noexcept -> std::array<float, 4> {
+        const auto bits = uint64_t{packed[0]} | uint64_t{packed[1]} << 16 | uint64_t{packed[2]} << 32;
+        const auto largest = static_cast<size_t>(bits & 3);
+
+        auto c = std::array<float, 4>{};
+        auto shift = 2;
+        auto sum = 0.0f;
+        for (size_t i = 0; i < 4; i++) {
+            if (i == largest) {
+                continue;
+            }
+            const auto value = (static_cast<float>((bits >> shift) & 0x7fff) / ROTATION_MAX - 0.5f) * SQRT2;
+            c[i] = value;
+            sum += value * value;
+            shift += 15;
+        }
+        c[largest] = std::sqrt(std::max(1.0f - sum, 0.0f));
+        return c;
+    }
+
+    auto rotationComponents(const Transform& t) noexcept -> std::array<float, 4> {
+        return {t.rotation.x, t.rotation.y, t.rotation.z, t.rotation.w};
+    }
+
+    auto vectorComponents(const Transform& t, bool scale) noexcept -> std::array<float, 3> {
+        const auto& v = scale ? t.scale : t.position;
+        return {v.x, v.y, v.z};
+    }
+}
+
+auto AnimationClip::compress(std::span<const Transform> frames, uint32_t joints, float sample_rate) -> std::optional<AnimationClip> {
+    return compress(frames, joints, sample_rate, Settings{});
+}
+
+auto AnimationClip::compress(std::span<const Transform> frames, uint32_t joints, float sample_rate, const Settings& settings) -> std::optional<AnimationClip> {
+    if (joints == 0 || joints >= 0xffff || frames.empty() || frames.size() % joints != 0 || !(sample_rate > 0.0f)) {
+        Debug{"animation"}.error("clip needs a positive sample rate and whole frames of 1 to 65534 joints");
+        return std::nullopt;
+    }
+
+    auto clip = AnimationClip{};
+    clip.frame_count = static_cast<uint32_t>(frames.size() / joints);
+    clip.rate = sample_rate;
+    clip.constants.resize(joints);
+
+    const auto key = [&](uint32_t frame, uint32_t joint) -> const Transform& {
+        return frames[static_cast<size_t>(frame) * joints + joint];
+    };
+
+    for (uint32_t joint = 0; joint < joints; joint++) {
+        clip.constants.set(joint, key(0, joint));
+
+        const auto first = rotationComponents(key(0, joint));
+        auto rotation_moves = false;
+        for (uint32_t frame = 1; frame < clip.frame_count && !rotation_moves; frame++) {
+            const auto q = rotationComponents(key(frame, joint));
+            const auto d = first[0] * q[0] + first[1] * q[1] + first[2] * q[2] + first[3] * q[3];
+            rotation_moves = 1.0f - std::abs(d) > settings.rotation_tolerance;
+        }
+        if (rotation_moves) {
+            clip.tracks.emplace_back(Track{.joint = static_cast<uint16_t>(joint), .type = eRotation});
+        }
+
+        for (const auto type : {ePosition, eScale}) {
+            const auto scale = type == eScale;
+            const auto tolerance = scale ? settings.scale_tolerance : settings.position_tolerance;
+            auto lo = vectorComponents(key(0, joint), scale);
+            auto hi = lo;
+            for (uint32_t frame = 1; frame < clip.frame_count; frame++) {
+                const auto v = vectorComponents(key(frame, joint), scale);
+                for (size_t i = 0; i < 3; i++) {
+                    lo[i] = std::min(lo[i], v[i]);
+                    hi[i] = std::max(hi[i], v[i]);
+                }
+            }
+            if (hi[0] - lo[0] <= tolerance && hi[1] - lo[1] <= tolerance && hi[2] - lo[2] <= tolerance) {
+                continue;
+            }
+            auto track = Track{.joint = static_cast<uint16_t>(joint), .type = type};
+            for (size_t i = 0; i < 3; i++) {
+                track.min[i] = lo[i];
+                track.extent[i] = hi[i] - lo[i];
+            }
+            clip.tracks.emplace_back(track);
+        }
+    }
+
+    const auto row_size = clip.tracks.size() * 3;
+    clip.keys.resize(row_size * clip.frame_count);
+    for (uint32_t frame = 0; frame < clip.frame_count; frame++) {
+        auto row = clip.keys.data() + frame * row_size;
+        for (const auto& track : clip.tracks) {
+            const auto& transform = key(frame, track.joint);
+            if (track.type == eRotation) {
+                const auto packed = packRotation(transform.rotation);
+                std::copy(packed.begin(), packed.end(), row);
+            } else {
+                const auto v = vectorComponents(transform, track.type == eScale);
+                for (size_t i = 0; i < 3; i++) {
+                    const auto unit = track.extent[i] > 0.0f ? (v[i] - track.min[i]) / track.extent[i] : 0.0f;
+                    row[i] = static_cast<uint16_t>(std::lround(std::clamp(unit, 0.0f, 1.0f) * 65535.0f));
+                }
+            }
+            row += 3;
+        }
+    }
+    return clip;
+}
+
+void AnimationClip::sample(float time, bool loop, Pose& out) const noexcept {
+    out.copyFrom(constants);
+    if (tracks.empty()) {
+        return;
+    }
+
+    const auto last = static_cast<float>(frame_count - 1);
+    auto frame = time * rate;
+    if (loop && last > 0.0f) {
+        frame = std::fmod(frame, last);
+        if (frame < 0.0f) {
+            frame += last;
+        }
+    }
+    frame = std::clamp(frame, 0.0f, last);
+
+    const auto first = std::min(static_cast<uint32_t>(frame), frame_count - 1);
+    const auto second = std::min(first + 1, frame_count - 1);
+    const auto row_size = tracks.size() * 3;
+    _decode(keys.data() + first * row_size, keys.data() + second * row_size, frame - static_cast<float>(first), out);
+}
+
+void AnimationClip::_decode(const uint16_t* row, const uint16_t* next, float t, Pose& out) const noexcept {
+    const auto stride = out.stride();
+    const auto rotations = out.channel(Pose::eRotationX);
+    const auto positions = out.channel(Pose::ePositionX);
+    const auto scales = out.channel(Pose::eScaleX);
+
+    for (const auto& track : tracks) {
+        if (track.type == eRotation) {
+            const auto a = unpackRotation(row);
+            const auto b = unpackRotation(next);
+            const auto d = a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3];
+            const auto s = d < 0.0f ? -t : t;
+            auto q = std::array<float, 4>{};
+            auto length = 0.0f;
+            for (size_t i = 0; i < 4; i++) {
+                q[i] = a[i] - a[i] * t + b[i] * s;
+                length += q[i] * q[i];
+            }
+            const auto scale = 1.0f / std::sqrt(length);
+            for (size_t i = 0; i < 4; i++) {
+                rotations[i * stride + track.joint] = q[i] * scale;
+            }
+        } else {
+            const auto channels = track.type == eScale ? scales : positions;
+            for (size_t i = 0; i < 3; i++) {
+                const auto a = static_cast<float>(row[i]);
+                const auto b = static_cast<float>(next[i]);
+                channels[i * stride + track.joint] = track.min[i] + (a + (b - a) * t) * (track.extent[i] / 65535.0f);
+            }
+        }
+        row += 3;
+        next += 3;
+    }
+}
+
+auto AnimationClip::compressedSize() const noexcept -> size_t {
+    return keys.size() * sizeof(uint16_t) + tracks.size() * sizeof(Track) + static_cast<size_t>(constants.stride()) * Pose::CHANNEL_COUNT * sizeof(float);
+}
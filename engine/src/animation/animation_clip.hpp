@@ -0,0 +1,66 @@
+#pragma once
+
+#include "pose.hpp"
+
+#include <span>
+#include <vector>
+#include <cstdint>
+#include <optional>
+
+// A compressed animation for one skeleton, sampled at a fixed rate. Tracks that don't move are stored once;
+// animated rotations are quantized to 48 bits with the smallest three components, and animated positions and
+// scales to 16 bits per component within the track's range. Keys are stored frame by frame, so sampling
+// reads two consecutive rows.
+struct AnimationClip {
+    struct Settings {
+        // tracks whose keys all stay this close to the first one are constant
+        float rotation_tolerance = 1e-4f;
+        float position_tolerance = 1e-4f;
+        float scale_tolerance = 1e-4f;
+    };
+
+    AnimationClip() = default;
+
+    // frames holds frame_count * joints local transforms, frame after frame, taken sample_rate times a second
+    static auto compress(std::span<const Transform> frames, uint32_t joints, float sample_rate) -> std::optional<AnimationClip>;
+    static auto compress(std::span<const Transform> frames, uint32_t joints, float sample_rate, const Settings& settings) -> std::optional<AnimationClip>;
+
+    // Writes the pose at time seconds, wrapping around when looping and holding the last frame otherwise
+    void sample(float time, bool loop, Pose& out) const noexcept;
+
+    [[nodiscard]] auto duration() const noexcept -> float {
+        return frame_count > 1 ? static_cast<float>(frame_count - 1) / rate : 0.0f;
+    }
+
+    [[nodiscard]] auto joints() const noexcept -> uint32_t {
+        return constants.joints();
+    }
+
+    // of the keys and track descriptions, for comparing against the raw clip
+    [[nodiscard]] auto compressedSize() const noexcept -> size_t;
+
+private:
+    enum TrackType : uint8_t {
+        eRotation,
+        ePosition,
+        eScale
+    };
+
+    struct Track {
+        uint16_t joint;
+        TrackType type;
+        // positions and scales: key = min + quantized / 65535 * extent
+        float min[3]{};
+        float extent[3]{};
+    };
+
+    void _decode(const uint16_t* row, const uint16_t* next, float t, Pose& out) const noexcept;
+
+    // every joint's constant value, animated tracks are overwritten when sampling
+    Pose constants;
+    std::vector<Track> tracks;
+    // frame_count rows of three uint16_t per track
+    std::vector<uint16_t> keys;
+    uint32_t frame_count = 0;
+    float rate = 30.0f;
+};
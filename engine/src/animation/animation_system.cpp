@@ -0,0 +1,201 @@
+#include "animation_system.hpp"
+
+#include <jobs/job_system.hpp>
+
+#include <array>
+#include <algorithm>
+
+namespace {
+    constexpr auto W = static_cast<uint32_t>(SimdFloat::WIDTH);
+    // 3x4 affine matrices as structure of arrays, column major
+    constexpr uint32_t AFFINE = 12;
+
+    auto at(float* soa, uint32_t stride, uint32_t column, uint32_t row) noexcept -> float* {
+        return soa + (column * 3 + row) * stride;
+    }
+
+    // Same layout as Mat4::fromTRS, SimdFloat::WIDTH joints at a time
+    void localMatrices(const Pose& pose, float* out) noexcept {
+        const auto stride = pose.stride();
+        const auto two = SimdFloat::broadcast(2.0f);
+        const auto one = SimdFloat::broadcast(1.0f);
+        for (uint32_t i = 0; i < stride; i += W) {
+            const auto x = SimdFloat::load(pose.channel(Pose::eRotationX) + i);
+            const auto y = SimdFloat::load(pose.channel(Pose::eRotationY) + i);
+            const auto z = SimdFloat::load(pose.channel(Pose::eRotationZ) + i);
+            const auto w = SimdFloat::load(pose.channel(Pose::eRotationW) + i);
+            const auto sx = SimdFloat::load(pose.channel(Pose::eScaleX) + i);
+            const auto sy = SimdFloat::load(pose.channel(Pose::eScaleY) + i);
+            const auto sz = SimdFloat::load(pose.channel(Pose::eScaleZ) + i);
+
+            const auto xx = x * x, yy = y * y, zz = z * z;
+            const auto xy = x * y, xz = x * z, yz = y * z;
+            const auto wx = w * x, wy = w * y, wz = w * z;
+
+            ((one - two * (yy + zz)) * sx).store(at(out, stride, 0, 0) + i);
+            (two * (xy + wz) * sx).store(at(out, stride, 0, 1) + i);
+            (two * (xz - wy) * sx).store(at(out, stride, 0, 2) + i);
+            (two * (xy - wz) * sy).store(at(out, stride, 1, 0) + i);
+            ((one - two * (xx + zz)) * sy).store(at(out, stride, 1, 1) + i);
+            (two * (yz + wx) * sy).store(at(out, stride, 1, 2) + i);
+            (two * (xz + wy) * sz).store(at(out, stride, 2, 0) + i);
+            (two * (yz - wx) * sz).store(at(out, stride, 2, 1) + i);
+            ((one - two * (xx + yy)) * sz).store(at(out, stride, 2, 2) + i);
+            SimdFloat::load(pose.channel(Pose::ePositionX) + i).store(at(out, stride, 3, 0) + i);
+            SimdFloat::load(pose.channel(Pose::ePositionY) + i).store(at(out, stride, 3, 1) + i);
+            SimdFloat::load(pose.channel(Pose::ePositionZ) + i).store(at(out, stride, 3, 2) + i);
+        }
+    }
+
+    // Parents come first, so one pass in joint order leaves every joint in model space
+    void modelMatrices(std::span<const uint16_t> parents, uint32_t stride, const float* local, float* model) noexcept {
+        for (uint32_t joint = 0; joint < parents.size(); joint++) {
+            const auto parent = parents[joint];
+            if (parent == Skeleton::NO_PARENT) {
+                for (uint32_t c = 0; c < AFFINE; c++) {
+                    model[c * stride + joint] = local[c * stride + joint];
+                }
+                continue;
+            }
+
+            auto a = std::array<float, AFFINE>{};
+            auto b = std::array<float, AFFINE>{};
+            for (uint32_t c = 0; c < AFFINE; c++) {
+                a[c] = model[c * stride + parent];
+                b[c] = local[c * stride + joint];
+            }
+            for (uint32_t column = 0; column < 4; column++) {
+                for (uint32_t row = 0; row < 3; row++) {
+                    auto value = a[row] * b[column * 3] + a[3 + row] * b[column * 3 + 1] + a[6 + row] * b[column * 3 + 2];
+                    if (column == 3) {
+                        value += a[9 + row];
+                    }
+                    model[(column * 3 + row) * stride + joint] = value;
+                }
+            }
+        }
+    }
+
+    // out = a * b for every joint, SimdFloat::WIDTH joints at a time
+    void multiplyAffine(const float* a, const float* b, uint32_t stride, float* out) noexcept {
+        for (uint32_t i = 0; i < stride; i += W) {
+            auto ma = std::array<SimdFloat, AFFINE>{};
+            auto mb = std::array<SimdFloat, AFFINE>{};
+            for (uint32_t c = 0; c < AFFINE; c++) {
+                ma[c] = SimdFloat::load(a + c * stride + i);
+                mb[c] = SimdFloat::load(b + c * stride + i);
+            }
+            for (uint32_t column = 0; column < 4; column++) {
+                for (uint32_t row = 0; row < 3; row++) {
+                    auto value = madd(ma[row], mb[column * 3], madd(ma[3 + row], mb[column * 3 + 1], ma[6 + row] * mb[column * 3 + 2]));
+                    if (column == 3) {
+                        value = value + ma[9 + row];
+                    }
+                    value.store(out + (column * 3 + row) * stride + i);
+                }
+            }
+        }
+    }
+}
+
+auto AnimationSystem::addCharacter(const Skeleton& skeleton) -> uint32_t {
+    const auto joints = skeleton.joints();
+    const auto reusable = std::find_if(free_characters.begin(), free_characters.end(), [&](uint32_t id) {
+        return characters[id].capacity >= joints;
+    });
+
+    auto id = uint32_t{};
+    if (reusable != free_characters.end()) {
+        id = *reusable;
+        free_characters.erase(reusable);
+    } else {
+        id = static_cast<uint32_t>(characters.size());
+        characters.emplace_back(Character{
+            .first_matrix = static_cast<uint32_t>(skin_matrices.size()),
+            .capacity = joints
+        });
+        skin_matrices.resize(skin_matrices.size() + joints);
+    }
+
+    auto& character = characters[id];
+    character.skeleton = &skeleton;
+    character.layers = {};
+    character.alive = true;
+    return id;
+}
+
+void AnimationSystem::removeCharacter(uint32_t character) {
+    if (!characters[character].alive) {
+        return;
+    }
+    characters[character].alive = false;
+    characters[character].skeleton = nullptr;
+    free_characters.emplace_back(character);
+}
+
+void AnimationSystem::play(uint32_t character, uint32_t layer, const AnimationClip* clip, float weight, float speed, bool loop) {
+    characters[character].layers[layer] = Layer{
+        .clip = clip,
+        .time = 0.0f,
+        .speed = speed,
+        .weight = weight,
+        .loop = loop
+    };
+}
+
+void AnimationSystem::update(float dt) {
+    scratch.resize(JobSystem::threadCount() + 1);
+    JobSystem::parallelFor(characters.size(), 0, [this, dt](size_t begin, size_t end) {
+        auto& worker = scratch[JobSystem::threadIndex()];
+        for (auto i = begin; i < end; i++) {
+            if (characters[i].alive) {
+                _animate(characters[i], worker, dt);
+            }
+        }
+    });
+}
+
+void AnimationSystem::_animate(Character& character, Scratch& worker, float dt) {
+    const auto& skeleton = *character.skeleton;
+    const auto joints = skeleton.joints();
+
+    auto sampled = false;
+    for (auto& layer : character.layers) {
+        if (layer.clip == nullptr || layer.clip->joints() != joints) {
+            continue;
+        }
+        layer.time += dt * layer.speed;
+        if (!layer.loop) {
+            layer.time = std::clamp(layer.time, 0.0f, layer.clip->duration());
+        }
+        if (!sampled) {
+            layer.clip->sample(layer.time, layer.loop, worker.pose);
+            sampled = true;
+        } else if (layer.weight > 0.0f) {
+            layer.clip->sample(layer.time, layer.loop, worker.layer);
+            blendPoses(worker.pose, worker.layer, std::min(layer.weight, 1.0f), worker.pose);
+        }
+    }
+    if (!sampled) {
+        worker.pose.copyFrom(skeleton.bindPose());
+    }
+
+    const auto stride = worker.pose.stride();
+    worker.local.resize(static_cast<size_t>(stride) * AFFINE);
+    worker.model.resize(static_cast<size_t>(stride) * AFFINE);
+    localMatrices(worker.pose, worker.local.data());
+    modelMatrices(skeleton.parents(), stride, worker.local.data(), worker.model.data());
+    // the local matrices are done with, the skinning matrices take their place
+    multiplyAffine(worker.model.data(), skeleton.inverseBind(), stride, worker.local.data());
+
+    auto out = skin_matrices.data() + character.first_matrix;
+    for (uint32_t joint = 0; joint < joints; joint++) {
+        auto& m = out[joint].m;
+        for (uint32_t column = 0; column < 4; column++) {
+            for (uint32_t row = 0; row < 3; row++) {
+                m[column * 4 + row] = worker.local[(column * 3 + row) * stride + joint];
+            }
+            m[column * 4 + 3] = column == 3 ? 1.0f : 0.0f;
+        }
+    }
+}
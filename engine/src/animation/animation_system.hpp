@@ -0,0 +1,81 @@
+#pragma once
+
+#include "pose.hpp"
+#include "animation_clip.hpp"
+
+#include <span>
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <optional>
+
+// Animates characters and produces their skinning matrices. update() spreads the characters over the job
+// system; each one samples its layers, blends them, and turns the pose into matrices, with the per joint math
+// done SimdFloat::WIDTH joints at a time. Only walking the hierarchy goes joint by joint.
+//
+// Every character owns a fixed range of matrices(), so the whole crowd can be uploaded with one copy.
+// Skeletons and clips are referenced, not copied, and have to outlive the characters using them.
+struct AnimationSystem {
+    static constexpr uint32_t MAX_LAYERS = 4;
+
+    struct Layer {
+        const AnimationClip* clip = nullptr;
+        float time = 0.0f;
+        float speed = 1.0f;
+        // blended over the layers below it, the first layer with a clip is taken as is
+        float weight = 1.0f;
+        bool loop = true;
+    };
+
+    auto addCharacter(const Skeleton& skeleton) -> uint32_t;
+    void removeCharacter(uint32_t character);
+
+    // Starts clip on a layer from the beginning, a null clip clears the layer
+    void play(uint32_t character, uint32_t layer, const AnimationClip* clip, float weight = 1.0f, float speed = 1.0f, bool loop = true);
+
+    [[nodiscard]] auto layer(uint32_t character, uint32_t index) noexcept -> Layer& {
+        return characters[character].layers[index];
+    }
+
+    void update(float dt);
+
+    // model space joint transforms times the inverse bind matrices, the character's joints in order
+    [[nodiscard]] auto skinningMatrices(uint32_t character) const noexcept -> std::span<const Mat4> {
+        const auto& c = characters[character];
+        return {skin_matrices.data() + c.first_matrix, c.skeleton->joints()};
+    }
+
+    [[nodiscard]] auto firstMatrix(uint32_t character) const noexcept -> uint32_t {
+        return characters[character].first_matrix;
+    }
+
+    // every character's skinning matrices, ranges of removed ones are left as they were
+    [[nodiscard]] auto matrices() const noexcept -> std::span<const Mat4> {
+        return skin_matrices;
+    }
+
+private:
+    struct Character {
+        const Skeleton* skeleton = nullptr;
+        std::array<Layer, MAX_LAYERS> layers{};
+        uint32_t first_matrix = 0;
+        // joints the matrix range has room for, a removed character's range is reused by skeletons that fit
+        uint32_t capacity = 0;
+        bool alive = false;
+    };
+
+    // per worker, so that nothing is allocated once they have grown to the largest skeleton
+    struct Scratch {
+        Pose pose;
+        Pose layer;
+        std::vector<float> local;
+        std::vector<float> model;
+    };
+
+    void _animate(Character& character, Scratch& scratch, float dt);
+
+    std::vector<Character> characters;
+    std::vector<uint32_t> free_characters;
+    std::vector<Mat4> skin_matrices;
+    std::vector<Scratch> scratch;
+};
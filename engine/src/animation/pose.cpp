@@ -0,0 +1,121 @@
+#include "pose.hpp"
+
+#include <debug.hpp>
+
+#include <array>
+#include <cstring>
+#include <algorithm>
+
+namespace {
+    constexpr auto W = static_cast<uint32_t>(SimdFloat::WIDTH);
+}
+
+Pose::Pose(uint32_t joints) {
+    resize(joints);
+}
+
+void Pose::resize(uint32_t joints) {
+    count = joints;
+    padded = (joints + W - 1) / W * W;
+    data.resize(static_cast<size_t>(padded) * CHANNEL_COUNT);
+    for (uint32_t joint = 0; joint < padded; joint++) {
+        set(joint, Transform{});
+    }
+}
+
+void Pose::set(uint32_t joint, const Transform& transform) noexcept {
+    const auto values = std::array{
+        transform.rotation.x, transform.rotation.y, transform.rotation.z, transform.rotation.w,
+        transform.position.x, transform.position.y, transform.position.z,
+        transform.scale.x, transform.scale.y, transform.scale.z
+    };
+    for (uint32_t c = 0; c < CHANNEL_COUNT; c++) {
+        data[c * padded + joint] = values[c];
+    }
+}
+
+auto Pose::get(uint32_t joint) const noexcept -> Transform {
+    const auto value = [&](Channel c) {
+        return data[c * padded + joint];
+    };
+    return Transform{
+        .position = {value(ePositionX), value(ePositionY), value(ePositionZ)},
+        .rotation = {value(eRotationX), value(eRotationY), value(eRotationZ), value(eRotationW)},
+        .scale = {value(eScaleX), value(eScaleY), value(eScaleZ)}
+    };
+}
+
+void Pose::copyFrom(const Pose& other) noexcept {
+    if (padded != other.padded) {
+        resize(other.count);
+    }
+    std::memcpy(data.data(), other.data.data(), data.size() * sizeof(float));
+}
+
+void blendPoses(const Pose& a, const Pose& b, float weight, Pose& out) noexcept {
+    const auto w = SimdFloat::broadcast(weight);
+    const auto stride = a.stride();
+
+    const auto ax = a.channel(Pose::eRotationX), ay = a.channel(Pose::eRotationY), az = a.channel(Pose::eRotationZ), aw = a.channel(Pose::eRotationW);
+    const auto bx = b.channel(Pose::eRotationX), by = b.channel(Pose::eRotationY), bz = b.channel(Pose::eRotationZ), bw = b.channel(Pose::eRotationW);
+    const auto ox = out.channel(Pose::eRotationX), oy = out.channel(Pose::eRotationY), oz = out.channel(Pose::eRotationZ), ow = out.channel(Pose::eRotationW);
+    for (uint32_t i = 0; i < stride; i += W) {
+        const auto qax = SimdFloat::load(ax + i), qay = SimdFloat::load(ay + i), qaz = SimdFloat::load(az + i), qaw = SimdFloat::load(aw + i);
+        const auto qbx = SimdFloat::load(bx + i), qby = SimdFloat::load(by + i), qbz = SimdFloat::load(bz + i), qbw = SimdFloat::load(bw + i);
+
+        // q and -q are the same rotation, b is flipped to the side of a
+        const auto s = sign(qax * qbx + qay * qby + qaz * qbz + qaw * qbw) * w;
+        const auto rx = madd(qbx, s, qax - qax * w);
+        const auto ry = madd(qby, s, qay - qay * w);
+        const auto rz = madd(qbz, s, qaz - qaz * w);
+        const auto rw = madd(qbw, s, qaw - qaw * w);
+        const auto scale = rsqrt(rx * rx + ry * ry + rz * rz + rw * rw);
+        (rx * scale).store(ox + i);
+        (ry * scale).store(oy + i);
+        (rz * scale).store(oz + i);
+        (rw * scale).store(ow + i);
+    }
+
+    for (uint32_t c = Pose::ePositionX; c < Pose::CHANNEL_COUNT; c++) {
+        const auto channel = static_cast<Pose::Channel>(c);
+        const auto pa = a.channel(channel);
+        const auto pb = b.channel(channel);
+        const auto po = out.channel(channel);
+        for (uint32_t i = 0; i < stride; i += W) {
+            const auto va = SimdFloat::load(pa + i);
+            madd(SimdFloat::load(pb + i) - va, w, va).store(po + i);
+        }
+    }
+}
+
+auto Skeleton::create(std::vector<uint16_t> parents, std::span<const Transform> bind_pose, std::span<const Mat4> inverse_bind) -> std::optional<Skeleton> {
+    const auto joints = parents.size();
+    if (joints == 0 || joints >= NO_PARENT || bind_pose.size() != joints || inverse_bind.size() != joints) {
+        Debug{"animation"}.error("skeleton needs matching parents, bind pose and inverse bind matrices for 1 to {} joints", NO_PARENT - 1);
+        return std::nullopt;
+    }
+    for (size_t joint = 0; joint < joints; joint++) {
+        if (parents[joint] != NO_PARENT && parents[joint] >= joint) {
+            Debug{"animation"}.error("joint {} comes before its parent {}", joint, parents[joint]);
+            return std::nullopt;
+        }
+    }
+
+    auto skeleton = Skeleton{};
+    skeleton.parent_indices = std::move(parents);
+    skeleton.bind.resize(static_cast<uint32_t>(joints));
+    for (uint32_t joint = 0; joint < joints; joint++) {
+        skeleton.bind.set(joint, bind_pose[joint]);
+    }
+
+    const auto stride = skeleton.bind.stride();
+    skeleton.inverse_bind_soa.assign(static_cast<size_t>(stride) * 12, 0.0f);
+    for (uint32_t joint = 0; joint < joints; joint++) {
+        for (uint32_t column = 0; column < 4; column++) {
+            for (uint32_t row = 0; row < 3; row++) {
+                skeleton.inverse_bind_soa[(column * 3 + row) * stride + joint] = inverse_bind[joint].m[column * 4 + row];
+            }
+        }
+    }
+    return skeleton;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <math/math.hpp>
+#include <math/simd.hpp>
+
+#include <span>
+#include <vector>
+#include <cstdint>
+#include <optional>
+
+// Local joint transforms as structure of arrays, one array per component. Arrays are padded to a multiple of
+// SimdFloat::WIDTH so that whole lanes can be processed; padding joints hold the identity.
+struct Pose {
+    enum Channel : uint32_t {
+        eRotationX,
+        eRotationY,
+        eRotationZ,
+        eRotationW,
+        ePositionX,
+        ePositionY,
+        ePositionZ,
+        eScaleX,
+        eScaleY,
+        eScaleZ,
+        CHANNEL_COUNT
+    };
+
+    Pose() = default;
+    explicit Pose(uint32_t joints);
+
+    // keeps the allocation when it is big enough
+    void resize(uint32_t joints);
+
+    [[nodiscard]] auto channel(Channel c) noexcept -> float* {
+        return data.data() + c * padded;
+    }
+
+    [[nodiscard]] auto channel(Channel c) const noexcept -> const float* {
+        return data.data() + c * padded;
+    }
+
+    [[nodiscard]] auto joints() const noexcept -> uint32_t {
+        return count;
+    }
+
+    // joints rounded up to SimdFloat::WIDTH, the length of every channel
+    [[nodiscard]] auto stride() const noexcept -> uint32_t {
+        return padded;
+    }
+
+    void set(uint32_t joint, const Transform& transform) noexcept;
+    [[nodiscard]] auto get(uint32_t joint) const noexcept -> Transform;
+
+    void copyFrom(const Pose& other) noexcept;
+
+private:
+    std::vector<float> data;
+    uint32_t count = 0;
+    uint32_t padded = 0;
+};
+
+// out = a * (1 - weight) + b * weight, rotations take the shorter way and are renormalized. out may be a or b.
+void blendPoses(const Pose& a, const Pose& b, float weight, Pose& out) noexcept;
+
+// Joints are ordered so that every parent comes before its children. inverse_bind takes model space into the
+// joint's space at bind time, skinning matrices are model * inverse_bind.
+struct Skeleton {
+    static constexpr uint16_t NO_PARENT = 0xffff;
+
+    static auto create(std::vector<uint16_t> parents, std::span<const Transform> bind_pose, std::span<const Mat4> inverse_bind) -> std::optional<Skeleton>;
+
+    [[nodiscard]] auto joints() const noexcept -> uint32_t {
+        return static_cast<uint32_t>(parent_indices.size());
+    }
+
+    [[nodiscard]] auto parents() const noexcept -> std::span<const uint16_t> {
+        return parent_indices;
+    }
+
+    [[nodiscard]] auto bindPose() const noexcept -> const Pose& {
+        return bind;
+    }
+
+    // 3x4 affine matrices as structure of arrays, column major: channel column * 3 + row, Pose::stride() apart
+    [[nodiscard]] auto inverseBind() const noexcept -> const float* {
+        return inverse_bind_soa.data();
+    }
+
+private:
+    std::vector<uint16_t> parent_indices;
+    Pose bind;
+    std::vector<float> inverse_bind_soa;
+};
@@ -1,9 +1,34 @@
 #pragma once
 
+#include <span>
+#include <vector>
+#include <cstddef>
+
+struct SnapshotChannel;
+
 struct AppMain {
     virtual ~AppMain() = default;
     virtual void onAttach() = 0;
     virtual void onDetach() = 0;
     virtual void onUpdate() = 0;
     virtual void onRender() = 0;
-};
\ No newline at end of file
+
+    // Called before the main render pass begins, for compute and transfer work the frame depends on.
+    virtual void onPreRender() {}
+
+    // Called at the rate set by JellyEngine::setFixedTimestep with a constant dt, on the simulation thread if
+    // the engine runs one. State the renderer needs goes into the write() slot of the SnapshotBuffer returned
+    // by snapshots(); the engine publishes it after every tick.
+    virtual void onFixedUpdate(double dt) {}
+
+    // The buffer the simulation hands its state to the renderer through, asked for once when run() starts.
+    // Each frame the engine acquires the newest snapshot before onPreRender, onRender then blends previous()
+    // and current() by RenderContext::alpha.
+    virtual auto snapshots() -> SnapshotChannel* { return nullptr; }
+
+    // Called from pollEvents when the platform is about to kill the process (Android's onSaveInstanceState).
+    // Scene::saveSnapshot fits here. The returned bytes come back through onRestoreState after onAttach
+    // when the process is recreated. The simulation thread is paused between ticks while this is called.
+    virtual auto onSaveState() -> std::vector<std::byte> { return {}; }
+    virtual void onRestoreState(std::span<const std::byte> state) {}
+};
@@ -0,0 +1,185 @@
+#include "lz4.hpp"
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+namespace {
+    constexpr size_t MIN_MATCH = 4;
+    constexpr size_t LAST_LITERALS = 5;
+    constexpr size_t MF_LIMIT = 12;
+    constexpr size_t MAX_DISTANCE = 65535;
+    constexpr uint32_t HASH_LOG = 12;
+
+    auto read32(const uint8_t* p) noexcept -> uint32_t {
+        uint32_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    auto hash(uint32_t sequence) noexcept -> uint32_t {
+        return (sequence * 2654435761u) >> (32 - HASH_LOG);
+    }
+
+    void writeLength(uint8_t*& op, size_t length) noexcept {
+        while (length >= 255) {
+            *op++ = 255;
+            length -= 255;
+        }
+        *op++ = static_cast<uint8_t>(length);
+    }
+
+    auto readLength(const uint8_t*& ip, const uint8_t* iend, size_t& length) noexcept -> bool {
+        uint8_t b;
+        do {
+            if (ip >= iend) {
+                return false;
+            }
+            b = *ip++;
+            length += b;
+        } while (b == 255);
+        return true;
+    }
+
+    void writeSequence(uint8_t*& op, const uint8_t* literals, size_t literal_length, size_t offset, size_t match_length) noexcept {
+        auto token = op++;
+        *token = static_cast<uint8_t>(std::min<size_t>(literal_length, 15) << 4);
+        if (literal_length >= 15) {
+            writeLength(op, literal_length - 15);
+        }
+        if (literal_length != 0) {
+            std::memcpy(op, literals, literal_length);
+            op += literal_length;
+        }
+
+        if (match_length == 0) {
+            return;
+        }
+        *op++ = static_cast<uint8_t>(offset & 0xFF);
+        *op++ = static_cast<uint8_t>(offset >> 8);
+
+        const auto length = match_length - MIN_MATCH;
+        *token |= static_cast<uint8_t>(std::min<size_t>(length, 15));
+        if (length >= 15) {
+            writeLength(op, length - 15);
+        }
+    }
+}
+
+auto LZ4::compressBound(size_t size) noexcept -> size_t {
+    return size + size / 255 + 16;
+}
+
+auto LZ4::compress(std::span<const char> src, std::span<char> dst) noexcept -> size_t {
+    if (dst.size() < compressBound(src.size())) {
+        return 0;
+    }
+
+    const auto base = reinterpret_cast<const uint8_t*>(src.data());
+    const auto end = base + src.size();
+    auto op = reinterpret_cast<uint8_t*>(dst.data());
+    auto ip = base;
+    auto anchor = base;
+
+    if (src.size() > MF_LIMIT) {
+        // the last match must start at least MF_LIMIT bytes before the end,
+        // and the last LAST_LITERALS bytes are always emitted as literals
+        const auto match_limit = end - MF_LIMIT;
+        const auto match_end = end - LAST_LITERALS;
+
+        std::array<uint32_t, 1u << HASH_LOG> table{};
+        while (++ip <= match_limit) {
+            const auto h = hash(read32(ip));
+            auto ref = base + table[h];
+            table[h] = static_cast<uint32_t>(ip - base);
+
+            if (static_cast<size_t>(ip - ref) > MAX_DISTANCE || read32(ref) != read32(ip)) {
+                continue;
+            }
+
+            while (ip > anchor && ref > base && ip[-1] == ref[-1]) {
+                ip--;
+                ref--;
+            }
+
+            auto length = MIN_MATCH;
+            while (ip + length < match_end && ip[length] == ref[length]) {
+                length++;
+            }
+
+            writeSequence(op, anchor, static_cast<size_t>(ip - anchor), static_cast<size_t>(ip - ref), length);
+
+            ip += length;
+            anchor = ip;
+            if (ip <= match_limit) {
+                table[hash(read32(ip - 2))] = static_cast<uint32_t>(ip - 2 - base);
+            }
+            ip--;
+        }
+    }
+
+    writeSequence(op, anchor, static_cast<size_t>(end - anchor), 0, 0);
+    return static_cast<size_t>(op - reinterpret_cast<uint8_t*>(dst.data()));
+}
+
+auto LZ4::decompress(std::span<const char> src, std::span<char> dst) noexcept -> std::optional<size_t> {
+    auto ip = reinterpret_cast<const uint8_t*>(src.data());
+    const auto iend = ip + src.size();
+    const auto obase = reinterpret_cast<uint8_t*>(dst.data());
+    const auto oend = obase + dst.size();
+    auto op = obase;
+
+    while (true) {
+        if (ip >= iend) {
+            return std::nullopt;
+        }
+        const auto token = *ip++;
+
+        size_t literal_length = token >> 4;
+        if (literal_length == 15 && !readLength(ip, iend, literal_length)) {
+            return std::nullopt;
+        }
+        if (literal_length > static_cast<size_t>(iend - ip) || literal_length > static_cast<size_t>(oend - op)) {
+            return std::nullopt;
+        }
+        if (literal_length != 0) {
+            std::memcpy(op, ip, literal_length);
+            ip += literal_length;
+            op += literal_length;
+        }
+
+        if (ip == iend) {
+            break;
+        }
+
+        if (iend - ip < 2) {
+            return std::nullopt;
+        }
+        const auto offset = static_cast<size_t>(ip[0]) | (static_cast<size_t>(ip[1]) << 8);
+        ip += 2;
+        if (offset == 0 || offset > static_cast<size_t>(op - obase)) {
+            return std::nullopt;
+        }
+
+        size_t match_length = token & 15;
+        if (match_length == 15 && !readLength(ip, iend, match_length)) {
+            return std::nullopt;
+        }
+        match_length += MIN_MATCH;
+        if (match_length > static_cast<size_t>(oend - op)) {
+            return std::nullopt;
+        }
+
+        const auto match = op - offset;
+        if (offset >= match_length) {
+            std::memcpy(op, match, match_length);
+        } else {
+            for (size_t i = 0; i < match_length; i++) {
+                op[i] = match[i];
+            }
+        }
+        op += match_length;
+    }
+    return static_cast<size_t>(op - obase);
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <span>
+#include <cstddef>
+#include <optional>
+
+// LZ4 block format (https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md).
+// Streams produced by compress() can be decoded by the reference lz4 library and vice versa.
+struct LZ4 {
+    static auto compressBound(size_t size) noexcept -> size_t;
+
+    // Returns the number of bytes written into dst, or 0 when dst is smaller than compressBound(src.size())
+    static auto compress(std::span<const char> src, std::span<char> dst) noexcept -> size_t;
+
+    // Returns the number of bytes written into dst, or std::nullopt when src is malformed or dst is too small
+    static auto decompress(std::span<const char> src, std::span<char> dst) noexcept -> std::optional<size_t>;
+};
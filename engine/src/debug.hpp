@@ -1,42 +1,100 @@
 #pragma once
 
 #include <string>
+#include <cstdint>
+#include <utility>
 #include <iostream>
+#include <iterator>
+#include <string_view>
+#include <fmt/format.h>
 
 //#include <android/log.h>
 
+// Messages take string views, and the format overloads render into a buffer on the stack,
+// so logging doesn't allocate unless a message is longer than the buffer.
 struct Debug {
     explicit Debug(std::string tag) noexcept : tag{std::move(tag)} {}
 
-    void verbose(const std::string& s) {
-//        write(ANDROID_LOG_VERBOSE, s);
+    void verbose(std::string_view s) {
+        _write(Level::eVerbose, s);
     }
 
-    void debug(const std::string& s) {
-//        write(ANDROID_LOG_DEBUG, s);
+    void debug(std::string_view s) {
+        _write(Level::eDebug, s);
     }
 
-    void info(const std::string& s) {
-//        write(ANDROID_LOG_INFO, s);
+    void info(std::string_view s) {
+        _write(Level::eInfo, s);
     }
 
-    void warn(const std::string& s) {
-//        write(ANDROID_LOG_WARN, s);
+    void warn(std::string_view s) {
+        _write(Level::eWarn, s);
     }
 
-    void error(const std::string& s) {
-        std::cerr << s << std::endl;
-//        write(ANDROID_LOG_ERROR, s);
+    void error(std::string_view s) {
+        _write(Level::eError, s);
     }
 
-    void fatal(const std::string& s) {
-//        write(ANDROID_LOG_FATAL, s);
+    void fatal(std::string_view s) {
+        _write(Level::eFatal, s);
+    }
+
+    template<typename... Args>
+    void verbose(fmt::format_string<Args...> format, Args&&... args) {
+        _format(Level::eVerbose, format, std::forward<Args>(args)...);
+    }
+
+    template<typename... Args>
+    void debug(fmt::format_string<Args...> format, Args&&... args) {
+        _format(Level::eDebug, format, std::forward<Args>(args)...);
+    }
+
+    template<typename... Args>
+    void info(fmt::format_string<Args...> format, Args&&... args) {
+        _format(Level::eInfo, format, std::forward<Args>(args)...);
+    }
+
+    template<typename... Args>
+    void warn(fmt::format_string<Args...> format, Args&&... args) {
+        _format(Level::eWarn, format, std::forward<Args>(args)...);
+    }
+
+    template<typename... Args>
+    void error(fmt::format_string<Args...> format, Args&&... args) {
+        _format(Level::eError, format, std::forward<Args>(args)...);
+    }
+
+    template<typename... Args>
+    void fatal(fmt::format_string<Args...> format, Args&&... args) {
+        _format(Level::eFatal, format, std::forward<Args>(args)...);
     }
 
 private:
+    enum class Level : uint8_t {
+        eVerbose,
+        eDebug,
+        eInfo,
+        eWarn,
+        eError,
+        eFatal
+    };
+
     std::string tag;
 
-//    void write(android_LogPriority prio, const std::string& s) {
-//        __android_log_write(prio, tag.c_str(), s.c_str());
-//    }
+    template<typename... Args>
+    void _format(Level level, fmt::format_string<Args...> format, Args&&... args) {
+        fmt::memory_buffer buffer;
+        fmt::vformat_to(std::back_inserter(buffer), format, fmt::make_format_args(args...));
+        _write(level, std::string_view(buffer.data(), buffer.size()));
+    }
+
+    void _write(Level level, std::string_view s) {
+        if (level == Level::eError) {
+            std::cerr << s << std::endl;
+        }
+//        static constexpr android_LogPriority priorities[] = {
+//            ANDROID_LOG_VERBOSE, ANDROID_LOG_DEBUG, ANDROID_LOG_INFO, ANDROID_LOG_WARN, ANDROID_LOG_ERROR, ANDROID_LOG_FATAL
+//        };
+//        __android_log_print(priorities[static_cast<size_t>(level)], tag.c_str(), "%.*s", static_cast<int>(s.size()), s.data());
+    }
 };
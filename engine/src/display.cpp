@@ -42,6 +42,16 @@ struct Display::Impl {
         auto extensions = glfwGetRequiredInstanceExtensions(&count);
         return {extensions, extensions + count};
     }
+
+    auto savedState() -> std::span<const std::byte> {
+        return {};
+    }
+
+    void setSaveStateHandler(std::function<std::vector<std::byte>()> handler) {}
+
+    auto thermalHeadroom() -> std::optional<float> {
+        return std::nullopt;
+    }
 };
 #else
 struct Display::Impl {
@@ -76,6 +86,21 @@ struct Display::Impl {
             VK_KHR_ANDROID_SURFACE_EXTENSION_NAME
         };
     }
+
+    auto savedState() -> std::span<const std::byte> {
+        extern auto AndroidPlatform_savedState() -> std::span<const std::byte>;
+        return AndroidPlatform_savedState();
+    }
+
+    void setSaveStateHandler(std::function<std::vector<std::byte>()> handler) {
+        extern void AndroidPlatform_setSaveStateHandler(std::function<std::vector<std::byte>()> handler);
+        AndroidPlatform_setSaveStateHandler(std::move(handler));
+    }
+
+    auto thermalHeadroom() -> std::optional<float> {
+        extern auto AndroidPlatform_thermalHeadroom() -> std::optional<float>;
+        return AndroidPlatform_thermalHeadroom();
+    }
 };
 #endif
 
@@ -98,4 +123,16 @@ auto Display::createSurface(vk::Instance instance) -> vk::SurfaceKHR {
 
 auto Display::getInstanceExtensions() -> std::vector<const char *> {
     return impl->getInstanceExtensions();
+}
+
+auto Display::savedState() -> std::span<const std::byte> {
+    return impl->savedState();
+}
+
+void Display::setSaveStateHandler(std::function<std::vector<std::byte>()> handler) {
+    impl->setSaveStateHandler(std::move(handler));
+}
+
+auto Display::thermalHeadroom() -> std::optional<float> {
+    return impl->thermalHeadroom();
 }
\ No newline at end of file
@@ -1,8 +1,12 @@
 #pragma once
 
+#include <span>
 #include <string>
 #include <vector>
 #include <memory>
+#include <optional>
+#include <cstddef>
+#include <functional>
 #include <vulkan/vulkan.hpp>
 
 struct Display {
@@ -16,6 +20,16 @@ struct Display {
     auto createSurface(vk::Instance instance) -> vk::SurfaceKHR;
     auto getInstanceExtensions() -> std::vector<const char *>;
 
+    // State saved by a previous instance of the process, empty on desktop
+    auto savedState() -> std::span<const std::byte>;
+
+    // The handler runs inside pollEvents when the platform asks for state to save
+    void setSaveStateHandler(std::function<std::vector<std::byte>()> handler);
+
+    // Forecast thermal headroom, 1 is where the platform throttles. Empty where the platform doesn't report it.
+    // Android rate limits the query, it shouldn't be called more than about once a second.
+    auto thermalHeadroom() -> std::optional<float>;
+
 private:
     std::unique_ptr<Impl> impl;
 };
\ No newline at end of file
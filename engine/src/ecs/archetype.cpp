@@ -0,0 +1,103 @@
+#include "archetype.hpp"
+
+#include <new>
+#include <cstring>
+#include <algorithm>
+
+namespace {
+    auto alignUp(size_t value, size_t alignment) noexcept -> size_t {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+}
+
+void Archetype::FreeChunk::operator()(std::byte* chunk) const noexcept {
+    ::operator delete[](chunk, std::align_val_t{CHUNK_ALIGN});
+}
+
+Archetype::Archetype(std::vector<const ComponentType*> types) {
+    std::sort(types.begin(), types.end(), [](const ComponentType* a, const ComponentType* b) {
+        return a->id < b->id;
+    });
+
+    size_t row_size = sizeof(Entity);
+    for (const auto type : types) {
+        ids.emplace_back(type->id);
+        row_size += type->size;
+    }
+
+    // start from the estimate and shrink until the aligned columns fit into a chunk
+    capacity = CHUNK_SIZE / row_size;
+    while (true) {
+        columns.clear();
+        auto offset = capacity * sizeof(Entity);
+        for (const auto type : types) {
+            offset = alignUp(offset, type->align);
+            columns.emplace_back(Column{.type = type, .offset = offset});
+            offset += capacity * type->size;
+        }
+        if (offset <= CHUNK_SIZE || capacity == 1) {
+            chunk_bytes = std::max(CHUNK_SIZE, offset);
+            break;
+        }
+        capacity--;
+    }
+}
+
+auto Archetype::find(ComponentId id) const noexcept -> ptrdiff_t {
+    const auto it = std::lower_bound(ids.begin(), ids.end(), id);
+    if (it == ids.end() || *it != id) {
+        return -1;
+    }
+    return it - ids.begin();
+}
+
+auto Archetype::allocate(size_t n) -> size_t {
+    const auto first = count;
+    count += n;
+    while (chunks.size() * capacity < count) {
+        chunks.emplace_back(static_cast<std::byte*>(::operator new[](chunk_bytes, std::align_val_t{CHUNK_ALIGN})));
+    }
+    return first;
+}
+
+void Archetype::clear() {
+    count = 0;
+    chunks.resize(std::min<size_t>(chunks.size(), 1));
+}
+
+auto Archetype::remove(size_t row) -> Entity {
+    const auto last = count - 1;
+    auto moved = Entity{};
+    if (row != last) {
+        moved = entity(last);
+        entity(row) = moved;
+        for (size_t i = 0; i < columns.size(); i++) {
+            std::memcpy(component(row, i), component(last, i), columns[i].type->size);
+        }
+    }
+    count--;
+
+    // keep one spare chunk around so an entity bouncing on a chunk boundary doesn't reallocate
+    while (chunks.size() > chunkCount() + 1) {
+        chunks.pop_back();
+    }
+    return moved;
+}
+
+void Archetype::copy(size_t dst_row, const Archetype& src, size_t src_row) {
+    size_t i = 0;
+    size_t j = 0;
+    while (i < columns.size() && j < src.columns.size()) {
+        const auto a = ids[i];
+        const auto b = src.ids[j];
+        if (a == b) {
+            std::memcpy(component(dst_row, i), src.component(src_row, j), columns[i].type->size);
+            i++;
+            j++;
+        } else if (a < b) {
+            i++;
+        } else {
+            j++;
+        }
+    }
+}
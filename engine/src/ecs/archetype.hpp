@@ -0,0 +1,98 @@
+#pragma once
+
+#include "component.hpp"
+
+#include <span>
+#include <memory>
+#include <vector>
+#include <entity.hpp>
+#include <unordered_map>
+
+// Storage for every entity with exactly the same set of components.
+// Rows live in fixed-size chunks; inside a chunk the entity handles and each component are separate
+// contiguous arrays (SoA), so iterating a component touches only that component's memory.
+struct Archetype {
+    static constexpr size_t CHUNK_SIZE = 16 * 1024;
+    static constexpr size_t CHUNK_ALIGN = 64;
+
+    struct Column {
+        const ComponentType* type;
+        size_t offset;
+    };
+
+    explicit Archetype(std::vector<const ComponentType*> types);
+
+    Archetype(const Archetype&) = delete;
+    auto operator=(const Archetype&) -> Archetype& = delete;
+
+    [[nodiscard]] auto size() const noexcept -> size_t {
+        return count;
+    }
+
+    [[nodiscard]] auto chunkCount() const noexcept -> size_t {
+        return (count + capacity - 1) / capacity;
+    }
+
+    [[nodiscard]] auto chunkCapacity() const noexcept -> size_t {
+        return capacity;
+    }
+
+    // number of live rows in the chunk
+    [[nodiscard]] auto chunkSize(size_t chunk) const noexcept -> size_t {
+        return std::min(capacity, count - chunk * capacity);
+    }
+
+    [[nodiscard]] auto componentIds() const noexcept -> std::span<const ComponentId> {
+        return ids;
+    }
+
+    [[nodiscard]] auto componentColumns() const noexcept -> std::span<const Column> {
+        return columns;
+    }
+
+    // index into componentColumns(), or -1 when the archetype doesn't have the component
+    [[nodiscard]] auto find(ComponentId id) const noexcept -> ptrdiff_t;
+
+    [[nodiscard]] auto entities(size_t chunk) const noexcept -> Entity* {
+        return reinterpret_cast<Entity*>(chunks[chunk].get());
+    }
+
+    [[nodiscard]] auto column(size_t chunk, size_t column) const noexcept -> std::byte* {
+        return chunks[chunk].get() + columns[column].offset;
+    }
+
+    [[nodiscard]] auto component(size_t row, size_t column) const noexcept -> std::byte* {
+        return this->column(row / capacity, column) + (row % capacity) * columns[column].type->size;
+    }
+
+    [[nodiscard]] auto entity(size_t row) const noexcept -> Entity& {
+        return entities(row / capacity)[row % capacity];
+    }
+
+    // Appends n uninitialized rows and returns the index of the first one
+    auto allocate(size_t n) -> size_t;
+
+    // Drops every row, keeping one chunk allocated
+    void clear();
+
+    // Removes the row by moving the last row into its place; returns the entity that moved, if any
+    auto remove(size_t row) -> Entity;
+
+    // Copies the components both archetypes share from src_row of src into dst_row
+    void copy(size_t dst_row, const Archetype& src, size_t src_row);
+
+    std::unordered_map<ComponentId, Archetype*> add_edges;
+    std::unordered_map<ComponentId, Archetype*> remove_edges;
+
+private:
+    struct FreeChunk {
+        void operator()(std::byte* chunk) const noexcept;
+    };
+
+    std::vector<ComponentId> ids;
+    std::vector<Column> columns;
+    std::vector<std::unique_ptr<std::byte[], FreeChunk>> chunks;
+    size_t capacity = 0;
+    size_t count = 0;
+    size_t chunk_bytes = CHUNK_SIZE;
+};
@@ -0,0 +1,45 @@
+#include "component.hpp"
+
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+
+namespace {
+    struct ComponentTypes {
+        std::mutex mutex;
+        std::deque<ComponentType> types;
+        std::unordered_map<uint64_t, const ComponentType*> by_hash;
+    };
+
+    auto registry() -> ComponentTypes& {
+        static ComponentTypes types;
+        return types;
+    }
+}
+
+auto ComponentType::create(uint64_t hash, size_t size, size_t align, std::string_view name) -> const ComponentType& {
+    auto& types = registry();
+    std::lock_guard lock{types.mutex};
+
+    // of<T>() is instantiated once per shared library, the scene library's copy gets the engine's id
+    if (const auto it = types.by_hash.find(hash); it != types.by_hash.end()) {
+        return *it->second;
+    }
+    const auto& type = types.types.emplace_back(ComponentType{
+        .id = static_cast<ComponentId>(types.types.size()),
+        .hash = hash,
+        .size = size,
+        .align = align,
+        .name = name
+    });
+    types.by_hash.emplace(hash, &type);
+    return type;
+}
+
+auto ComponentType::find(uint64_t hash) -> const ComponentType* {
+    auto& types = registry();
+    std::lock_guard lock{types.mutex};
+
+    const auto it = types.by_hash.find(hash);
+    return it != types.by_hash.end() ? it->second : nullptr;
+}
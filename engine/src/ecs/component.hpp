@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string_view>
+#include <type_traits>
+
+using ComponentId = uint32_t;
+
+// Runtime description of a component type. Ids are dense and assigned on first use, hashes are derived from
+// the type name and stay the same between runs of the same build, which is what serialized data refers to.
+struct ComponentType {
+    ComponentId id;
+    uint64_t hash;
+    size_t size;
+    size_t align;
+    std::string_view name;
+
+    template<typename T>
+    static auto of() -> const ComponentType&;
+
+    static auto find(uint64_t hash) -> const ComponentType*;
+
+private:
+    static auto create(uint64_t hash, size_t size, size_t align, std::string_view name) -> const ComponentType&;
+
+    template<typename T>
+    static constexpr auto typeName() noexcept -> std::string_view {
+#if defined(_MSC_VER)
+        return __FUNCSIG__;
+#else
+        return __PRETTY_FUNCTION__;
+#endif
+    }
+
+    static constexpr auto hashName(std::string_view name) noexcept -> uint64_t {
+        uint64_t hash = 0xCBF29CE484222325ull;
+        for (const auto c : name) {
+            hash ^= static_cast<uint8_t>(c);
+            hash *= 0x100000001B3ull;
+        }
+        return hash;
+    }
+};
+
+// Components are relocated with memcpy when entities change archetype and are written to snapshots as raw bytes
+template<typename T>
+concept Component = std::is_trivially_copyable_v<T> && !std::is_empty_v<T>;
+
+template<typename T>
+auto ComponentType::of() -> const ComponentType& {
+    if constexpr (std::is_const_v<T>) {
+        return of<std::remove_const_t<T>>();
+    } else {
+        static_assert(Component<T>, "components must be trivially copyable");
+
+        static const auto& type = create(hashName(typeName<T>()), sizeof(T), alignof(T), typeName<T>());
+        return type;
+    }
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include "archetype.hpp"
+
+#include <span>
+#include <array>
+#include <tuple>
+#include <memory>
+#include <vector>
+#include <type_traits>
+
+// Rows of one archetype chunk, with one contiguous array per queried component
+template<typename... Ts>
+struct QueryChunk {
+    Entity* entity_data;
+    std::tuple<Ts*...> columns;
+    size_t count;
+
+    [[nodiscard]] auto size() const noexcept -> size_t {
+        return count;
+    }
+
+    [[nodiscard]] auto entities() const noexcept -> std::span<const Entity> {
+        return {entity_data, count};
+    }
+
+    template<typename T>
+    [[nodiscard]] auto get() const noexcept -> std::span<T> {
+        return {std::get<T*>(columns), count};
+    }
+
+    // fn(Ts&...) or fn(Entity, Ts&...) for every row
+    template<typename Fn>
+    void each(Fn&& fn) const {
+        for (size_t i = 0; i < count; i++) {
+            if constexpr (std::is_invocable_v<Fn, Entity, Ts&...>) {
+                fn(entity_data[i], std::get<Ts*>(columns)[i]...);
+            } else {
+                fn(std::get<Ts*>(columns)[i]...);
+            }
+        }
+    }
+};
+
+// Iterates every entity that has all of Ts. `const T` marks read-only access.
+// Matching archetypes are cached and only archetypes created since the last use are examined.
+template<typename... Ts>
+struct Query {
+    explicit Query(const std::vector<std::unique_ptr<Archetype>>& archetypes) : archetypes(&archetypes) {}
+
+    template<typename Fn>
+    void each(Fn&& fn) {
+        eachChunk([&fn](const QueryChunk<Ts...>& chunk) {
+            chunk.each(fn);
+        });
+    }
+
+    template<typename Fn>
+    void eachChunk(Fn&& fn) {
+        refresh();
+        for (const auto& match : matches) {
+            for (size_t chunk = 0; chunk < match.archetype->chunkCount(); chunk++) {
+                fn(makeChunk(match, chunk));
+            }
+        }
+    }
+
+    // Appends every non-empty chunk to out, e.g. to split the work across threads
+    void chunks(std::vector<QueryChunk<Ts...>>& out) {
+        refresh();
+        for (const auto& match : matches) {
+            for (size_t chunk = 0; chunk < match.archetype->chunkCount(); chunk++) {
+                out.emplace_back(makeChunk(match, chunk));
+            }
+        }
+    }
+
+    [[nodiscard]] auto size() -> size_t {
+        refresh();
+        size_t total = 0;
+        for (const auto& match : matches) {
+            total += match.archetype->size();
+        }
+        return total;
+    }
+
+private:
+    struct Match {
+        Archetype* archetype;
+        std::array<size_t, sizeof...(Ts)> columns;
+    };
+
+    void refresh() {
+        for (; checked < archetypes->size(); checked++) {
+            const auto archetype = (*archetypes)[checked].get();
+            const auto found = std::array<ptrdiff_t, sizeof...(Ts)>{
+                archetype->find(ComponentType::of<Ts>().id)...
+            };
+            if (std::find(found.begin(), found.end(), -1) != found.end()) {
+                continue;
+            }
+            auto match = Match{.archetype = archetype};
+            std::copy(found.begin(), found.end(), match.columns.begin());
+            matches.emplace_back(match);
+        }
+    }
+
+    auto makeChunk(const Match& match, size_t chunk) const -> QueryChunk<Ts...> {
+        return makeChunk(match, chunk, std::index_sequence_for<Ts...>{});
+    }
+
+    template<size_t... Is>
+    auto makeChunk(const Match& match, size_t chunk, std::index_sequence<Is...>) const -> QueryChunk<Ts...> {
+        return QueryChunk<Ts...>{
+            .entity_data = match.archetype->entities(chunk),
+            .columns = std::tuple<Ts*...>{
+                reinterpret_cast<Ts*>(match.archetype->column(chunk, match.columns[Is]))...
+            },
+            .count = match.archetype->chunkSize(chunk)
+        };
+    }
+
+    const std::vector<std::unique_ptr<Archetype>>* archetypes;
+    std::vector<Match> matches;
+    size_t checked = 0;
+};
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+
+// Binary layout of a Scene snapshot, every offset is from the start of the snapshot:
+//
+//   SnapshotHeader
+//   SnapshotType[type_count]
+//   uint32_t type indices, SnapshotArchetype::type_count per archetype
+//   SnapshotArchetype[archetype_count]
+//   SnapshotRecord[record_count]
+//   per archetype: Entity[entity_count], then one packed array per component, each aligned to SNAPSHOT_ALIGN
+//
+// Component types are matched by ComponentType::hash, which only stays the same for the same build.
+inline constexpr uint32_t SNAPSHOT_MAGIC = 0x504E534A; // 'JSNP'
+inline constexpr uint32_t SNAPSHOT_VERSION = 1;
+inline constexpr uint64_t SNAPSHOT_ALIGN = 64;
+inline constexpr uint32_t SNAPSHOT_NO_ARCHETYPE = UINT32_MAX;
+
+struct SnapshotHeader {
+    uint32_t magic = SNAPSHOT_MAGIC;
+    uint32_t version = SNAPSHOT_VERSION;
+    uint32_t type_count = 0;
+    uint32_t archetype_count = 0;
+    uint64_t record_count = 0;
+    uint64_t types_offset = 0;
+    uint64_t type_indices_offset = 0;
+    uint64_t archetypes_offset = 0;
+    uint64_t records_offset = 0;
+    uint64_t size = 0;
+};
+
+struct SnapshotType {
+    uint64_t hash = 0;
+    uint32_t size = 0;
+    uint32_t align = 0;
+};
+
+struct SnapshotArchetype {
+    uint32_t first_type_index = 0;
+    uint32_t type_count = 0;
+    uint64_t entity_count = 0;
+    // entities, then the columns in the order of the archetype's type indices
+    uint64_t data_offset = 0;
+};
+
+// One per entity index, dead indices have no archetype
+struct SnapshotRecord {
+    uint32_t archetype = SNAPSHOT_NO_ARCHETYPE;
+    uint32_t generation = 1;
+    uint64_t row = 0;
+};
+
+static_assert(sizeof(SnapshotHeader) == 64);
+static_assert(sizeof(SnapshotType) == 16);
+static_assert(sizeof(SnapshotArchetype) == 24);
+static_assert(sizeof(SnapshotRecord) == 16);
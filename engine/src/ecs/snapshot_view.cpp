@@ -0,0 +1,151 @@
+#include "snapshot_view.hpp"
+
+#include <debug.hpp>
+#include <entity.hpp>
+
+#include <cstring>
+
+namespace {
+    auto alignUp(uint64_t value, uint64_t alignment) noexcept -> uint64_t {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+    // tables are read with memcpy, the snapshot may come from a buffer with any alignment
+    template<typename T>
+    auto readAt(std::span<const std::byte> bytes, uint64_t offset) noexcept -> T {
+        auto value = T{};
+        std::memcpy(&value, bytes.data() + offset, sizeof(T));
+        return value;
+    }
+
+    auto inBounds(std::span<const std::byte> bytes, uint64_t offset, uint64_t count, uint64_t stride) noexcept -> bool {
+        return offset <= bytes.size() && count <= (bytes.size() - offset) / stride;
+    }
+}
+
+auto SnapshotView::parse(std::span<const std::byte> bytes) -> std::optional<SnapshotView> {
+    auto logger = Debug{"scene"};
+
+    if (bytes.size() < sizeof(SnapshotHeader)) {
+        logger.error("snapshot is truncated");
+        return std::nullopt;
+    }
+    const auto header = readAt<SnapshotHeader>(bytes, 0);
+    if (header.magic != SNAPSHOT_MAGIC || header.version != SNAPSHOT_VERSION) {
+        logger.error("not a snapshot or unsupported version {}", header.version);
+        return std::nullopt;
+    }
+    if (header.size > bytes.size()
+        || !inBounds(bytes, header.types_offset, header.type_count, sizeof(SnapshotType))
+        || !inBounds(bytes, header.archetypes_offset, header.archetype_count, sizeof(SnapshotArchetype))
+        || !inBounds(bytes, header.records_offset, header.record_count, sizeof(SnapshotRecord))) {
+        logger.error("snapshot tables are out of bounds");
+        return std::nullopt;
+    }
+
+    auto types = std::vector<const ComponentType*>(header.type_count);
+    for (uint32_t i = 0; i < header.type_count; i++) {
+        const auto entry = readAt<SnapshotType>(bytes, header.types_offset + i * sizeof(SnapshotType));
+        types[i] = ComponentType::find(entry.hash);
+        if (types[i] == nullptr) {
+            logger.error("snapshot component {:016x} is not registered", entry.hash);
+            return std::nullopt;
+        }
+        if (types[i]->size != entry.size || types[i]->align != entry.align) {
+            logger.error("snapshot component {} changed layout", types[i]->name);
+            return std::nullopt;
+        }
+    }
+
+    auto view = SnapshotView{};
+    view.tables.resize(header.archetype_count);
+    for (uint32_t i = 0; i < header.archetype_count; i++) {
+        const auto entry = readAt<SnapshotArchetype>(bytes, header.archetypes_offset + i * sizeof(SnapshotArchetype));
+        auto& table = view.tables[i];
+        table.size = entry.entity_count;
+
+        const auto first = uint64_t{entry.first_type_index};
+        if (!inBounds(bytes, header.type_indices_offset + first * sizeof(uint32_t), entry.type_count, sizeof(uint32_t))) {
+            logger.error("snapshot archetype {} is out of bounds", i);
+            return std::nullopt;
+        }
+
+        auto offset = entry.data_offset;
+        if (!inBounds(bytes, offset, entry.entity_count, sizeof(Entity))) {
+            logger.error("snapshot archetype {} data is out of bounds", i);
+            return std::nullopt;
+        }
+        table.entities = bytes.data() + offset;
+        offset += entry.entity_count * sizeof(Entity);
+
+        for (uint32_t t = 0; t < entry.type_count; t++) {
+            const auto index = readAt<uint32_t>(bytes, header.type_indices_offset + (first + t) * sizeof(uint32_t));
+            if (index >= types.size()) {
+                logger.error("snapshot archetype {} refers to unknown type {}", i, index);
+                return std::nullopt;
+            }
+            const auto type = types[index];
+
+            offset = alignUp(offset, SNAPSHOT_ALIGN);
+            if (!inBounds(bytes, offset, entry.entity_count, type->size)) {
+                logger.error("snapshot archetype {} data is out of bounds", i);
+                return std::nullopt;
+            }
+            table.types.emplace_back(type);
+            table.columns.emplace_back(bytes.data() + offset);
+            offset += entry.entity_count * type->size;
+        }
+    }
+
+    if (header.record_count > UINT32_MAX) {
+        logger.error("snapshot has more records than entity indices");
+        return std::nullopt;
+    }
+    view.records = bytes.data() + header.records_offset;
+    view.record_count = header.record_count;
+
+    // Every live record has to point at a row holding its own entity, which also keeps two records from sharing
+    // a row. With as many live records as rows, no row is left without one, so the scene's records and tables
+    // agree once loaded.
+    auto live = size_t{0};
+    for (size_t i = 0; i < view.record_count; i++) {
+        const auto record = view.record(i);
+        if (record.generation == 0) {
+            logger.error("snapshot record {} has generation 0", i);
+            return std::nullopt;
+        }
+        if (record.archetype == SNAPSHOT_NO_ARCHETYPE) {
+            continue;
+        }
+        if (record.archetype >= view.tables.size() || record.row >= view.tables[record.archetype].size) {
+            logger.error("snapshot record {} is invalid", i);
+            return std::nullopt;
+        }
+        const auto& table = view.tables[record.archetype];
+        const auto entity = readAt<Entity>({table.entities, table.size * sizeof(Entity)}, record.row * sizeof(Entity));
+        if (entity != Entity{.index = static_cast<uint32_t>(i), .generation = record.generation}) {
+            logger.error("snapshot record {} points at the row of another entity", i);
+            return std::nullopt;
+        }
+        live++;
+    }
+    if (live != view.entityCount()) {
+        logger.error("snapshot has {} rows that no record points to", view.entityCount() - live);
+        return std::nullopt;
+    }
+    return view;
+}
+
+auto SnapshotView::record(size_t index) const noexcept -> SnapshotRecord {
+    auto record = SnapshotRecord{};
+    std::memcpy(&record, records + index * sizeof(SnapshotRecord), sizeof(SnapshotRecord));
+    return record;
+}
+
+auto SnapshotView::entityCount() const noexcept -> size_t {
+    auto count = size_t{0};
+    for (const auto& table : tables) {
+        count += table.size;
+    }
+    return count;
+}
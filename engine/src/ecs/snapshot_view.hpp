@@ -0,0 +1,41 @@
+#pragma once
+
+#include "component.hpp"
+#include "snapshot_format.hpp"
+
+#include <span>
+#include <vector>
+#include <cstddef>
+#include <optional>
+
+// A validated Scene snapshot with its component types resolved. Nothing is copied, the view points into
+// the bytes it was parsed from. Parsing only touches the tables, so it is cheap and safe on any thread.
+struct SnapshotView {
+    // the entities of one archetype
+    struct Table {
+        std::vector<const ComponentType*> types;
+        size_t size = 0;
+        const std::byte* entities = nullptr;
+        // packed arrays of size elements, in the order of types
+        std::vector<const std::byte*> columns;
+    };
+
+    std::vector<Table> tables;
+
+    // Returns nothing when the snapshot is malformed or refers to a component type this build hasn't registered
+    static auto parse(std::span<const std::byte> bytes) -> std::optional<SnapshotView>;
+
+    [[nodiscard]] auto recordCount() const noexcept -> size_t {
+        return record_count;
+    }
+
+    // SnapshotRecord::archetype indexes tables
+    [[nodiscard]] auto record(size_t index) const noexcept -> SnapshotRecord;
+
+    // number of live entities over every table
+    [[nodiscard]] auto entityCount() const noexcept -> size_t;
+
+private:
+    const std::byte* records = nullptr;
+    size_t record_count = 0;
+};
@@ -0,0 +1,104 @@
+#include "system_scheduler.hpp"
+
+#include <scene.hpp>
+#include <jobs/job_system.hpp>
+
+#include <atomic>
+#include <algorithm>
+
+namespace {
+    auto intersects(const std::vector<ComponentId>& a, const std::vector<ComponentId>& b) -> bool {
+        return std::any_of(a.begin(), a.end(), [&b](ComponentId id) {
+            return std::find(b.begin(), b.end(), id) != b.end();
+        });
+    }
+}
+
+auto SystemAccess::conflicts(const SystemAccess& other) const noexcept -> bool {
+    return intersects(writes, other.writes) || intersects(writes, other.reads) || intersects(reads, other.writes);
+}
+
+struct SystemScheduler::Impl {
+    struct System {
+        std::string name;
+        SystemAccess access;
+        SystemFn fn;
+        std::vector<size_t> dependents;
+        size_t dependencies = 0;
+    };
+
+    std::vector<System> systems;
+    std::unique_ptr<std::atomic<size_t>[]> counters;
+    bool dirty = true;
+
+    void rebuild() {
+        for (auto& system : systems) {
+            system.dependents.clear();
+            system.dependencies = 0;
+        }
+        for (size_t i = 0; i < systems.size(); i++) {
+            for (size_t j = i + 1; j < systems.size(); j++) {
+                if (systems[i].access.conflicts(systems[j].access)) {
+                    systems[i].dependents.emplace_back(j);
+                    systems[j].dependencies++;
+                }
+            }
+        }
+        counters = std::make_unique<std::atomic<size_t>[]>(systems.size());
+        dirty = false;
+    }
+};
+
+void SystemContext::parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& fn) {
+    JobSystem::parallelFor(count, grain, fn);
+}
+
+SystemScheduler::SystemScheduler(Scene& scene) : scene(scene) {
+    impl = std::make_unique<Impl>();
+}
+
+SystemScheduler::~SystemScheduler() = default;
+
+void SystemScheduler::addSystem(std::string name, SystemAccess access, SystemFn fn) {
+    impl->systems.emplace_back(Impl::System{
+        .name = std::move(name),
+        .access = std::move(access),
+        .fn = std::move(fn)
+    });
+    impl->dirty = true;
+}
+
+void SystemScheduler::run() {
+    if (impl->systems.empty()) {
+        return;
+    }
+    if (impl->dirty) {
+        impl->rebuild();
+    }
+
+    for (size_t i = 0; i < impl->systems.size(); i++) {
+        impl->counters[i].store(impl->systems[i].dependencies, std::memory_order_relaxed);
+    }
+
+    // systems become children of the group as their dependencies finish, so waiting on it covers all of them
+    const auto group = JobSystem::beginGroup();
+    for (size_t i = 0; i < impl->systems.size(); i++) {
+        if (impl->systems[i].dependencies == 0) {
+            JobSystem::scheduleChild(group, [this, group, i] { _execute(group, i); });
+        }
+    }
+    JobSystem::endGroup(group);
+    JobSystem::wait(group);
+}
+
+void SystemScheduler::_execute(JobHandle group, size_t index) {
+    auto& system = impl->systems[index];
+    auto context = SystemContext(scene);
+    system.fn(context);
+
+    for (const auto dependent : system.dependents) {
+        if (impl->counters[dependent].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            JobSystem::scheduleChild(group, [this, group, dependent] { _execute(group, dependent); });
+        }
+    }
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "component.hpp"
+#include "query.hpp"
+
+#include <jobs/job_system.hpp>
+
+#include <string>
+#include <memory>
+#include <vector>
+#include <functional>
+#include <type_traits>
+
+struct Scene;
+
+// Components a system touches. Systems that don't write anything the other one reads or writes may run concurrently.
+struct SystemAccess {
+    std::vector<ComponentId> reads;
+    std::vector<ComponentId> writes;
+
+    // `const T` is a read, `T` is a write
+    template<typename... Ts>
+    static auto of() -> SystemAccess {
+        auto access = SystemAccess{};
+        (access.template _add<Ts>(), ...);
+        return access;
+    }
+
+    [[nodiscard]] auto conflicts(const SystemAccess& other) const noexcept -> bool;
+
+private:
+    template<typename T>
+    void _add() {
+        if constexpr (std::is_const_v<T>) {
+            reads.emplace_back(ComponentType::of<T>().id);
+        } else {
+            writes.emplace_back(ComponentType::of<T>().id);
+        }
+    }
+};
+
+struct SystemContext {
+    Scene& scene;
+
+    // Calls fn(begin, end) for sub-ranges of [0, count) on the job system and returns when all are done
+    void parallelFor(size_t count, size_t grain, const std::function<void(size_t begin, size_t end)>& fn);
+
+    // Splits the query into chunks and runs fn over every row on the worker threads
+    template<typename... Ts, typename Fn>
+    void parallelEach(Query<Ts...>& query, Fn&& fn) {
+        auto chunks = std::vector<QueryChunk<Ts...>>{};
+        query.chunks(chunks);
+        parallelFor(chunks.size(), 1, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                chunks[i].each(fn);
+            }
+        });
+    }
+
+private:
+    friend struct SystemScheduler;
+
+    explicit SystemContext(Scene& scene) : scene(scene) {}
+};
+
+// Runs systems over a Scene once per run() call. Systems are ordered by registration; a system waits only for
+// earlier systems whose access conflicts with its own, everything else runs concurrently on the JobSystem.
+// Systems must not create or destroy entities or add or remove components while the scheduler runs.
+struct SystemScheduler {
+    struct Impl;
+
+    using SystemFn = std::function<void(SystemContext&)>;
+
+    explicit SystemScheduler(Scene& scene);
+    ~SystemScheduler();
+
+    void addSystem(std::string name, SystemAccess access, SystemFn fn);
+
+    template<typename... Ts>
+    void addSystem(std::string name, SystemFn fn) {
+        addSystem(std::move(name), SystemAccess::of<Ts...>(), std::move(fn));
+    }
+
+    void run();
+
+private:
+    friend struct SystemContext;
+
+    void _execute(JobHandle group, size_t index);
+
+    Scene& scene;
+    std::unique_ptr<Impl> impl;
+};
@@ -3,11 +3,24 @@
 #include <debug.hpp>
 
 #include <app.hpp>
+#include <snapshot_buffer.hpp>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <chrono>
 #include <iostream>
 #include <optional>
+#include <algorithm>
 #include <vk_mem_alloc.hpp>
 #include <vulkan/vulkan.hpp>
 #include <input/input_system.hpp>
+#include <render/render_queue.hpp>
+#include <render/sprite_batch.hpp>
+#include <render/dynamic_resolution.hpp>
+#include <render/render_context.hpp>
+#include <spatial/spatial_index.hpp>
+#include <memory/memory_system.hpp>
+#include <resources/resource_system.hpp>
 
 #include <imgui.h>
 #include <imgui_layer.hpp>
@@ -50,10 +63,33 @@ namespace vk {
     VULKAN_HPP_STORAGE_API DispatchLoaderDynamic defaultDispatchLoaderDynamic;
 }
 
+namespace {
+    VKAPI_ATTR auto VKAPI_CALL vulkanAllocate(void*, size_t size, size_t alignment, VkSystemAllocationScope) -> void* {
+        return MemorySystem::heap().allocate(size, alignment);
+    }
+
+    VKAPI_ATTR auto VKAPI_CALL vulkanReallocate(void*, void* ptr, size_t size, size_t alignment, VkSystemAllocationScope) -> void* {
+        return MemorySystem::heap().reallocate(ptr, size, alignment);
+    }
+
+    VKAPI_ATTR void VKAPI_CALL vulkanFree(void*, void* ptr) {
+        MemorySystem::heap().release(ptr);
+    }
+
+    const auto vulkan_allocation_callbacks = VkAllocationCallbacks{
+        .pUserData = nullptr,
+        .pfnAllocation = vulkanAllocate,
+        .pfnReallocation = vulkanReallocate,
+        .pfnFree = vulkanFree,
+        .pfnInternalAllocation = nullptr,
+        .pfnInternalFree = nullptr
+    };
+}
+
 struct JellyEngine::Impl {
     Debug logger{"engine"};
     Display display{"Engine"};
-    ImGuiLayer ui{};
+    ImGuiLayer ui{MemorySystem::imguiAllocate, MemorySystem::imguiFree};
 
     VmaAllocator allocator;
 
@@ -68,6 +104,11 @@ struct JellyEngine::Impl {
     uint32_t graphics_family;
     uint32_t present_family;
 
+    bool multi_draw_indirect = false;
+    bool draw_indirect_first_instance = false;
+    bool draw_indirect_count = false;
+    bool image_cube_array = false;
+
     vk::Queue graphics_queue;
     vk::Queue present_queue;
 
@@ -84,12 +125,74 @@ struct JellyEngine::Impl {
     std::vector<vk::Semaphore> complete_semaphores;
 
     std::vector<vk::CommandPool> cmd_pools;
+    std::vector<vk::CommandBuffer> cmd_buffers;
+
+    // multisampled color and depth, shared by every frame. They never leave the render pass, so on tilers
+    // they live in lazily allocated memory that is never backed
+    vk::SampleCountFlagBits samples = vk::SampleCountFlagBits::e1;
+    vk::Format depth_format = vk::Format::eUndefined;
+    vk::Image color_image;
+    VmaAllocation color_allocation = nullptr;
+    vk::ImageView color_view;
+    vk::Image depth_image;
+    VmaAllocation depth_allocation = nullptr;
+    vk::ImageView depth_view;
 
     vk::RenderPass pass;
     std::vector<vk::Framebuffer> framebuffers;
 
+    // Below full resolution the main pass renders into scene_image through offscreen_pass, which is compatible
+    // with pass, and the result is blitted into the swapchain image
+    std::optional<DynamicResolution> dynamic_resolution;
+    vk::Extent2D render_extent;
+    vk::RenderPass offscreen_pass;
+    vk::Image scene_image;
+    VmaAllocation scene_allocation = nullptr;
+    vk::ImageView scene_view;
+    vk::Framebuffer scene_framebuffer;
+    vk::Filter upscale_filter = vk::Filter::eLinear;
+
+    // a pair of timestamps around every frame's commands
+    vk::QueryPool timestamps;
+    double timestamp_period = 0.0;
+    // bits above the queue's timestampValidBits are undefined
+    uint64_t timestamp_mask = 0;
+    std::vector<bool> timestamps_written;
+    double gpu_frame_ms = 0.0;
+    // update, recording and submission, without the waits on the GPU and the display
+    double cpu_frame_ms = 0.0;
+
+    // time between the ends of the last two frames, waits included
+    double frame_ms = 0.0;
+
+    std::optional<FrameStats> benchmark;
+    uint32_t benchmark_warmup = 0;
+    std::filesystem::path benchmark_output;
+    uint64_t benchmark_frame = 0;
+
+    std::optional<FrameGovernor> governor;
+    std::function<std::optional<float>()> thermal_source;
+    std::chrono::steady_clock::time_point next_frame;
+    std::chrono::steady_clock::time_point last_governed;
+    std::chrono::steady_clock::time_point next_thermal;
+
     size_t current_frame = 0;
 
+    RenderQueue render_queue;
+    SpatialIndex spatial;
+    std::vector<Entity> visible;
+    RenderContext render_context;
+    std::unique_ptr<SpriteBatch> sprites;
+
+    std::chrono::steady_clock::duration fixed_step{};
+    bool fixed_threaded = true;
+    std::chrono::steady_clock::time_point next_tick{};
+    std::thread simulation;
+    std::atomic<bool> simulating = false;
+    // held by the simulation thread while it ticks, so the frame arena isn't reset and the state isn't saved under it
+    std::mutex simulation_mutex;
+    SnapshotChannel* snapshots = nullptr;
+
     /*******************************************************************************************/
 //    std::unique_ptr<JellyLayer> layer;
 
@@ -101,9 +204,20 @@ struct JellyEngine::Impl {
     void _createAllocator();
     void _createDebugUtils();
     void _createSwapchain();
-    void _createRenderPass();
+    void _createAttachments();
+    auto _createRenderPass(vk::ImageLayout final_layout) -> vk::RenderPass;
     void _createFrameBuffers();
     void _createCommandPools();
+    void _createTimestamps();
+    auto _createOffscreenTarget() -> bool;
+    void _measureFrame(uint32_t image_index);
+    void _upscale(vk::CommandBuffer cmd, uint32_t image_index);
+    void _pace();
+    void _govern();
+    void _recordFrame();
+    void _cull();
+    auto _benchmarkDone() const noexcept -> bool;
+    void _reportBenchmark();
     auto _findQueueFamilies(vk::PhysicalDevice device) -> std::optional<std::pair<uint32_t, uint32_t>>;
     auto _selectSurfaceExtent(
         const vk::Extent2D &extent,
@@ -119,6 +233,12 @@ struct JellyEngine::Impl {
         vk::ArrayProxy<const vk::PresentModeKHR> request_modes
     ) -> vk::PresentModeKHR;
     auto _getImageCountFromPresentMode(vk::PresentModeKHR mode) -> uint32_t;
+    auto _selectDepthFormat() -> vk::Format;
+    auto _createTransientImage(vk::Format format, vk::ImageUsageFlags usage, vk::ImageAspectFlags aspect, vk::Image& image, VmaAllocation& allocation) -> vk::ImageView;
+
+    void _startSimulation(AppMain& app);
+    void _stopSimulation();
+    void _tick(AppMain& app);
 
     static VKAPI_ATTR auto VKAPI_CALL _debugCallback(
         VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity,
@@ -138,9 +258,11 @@ void JellyEngine::Impl::_initVulkan() {
     _createAllocator();
     _createDebugUtils();
     _createSwapchain();
-    _createRenderPass();
+    _createAttachments();
+    pass = _createRenderPass(vk::ImageLayout::ePresentSrcKHR);
     _createFrameBuffers();
     _createCommandPools();
+    _createTimestamps();
 }
 
 void JellyEngine::Impl::_createInstance() {
@@ -210,10 +332,43 @@ void JellyEngine::Impl::_createLogicalDevice() {
         VK_KHR_GET_MEMORY_REQUIREMENTS_2_EXTENSION_NAME
     };
 
-    const auto features = vk::PhysicalDeviceFeatures {
-        .fillModeNonSolid = true,
-        .samplerAnisotropy = true
-    };
+    // the indirect draw features and cube map arrays are enabled where supported, RenderContext reports which ones
+    // made it. So are the compressed texture formats, which TextureLoader checks per format.
+    auto features = vk::StructureChain<
+        vk::PhysicalDeviceFeatures2,
+        vk::PhysicalDeviceVulkan12Features
+    >{};
+    auto& core = features.get<vk::PhysicalDeviceFeatures2>().features;
+    core.fillModeNonSolid = true;
+    core.samplerAnisotropy = true;
+
+    if (gpu.getProperties().apiVersion >= VK_API_VERSION_1_2) {
+        const auto supported = gpu.getFeatures2<
+            vk::PhysicalDeviceFeatures2,
+            vk::PhysicalDeviceVulkan12Features
+        >();
+        core.multiDrawIndirect = supported.get<vk::PhysicalDeviceFeatures2>().features.multiDrawIndirect;
+        core.drawIndirectFirstInstance = supported.get<vk::PhysicalDeviceFeatures2>().features.drawIndirectFirstInstance;
+        core.textureCompressionBC = supported.get<vk::PhysicalDeviceFeatures2>().features.textureCompressionBC;
+        core.textureCompressionETC2 = supported.get<vk::PhysicalDeviceFeatures2>().features.textureCompressionETC2;
+        core.textureCompressionASTC_LDR = supported.get<vk::PhysicalDeviceFeatures2>().features.textureCompressionASTC_LDR;
+        core.imageCubeArray = supported.get<vk::PhysicalDeviceFeatures2>().features.imageCubeArray;
+        features.get<vk::PhysicalDeviceVulkan12Features>().drawIndirectCount = supported.get<vk::PhysicalDeviceVulkan12Features>().drawIndirectCount;
+        draw_indirect_count = supported.get<vk::PhysicalDeviceVulkan12Features>().drawIndirectCount;
+    } else {
+        const auto supported = gpu.getFeatures();
+        core.multiDrawIndirect = supported.multiDrawIndirect;
+        core.drawIndirectFirstInstance = supported.drawIndirectFirstInstance;
+        core.textureCompressionBC = supported.textureCompressionBC;
+        core.textureCompressionETC2 = supported.textureCompressionETC2;
+        core.textureCompressionASTC_LDR = supported.textureCompressionASTC_LDR;
+        core.imageCubeArray = supported.imageCubeArray;
+        features.unlink<vk::PhysicalDeviceVulkan12Features>();
+    }
+
+    multi_draw_indirect = core.multiDrawIndirect;
+    draw_indirect_first_instance = core.drawIndirectFirstInstance;
+    image_cube_array = core.imageCubeArray;
 
     const auto priorities = std::array{
         1.0f
@@ -237,13 +392,14 @@ void JellyEngine::Impl::_createLogicalDevice() {
     }
 
     const auto info = vk::DeviceCreateInfo{
+        .pNext = &features.get<vk::PhysicalDeviceFeatures2>(),
         .queueCreateInfoCount = static_cast<uint32_t>(std::size(infos)),
         .pQueueCreateInfos = std::data(infos),
         .enabledLayerCount = static_cast<uint32_t>(std::size(layers)),
         .ppEnabledLayerNames = std::data(layers),
         .enabledExtensionCount = static_cast<uint32_t>(std::size(extensions)),
         .ppEnabledExtensionNames = std::data(extensions),
-        .pEnabledFeatures = &features
+        .pEnabledFeatures = nullptr
     };
 
     device = gpu.createDevice(info, nullptr);
@@ -293,6 +449,7 @@ void JellyEngine::Impl::_createAllocator() {
         .flags = {},
         .physicalDevice = gpu,
         .device = device,
+        .pAllocationCallbacks = &vulkan_allocation_callbacks,
         .pVulkanFunctions = &functions,
         .instance = instance,
         .vulkanApiVersion = VK_API_VERSION_1_2
@@ -356,7 +513,8 @@ void JellyEngine::Impl::_createSwapchain() {
         .imageColorSpace = surface_format.colorSpace,
         .imageExtent = surface_extent,
         .imageArrayLayers = 1,
-        .imageUsage = vk::ImageUsageFlagBits::eColorAttachment,
+        // blitted into when dynamic resolution renders below the surface size
+        .imageUsage = vk::ImageUsageFlagBits::eColorAttachment | (capabilities.supportedUsageFlags & vk::ImageUsageFlagBits::eTransferDst),
         .imageSharingMode = queue_family_indices.size() == 1
                             ? vk::SharingMode::eExclusive
                             : vk::SharingMode::eConcurrent,
@@ -405,19 +563,74 @@ void JellyEngine::Impl::_createSwapchain() {
     }
 }
 
-void JellyEngine::Impl::_createRenderPass() {
-    const auto attachments = std::array{
+void JellyEngine::Impl::_createAttachments() {
+    static constexpr auto MSAA_SAMPLES = vk::SampleCountFlagBits::e4;
+
+    const auto limits = gpu.getProperties().limits;
+    const auto supported = limits.framebufferColorSampleCounts & limits.framebufferDepthSampleCounts;
+    samples = (supported & MSAA_SAMPLES) ? MSAA_SAMPLES : vk::SampleCountFlagBits::e1;
+    depth_format = _selectDepthFormat();
+
+    if (samples != vk::SampleCountFlagBits::e1) {
+        color_view = _createTransientImage(
+            surface_format.format,
+            vk::ImageUsageFlagBits::eColorAttachment,
+            vk::ImageAspectFlagBits::eColor,
+            color_image,
+            color_allocation
+        );
+    }
+
+    const auto has_stencil = depth_format == vk::Format::eD24UnormS8Uint || depth_format == vk::Format::eD32SfloatS8Uint;
+    depth_view = _createTransientImage(
+        depth_format,
+        vk::ImageUsageFlagBits::eDepthStencilAttachment,
+        has_stencil ? vk::ImageAspectFlagBits::eDepth | vk::ImageAspectFlagBits::eStencil : vk::ImageAspectFlagBits::eDepth,
+        depth_image,
+        depth_allocation
+    );
+}
+
+// final_layout is the layout the swapchain image or scene_image is left in, render passes that only differ in it
+// are compatible and share pipelines
+auto JellyEngine::Impl::_createRenderPass(vk::ImageLayout final_layout) -> vk::RenderPass {
+    const auto msaa = samples != vk::SampleCountFlagBits::e1;
+
+    // with msaa the samples are resolved into the swapchain image at the end of the subpass and never stored
+    auto attachments = std::vector{
         vk::AttachmentDescription{
             .format = surface_format.format,
-            .samples = vk::SampleCountFlagBits::e1,
+            .samples = samples,
             .loadOp = vk::AttachmentLoadOp::eClear,
-            .storeOp = vk::AttachmentStoreOp::eStore,
+            .storeOp = msaa ? vk::AttachmentStoreOp::eDontCare : vk::AttachmentStoreOp::eStore,
             .stencilLoadOp = vk::AttachmentLoadOp::eDontCare,
             .stencilStoreOp = vk::AttachmentStoreOp::eDontCare,
             .initialLayout = vk::ImageLayout::eUndefined,
-            .finalLayout = vk::ImageLayout::ePresentSrcKHR
+            .finalLayout = msaa ? vk::ImageLayout::eColorAttachmentOptimal : final_layout
+        },
+        vk::AttachmentDescription{
+            .format = depth_format,
+            .samples = samples,
+            .loadOp = vk::AttachmentLoadOp::eClear,
+            .storeOp = vk::AttachmentStoreOp::eDontCare,
+            .stencilLoadOp = vk::AttachmentLoadOp::eClear,
+            .stencilStoreOp = vk::AttachmentStoreOp::eDontCare,
+            .initialLayout = vk::ImageLayout::eUndefined,
+            .finalLayout = vk::ImageLayout::eDepthStencilAttachmentOptimal
         }
     };
+    if (msaa) {
+        attachments.emplace_back(vk::AttachmentDescription{
+            .format = surface_format.format,
+            .samples = vk::SampleCountFlagBits::e1,
+            .loadOp = vk::AttachmentLoadOp::eDontCare,
+            .storeOp = vk::AttachmentStoreOp::eStore,
+            .stencilLoadOp = vk::AttachmentLoadOp::eDontCare,
+            .stencilStoreOp = vk::AttachmentStoreOp::eDontCare,
+            .initialLayout = vk::ImageLayout::eUndefined,
+            .finalLayout = final_layout
+        });
+    }
 
     const auto color_attachments = std::array {
         vk::AttachmentReference{
@@ -426,6 +639,18 @@ void JellyEngine::Impl::_createRenderPass() {
         }
     };
 
+    const auto resolve_attachments = std::array {
+        vk::AttachmentReference{
+            .attachment = 2,
+            .layout = vk::ImageLayout::eColorAttachmentOptimal
+        }
+    };
+
+    const auto depth_attachment = vk::AttachmentReference{
+        .attachment = 1,
+        .layout = vk::ImageLayout::eDepthStencilAttachmentOptimal
+    };
+
     const auto subpasses = std::array {
         vk::SubpassDescription{
             .pipelineBindPoint = vk::PipelineBindPoint::eGraphics,
@@ -433,32 +658,52 @@ void JellyEngine::Impl::_createRenderPass() {
             .pInputAttachments = nullptr,
             .colorAttachmentCount = static_cast<uint32_t>(color_attachments.size()),
             .pColorAttachments = color_attachments.data(),
-            .pResolveAttachments = nullptr,
-            .pDepthStencilAttachment = nullptr,
+            .pResolveAttachments = msaa ? resolve_attachments.data() : nullptr,
+            .pDepthStencilAttachment = &depth_attachment,
             .preserveAttachmentCount = 0,
             .pPreserveAttachments = nullptr
         }
     };
 
+    // the attachments are shared between frames, so a frame's writes wait for the previous frame's writes
+    // and, for scene_image, its upscale
+    const auto attachment_stages = vk::PipelineStageFlagBits::eColorAttachmentOutput
+        | vk::PipelineStageFlagBits::eEarlyFragmentTests
+        | vk::PipelineStageFlagBits::eLateFragmentTests;
+    const auto dependencies = std::array {
+        vk::SubpassDependency{
+            .srcSubpass = VK_SUBPASS_EXTERNAL,
+            .dstSubpass = 0,
+            .srcStageMask = attachment_stages | vk::PipelineStageFlagBits::eTransfer,
+            .dstStageMask = attachment_stages,
+            .srcAccessMask = vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eDepthStencilAttachmentWrite,
+            .dstAccessMask = vk::AccessFlagBits::eColorAttachmentRead
+                | vk::AccessFlagBits::eColorAttachmentWrite
+                | vk::AccessFlagBits::eDepthStencilAttachmentRead
+                | vk::AccessFlagBits::eDepthStencilAttachmentWrite
+        }
+    };
+
     const auto info = vk::RenderPassCreateInfo{
-        .attachmentCount = attachments.size(),
+        .attachmentCount = static_cast<uint32_t>(attachments.size()),
         .pAttachments = attachments.data(),
         .subpassCount = subpasses.size(),
         .pSubpasses = subpasses.data(),
-        .dependencyCount = 0,
-        .pDependencies = nullptr
+        .dependencyCount = dependencies.size(),
+        .pDependencies = dependencies.data()
     };
-    pass = device.createRenderPass(info);
+    return device.createRenderPass(info);
 }
 
 void JellyEngine::Impl::_createFrameBuffers() {
     for (auto view : swapchain_views) {
-        const auto attachments = std::array{
-            view
-        };
+        auto attachments = std::vector{view, depth_view};
+        if (samples != vk::SampleCountFlagBits::e1) {
+            attachments = {color_view, depth_view, view};
+        }
         const auto info = vk::FramebufferCreateInfo{
             .renderPass = pass,
-            .attachmentCount = attachments.size(),
+            .attachmentCount = static_cast<uint32_t>(attachments.size()),
             .pAttachments = attachments.data(),
             .width = static_cast<uint32_t>(surface_extent.width),
             .height = static_cast<uint32_t>(surface_extent.height),
@@ -473,10 +718,282 @@ void JellyEngine::Impl::_createCommandPools() {
     for (const auto image : swapchain_images) {
         const auto info = vk::CommandPoolCreateInfo{
             .pNext = nullptr,
-            .flags = vk::CommandPoolCreateFlagBits::eResetCommandBuffer,
+            .flags = vk::CommandPoolCreateFlagBits::eTransient,
             .queueFamilyIndex = graphics_family,
         };
         cmd_pools.emplace_back(device.createCommandPool(info));
+
+        // allocated once and recycled by resetting the pool, so recording a frame doesn't allocate
+        const auto cmd_info = vk::CommandBufferAllocateInfo{
+            .commandPool = cmd_pools.back(),
+            .level = vk::CommandBufferLevel::ePrimary,
+            .commandBufferCount = 1
+        };
+        auto cmd = vk::CommandBuffer{};
+        static_cast<void>(device.allocateCommandBuffers(&cmd_info, &cmd));
+        cmd_buffers.emplace_back(cmd);
+    }
+}
+
+void JellyEngine::Impl::_createTimestamps() {
+    const auto valid_bits = gpu.getQueueFamilyProperties()[graphics_family].timestampValidBits;
+    if (valid_bits == 0) {
+        logger.info("graphics queue has no timestamps, gpu frame times are not measured");
+        return;
+    }
+    timestamp_mask = valid_bits >= 64 ? ~uint64_t{0} : (uint64_t{1} << valid_bits) - 1;
+    timestamp_period = gpu.getProperties().limits.timestampPeriod;
+    timestamps = device.createQueryPool(vk::QueryPoolCreateInfo{
+        .queryType = vk::QueryType::eTimestamp,
+        .queryCount = 2 * static_cast<uint32_t>(swapchain_images.size())
+    });
+    timestamps_written.assign(swapchain_images.size(), false);
+}
+
+auto JellyEngine::Impl::_createOffscreenTarget() -> bool {
+    const auto features = gpu.getFormatProperties(surface_format.format).optimalTilingFeatures;
+    const auto usage = gpu.getSurfaceCapabilitiesKHR(surface).supportedUsageFlags;
+    if (!(features & vk::FormatFeatureFlagBits::eBlitSrc) || !(features & vk::FormatFeatureFlagBits::eBlitDst) || !(usage & vk::ImageUsageFlagBits::eTransferDst)) {
+        logger.warn("swapchain images can't be blitted to, dynamic resolution is off");
+        return false;
+    }
+    if (!timestamps) {
+        logger.warn("gpu frame times can't be measured, dynamic resolution is off");
+        return false;
+    }
+    upscale_filter = (features & vk::FormatFeatureFlagBits::eSampledImageFilterLinear) ? vk::Filter::eLinear : vk::Filter::eNearest;
+
+    const auto image_info = static_cast<VkImageCreateInfo>(vk::ImageCreateInfo{
+        .imageType = vk::ImageType::e2D,
+        .format = surface_format.format,
+        .extent = {surface_extent.width, surface_extent.height, 1},
+        .mipLevels = 1,
+        .arrayLayers = 1,
+        .samples = vk::SampleCountFlagBits::e1,
+        .tiling = vk::ImageTiling::eOptimal,
+        .usage = vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransferSrc,
+        .sharingMode = vk::SharingMode::eExclusive,
+        .initialLayout = vk::ImageLayout::eUndefined
+    });
+    const auto allocation_info = VmaAllocationCreateInfo{
+        .usage = VMA_MEMORY_USAGE_GPU_ONLY
+    };
+    auto image = VkImage{};
+    if (vmaCreateImage(allocator, &image_info, &allocation_info, &image, &scene_allocation, nullptr) != VK_SUCCESS) {
+        logger.error("could not allocate the offscreen target, dynamic resolution is off");
+        return false;
+    }
+    scene_image = image;
+    scene_view = device.createImageView(vk::ImageViewCreateInfo{
+        .image = scene_image,
+        .viewType = vk::ImageViewType::e2D,
+        .format = surface_format.format,
+        .subresourceRange = {
+            .aspectMask = vk::ImageAspectFlagBits::eColor,
+            .baseMipLevel = 0,
+            .levelCount = 1,
+            .baseArrayLayer = 0,
+            .layerCount = 1
+        }
+    });
+
+    offscreen_pass = _createRenderPass(vk::ImageLayout::eTransferSrcOptimal);
+
+    auto attachments = std::vector{scene_view, depth_view};
+    if (samples != vk::SampleCountFlagBits::e1) {
+        attachments = {color_view, depth_view, scene_view};
+    }
+    scene_framebuffer = device.createFramebuffer(vk::FramebufferCreateInfo{
+        .renderPass = offscreen_pass,
+        .attachmentCount = static_cast<uint32_t>(attachments.size()),
+        .pAttachments = attachments.data(),
+        .width = surface_extent.width,
+        .height = surface_extent.height,
+        .layers = 1
+    });
+    return true;
+}
+
+// Reads the timestamps the last frame on this swapchain image wrote, they are done by the time its image
+// comes back from acquire. The measured time picks the scale of the frame about to be recorded.
+void JellyEngine::Impl::_measureFrame(uint32_t image_index) {
+    if (!timestamps || !timestamps_written[image_index]) {
+        return;
+    }
+    auto ticks = std::array<uint64_t, 2>{};
+    const auto result = device.getQueryPoolResults(
+        timestamps,
+        image_index * 2,
+        2,
+        sizeof(ticks),
+        ticks.data(),
+        sizeof(uint64_t),
+        vk::QueryResultFlagBits::e64
+    );
+    if (result != vk::Result::eSuccess) {
+        return;
+    }
+    // masking the difference again keeps it right when the counter wrapped between the two
+    const auto elapsed = ((ticks[1] & timestamp_mask) - (ticks[0] & timestamp_mask)) & timestamp_mask;
+    gpu_frame_ms = static_cast<double>(elapsed) * timestamp_period * 1e-6;
+
+    if (dynamic_resolution) {
+        const auto scale = dynamic_resolution->update(gpu_frame_ms);
+        render_extent = vk::Extent2D{
+            std::clamp(static_cast<uint32_t>(static_cast<float>(surface_extent.width) * scale), 1u, surface_extent.width),
+            std::clamp(static_cast<uint32_t>(static_cast<float>(surface_extent.height) * scale), 1u, surface_extent.height)
+        };
+    }
+}
+
+void JellyEngine::Impl::_upscale(vk::CommandBuffer cmd, uint32_t image_index) {
+    const auto range = vk::ImageSubresourceRange{
+        .aspectMask = vk::ImageAspectFlagBits::eColor,
+        .baseMipLevel = 0,
+        .levelCount = 1,
+        .baseArrayLayer = 0,
+        .layerCount = 1
+    };
+    const auto layers = vk::ImageSubresourceLayers{
+        .aspectMask = vk::ImageAspectFlagBits::eColor,
+        .mipLevel = 0,
+        .baseArrayLayer = 0,
+        .layerCount = 1
+    };
+
+    // the acquire semaphore is waited on at the transfer stage as well
+    const auto to_transfer = vk::ImageMemoryBarrier{
+        .srcAccessMask = {},
+        .dstAccessMask = vk::AccessFlagBits::eTransferWrite,
+        .oldLayout = vk::ImageLayout::eUndefined,
+        .newLayout = vk::ImageLayout::eTransferDstOptimal,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = swapchain_images[image_index],
+        .subresourceRange = range
+    };
+    cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer, {}, nullptr, nullptr, to_transfer);
+
+    const auto blit = vk::ImageBlit{
+        .srcSubresource = layers,
+        .srcOffsets = std::array{
+            vk::Offset3D{0, 0, 0},
+            vk::Offset3D{static_cast<int32_t>(render_extent.width), static_cast<int32_t>(render_extent.height), 1}
+        },
+        .dstSubresource = layers,
+        .dstOffsets = std::array{
+            vk::Offset3D{0, 0, 0},
+            vk::Offset3D{static_cast<int32_t>(surface_extent.width), static_cast<int32_t>(surface_extent.height), 1}
+        }
+    };
+    cmd.blitImage(
+        scene_image,
+        vk::ImageLayout::eTransferSrcOptimal,
+        swapchain_images[image_index],
+        vk::ImageLayout::eTransferDstOptimal,
+        blit,
+        upscale_filter
+    );
+
+    const auto to_present = vk::ImageMemoryBarrier{
+        .srcAccessMask = vk::AccessFlagBits::eTransferWrite,
+        .dstAccessMask = {},
+        .oldLayout = vk::ImageLayout::eTransferDstOptimal,
+        .newLayout = vk::ImageLayout::ePresentSrcKHR,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = swapchain_images[image_index],
+        .subresourceRange = range
+    };
+    cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eBottomOfPipe, {}, nullptr, nullptr, to_present);
+}
+
+// Sleeps until the next frame is due at the governor's rate. Frames keep to a fixed cadence as long as they
+// are on time; one that is later than a whole interval starts the cadence over.
+void JellyEngine::Impl::_pace() {
+    if (!governor || governor->policy().target_fps <= 0.0) {
+        return;
+    }
+    const auto interval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(1.0 / governor->policy().target_fps)
+    );
+    auto now = std::chrono::steady_clock::now();
+    if (now < next_frame) {
+        std::this_thread::sleep_until(next_frame);
+        now = next_frame;
+    }
+    next_frame += interval;
+    if (next_frame <= now) {
+        next_frame = now + interval;
+    }
+}
+
+void JellyEngine::Impl::_govern() {
+    const auto now = std::chrono::steady_clock::now();
+    const auto dt = std::chrono::duration<double>(now - last_governed).count();
+    last_governed = now;
+    frame_ms = dt * 1000.0;
+    if (!governor) {
+        return;
+    }
+
+    auto sample = FrameGovernor::Sample{
+        .dt = std::min(dt, 1.0),
+        .cpu_ms = cpu_frame_ms,
+        .gpu_ms = gpu_frame_ms
+    };
+    if (now >= next_thermal) {
+        sample.thermal = thermal_source ? thermal_source() : display.thermalHeadroom();
+        next_thermal = now + std::chrono::seconds(1);
+    }
+
+    const auto previous = governor->policy();
+    const auto& policy = governor->update(sample);
+    if (policy.target_fps != previous.target_fps || policy.quality_tier != previous.quality_tier) {
+        logger.info("frame governor: {} fps, quality tier {}", policy.target_fps, policy.quality_tier);
+    }
+    render_context.quality_tier = policy.quality_tier;
+}
+
+// Collects the entities of the spatial index inside the camera's frustum into visible, for the frame about to
+// be recorded. Without a camera nothing is culled and visible stays empty.
+void JellyEngine::Impl::_cull() {
+    visible.clear();
+    if (render_context.camera) {
+        spatial.cullFrustum(Frustum::fromMatrix(*render_context.camera), visible);
+    }
+    render_context.visible = visible;
+}
+
+// Timings of the frame just presented. The GPU time comes from the last frame that used the same swapchain
+// image, so the warmup also covers the first round of images that have nothing measured yet.
+void JellyEngine::Impl::_recordFrame() {
+    if (!benchmark) {
+        return;
+    }
+    if (++benchmark_frame <= benchmark_warmup) {
+        return;
+    }
+    benchmark->record(FrameStats::Frame{
+        .frame_ms = frame_ms,
+        .cpu_ms = cpu_frame_ms,
+        .gpu_ms = gpu_frame_ms
+    });
+}
+
+auto JellyEngine::Impl::_benchmarkDone() const noexcept -> bool {
+    return benchmark && benchmark->full();
+}
+
+// also runs when the display closes early, with however many frames were recorded
+void JellyEngine::Impl::_reportBenchmark() {
+    const auto summary = benchmark->summarize();
+    logger.info(
+        "benchmark: {} frames, frame p50 {:.2f} p99 {:.2f} max {:.2f} ms, cpu p50 {:.2f} ms, gpu p50 {:.2f} ms, {} hitches",
+        summary.frames, summary.frame.p50, summary.frame.p99, summary.frame.max, summary.cpu.p50, summary.gpu.p50, summary.hitches
+    );
+    if (benchmark->write(benchmark_output)) {
+        logger.info("benchmark results written to {}", benchmark_output.string());
     }
 }
 
@@ -576,6 +1093,72 @@ auto JellyEngine::Impl::_getImageCountFromPresentMode(vk::PresentModeKHR mode) -
     }
 }
 
+auto JellyEngine::Impl::_selectDepthFormat() -> vk::Format {
+    const auto candidates = std::array{
+        vk::Format::eD24UnormS8Uint,
+        vk::Format::eD32Sfloat,
+        vk::Format::eD32SfloatS8Uint,
+        vk::Format::eD16Unorm
+    };
+    for (const auto format : candidates) {
+        if (gpu.getFormatProperties(format).optimalTilingFeatures & vk::FormatFeatureFlagBits::eDepthStencilAttachment) {
+            return format;
+        }
+    }
+    return vk::Format::eD16Unorm;
+}
+
+// Prefers memory that is only committed if the tiler spills the attachment, which it doesn't when nothing
+// is loaded or stored. Without such a memory type, desktop GPUs mostly, the attachment gets regular memory.
+auto JellyEngine::Impl::_createTransientImage(
+    vk::Format format,
+    vk::ImageUsageFlags usage,
+    vk::ImageAspectFlags aspect,
+    vk::Image& image,
+    VmaAllocation& allocation
+) -> vk::ImageView {
+    const auto image_info = static_cast<VkImageCreateInfo>(vk::ImageCreateInfo{
+        .imageType = vk::ImageType::e2D,
+        .format = format,
+        .extent = {surface_extent.width, surface_extent.height, 1},
+        .mipLevels = 1,
+        .arrayLayers = 1,
+        .samples = samples,
+        .tiling = vk::ImageTiling::eOptimal,
+        .usage = usage | vk::ImageUsageFlagBits::eTransientAttachment,
+        .sharingMode = vk::SharingMode::eExclusive,
+        .initialLayout = vk::ImageLayout::eUndefined
+    });
+
+    auto allocation_info = VmaAllocationCreateInfo{
+        .usage = VMA_MEMORY_USAGE_GPU_LAZILY_ALLOCATED
+    };
+    auto handle = VkImage{};
+    if (vmaCreateImage(allocator, &image_info, &allocation_info, &handle, &allocation, nullptr) != VK_SUCCESS) {
+        logger.info("no lazily allocated memory for {} attachment", vk::to_string(format));
+        allocation_info.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+        // the main render pass can't do without its attachments, so this fails like any other vulkan call
+        if (const auto result = vmaCreateImage(allocator, &image_info, &allocation_info, &handle, &allocation, nullptr); result != VK_SUCCESS) {
+            logger.error("could not allocate {} attachment", vk::to_string(format));
+            throw vk::SystemError(vk::make_error_code(static_cast<vk::Result>(result)), "vmaCreateImage");
+        }
+    }
+    image = handle;
+
+    return device.createImageView(vk::ImageViewCreateInfo{
+        .image = image,
+        .viewType = vk::ImageViewType::e2D,
+        .format = format,
+        .subresourceRange = {
+            .aspectMask = aspect,
+            .baseMipLevel = 0,
+            .levelCount = 1,
+            .baseArrayLayer = 0,
+            .layerCount = 1
+        }
+    });
+}
+
 auto JellyEngine::Impl::_debugCallback(
     VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity,
     VkDebugUtilsMessageTypeFlagsEXT messageType,
@@ -604,23 +1187,167 @@ JellyEngine::~JellyEngine() = default;
 void JellyEngine::initialize() {
     impl = std::make_unique<Impl>();
     impl->_initVulkan();
+
+    impl->render_context = RenderContext{
+        .device = impl->device,
+        .gpu = impl->gpu,
+        .allocator = impl->allocator,
+        .pass = impl->pass,
+        .extent = impl->surface_extent,
+        .samples = impl->samples,
+        .image_count = static_cast<uint32_t>(impl->swapchain_images.size()),
+        .queue = &impl->render_queue,
+        .spatial = &impl->spatial,
+        .multi_draw_indirect = impl->multi_draw_indirect,
+        .draw_indirect_first_instance = impl->draw_indirect_first_instance,
+        .draw_indirect_count = impl->draw_indirect_count,
+        .image_cube_array = impl->image_cube_array
+    };
+}
+
+auto JellyEngine::renderContext() noexcept -> RenderContext& {
+    return impl->render_context;
+}
+
+// Runs every tick that is due. If the simulation falls more than MAX_CATCH_UP_TICKS behind, the missed time
+// is dropped instead of trying to catch up, which would only make it fall further behind.
+void JellyEngine::Impl::_tick(AppMain& app) {
+    static constexpr int MAX_CATCH_UP_TICKS = 8;
+
+    const auto dt = std::chrono::duration<double>(fixed_step).count();
+    const auto now = std::chrono::steady_clock::now();
+    if (now - next_tick > fixed_step * MAX_CATCH_UP_TICKS) {
+        logger.warn("simulation is {} ticks behind, skipping", (now - next_tick) / fixed_step);
+        next_tick = now;
+    }
+    while (next_tick <= now) {
+        app.onFixedUpdate(dt);
+        if (snapshots != nullptr) {
+            snapshots->publish(std::chrono::steady_clock::now());
+        }
+        next_tick += fixed_step;
+    }
+}
+
+void JellyEngine::Impl::_startSimulation(AppMain& app) {
+    next_tick = std::chrono::steady_clock::now();
+    if (fixed_step == std::chrono::steady_clock::duration::zero() || !fixed_threaded) {
+        return;
+    }
+    simulating.store(true, std::memory_order_relaxed);
+    simulation = std::thread([this, &app] {
+        while (simulating.load(std::memory_order_relaxed)) {
+            {
+                std::lock_guard lock{simulation_mutex};
+                _tick(app);
+            }
+            std::this_thread::sleep_until(next_tick);
+        }
+    });
+}
+
+void JellyEngine::Impl::_stopSimulation() {
+    if (simulation.joinable()) {
+        simulating.store(false, std::memory_order_relaxed);
+        simulation.join();
+    }
+}
+
+void JellyEngine::setFrameGovernor(std::optional<FrameGovernor::Settings> settings) {
+    if (settings) {
+        impl->governor.emplace(std::move(*settings));
+    } else {
+        impl->governor.reset();
+    }
+    impl->render_context.quality_tier = 0;
+    impl->next_frame = {};
+}
+
+void JellyEngine::setThermalSource(std::function<std::optional<float>()> source) {
+    impl->thermal_source = std::move(source);
+    impl->next_thermal = {};
+}
+
+auto JellyEngine::framePolicy() noexcept -> FramePolicy {
+    return impl->governor ? impl->governor->policy() : FramePolicy{};
+}
+
+void JellyEngine::setDynamicResolution(float min_scale, float max_scale, double target_ms) {
+    if (min_scale >= 1.0f || target_ms <= 0.0) {
+        impl->dynamic_resolution.reset();
+        return;
+    }
+    auto settings = DynamicResolution::Settings{};
+    settings.min_scale = std::clamp(min_scale, settings.step, 1.0f);
+    settings.max_scale = std::clamp(max_scale, settings.min_scale, 1.0f);
+    settings.target_ms = target_ms;
+    impl->dynamic_resolution.emplace(settings);
+}
+
+void JellyEngine::setFixedTimestep(double ticks_per_second, bool threaded) {
+    if (ticks_per_second <= 0.0) {
+        impl->fixed_step = {};
+    } else {
+        impl->fixed_step = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(1.0 / ticks_per_second)
+        );
+    }
+    impl->fixed_threaded = threaded;
+}
+
+void JellyEngine::setBenchmark(uint32_t frames, uint32_t warmup, std::filesystem::path output) {
+    if (frames == 0) {
+        impl->benchmark.reset();
+        return;
+    }
+    impl->benchmark.emplace(FrameStats::Settings{.capacity = frames});
+    impl->benchmark_warmup = warmup;
+    impl->benchmark_output = std::move(output);
+    impl->benchmark_frame = 0;
 }
 
 void JellyEngine::run(AppMain& app) {
+    impl->sprites = std::make_unique<SpriteBatch>(impl->render_context);
+    impl->render_context.sprites = impl->sprites.get();
+    if (impl->dynamic_resolution && !impl->offscreen_pass && !impl->_createOffscreenTarget()) {
+        impl->dynamic_resolution.reset();
+    }
+    impl->render_extent = impl->surface_extent;
+
     app.onAttach();
+    if (const auto state = impl->display.savedState(); !state.empty()) {
+        app.onRestoreState(state);
+    }
+    // the simulation thread is held between ticks while the app saves
+    impl->display.setSaveStateHandler([&app] {
+        std::lock_guard lock{impl->simulation_mutex};
+        return app.onSaveState();
+    });
+    impl->snapshots = app.snapshots();
+    impl->_startSimulation(app);
+
+    impl->last_governed = std::chrono::steady_clock::now();
+    while (!impl->display.shouldClose() && !impl->_benchmarkDone()) {
+        impl->_pace();
+        auto frame_start = std::chrono::steady_clock::now();
 
-    while (!impl->display.shouldClose()) {
         impl->display.pollEvents();
 
         InputSystem::update();
+        ResourceSystem::update();
 
+        if (impl->fixed_step != std::chrono::steady_clock::duration::zero() && !impl->fixed_threaded) {
+            impl->_tick(app);
+        }
         app.onUpdate();
 
         const auto color = std::array{1.0f, 0.0f, 0.0f, 1.0f};
         const auto clear_values = std::array{
-            vk::ClearValue{.color = {.float32 = color}}
+            vk::ClearValue{.color = {.float32 = color}},
+            vk::ClearValue{.depthStencil = {.depth = 1.0f, .stencil = 0}}
         };
         const auto timeout = std::numeric_limits<uint64_t>::max();
+        auto cpu_time = std::chrono::steady_clock::now() - frame_start;
         impl->device.waitForFences(1, &impl->fences[impl->current_frame], true, timeout);
         impl->device.resetFences(1, &impl->fences[impl->current_frame]);
 
@@ -630,30 +1357,71 @@ void JellyEngine::run(AppMain& app) {
             impl->acquire_semaphores[impl->current_frame]
         );
 
+        frame_start = std::chrono::steady_clock::now();
+
+        // at full scale the frame renders straight into the swapchain image
+        impl->_measureFrame(image_index);
+        const auto render_extent = impl->render_extent;
+        const auto upscale = render_extent != impl->surface_extent;
+
         const auto begin_info = vk::RenderPassBeginInfo{
-            .renderPass = impl->pass,
-            .framebuffer = impl->framebuffers[image_index],
+            .renderPass = upscale ? impl->offscreen_pass : impl->pass,
+            .framebuffer = upscale ? impl->scene_framebuffer : impl->framebuffers[image_index],
             .renderArea = {
                 .offset = { .x = 0, .y = 0 },
-                .extent = impl->surface_extent
+                .extent = render_extent
             },
             .clearValueCount = clear_values.size(),
             .pClearValues = clear_values.data()
         };
 
-        const auto cmd_info = vk::CommandBufferAllocateInfo{
-            .commandPool = impl->cmd_pools[image_index],
-            .level = vk::CommandBufferLevel::ePrimary,
-            .commandBufferCount = 1
-        };
-        auto cmd = impl->device.allocateCommandBuffers(cmd_info).front();
+        impl->device.resetCommandPool(impl->cmd_pools[image_index]);
+        auto cmd = impl->cmd_buffers[image_index];
 
         cmd.begin({ .flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit});
+        if (impl->timestamps) {
+            cmd.resetQueryPool(impl->timestamps, image_index * 2, 2);
+            cmd.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, impl->timestamps, image_index * 2);
+        }
+
+        impl->render_context.cmd = cmd;
+        impl->render_context.image_index = image_index;
+        impl->render_context.frame++;
+        impl->render_context.render_extent = render_extent;
+        if (impl->snapshots != nullptr) {
+            impl->snapshots->acquire();
+            impl->render_context.alpha = impl->snapshots->alpha(std::chrono::steady_clock::now());
+        }
+        impl->_cull();
+        app.onPreRender();
+
         cmd.beginRenderPass(begin_info, vk::SubpassContents::eInline);
 
+        // pipelines are expected to take viewport and scissor as dynamic state
+        const auto viewport = vk::Viewport{
+            .width = static_cast<float>(render_extent.width),
+            .height = static_cast<float>(render_extent.height),
+            .maxDepth = 1.0f
+        };
+        cmd.setViewport(0, viewport);
+        cmd.setScissor(0, vk::Rect2D{.extent = render_extent});
+
+        impl->render_queue.clear();
+        impl->sprites->begin(image_index);
+
         app.onRender();
 
+        impl->render_queue.submit(cmd);
+        impl->sprites->submit(cmd, impl->surface_extent);
+
         cmd.endRenderPass();
+        if (upscale) {
+            impl->_upscale(cmd, image_index);
+        }
+        if (impl->timestamps) {
+            cmd.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, impl->timestamps, image_index * 2 + 1);
+            impl->timestamps_written[image_index] = true;
+        }
         cmd.end();
 
         const auto wait_semaphores = std::array{
@@ -665,7 +1433,7 @@ void JellyEngine::run(AppMain& app) {
         };
 
         const auto stages = std::array{
-            vk::PipelineStageFlags{vk::PipelineStageFlagBits::eColorAttachmentOutput}
+            vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eTransfer
         };
 
         const auto submit_info = vk::SubmitInfo {
@@ -679,6 +1447,8 @@ void JellyEngine::run(AppMain& app) {
         };
 
         impl->graphics_queue.submit(std::array{submit_info}, impl->fences[impl->current_frame]);
+        cpu_time += std::chrono::steady_clock::now() - frame_start;
+        impl->cpu_frame_ms = std::chrono::duration<double, std::milli>(cpu_time).count();
 
         const auto present_info = vk::PresentInfoKHR{
             .waitSemaphoreCount = signal_semaphores.size(),
@@ -690,10 +1460,24 @@ void JellyEngine::run(AppMain& app) {
         impl->present_queue.presentKHR(present_info);
         impl->present_queue.waitIdle();
 
-        impl->device.freeCommandBuffers(impl->cmd_pools[image_index], std::array{cmd});
-
         impl->current_frame = (impl->current_frame + 1) % impl->swapchain_images.size();
+        impl->_govern();
+        impl->_recordFrame();
+
+        {
+            std::lock_guard lock{impl->simulation_mutex};
+            MemorySystem::endFrame();
+        }
     }
 
+    impl->_stopSimulation();
+    impl->snapshots = nullptr;
+    if (impl->benchmark) {
+        impl->_reportBenchmark();
+    }
+    impl->display.setSaveStateHandler({});
     app.onDetach();
+
+    impl->render_context.sprites = nullptr;
+    impl->sprites.reset();
 }
\ No newline at end of file
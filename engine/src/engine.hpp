@@ -2,12 +2,29 @@
 
 #include <string>
 #include <memory>
+#include <cstdint>
 #include <optional>
+#include <filesystem>
+#include <functional>
+
+#include "frame_stats.hpp"
+#include "frame_governor.hpp"
 
 struct AppMain;
+struct RenderContext;
 struct JellyEngine {
     friend void EngineMain(int argc, char** argv);
 
+    // Device, command buffer and render queue for the frame being recorded, see render/render_context.hpp
+    static auto renderContext() noexcept -> RenderContext&;
+
+    // Replaces the platform's thermal headroom, e.g. with synthetic readings on desktop. It is called on the main
+    // thread at most once a second. An empty function goes back to the platform's.
+    static void setThermalSource(std::function<std::optional<float>()> source);
+
+    // what the governor asks for at the moment, the defaults while it is off
+    static auto framePolicy() noexcept -> FramePolicy;
+
 private:
     JellyEngine();
     ~JellyEngine();
@@ -15,6 +32,26 @@ private:
     static void initialize();
     static void run(AppMain& app);
 
+    // Calls AppMain::onFixedUpdate ticks_per_second times per second, independent of the frame rate.
+    // With threaded set the simulation runs on its own thread, otherwise it catches up before every onUpdate.
+    // A rate of 0 turns fixed updates off, which is the default. Must be called between initialize() and run().
+    static void setFixedTimestep(double ticks_per_second, bool threaded = true);
+
+    // Paces frames and picks the quality tier from CPU and GPU frame times and the platform's thermal headroom,
+    // see FrameGovernor. Empty turns it off, which is the default: frames go as fast as the present mode lets
+    // them and the quality tier stays 0. Must be called between initialize() and run().
+    static void setFrameGovernor(std::optional<FrameGovernor::Settings> settings);
+
+    // Renders the scene below the surface resolution when the measured GPU frame time goes over target_ms and
+    // upscales it into the swapchain image, sprites included. The scale stays between min_scale and max_scale.
+    // A min_scale of 1 turns it off, which is the default. Must be called between initialize() and run().
+    static void setDynamicResolution(float min_scale, float max_scale, double target_ms);
+
+    // Runs warmup frames, then records the timings of the next frames and leaves run() once they are done,
+    // writing the results to output, see FrameStats::write. 0 frames turns it off, which is the default and
+    // leaves run() to the display. Must be called between initialize() and run().
+    static void setBenchmark(uint32_t frames, uint32_t warmup, std::filesystem::path output);
+
     static void run(AppMain&& app) {
         run(app);
     }
@@ -1,5 +1,28 @@
 #pragma once
 
+#include <cstdint>
+#include <functional>
+
+// Generational handle into a Scene. A destroyed entity's index is reused with a new generation,
+// so stale handles are detected instead of aliasing the new entity.
 struct Entity {
+    uint32_t index = 0;
+    uint32_t generation = 0;
+
+    [[nodiscard]] constexpr auto valid() const noexcept -> bool {
+        return generation != 0;
+    }
+
+    [[nodiscard]] constexpr auto bits() const noexcept -> uint64_t {
+        return (static_cast<uint64_t>(generation) << 32) | index;
+    }
+
+    constexpr auto operator==(const Entity&) const noexcept -> bool = default;
+};
 
-};
\ No newline at end of file
+template<>
+struct std::hash<Entity> {
+    auto operator()(const Entity& entity) const noexcept -> size_t {
+        return std::hash<uint64_t>{}(entity.bits());
+    }
+};
@@ -0,0 +1,97 @@
+#include "frame_governor.hpp"
+
+#include <cmath>
+#include <algorithm>
+
+FrameGovernor::FrameGovernor() : FrameGovernor(Settings{}) {}
+
+FrameGovernor::FrameGovernor(Settings settings) : config(std::move(settings)) {
+    if (config.frame_rates.empty()) {
+        config.frame_rates.push_back(0.0);
+    }
+    raise_wait = config.raise_after;
+    since_raise = config.max_raise_after;
+    _setLevel(0);
+}
+
+auto FrameGovernor::_thermalFloor() const noexcept -> uint32_t {
+    // a single rate without quality tiers leaves nothing to fall back to
+    if (!thermal || *thermal < config.thermal_warn || maxLevel() == 0) {
+        return 0;
+    }
+    const auto range = std::max(config.thermal_severe - config.thermal_warn, 1e-3f);
+    const auto pressure = std::min((*thermal - config.thermal_warn) / range, 1.0f);
+    return std::clamp(static_cast<uint32_t>(std::ceil(pressure * static_cast<float>(maxLevel()) - 1e-3f)), 1u, maxLevel());
+}
+
+// milliseconds a frame may take at level, 0 when the rate isn't capped
+auto FrameGovernor::_interval(uint32_t level) const noexcept -> double {
+    const auto rate = config.frame_rates[std::min<size_t>(level, config.frame_rates.size() - 1)];
+    return rate > 0.0 ? 1000.0 / rate * config.budget : 0.0;
+}
+
+void FrameGovernor::_setLevel(uint32_t level) {
+    const auto last_rate = static_cast<uint32_t>(config.frame_rates.size()) - 1;
+    level_index = level;
+    current.target_fps = config.frame_rates[std::min(level, last_rate)];
+    current.quality_tier = level > last_rate ? level - last_rate : 0;
+    over_time = 0.0;
+    room_time = 0.0;
+}
+
+auto FrameGovernor::update(const Sample& sample) -> const FramePolicy& {
+    if (sample.thermal && std::isfinite(*sample.thermal)) {
+        thermal = sample.thermal;
+    }
+
+    const auto frame_ms = std::max(sample.cpu_ms, sample.gpu_ms);
+    if (smoothed == 0.0) {
+        smoothed = frame_ms;
+    } else {
+        const auto weight = frame_ms > smoothed ? 0.5 : 0.1;
+        smoothed += (frame_ms - smoothed) * weight;
+    }
+    since_raise += sample.dt;
+
+    const auto floor = _thermalFloor();
+    if (level_index < floor) {
+        _setLevel(floor);
+        return current;
+    }
+
+    const auto interval = _interval(level_index);
+    if (interval > 0.0 && smoothed > interval && level_index < maxLevel()) {
+        room_time = 0.0;
+        over_time += sample.dt;
+        if (over_time >= config.lower_after) {
+            // a step up that didn't hold, wait longer before trying it again
+            if (since_raise < raise_wait) {
+                raise_wait = std::min(raise_wait * 2.0, config.max_raise_after);
+            }
+            _setLevel(level_index + 1);
+        }
+        return current;
+    }
+    over_time = 0.0;
+
+    // with the same rate one level up, which is the case between quality tiers, the frame has to fit with a
+    // margin since the higher tier will cost more
+    const auto up = level_index - 1;
+    const auto up_interval = level_index > 0 ? _interval(up) : 0.0;
+    const auto margin = up_interval == interval ? 0.75 : 1.0;
+    if (level_index > floor && (up_interval == 0.0 || smoothed < up_interval * margin)) {
+        room_time += sample.dt;
+        if (room_time >= raise_wait) {
+            _setLevel(up);
+            since_raise = 0.0;
+        }
+    } else {
+        room_time = 0.0;
+    }
+
+    // a step up that held for a while is trusted again
+    if (since_raise >= config.max_raise_after) {
+        raise_wait = config.raise_after;
+    }
+    return current;
+}
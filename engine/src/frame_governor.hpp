@@ -0,0 +1,92 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <optional>
+
+// What the governor asks the frame loop for
+struct FramePolicy {
+    // the loop sleeps so that frames start no more often than this, 0 doesn't pace
+    double target_fps = 0.0;
+    // 0 is full quality, what the higher tiers give up is up to the app
+    uint32_t quality_tier = 0;
+};
+
+// Steps the frame rate down and then the quality tier up when frames stop fitting the frame interval or the
+// device runs out of thermal headroom, and back once there is room again. Levels go through frame_rates
+// first, since rendering less often saves the most power, then through the quality tiers at the lowest rate.
+//
+// Thermal headroom follows Android's AThermal_getThermalHeadroom: 0 is cool and 1 is where the platform starts
+// throttling. Between thermal_warn and thermal_severe it puts a floor under the level, so the rate comes down
+// before the platform takes the clocks down itself. The governor only sees numbers, it can be driven by
+// synthetic samples anywhere.
+struct FrameGovernor {
+    struct Settings {
+        // Highest first. Rates that divide the display's refresh rate evenly keep every frame on screen for the
+        // same number of refreshes, 45 on a 60 Hz panel would alternate between one and two.
+        std::vector<double> frame_rates = {60.0, 30.0, 20.0};
+        uint32_t max_quality_tier = 2;
+        float thermal_warn = 0.75f;
+        float thermal_severe = 0.95f;
+        // a frame fits a rate when it takes at most this much of the interval
+        double budget = 0.9;
+        // seconds over budget before stepping down
+        double lower_after = 0.5;
+        // seconds with room before stepping up, doubled every time a step up has to be undone right away
+        double raise_after = 5.0;
+        double max_raise_after = 60.0;
+    };
+
+    struct Sample {
+        // seconds since the previous sample
+        double dt = 0.0;
+        // time the frame kept the CPU and the GPU busy, without waiting on either
+        double cpu_ms = 0.0;
+        double gpu_ms = 0.0;
+        // only set when there is a fresh reading, the last one is kept otherwise
+        std::optional<float> thermal;
+    };
+
+    FrameGovernor();
+    explicit FrameGovernor(Settings settings);
+
+    auto update(const Sample& sample) -> const FramePolicy&;
+
+    [[nodiscard]] auto policy() const noexcept -> const FramePolicy& {
+        return current;
+    }
+
+    // 0 is the highest frame rate at full quality
+    [[nodiscard]] auto level() const noexcept -> uint32_t {
+        return level_index;
+    }
+
+    [[nodiscard]] auto maxLevel() const noexcept -> uint32_t {
+        return static_cast<uint32_t>(config.frame_rates.size()) - 1 + config.max_quality_tier;
+    }
+
+    // smoothed, rises fast and falls slowly
+    [[nodiscard]] auto frameTime() const noexcept -> double {
+        return smoothed;
+    }
+
+    [[nodiscard]] auto settings() const noexcept -> const Settings& {
+        return config;
+    }
+
+private:
+    auto _thermalFloor() const noexcept -> uint32_t;
+    auto _interval(uint32_t level) const noexcept -> double;
+    void _setLevel(uint32_t level);
+
+    Settings config;
+    FramePolicy current;
+    uint32_t level_index = 0;
+    double smoothed = 0.0;
+    std::optional<float> thermal;
+    double over_time = 0.0;
+    double room_time = 0.0;
+    // time since the last step up and how long the next one has to wait
+    double since_raise = 0.0;
+    double raise_wait = 0.0;
+};
@@ -0,0 +1,116 @@
+#include "frame_stats.hpp"
+
+#include <debug.hpp>
+#include <fmt/ranges.h>
+
+#include <cmath>
+#include <fstream>
+#include <iterator>
+#include <algorithm>
+
+namespace {
+    // nearest rank, so every percentile is a frame that was actually measured
+    auto percentile(const std::vector<double>& sorted, double p) noexcept -> double {
+        const auto rank = static_cast<size_t>(std::ceil(p * static_cast<double>(sorted.size())));
+        return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+    }
+
+    auto distribution(std::vector<double>& values) -> FrameStats::Distribution {
+        if (values.empty()) {
+            return {};
+        }
+        std::sort(values.begin(), values.end());
+        auto sum = 0.0;
+        for (const auto value : values) {
+            sum += value;
+        }
+        return FrameStats::Distribution{
+            .mean = sum / static_cast<double>(values.size()),
+            .p50 = percentile(values, 0.50),
+            .p95 = percentile(values, 0.95),
+            .p99 = percentile(values, 0.99),
+            .max = values.back()
+        };
+    }
+
+    void writeDistribution(std::ostream& out, const char* name, const FrameStats::Distribution& d) {
+        out << fmt::format(
+            "    \"{}\": {{\"mean\": {:.3f}, \"p50\": {:.3f}, \"p95\": {:.3f}, \"p99\": {:.3f}, \"max\": {:.3f}}},\n",
+            name, d.mean, d.p50, d.p95, d.p99, d.max
+        );
+    }
+}
+
+FrameStats::FrameStats() : FrameStats(Settings{}) {}
+
+FrameStats::FrameStats(Settings settings) : config(settings) {
+    config.histogram_bin_ms = std::max(config.histogram_bin_ms, 1e-3);
+    config.histogram_bins = std::max(config.histogram_bins, 1u);
+    recorded.reserve(config.capacity);
+}
+
+auto FrameStats::summarize() const -> Summary {
+    auto summary = Summary{};
+    summary.frames = recorded.size();
+    summary.histogram.resize(config.histogram_bins);
+    auto values = std::vector<double>(recorded.size());
+
+    std::transform(recorded.begin(), recorded.end(), values.begin(), [](const Frame& f) { return f.cpu_ms; });
+    summary.cpu = distribution(values);
+    std::transform(recorded.begin(), recorded.end(), values.begin(), [](const Frame& f) { return f.gpu_ms; });
+    summary.gpu = distribution(values);
+    std::transform(recorded.begin(), recorded.end(), values.begin(), [](const Frame& f) { return f.frame_ms; });
+    summary.frame = distribution(values);
+
+    for (const auto& frame : recorded) {
+        const auto bin = std::max(frame.frame_ms, 0.0) / config.histogram_bin_ms;
+        summary.histogram[static_cast<size_t>(std::min(bin, static_cast<double>(config.histogram_bins - 1)))]++;
+        if (frame.frame_ms >= summary.frame.p50 * config.severe_factor) {
+            summary.severe_hitches++;
+        }
+        if (frame.frame_ms >= summary.frame.p50 * config.hitch_factor) {
+            summary.hitches++;
+        }
+    }
+    return summary;
+}
+
+auto FrameStats::write(const std::filesystem::path& path) const -> bool {
+    auto file = std::ofstream(path, std::ios::trunc);
+    if (!file) {
+        Debug{"frame_stats"}.error("could not open {} for writing", path.string());
+        return false;
+    }
+    return path.extension() == ".csv" ? _writeCsv(file) : _writeJson(file);
+}
+
+auto FrameStats::_writeJson(std::ostream& out) const -> bool {
+    const auto summary = summarize();
+    out << "{\n";
+    out << fmt::format("    \"frames\": {},\n", summary.frames);
+    writeDistribution(out, "frame_ms", summary.frame);
+    writeDistribution(out, "cpu_ms", summary.cpu);
+    writeDistribution(out, "gpu_ms", summary.gpu);
+    out << fmt::format(
+        "    \"hitches\": {{\"factor\": {}, \"count\": {}, \"severe_factor\": {}, \"severe_count\": {}}},\n",
+        config.hitch_factor, summary.hitches, config.severe_factor, summary.severe_hitches
+    );
+    out << fmt::format(
+        "    \"histogram\": {{\"bin_ms\": {}, \"frames\": [{}]}}\n",
+        config.histogram_bin_ms, fmt::join(summary.histogram, ", ")
+    );
+    out << "}\n";
+    return out.good();
+}
+
+auto FrameStats::_writeCsv(std::ostream& out) const -> bool {
+    out << "frame,frame_ms,cpu_ms,gpu_ms\n";
+    auto line = fmt::memory_buffer{};
+    for (size_t i = 0; i < recorded.size(); i++) {
+        const auto& frame = recorded[i];
+        line.clear();
+        fmt::format_to(std::back_inserter(line), "{},{:.3f},{:.3f},{:.3f}\n", i, frame.frame_ms, frame.cpu_ms, frame.gpu_ms);
+        out.write(line.data(), static_cast<std::streamsize>(line.size()));
+    }
+    return out.good();
+}
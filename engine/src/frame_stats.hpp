@@ -0,0 +1,86 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <filesystem>
+
+// Per-frame timings of a benchmark run and what comes out of them. The buffer is reserved for the whole run up
+// front, so recording never allocates; frames past the capacity are dropped.
+//
+// Hitches are frames that take hitch_factor times the median frame time or longer, severe ones severe_factor
+// times. Measuring them against the median rather than a fixed budget keeps the counts comparable between
+// devices and present modes.
+struct FrameStats {
+    struct Settings {
+        size_t capacity = 1000;
+        // frame times are binned from 0, the last bin also takes everything past the range
+        double histogram_bin_ms = 1.0;
+        uint32_t histogram_bins = 50;
+        double hitch_factor = 2.0;
+        double severe_factor = 4.0;
+    };
+
+    struct Frame {
+        // time between the starts of consecutive frames, waits included
+        double frame_ms = 0.0;
+        // time the frame kept the CPU and the GPU busy, see FrameGovernor::Sample
+        double cpu_ms = 0.0;
+        double gpu_ms = 0.0;
+    };
+
+    struct Distribution {
+        double mean = 0.0;
+        double p50 = 0.0;
+        double p95 = 0.0;
+        double p99 = 0.0;
+        double max = 0.0;
+    };
+
+    struct Summary {
+        size_t frames = 0;
+        Distribution frame;
+        Distribution cpu;
+        Distribution gpu;
+        // frame times, bin i holds [i, i + 1) * histogram_bin_ms
+        std::vector<uint32_t> histogram;
+        uint32_t hitches = 0;
+        uint32_t severe_hitches = 0;
+    };
+
+    FrameStats();
+    explicit FrameStats(Settings settings);
+
+    void record(const Frame& frame) noexcept {
+        if (recorded.size() < recorded.capacity()) {
+            recorded.push_back(frame);
+        }
+    }
+
+    void clear() noexcept {
+        recorded.clear();
+    }
+
+    [[nodiscard]] auto full() const noexcept -> bool {
+        return recorded.size() == recorded.capacity();
+    }
+
+    [[nodiscard]] auto frames() const noexcept -> const std::vector<Frame>& {
+        return recorded;
+    }
+
+    [[nodiscard]] auto settings() const noexcept -> const Settings& {
+        return config;
+    }
+
+    [[nodiscard]] auto summarize() const -> Summary;
+
+    // The summary and histogram as JSON, or one row per frame as CSV when the path ends in .csv
+    [[nodiscard]] auto write(const std::filesystem::path& path) const -> bool;
+
+private:
+    auto _writeJson(std::ostream& out) const -> bool;
+    auto _writeCsv(std::ostream& out) const -> bool;
+
+    Settings config;
+    std::vector<Frame> recorded;
+};
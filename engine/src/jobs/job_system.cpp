@@ -0,0 +1,322 @@
+#include "job_system.hpp"
+#include "work_stealing_queue.hpp"
+
+#include <mutex>
+#include <deque>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <condition_variable>
+
+namespace {
+    constexpr size_t POOL_SIZE = 16384;
+    constexpr size_t QUEUE_SIZE = 4096;
+
+    thread_local size_t t_thread_index = SIZE_MAX;
+
+    struct SpinLock {
+        explicit SpinLock(std::atomic_flag& flag) noexcept : flag(flag) {
+            while (flag.test_and_set(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+        }
+        ~SpinLock() {
+            flag.clear(std::memory_order_release);
+        }
+        std::atomic_flag& flag;
+    };
+}
+
+struct JobSystem::Impl {
+    std::unique_ptr<Job[]> pool = std::make_unique<Job[]>(POOL_SIZE);
+    std::atomic<size_t> next_job{0};
+
+    std::vector<std::unique_ptr<WorkStealingQueue<Job*, QUEUE_SIZE>>> queues;
+    std::vector<std::thread> threads;
+
+    // jobs pushed by threads without a queue of their own
+    std::mutex injected_mutex;
+    std::deque<Job*> injected;
+    std::atomic<size_t> injected_count{0};
+
+    std::mutex sleep_mutex;
+    std::condition_variable wake;
+    std::atomic<uint64_t> epoch{0};
+    std::atomic<uint32_t> sleeping{0};
+    std::atomic<bool> stop{false};
+
+    explicit Impl(size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            queues.emplace_back(std::make_unique<WorkStealingQueue<Job*, QUEUE_SIZE>>());
+        }
+        t_thread_index = 0;
+        for (size_t i = 1; i < count; i++) {
+            threads.emplace_back([this, i] {
+                t_thread_index = i;
+                workerLoop();
+            });
+        }
+    }
+
+    ~Impl() {
+        {
+            std::lock_guard lock{sleep_mutex};
+            stop = true;
+        }
+        wake.notify_all();
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+
+    void workerLoop() {
+        while (!stop.load(std::memory_order_relaxed)) {
+            const auto seen = epoch.load();
+            if (const auto job = find()) {
+                execute(job);
+                continue;
+            }
+
+            std::unique_lock lock{sleep_mutex};
+            sleeping++;
+            wake.wait(lock, [&] {
+                return stop.load() || epoch.load() != seen;
+            });
+            sleeping--;
+        }
+    }
+
+    void push(Job* job) {
+        const auto index = t_thread_index;
+        if (index >= queues.size() || !queues[index]->push(job)) {
+            std::lock_guard lock{injected_mutex};
+            injected.emplace_back(job);
+            injected_count++;
+        }
+
+        epoch++;
+        if (sleeping.load() != 0) {
+            std::lock_guard lock{sleep_mutex};
+            wake.notify_one();
+        }
+    }
+
+    auto find() -> Job* {
+        const auto index = t_thread_index;
+        if (index < queues.size()) {
+            if (const auto job = queues[index]->pop()) {
+                return job;
+            }
+        }
+
+        if (injected_count.load(std::memory_order_relaxed) != 0) {
+            std::lock_guard lock{injected_mutex};
+            if (!injected.empty()) {
+                const auto job = injected.front();
+                injected.pop_front();
+                injected_count--;
+                return job;
+            }
+        }
+
+        const auto start = index < queues.size() ? index + 1 : 0;
+        for (size_t i = 0; i < queues.size(); i++) {
+            const auto victim = (start + i) % queues.size();
+            if (victim == index) {
+                continue;
+            }
+            if (const auto job = queues[victim]->steal()) {
+                return job;
+            }
+        }
+        return nullptr;
+    }
+
+    void execute(Job* job) {
+        job->invoke(job->storage);
+        if (job->destroy != nullptr) {
+            job->destroy(job->storage);
+        }
+        finish(job);
+    }
+
+    void finish(Job* job) {
+        if (job->unfinished.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+            return;
+        }
+
+        auto continuations = std::array<Job*, Job::MAX_CONTINUATIONS>{};
+        uint32_t count;
+        {
+            SpinLock lock{job->lock};
+            job->finished = true;
+            count = job->continuation_count;
+            std::copy_n(job->continuations.begin(), count, continuations.begin());
+        }
+        for (uint32_t i = 0; i < count; i++) {
+            release(continuations[i]);
+        }
+
+        const auto parent = job->parent;
+        job->free.store(true, std::memory_order_release);
+        if (parent != nullptr) {
+            finish(parent);
+        }
+    }
+
+    // drops one pending reference and queues the job once nothing holds it back
+    void release(Job* job) {
+        if (job->pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            push(job);
+        }
+    }
+
+    // runs one job if there is any, used by threads that wait
+    auto help() -> bool {
+        if (const auto job = find()) {
+            execute(job);
+            return true;
+        }
+        std::this_thread::yield();
+        return false;
+    }
+};
+
+std::unique_ptr<JobSystem::Impl> JobSystem::impl;
+
+void JobSystem::initialize(size_t threads) {
+    if (threads == 0) {
+        threads = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    impl = std::make_unique<Impl>(threads);
+}
+
+// the group job is submitted by endGroup(), so it can't complete while children are still being attached
+auto JobSystem::beginGroup() -> JobHandle {
+    if (!impl) {
+        return JobHandle{};
+    }
+    const auto job = _allocate(JobHandle{});
+    job->invoke = [](void*) {};
+    job->destroy = nullptr;
+    return JobHandle{.job = job, .generation = job->generation.load(std::memory_order_relaxed)};
+}
+
+void JobSystem::endGroup(JobHandle group) {
+    if (group.job != nullptr) {
+        _submit(group.job, {});
+    }
+}
+
+auto JobSystem::done(JobHandle handle) noexcept -> bool {
+    if (handle.job == nullptr) {
+        return true;
+    }
+    return handle.job->generation.load(std::memory_order_acquire) != handle.generation
+        || handle.job->unfinished.load(std::memory_order_acquire) == 0;
+}
+
+void JobSystem::wait(JobHandle handle) {
+    while (!done(handle)) {
+        impl->help();
+    }
+}
+
+auto JobSystem::threadCount() noexcept -> size_t {
+    return impl ? impl->queues.size() : 1;
+}
+
+auto JobSystem::threadIndex() noexcept -> size_t {
+    return impl ? std::min(t_thread_index, impl->queues.size()) : 0;
+}
+
+auto JobSystem::_allocate(JobHandle parent) -> Job* {
+    Job* job;
+    while (true) {
+        job = &impl->pool[impl->next_job.fetch_add(1, std::memory_order_relaxed) % POOL_SIZE];
+        auto expected = true;
+        if (job->free.compare_exchange_strong(expected, false, std::memory_order_acq_rel)) {
+            break;
+        }
+        // the ring wrapped around onto a job that is still in flight
+        impl->help();
+    }
+
+    {
+        SpinLock lock{job->lock};
+        job->generation.fetch_add(1, std::memory_order_release);
+        job->finished = false;
+        job->continuation_count = 0;
+    }
+    job->unfinished.store(1, std::memory_order_relaxed);
+    job->pending.store(1, std::memory_order_relaxed);
+    job->parent = nullptr;
+
+    if (!done(parent)) {
+        parent.job->unfinished.fetch_add(1, std::memory_order_relaxed);
+        job->parent = parent.job;
+    }
+    return job;
+}
+
+auto JobSystem::_submit(Job* job, std::span<const JobHandle> dependencies) -> JobHandle {
+    const auto handle = JobHandle{.job = job, .generation = job->generation.load(std::memory_order_relaxed)};
+
+    for (const auto& dependency : dependencies) {
+        if (dependency.job == nullptr) {
+            continue;
+        }
+        job->pending.fetch_add(1, std::memory_order_relaxed);
+
+        auto added = false;
+        auto full = false;
+        {
+            SpinLock lock{dependency.job->lock};
+            if (dependency.job->generation.load(std::memory_order_relaxed) == dependency.generation && !dependency.job->finished) {
+                full = dependency.job->continuation_count == Job::MAX_CONTINUATIONS;
+                if (!full) {
+                    dependency.job->continuations[dependency.job->continuation_count++] = job;
+                    added = true;
+                }
+            }
+        }
+        if (full) {
+            // nowhere to hook the job in, so the dependency is waited for here instead
+            wait(dependency);
+        }
+        if (!added) {
+            job->pending.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+
+    impl->release(job);
+    return handle;
+}
+
+void JobSystem::_parallelFor(size_t count, size_t grain, void (*fn)(void*, size_t, size_t), void* context) {
+    if (count == 0) {
+        return;
+    }
+    if (!impl || impl->queues.size() == 1) {
+        fn(context, 0, count);
+        return;
+    }
+    if (grain == 0) {
+        grain = std::max<size_t>(1, count / (impl->queues.size() * 4));
+    }
+    if (count <= grain) {
+        fn(context, 0, count);
+        return;
+    }
+
+    const auto group = beginGroup();
+    for (size_t begin = grain; begin < count; begin += grain) {
+        const auto end = std::min(begin + grain, count);
+        _schedule([fn, context, begin, end] {
+            fn(context, begin, end);
+        }, {}, group);
+    }
+    endGroup(group);
+    fn(context, 0, grain);
+    wait(group);
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <span>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <type_traits>
+
+struct Job {
+    static constexpr size_t STORAGE_SIZE = 64;
+    static constexpr size_t MAX_CONTINUATIONS = 8;
+
+    alignas(std::max_align_t) std::byte storage[STORAGE_SIZE];
+    void (*invoke)(void* storage) = nullptr;
+    void (*destroy)(void* storage) = nullptr;
+
+    Job* parent = nullptr;
+    // the job itself plus its unfinished children
+    std::atomic<int32_t> unfinished{0};
+    // unfinished dependencies, plus one until the job is submitted
+    std::atomic<int32_t> pending{0};
+    std::atomic<uint32_t> generation{0};
+    std::atomic<bool> free{true};
+
+    std::atomic_flag lock = ATOMIC_FLAG_INIT;
+    bool finished = true;
+    uint32_t continuation_count = 0;
+    std::array<Job*, MAX_CONTINUATIONS> continuations{};
+};
+
+// Refers to a scheduled job. Handles stay valid after the job completes and its slot is reused.
+struct JobHandle {
+    Job* job = nullptr;
+    uint32_t generation = 0;
+};
+
+// Work-stealing job system: one Chase-Lev deque per thread, idle threads steal from the others.
+// Jobs are allocated from a fixed ring and carry their callable inline, so scheduling doesn't touch the heap.
+struct JobSystem {
+    friend struct JellyEngine;
+    friend void EngineMain(int argc, char** argv);
+
+    // Runs fn once every job in dependencies has completed. fn must fit into Job::STORAGE_SIZE bytes.
+    // Up to Job::MAX_CONTINUATIONS jobs can wait on the same dependency without blocking; past that,
+    // schedule() itself waits for the dependency, helping with other jobs in the meantime.
+    template<typename Fn>
+    static auto schedule(Fn&& fn, std::span<const JobHandle> dependencies = {}) -> JobHandle {
+        return _schedule(std::forward<Fn>(fn), dependencies, JobHandle{});
+    }
+
+    // Like schedule(), but parent doesn't complete until the child has completed as well
+    template<typename Fn>
+    static auto scheduleChild(JobHandle parent, Fn&& fn) -> JobHandle {
+        return _schedule(std::forward<Fn>(fn), {}, parent);
+    }
+
+    // A group completes once endGroup() was called and every child scheduled into it has completed
+    static auto beginGroup() -> JobHandle;
+    static void endGroup(JobHandle group);
+
+    [[nodiscard]] static auto done(JobHandle handle) noexcept -> bool;
+
+    // Blocks until the job has completed, executing other jobs in the meantime
+    static void wait(JobHandle handle);
+
+    // Calls fn(begin, end) over sub-ranges of [0, count) of at least grain elements and waits for all of them.
+    // A grain of 0 picks one based on the number of threads.
+    template<typename Fn>
+    static void parallelFor(size_t count, size_t grain, Fn&& fn) {
+        _parallelFor(count, grain, [](void* context, size_t begin, size_t end) {
+            (*static_cast<std::remove_reference_t<Fn>*>(context))(begin, end);
+        }, const_cast<void*>(static_cast<const void*>(std::addressof(fn))));
+    }
+
+    // Number of threads executing jobs, including the one that called initialize()
+    [[nodiscard]] static auto threadCount() noexcept -> size_t;
+
+    // Index of the calling thread in [0, threadCount()), or threadCount() for threads the system doesn't own
+    [[nodiscard]] static auto threadIndex() noexcept -> size_t;
+
+private:
+    struct Impl;
+
+    // threads == 0 uses one thread per hardware core
+    static void initialize(size_t threads = 0);
+
+    template<typename Fn>
+    static auto _schedule(Fn&& fn, std::span<const JobHandle> dependencies, JobHandle parent) -> JobHandle {
+        using F = std::decay_t<Fn>;
+        static_assert(sizeof(F) <= Job::STORAGE_SIZE, "job callable is too large, capture by reference or by pointer");
+        static_assert(alignof(F) <= alignof(std::max_align_t));
+
+        // without worker threads the job runs right away, so its dependencies have run already too
+        if (!impl) {
+            fn();
+            return JobHandle{};
+        }
+
+        auto job = _allocate(parent);
+        new (job->storage) F(std::forward<Fn>(fn));
+        job->invoke = [](void* storage) {
+            (*static_cast<F*>(storage))();
+        };
+        if constexpr (std::is_trivially_destructible_v<F>) {
+            job->destroy = nullptr;
+        } else {
+            job->destroy = [](void* storage) {
+                static_cast<F*>(storage)->~F();
+            };
+        }
+        return _submit(job, dependencies);
+    }
+
+    static auto _allocate(JobHandle parent) -> Job*;
+    static auto _submit(Job* job, std::span<const JobHandle> dependencies) -> JobHandle;
+    static void _parallelFor(size_t count, size_t grain, void (*fn)(void*, size_t, size_t), void* context);
+
+    static std::unique_ptr<Impl> impl;
+};
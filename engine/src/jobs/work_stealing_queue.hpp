@@ -0,0 +1,70 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// Chase-Lev work-stealing deque ("Correct and Efficient Work-Stealing for Weak Memory Models", Lê et al. 2013).
+// The owning thread pushes and pops at the bottom, any other thread steals from the top.
+template<typename T, size_t Capacity>
+struct WorkStealingQueue {
+    static_assert((Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+
+    // owner only; returns false when the queue is full
+    auto push(T item) noexcept -> bool {
+        const auto b = bottom.load(std::memory_order_relaxed);
+        const auto t = top.load(std::memory_order_acquire);
+        if (b - t >= static_cast<int64_t>(Capacity)) {
+            return false;
+        }
+        buffer[static_cast<size_t>(b) & (Capacity - 1)].store(item, std::memory_order_relaxed);
+        bottom.store(b + 1, std::memory_order_release);
+        return true;
+    }
+
+    // owner only; returns T{} when empty
+    auto pop() noexcept -> T {
+        const auto b = bottom.load(std::memory_order_relaxed) - 1;
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        auto t = top.load(std::memory_order_relaxed);
+        if (t > b) {
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return T{};
+        }
+
+        auto item = buffer[static_cast<size_t>(b) & (Capacity - 1)].load(std::memory_order_relaxed);
+        if (t == b) {
+            // last item, race against stealers
+            if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                item = T{};
+            }
+            bottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return item;
+    }
+
+    // any thread; returns T{} when empty or when another thread won the race
+    auto steal() noexcept -> T {
+        auto t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const auto b = bottom.load(std::memory_order_acquire);
+        if (t >= b) {
+            return T{};
+        }
+        const auto item = buffer[static_cast<size_t>(t) & (Capacity - 1)].load(std::memory_order_relaxed);
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return T{};
+        }
+        return item;
+    }
+
+    [[nodiscard]] auto empty() const noexcept -> bool {
+        return bottom.load(std::memory_order_relaxed) <= top.load(std::memory_order_relaxed);
+    }
+
+private:
+    alignas(64) std::atomic<int64_t> top{0};
+    alignas(64) std::atomic<int64_t> bottom{0};
+    alignas(64) std::array<std::atomic<T>, Capacity> buffer{};
+};
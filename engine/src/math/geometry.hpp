@@ -0,0 +1,86 @@
+#pragma once
+
+#include "math.hpp"
+
+#include <array>
+#include <algorithm>
+
+struct Aabb {
+    Vec3 min{};
+    Vec3 max{};
+
+    static constexpr auto fromCenter(const Vec3& center, const Vec3& extents) noexcept -> Aabb {
+        return Aabb{center - extents, center + extents};
+    }
+
+    [[nodiscard]] constexpr auto center() const noexcept -> Vec3 {
+        return (min + max) * 0.5f;
+    }
+
+    // half the surface area, enough to compare boxes
+    [[nodiscard]] constexpr auto perimeter() const noexcept -> float {
+        const auto d = max - min;
+        return d.x * d.y + d.y * d.z + d.z * d.x;
+    }
+
+    [[nodiscard]] constexpr auto contains(const Aabb& other) const noexcept -> bool {
+        return min.x <= other.min.x && min.y <= other.min.y && min.z <= other.min.z
+            && other.max.x <= max.x && other.max.y <= max.y && other.max.z <= max.z;
+    }
+
+    [[nodiscard]] constexpr auto overlaps(const Aabb& other) const noexcept -> bool {
+        return min.x <= other.max.x && other.min.x <= max.x
+            && min.y <= other.max.y && other.min.y <= max.y
+            && min.z <= other.max.z && other.min.z <= max.z;
+    }
+
+    [[nodiscard]] constexpr auto expanded(float margin) const noexcept -> Aabb {
+        return Aabb{min - Vec3{margin, margin, margin}, max + Vec3{margin, margin, margin}};
+    }
+
+    friend constexpr auto merge(const Aabb& a, const Aabb& b) noexcept -> Aabb {
+        return Aabb{
+            {std::min(a.min.x, b.min.x), std::min(a.min.y, b.min.y), std::min(a.min.z, b.min.z)},
+            {std::max(a.max.x, b.max.x), std::max(a.max.y, b.max.y), std::max(a.max.z, b.max.z)}
+        };
+    }
+
+    // squared distance from p to the box, 0 inside
+    [[nodiscard]] constexpr auto distanceSquared(const Vec3& p) const noexcept -> float {
+        const auto dx = std::max({min.x - p.x, 0.0f, p.x - max.x});
+        const auto dy = std::max({min.y - p.y, 0.0f, p.y - max.y});
+        const auto dz = std::max({min.z - p.z, 0.0f, p.z - max.z});
+        return dx * dx + dy * dy + dz * dz;
+    }
+};
+
+// Points with dot(normal, p) + distance >= 0 are on the inner side
+struct Plane {
+    Vec3 normal{};
+    float distance = 0.0f;
+};
+
+struct Frustum {
+    std::array<Plane, 6> planes{};
+
+    // Extracts the planes of a view-projection matrix with Vulkan's [0, 1] clip depth
+    static auto fromMatrix(const Mat4& m) noexcept -> Frustum {
+        const auto row = [&m](int r) {
+            return std::array{m.m[r], m.m[4 + r], m.m[8 + r], m.m[12 + r]};
+        };
+        const auto r0 = row(0), r1 = row(1), r2 = row(2), r3 = row(3);
+        const auto plane = [](float a, float b, float c, float d) {
+            const auto inv = 1.0f / std::sqrt(a * a + b * b + c * c);
+            return Plane{{a * inv, b * inv, c * inv}, d * inv};
+        };
+
+        auto frustum = Frustum{};
+        frustum.planes[0] = plane(r3[0] + r0[0], r3[1] + r0[1], r3[2] + r0[2], r3[3] + r0[3]);
+        frustum.planes[1] = plane(r3[0] - r0[0], r3[1] - r0[1], r3[2] - r0[2], r3[3] - r0[3]);
+        frustum.planes[2] = plane(r3[0] + r1[0], r3[1] + r1[1], r3[2] + r1[2], r3[3] + r1[3]);
+        frustum.planes[3] = plane(r3[0] - r1[0], r3[1] - r1[1], r3[2] - r1[2], r3[3] - r1[3]);
+        frustum.planes[4] = plane(r2[0], r2[1], r2[2], r2[3]);
+        frustum.planes[5] = plane(r3[0] - r2[0], r3[1] - r2[1], r3[2] - r2[2], r3[3] - r2[3]);
+        return frustum;
+    }
+};
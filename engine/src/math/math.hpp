@@ -0,0 +1,135 @@
+#pragma once
+
+#include <cmath>
+
+struct Vec3 {
+    float x = 0.0f;
+    float y = 0.0f;
+    float z = 0.0f;
+
+    friend constexpr auto operator+(const Vec3& a, const Vec3& b) noexcept -> Vec3 {
+        return Vec3{a.x + b.x, a.y + b.y, a.z + b.z};
+    }
+
+    friend constexpr auto operator-(const Vec3& a, const Vec3& b) noexcept -> Vec3 {
+        return Vec3{a.x - b.x, a.y - b.y, a.z - b.z};
+    }
+
+    friend constexpr auto operator*(const Vec3& a, float s) noexcept -> Vec3 {
+        return Vec3{a.x * s, a.y * s, a.z * s};
+    }
+
+    friend constexpr auto operator==(const Vec3& a, const Vec3& b) noexcept -> bool = default;
+};
+
+constexpr auto dot(const Vec3& a, const Vec3& b) noexcept -> float {
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+constexpr auto cross(const Vec3& a, const Vec3& b) noexcept -> Vec3 {
+    return Vec3{a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};
+}
+
+inline auto length(const Vec3& v) noexcept -> float {
+    return std::sqrt(dot(v, v));
+}
+
+inline auto normalize(const Vec3& v) noexcept -> Vec3 {
+    return v * (1.0f / length(v));
+}
+
+struct Quat {
+    float x = 0.0f;
+    float y = 0.0f;
+    float z = 0.0f;
+    float w = 1.0f;
+
+    // angle in radians, axis must be normalized
+    static auto fromAxisAngle(const Vec3& axis, float angle) noexcept -> Quat {
+        const auto s = std::sin(angle * 0.5f);
+        return Quat{axis.x * s, axis.y * s, axis.z * s, std::cos(angle * 0.5f)};
+    }
+
+    friend constexpr auto operator*(const Quat& a, const Quat& b) noexcept -> Quat {
+        return Quat{
+            a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+            a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+            a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+            a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z
+        };
+    }
+
+    friend constexpr auto operator==(const Quat& a, const Quat& b) noexcept -> bool = default;
+};
+
+// Column-major, m[column * 4 + row], matching GLSL and Vulkan
+struct alignas(16) Mat4 {
+    float m[16] = {
+        1.0f, 0.0f, 0.0f, 0.0f,
+        0.0f, 1.0f, 0.0f, 0.0f,
+        0.0f, 0.0f, 1.0f, 0.0f,
+        0.0f, 0.0f, 0.0f, 1.0f
+    };
+
+    static constexpr auto identity() noexcept -> Mat4 {
+        return Mat4{};
+    }
+
+    // translation * rotation * scale
+    static constexpr auto fromTRS(const Vec3& t, const Quat& r, const Vec3& s) noexcept -> Mat4 {
+        const auto xx = r.x * r.x, yy = r.y * r.y, zz = r.z * r.z;
+        const auto xy = r.x * r.y, xz = r.x * r.z, yz = r.y * r.z;
+        const auto wx = r.w * r.x, wy = r.w * r.y, wz = r.w * r.z;
+
+        auto result = Mat4{};
+        result.m[0] = (1.0f - 2.0f * (yy + zz)) * s.x;
+        result.m[1] = 2.0f * (xy + wz) * s.x;
+        result.m[2] = 2.0f * (xz - wy) * s.x;
+        result.m[4] = 2.0f * (xy - wz) * s.y;
+        result.m[5] = (1.0f - 2.0f * (xx + zz)) * s.y;
+        result.m[6] = 2.0f * (yz + wx) * s.y;
+        result.m[8] = 2.0f * (xz + wy) * s.z;
+        result.m[9] = 2.0f * (yz - wx) * s.z;
+        result.m[10] = (1.0f - 2.0f * (xx + yy)) * s.z;
+        result.m[12] = t.x;
+        result.m[13] = t.y;
+        result.m[14] = t.z;
+        return result;
+    }
+
+    friend constexpr auto operator*(const Mat4& a, const Mat4& b) noexcept -> Mat4 {
+        auto result = Mat4{};
+        for (int c = 0; c < 4; c++) {
+            for (int r = 0; r < 4; r++) {
+                result.m[c * 4 + r] =
+                    a.m[0 * 4 + r] * b.m[c * 4 + 0] +
+                    a.m[1 * 4 + r] * b.m[c * 4 + 1] +
+                    a.m[2 * 4 + r] * b.m[c * 4 + 2] +
+                    a.m[3 * 4 + r] * b.m[c * 4 + 3];
+            }
+        }
+        return result;
+    }
+
+    [[nodiscard]] constexpr auto transformPoint(const Vec3& p) const noexcept -> Vec3 {
+        return Vec3{
+            m[0] * p.x + m[4] * p.y + m[8] * p.z + m[12],
+            m[1] * p.x + m[5] * p.y + m[9] * p.z + m[13],
+            m[2] * p.x + m[6] * p.y + m[10] * p.z + m[14]
+        };
+    }
+
+    [[nodiscard]] constexpr auto translation() const noexcept -> Vec3 {
+        return Vec3{m[12], m[13], m[14]};
+    }
+};
+
+struct Transform {
+    Vec3 position{};
+    Quat rotation{};
+    Vec3 scale{1.0f, 1.0f, 1.0f};
+
+    [[nodiscard]] constexpr auto matrix() const noexcept -> Mat4 {
+        return Mat4::fromTRS(position, rotation, scale);
+    }
+};
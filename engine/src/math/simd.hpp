@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define JELLY_SIMD_SSE 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+// Lane-parallel float, 8 wide with AVX, 4 wide with SSE2 or NEON and a 4 wide scalar fallback elsewhere.
+// Loads and stores are unaligned.
+struct SimdFloat {
+#if defined(__AVX__)
+    static constexpr size_t WIDTH = 8;
+    __m256 v;
+
+    static auto load(const float* p) noexcept -> SimdFloat { return {_mm256_loadu_ps(p)}; }
+    static auto broadcast(float s) noexcept -> SimdFloat { return {_mm256_set1_ps(s)}; }
+    void store(float* p) const noexcept { _mm256_storeu_ps(p, v); }
+
+    friend auto operator+(SimdFloat a, SimdFloat b) noexcept -> SimdFloat { return {_mm256_add_ps(a.v, b.v)}; }
+    friend auto operator-(SimdFloat a, SimdFloat b) noexcept -> SimdFloat { return {_mm256_sub_ps(a.v, b.v)}; }
+    friend auto operator*(SimdFloat a, SimdFloat b) noexcept -> SimdFloat { return {_mm256_mul_ps(a.v, b.v)}; }
+    friend auto min(SimdFloat a, SimdFloat b) noexcept -> SimdFloat { return {_mm256_min_ps(a.v, b.v)}; }
+    friend auto max(SimdFloat a, SimdFloat b) noexcept -> SimdFloat { return {_mm256_max_ps(a.v, b.v)}; }
+    friend auto sign(SimdFloat a) noexcept -> SimdFloat { return {_mm256_or_ps(_mm256_and_ps(a.v, _mm256_set1_ps(-0.0f)), _mm256_set1_ps(1.0f))}; }
+    friend auto rsqrt(SimdFloat a) noexcept -> SimdFloat { return _refine(a, {_mm256_rsqrt_ps(a.v)}); }
+#elif JELLY_SIMD_SSE
+    static constexpr size_t WIDTH = 4;
+    __m128 v;
+
+    static auto load(const float* p) noexcept -> SimdFloat { return {_mm_loadu_ps(p)}; }
+    static auto broadcast(float s) noexcept -> SimdFloat { return {_mm_set1_ps(s)}; }
+    void store(float* p) const noexcept { _mm_storeu_ps(p, v); }
+
+    friend auto operator+(SimdFloat a, SimdFloat b) noexcept -> SimdFloat { return {_mm_add_ps(a.v, b.v)}; }
+    friend auto operator-(SimdFloat a, SimdFloat b) noexcept -> SimdFloat { return {_mm_sub_ps(a.v, b.v)}; }
+    friend auto operator*(SimdFloat a, SimdFloat b) noexcept -> SimdFloat { return {_mm_mul_ps(a.v, b.v)}; }
+    friend auto min(SimdFloat a, SimdFloat b) noexcept -> SimdFloat { return {_mm_min_ps(a.v, b.v)}; }
+    friend auto max(SimdFloat a, SimdFloat b) noexcept -> SimdFloat { return {_mm_max_ps(a.v, b.v)}; }
+    friend auto sign(SimdFloat a) noexcept -> SimdFloat { return {_mm_or_ps(_mm_and_ps(a.v, _mm_set1_ps(-0.0f)), _mm_set1_ps(1.0f))}; }
+    friend auto rsqrt(SimdFloat a) noexcept -> SimdFloat { return _refine(a, {_mm_rsqrt_ps(a.v)}); }
+#elif defined(__ARM_NEON)
+    static constexpr size_t WIDTH = 4;
+    float32x4_t v;
+
+    static auto load(const float* p) noexcept -> SimdFloat { return {vld1q_f32(p)}; }
+    static auto broadcast(float s) noexcept -> SimdFloat { return {vdupq_n_f32(s)}; }
+    void store(float* p) const noexcept { vst1q_f32(p, v); }
+
+    friend auto operator+(SimdFloat a, SimdFloat b) noexcept -> SimdFloat { return {vaddq_f32(a.v, b.v)}; }
+    friend auto operator-(SimdFloat a, SimdFloat b) noexcept -> SimdFloat { return {vsubq_f32(a.v, b.v)}; }
+    friend auto operator*(SimdFloat a, SimdFloat b) noexcept -> SimdFloat { return {vmulq_f32(a.v, b.v)}; }
+    friend auto min(SimdFloat a, SimdFloat b) noexcept -> SimdFloat { return {vminq_f32(a.v, b.v)}; }
+    friend auto max(SimdFloat a, SimdFloat b) noexcept -> SimdFloat { return {vmaxq_f32(a.v, b.v)}; }
+    friend auto sign(SimdFloat a) noexcept -> SimdFloat {
+        const auto bits = vorrq_u32(vandq_u32(vreinterpretq_u32_f32(a.v), vdupq_n_u32(0x80000000u)), vreinterpretq_u32_f32(vdupq_n_f32(1.0f)));
+        return {vreinterpretq_f32_u32(bits)};
+    }
+    // armv7 has no vector square root or division, only the estimate and its Newton step
+    friend auto rsqrt(SimdFloat a) noexcept -> SimdFloat {
+        auto estimate = vrsqrteq_f32(a.v);
+        estimate = vmulq_f32(estimate, vrsqrtsq_f32(vmulq_f32(a.v, estimate), estimate));
+        estimate = vmulq_f32(estimate, vrsqrtsq_f32(vmulq_f32(a.v, estimate), estimate));
+        return {estimate};
+    }
+#else
+    static constexpr size_t WIDTH = 4;
+    float v[WIDTH];
+
+    static auto load(const float* p) noexcept -> SimdFloat {
+        return {{p[0], p[1], p[2], p[3]}};
+    }
+
+    static auto broadcast(float s) noexcept -> SimdFloat {
+        return {{s, s, s, s}};
+    }
+
+    void store(float* p) const noexcept {
+        for (size_t i = 0; i < WIDTH; i++) {
+            p[i] = v[i];
+        }
+    }
+
+    friend auto operator+(SimdFloat a, SimdFloat b) noexcept -> SimdFloat { return a._apply(b, [](float x, float y) { return x + y; }); }
+    friend auto operator-(SimdFloat a, SimdFloat b) noexcept -> SimdFloat { return a._apply(b, [](float x, float y) { return x - y; }); }
+    friend auto operator*(SimdFloat a, SimdFloat b) noexcept -> SimdFloat { return a._apply(b, [](float x, float y) { return x * y; }); }
+    friend auto min(SimdFloat a, SimdFloat b) noexcept -> SimdFloat { return a._apply(b, [](float x, float y) { return y < x ? y : x; }); }
+    friend auto max(SimdFloat a, SimdFloat b) noexcept -> SimdFloat { return a._apply(b, [](float x, float y) { return x < y ? y : x; }); }
+    friend auto sign(SimdFloat a) noexcept -> SimdFloat { return a._apply(a, [](float x, float) { return std::copysign(1.0f, x); }); }
+    friend auto rsqrt(SimdFloat a) noexcept -> SimdFloat { return a._apply(a, [](float x, float) { return 1.0f / std::sqrt(x); }); }
+
+    template<typename Fn>
+    auto _apply(SimdFloat other, Fn fn) const noexcept -> SimdFloat {
+        auto result = SimdFloat{};
+        for (size_t i = 0; i < WIDTH; i++) {
+            result.v[i] = fn(v[i], other.v[i]);
+        }
+        return result;
+    }
+#endif
+
+    // a * b + c
+    friend auto madd(SimdFloat a, SimdFloat b, SimdFloat c) noexcept -> SimdFloat {
+        return a * b + c;
+    }
+
+#if defined(__AVX__) || JELLY_SIMD_SSE
+    // one Newton step takes the 12 bit estimate to about 22 bits
+    static auto _refine(SimdFloat a, SimdFloat estimate) noexcept -> SimdFloat {
+        return estimate * (broadcast(1.5f) - broadcast(0.5f) * a * estimate * estimate);
+    }
+#endif
+};
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+// Interface engine containers and subsystems allocate through, so allocations can be tracked, pooled or
+// served from the frame arena instead of going to global new.
+struct Allocator {
+    virtual ~Allocator() = default;
+
+    virtual auto allocate(size_t size, size_t alignment = alignof(std::max_align_t)) -> void* = 0;
+    virtual void deallocate(void* ptr, size_t size, size_t alignment = alignof(std::max_align_t)) = 0;
+};
+
+// Standard allocator adapter, e.g. std::vector<T, StlAllocator<T>>{StlAllocator<T>{MemorySystem::frame()}}
+template<typename T>
+struct StlAllocator {
+    using value_type = T;
+
+    StlAllocator(Allocator& resource) noexcept : resource(&resource) {}
+
+    template<typename U>
+    StlAllocator(const StlAllocator<U>& other) noexcept : resource(other.resource) {}
+
+    auto allocate(size_t n) -> T* {
+        return static_cast<T*>(resource->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* ptr, size_t n) noexcept {
+        resource->deallocate(ptr, n * sizeof(T), alignof(T));
+    }
+
+    template<typename U>
+    auto operator==(const StlAllocator<U>& other) const noexcept -> bool {
+        return resource == other.resource;
+    }
+
+private:
+    template<typename U>
+    friend struct StlAllocator;
+
+    Allocator* resource;
+};
+
+template<typename T>
+using AllocatorVector = std::vector<T, StlAllocator<T>>;
+
+// Starts over with an empty vector on the same allocator that has room for as many elements as the old one
+// held. Vectors in the frame arena need this once a frame, the arena's reset took their storage.
+template<typename T>
+void renew(AllocatorVector<T>& vector) {
+    const auto size = vector.size();
+    vector = AllocatorVector<T>(vector.get_allocator());
+    vector.reserve(size);
+}
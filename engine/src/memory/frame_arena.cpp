@@ -0,0 +1,69 @@
+#include "frame_arena.hpp"
+
+#include <new>
+#include <cstdint>
+#include <algorithm>
+
+namespace {
+    constexpr size_t BUFFER_ALIGNMENT = 64;
+
+    constexpr auto alignUp(size_t value, size_t alignment) -> size_t {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+}
+
+FrameArena::FrameArena(Allocator& upstream, size_t capacity) : upstream(upstream), size(capacity) {
+    buffer = static_cast<std::byte*>(upstream.allocate(size, BUFFER_ALIGNMENT));
+}
+
+FrameArena::~FrameArena() {
+    reset();
+    upstream.deallocate(buffer, size, BUFFER_ALIGNMENT);
+}
+
+auto FrameArena::allocate(size_t bytes, size_t alignment) -> void* {
+    const auto base = reinterpret_cast<uintptr_t>(buffer);
+
+    auto current = offset.load(std::memory_order_relaxed);
+    size_t begin;
+    do {
+        begin = alignUp(base + current, alignment) - base;
+        if (begin + bytes > size) {
+            return _allocateOverflow(bytes, alignment);
+        }
+    } while (!offset.compare_exchange_weak(current, begin + bytes, std::memory_order_relaxed));
+    return buffer + begin;
+}
+
+auto FrameArena::_allocateOverflow(size_t bytes, size_t alignment) -> void* {
+    alignment = std::max(alignment, alignof(Overflow));
+    const auto header = alignUp(sizeof(Overflow), alignment);
+
+    const auto raw = static_cast<std::byte*>(upstream.allocate(header + bytes, alignment));
+    if (raw == nullptr) {
+        return nullptr;
+    }
+    auto node = new (raw) Overflow{.next = nullptr, .size = header + bytes, .alignment = alignment};
+    node->next = overflows.load(std::memory_order_relaxed);
+    while (!overflows.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed)) {}
+    overflow_bytes.fetch_add(bytes, std::memory_order_relaxed);
+    return raw + header;
+}
+
+void FrameArena::reset() {
+    auto node = overflows.exchange(nullptr, std::memory_order_acquire);
+    while (node != nullptr) {
+        const auto next = node->next;
+        upstream.deallocate(node, node->size, node->alignment);
+        node = next;
+    }
+
+    last_overflow = overflow_bytes.exchange(0, std::memory_order_relaxed);
+    if (last_overflow != 0) {
+        const auto required = alignUp(offset.load(std::memory_order_relaxed) + last_overflow, BUFFER_ALIGNMENT);
+        upstream.deallocate(buffer, size, BUFFER_ALIGNMENT);
+        size = std::max(required, size * 2);
+        buffer = static_cast<std::byte*>(upstream.allocate(size, BUFFER_ALIGNMENT));
+    }
+    offset.store(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "allocator.hpp"
+
+#include <atomic>
+
+// Linear allocator for data that only lives until the end of the frame. Allocation is a single atomic bump,
+// so jobs may allocate concurrently; deallocate() does nothing and reset() frees everything at once.
+// Allocations that don't fit go to the upstream allocator until the next reset(), which then grows the arena
+// to the frame's peak so the following frames fit again.
+struct FrameArena : Allocator {
+    FrameArena(Allocator& upstream, size_t capacity);
+    ~FrameArena() override;
+
+    FrameArena(const FrameArena&) = delete;
+    auto operator=(const FrameArena&) -> FrameArena& = delete;
+
+    auto allocate(size_t size, size_t alignment = alignof(std::max_align_t)) -> void* override;
+    void deallocate(void* ptr, size_t size, size_t alignment = alignof(std::max_align_t)) override {}
+
+    // Must not race with allocate()
+    void reset();
+
+    [[nodiscard]] auto capacity() const noexcept -> size_t {
+        return size;
+    }
+
+    [[nodiscard]] auto used() const noexcept -> size_t {
+        return offset.load(std::memory_order_relaxed);
+    }
+
+    // Bytes the last frame allocated past the arena's capacity
+    [[nodiscard]] auto overflow() const noexcept -> size_t {
+        return last_overflow;
+    }
+
+private:
+    struct Overflow {
+        Overflow* next;
+        size_t size;
+        size_t alignment;
+    };
+
+    auto _allocateOverflow(size_t size, size_t alignment) -> void*;
+
+    Allocator& upstream;
+    std::byte* buffer = nullptr;
+    size_t size = 0;
+    std::atomic<size_t> offset = 0;
+
+    std::atomic<Overflow*> overflows = nullptr;
+    std::atomic<size_t> overflow_bytes = 0;
+    size_t last_overflow = 0;
+};
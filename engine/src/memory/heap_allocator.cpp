@@ -0,0 +1,77 @@
+#include "heap_allocator.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+namespace {
+    struct Header {
+        size_t size;
+        size_t offset;
+    };
+
+    constexpr size_t HEADER_SIZE = 16;
+    static_assert(sizeof(Header) <= HEADER_SIZE);
+
+    auto header(void* ptr) -> Header* {
+        return reinterpret_cast<Header*>(static_cast<std::byte*>(ptr) - HEADER_SIZE);
+    }
+}
+
+auto HeapAllocator::allocate(size_t size, size_t alignment) -> void* {
+    alignment = std::max(alignment, HEADER_SIZE);
+
+    const auto raw = static_cast<std::byte*>(std::malloc(size + alignment + HEADER_SIZE));
+    if (raw == nullptr) {
+        return nullptr;
+    }
+    const auto address = (reinterpret_cast<uintptr_t>(raw) + HEADER_SIZE + alignment - 1) & ~(alignment - 1);
+    const auto ptr = reinterpret_cast<std::byte*>(address);
+    *header(ptr) = Header{.size = size, .offset = static_cast<size_t>(ptr - raw)};
+
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    live_allocations.fetch_add(1, std::memory_order_relaxed);
+    const auto bytes = live_bytes.fetch_add(size, std::memory_order_relaxed) + size;
+    auto peak = peak_bytes.load(std::memory_order_relaxed);
+    while (peak < bytes && !peak_bytes.compare_exchange_weak(peak, bytes, std::memory_order_relaxed)) {}
+    return ptr;
+}
+
+void HeapAllocator::deallocate(void* ptr, size_t, size_t) {
+    release(ptr);
+}
+
+auto HeapAllocator::reallocate(void* ptr, size_t size, size_t alignment) -> void* {
+    if (ptr == nullptr) {
+        return allocate(size, alignment);
+    }
+    if (size == 0) {
+        release(ptr);
+        return nullptr;
+    }
+    const auto result = allocate(size, alignment);
+    if (result != nullptr) {
+        std::memcpy(result, ptr, std::min(size, header(ptr)->size));
+        release(ptr);
+    }
+    return result;
+}
+
+void HeapAllocator::release(void* ptr) {
+    if (ptr == nullptr) {
+        return;
+    }
+    const auto info = *header(ptr);
+    live_allocations.fetch_sub(1, std::memory_order_relaxed);
+    live_bytes.fetch_sub(info.size, std::memory_order_relaxed);
+    std::free(static_cast<std::byte*>(ptr) - info.offset);
+}
+
+auto HeapAllocator::stats() const noexcept -> HeapAllocationStats {
+    return HeapAllocationStats{
+        .allocations = allocations.load(std::memory_order_relaxed),
+        .live_allocations = live_allocations.load(std::memory_order_relaxed),
+        .live_bytes = live_bytes.load(std::memory_order_relaxed),
+        .peak_bytes = peak_bytes.load(std::memory_order_relaxed)
+    };
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "allocator.hpp"
+
+#include <atomic>
+#include <cstdint>
+
+struct HeapAllocationStats {
+    uint64_t allocations = 0;
+    uint64_t live_allocations = 0;
+    uint64_t live_bytes = 0;
+    uint64_t peak_bytes = 0;
+};
+
+// General purpose allocator on top of malloc that keeps allocation statistics.
+// Every block carries a small header with its size, so it also serves C style interfaces
+// (ImGui, VkAllocationCallbacks) that free or reallocate without passing the size back.
+struct HeapAllocator : Allocator {
+    auto allocate(size_t size, size_t alignment = alignof(std::max_align_t)) -> void* override;
+    void deallocate(void* ptr, size_t size, size_t alignment = alignof(std::max_align_t)) override;
+
+    auto reallocate(void* ptr, size_t size, size_t alignment = alignof(std::max_align_t)) -> void*;
+    void release(void* ptr);
+
+    [[nodiscard]] auto stats() const noexcept -> HeapAllocationStats;
+
+private:
+    std::atomic<uint64_t> allocations = 0;
+    std::atomic<uint64_t> live_allocations = 0;
+    std::atomic<uint64_t> live_bytes = 0;
+    std::atomic<uint64_t> peak_bytes = 0;
+};
@@ -0,0 +1,40 @@
+#include "memory_system.hpp"
+
+#include <debug.hpp>
+
+struct MemorySystem::Impl {
+    Debug logger{"memory"};
+    HeapAllocator heap{};
+    FrameArena frame;
+
+    explicit Impl(size_t frame_arena_size) : frame(heap, frame_arena_size) {}
+};
+
+MemorySystem::Impl* MemorySystem::impl = nullptr;
+
+void MemorySystem::initialize(size_t frame_arena_size) {
+    impl = new Impl(frame_arena_size);
+}
+
+auto MemorySystem::heap() -> HeapAllocator& {
+    return impl->heap;
+}
+
+auto MemorySystem::frame() -> FrameArena& {
+    return impl->frame;
+}
+
+auto MemorySystem::imguiAllocate(size_t size, void*) -> void* {
+    return impl->heap.allocate(size);
+}
+
+void MemorySystem::imguiFree(void* ptr, void*) {
+    impl->heap.release(ptr);
+}
+
+void MemorySystem::endFrame() {
+    impl->frame.reset();
+    if (impl->frame.overflow() != 0) {
+        impl->logger.warn("frame arena overflowed by {} bytes, grown to {} bytes", impl->frame.overflow(), impl->frame.capacity());
+    }
+}
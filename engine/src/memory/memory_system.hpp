@@ -0,0 +1,32 @@
+#pragma once
+
+#include "heap_allocator.hpp"
+#include "frame_arena.hpp"
+
+#include <cstddef>
+
+// Engine-wide allocators. heap() backs long-lived engine allocations, ImGui and Vulkan, frame() is reset
+// by the engine after every frame. Initialized first in EngineMain, before anything allocates through it.
+//
+// The reset waits for the simulation thread to finish its ticks, so onFixedUpdate may allocate from frame()
+// too, but what it gets is only good until it returns.
+struct MemorySystem {
+    friend struct JellyEngine;
+    friend void EngineMain(int argc, char** argv);
+
+    static auto heap() -> HeapAllocator&;
+    static auto frame() -> FrameArena&;
+
+    // C style hooks for ImGui::SetAllocatorFunctions
+    static auto imguiAllocate(size_t size, void* user_data) -> void*;
+    static void imguiFree(void* ptr, void* user_data);
+
+private:
+    struct Impl;
+
+    static void initialize(size_t frame_arena_size = 4 * 1024 * 1024);
+    static void endFrame();
+
+    // never destroyed, ImGui and Vulkan objects owned by other statics may still free through it at exit
+    static Impl* impl;
+};
@@ -0,0 +1,61 @@
+#include "pool_allocator.hpp"
+
+#include <new>
+#include <cassert>
+#include <algorithm>
+
+namespace {
+    constexpr auto alignUp(size_t value, size_t alignment) -> size_t {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+}
+
+PoolAllocator::PoolAllocator(Allocator& upstream, size_t block_size, size_t block_alignment, size_t blocks_per_page)
+    : upstream(upstream)
+    , block_alignment(std::max(block_alignment, alignof(Block)))
+    , blocks_per_page(std::max<size_t>(blocks_per_page, 1)) {
+    this->block_size = alignUp(std::max(block_size, sizeof(Block)), this->block_alignment);
+    page_header = alignUp(sizeof(Page), this->block_alignment);
+}
+
+PoolAllocator::~PoolAllocator() {
+    while (pages != nullptr) {
+        const auto next = pages->next;
+        upstream.deallocate(pages, page_header + block_size * blocks_per_page, block_alignment);
+        pages = next;
+    }
+}
+
+auto PoolAllocator::allocate(size_t size, size_t alignment) -> void* {
+    assert(size <= block_size && alignment <= block_alignment);
+
+    std::lock_guard lock{mutex};
+    if (free_blocks == nullptr && !_addPage()) {
+        return nullptr;
+    }
+    const auto block = free_blocks;
+    free_blocks = block->next;
+    return block;
+}
+
+void PoolAllocator::deallocate(void* ptr, size_t, size_t) {
+    if (ptr == nullptr) {
+        return;
+    }
+    std::lock_guard lock{mutex};
+    free_blocks = new (ptr) Block{.next = free_blocks};
+}
+
+auto PoolAllocator::_addPage() -> bool {
+    const auto raw = static_cast<std::byte*>(upstream.allocate(page_header + block_size * blocks_per_page, block_alignment));
+    if (raw == nullptr) {
+        return false;
+    }
+    pages = new (raw) Page{.next = pages};
+
+    // chained back to front, so blocks are handed out in address order
+    for (size_t i = blocks_per_page; i > 0; i--) {
+        free_blocks = new (raw + page_header + (i - 1) * block_size) Block{.next = free_blocks};
+    }
+    return true;
+}
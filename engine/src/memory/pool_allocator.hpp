@@ -0,0 +1,64 @@
+#pragma once
+
+#include "allocator.hpp"
+
+#include <new>
+#include <mutex>
+#include <utility>
+
+// Fixed-size block allocator. Blocks are carved from pages taken from the upstream allocator and recycled
+// through a free list, pages are only returned when the pool is destroyed.
+struct PoolAllocator : Allocator {
+    PoolAllocator(Allocator& upstream, size_t block_size, size_t block_alignment, size_t blocks_per_page = 64);
+    ~PoolAllocator() override;
+
+    PoolAllocator(const PoolAllocator&) = delete;
+    auto operator=(const PoolAllocator&) -> PoolAllocator& = delete;
+
+    // size and alignment must not exceed the block's
+    auto allocate(size_t size, size_t alignment = alignof(std::max_align_t)) -> void* override;
+    void deallocate(void* ptr, size_t size, size_t alignment = alignof(std::max_align_t)) override;
+
+private:
+    struct Block {
+        Block* next;
+    };
+
+    struct Page {
+        Page* next;
+    };
+
+    auto _addPage() -> bool;
+
+    Allocator& upstream;
+    size_t block_size;
+    size_t block_alignment;
+    size_t blocks_per_page;
+    size_t page_header;
+
+    std::mutex mutex;
+    Block* free_blocks = nullptr;
+    Page* pages = nullptr;
+};
+
+// Typed front end for PoolAllocator
+template<typename T>
+struct Pool {
+    explicit Pool(Allocator& upstream, size_t objects_per_page = 64)
+        : allocator(upstream, sizeof(T), alignof(T), objects_per_page) {}
+
+    template<typename... Args>
+    auto create(Args&&... args) -> T* {
+        return new (allocator.allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+
+    void destroy(T* object) {
+        if (object != nullptr) {
+            object->~T();
+            allocator.deallocate(object, sizeof(T), alignof(T));
+        }
+    }
+
+private:
+    PoolAllocator allocator;
+};
@@ -0,0 +1,142 @@
+#include "cooked_mesh.hpp"
+
+#include <debug.hpp>
+#include <resources/resource.hpp>
+
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+
+namespace {
+    // a section that lies within the resource and on its alignment
+    auto validSection(const Resource& resource, uint64_t offset, uint64_t size) noexcept -> bool {
+        return offset % MESH_SECTION_ALIGNMENT == 0 && offset <= resource.size() && size <= resource.size() - offset;
+    }
+
+    // whether every index names one of the vertices, a larger one would make the GPU read past the vertex buffer
+    template<typename Index>
+    auto validIndices(const char* indices, uint32_t index_count, uint32_t vertex_count) noexcept -> bool {
+        for (uint32_t i = 0; i < index_count; i++) {
+            auto index = Index{};
+            std::memcpy(&index, indices + size_t{i} * sizeof(Index), sizeof(Index));
+            if (index >= vertex_count) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // buffers can't be empty, a mesh without meshlets still gets one
+    auto bufferSize(uint64_t size) noexcept -> vk::DeviceSize {
+        return std::max<uint64_t>(size, MESH_SECTION_ALIGNMENT);
+    }
+}
+
+auto CookedMesh::load(vk::CommandBuffer cmd, const RenderContext& context, const Resource& resource, GpuBuffer& staging) -> std::optional<CookedMesh> {
+    auto header = MeshHeader{};
+    if (resource.size() < sizeof(header)) {
+        Debug{"mesh"}.error("not a cooked mesh, only {} bytes", resource.size());
+        return std::nullopt;
+    }
+    std::memcpy(&header, resource.bytes(), sizeof(header));
+    if (header.magic != MeshHeader::MAGIC || header.version != MeshHeader::VERSION) {
+        Debug{"mesh"}.error("not a cooked mesh of version {}, cook the assets again", MeshHeader::VERSION);
+        return std::nullopt;
+    }
+
+    const auto vertex_bytes = uint64_t{header.vertex_count} * sizeof(MeshVertex);
+    const auto index_bytes = uint64_t{header.index_count} * header.index_size;
+    const auto meshlet_bytes = uint64_t{header.meshlet_count} * sizeof(MeshMeshlet);
+    if ((header.index_size != 2 && header.index_size != 4) || header.index_count % 3 != 0
+        || !validSection(resource, header.vertices_offset, vertex_bytes)
+        || !validSection(resource, header.indices_offset, index_bytes)
+        || !validSection(resource, header.meshlets_offset, meshlet_bytes)) {
+        Debug{"mesh"}.error("cooked mesh is truncated or corrupt");
+        return std::nullopt;
+    }
+    const auto* indices = resource.bytes() + header.indices_offset;
+    const auto indices_valid = header.index_size == 2
+        ? validIndices<uint16_t>(indices, header.index_count, header.vertex_count)
+        : validIndices<uint32_t>(indices, header.index_count, header.vertex_count);
+    if (!indices_valid) {
+        Debug{"mesh"}.error("cooked mesh has indices past its {} vertices", header.vertex_count);
+        return std::nullopt;
+    }
+
+    auto mesh = CookedMesh{
+        .index_type = header.index_size == 2 ? vk::IndexType::eUint16 : vk::IndexType::eUint32,
+        .vertex_count = header.vertex_count,
+        .index_count = header.index_count,
+        .meshlet_count = header.meshlet_count,
+        .dequantize = Mat4::fromTRS(
+            Vec3{header.origin[0], header.origin[1], header.origin[2]},
+            Quat{},
+            Vec3{header.scale, header.scale, header.scale}
+        ),
+        .center = Vec3{header.center[0], header.center[1], header.center[2]},
+        .radius = header.radius
+    };
+    const auto transfer = vk::BufferUsageFlagBits::eTransferDst;
+    mesh.vertices = GpuBuffer::create(context.allocator, bufferSize(vertex_bytes), vk::BufferUsageFlagBits::eVertexBuffer | transfer, VMA_MEMORY_USAGE_GPU_ONLY);
+    mesh.indices = GpuBuffer::create(context.allocator, bufferSize(index_bytes), vk::BufferUsageFlagBits::eIndexBuffer | transfer, VMA_MEMORY_USAGE_GPU_ONLY);
+    mesh.meshlets = GpuBuffer::create(context.allocator, bufferSize(meshlet_bytes), vk::BufferUsageFlagBits::eStorageBuffer | transfer, VMA_MEMORY_USAGE_GPU_ONLY);
+    // the sections go to staging in one copy, keeping their offsets from the first of them
+    const auto begin = std::min({header.vertices_offset, header.indices_offset, header.meshlets_offset});
+    const auto last = std::max({header.vertices_offset + vertex_bytes, header.indices_offset + index_bytes, header.meshlets_offset + meshlet_bytes});
+    staging = GpuBuffer::create(context.allocator, bufferSize(last - begin), vk::BufferUsageFlagBits::eTransferSrc, VMA_MEMORY_USAGE_CPU_ONLY);
+    if (!mesh.vertices || !mesh.indices || !mesh.meshlets || !staging) {
+        Debug{"mesh"}.error("could not allocate the buffers of a mesh with {} vertices", header.vertex_count);
+        mesh.destroy(context.allocator);
+        staging.destroy(context.allocator);
+        return std::nullopt;
+    }
+    std::memcpy(staging.mapped, resource.bytes() + begin, last - begin);
+    vmaFlushAllocation(context.allocator, staging.allocation, 0, last - begin);
+
+    const auto copy = [&](const GpuBuffer& buffer, uint64_t offset, uint64_t size) {
+        if (size > 0) {
+            cmd.copyBuffer(staging.buffer, buffer.buffer, vk::BufferCopy{.srcOffset = offset - begin, .dstOffset = 0, .size = size});
+        }
+    };
+    copy(mesh.vertices, header.vertices_offset, vertex_bytes);
+    copy(mesh.indices, header.indices_offset, index_bytes);
+    copy(mesh.meshlets, header.meshlets_offset, meshlet_bytes);
+    const auto barrier = vk::MemoryBarrier{
+        .srcAccessMask = vk::AccessFlagBits::eTransferWrite,
+        .dstAccessMask = vk::AccessFlagBits::eVertexAttributeRead | vk::AccessFlagBits::eIndexRead | vk::AccessFlagBits::eShaderRead
+    };
+    cmd.pipelineBarrier(
+        vk::PipelineStageFlagBits::eTransfer,
+        vk::PipelineStageFlagBits::eVertexInput | vk::PipelineStageFlagBits::eComputeShader,
+        {}, barrier, nullptr, nullptr
+    );
+    return mesh;
+}
+
+void CookedMesh::destroy(VmaAllocator allocator) noexcept {
+    vertices.destroy(allocator);
+    indices.destroy(allocator);
+    meshlets.destroy(allocator);
+}
+
+void CookedMesh::draw(vk::CommandBuffer cmd, uint32_t instance_count) const {
+    cmd.bindVertexBuffers(0, vertices.buffer, vk::DeviceSize{0});
+    cmd.bindIndexBuffer(indices.buffer, 0, index_type);
+    cmd.drawIndexed(index_count, instance_count, 0, 0, 0);
+}
+
+auto CookedMesh::vertexBinding(uint32_t binding) noexcept -> vk::VertexInputBindingDescription {
+    return vk::VertexInputBindingDescription{
+        .binding = binding,
+        .stride = sizeof(MeshVertex),
+        .inputRate = vk::VertexInputRate::eVertex
+    };
+}
+
+auto CookedMesh::vertexAttributes(uint32_t binding) noexcept -> std::array<vk::VertexInputAttributeDescription, 3> {
+    return {
+        vk::VertexInputAttributeDescription{.location = 0, .binding = binding, .format = vk::Format::eR16G16B16A16Unorm, .offset = offsetof(MeshVertex, position)},
+        vk::VertexInputAttributeDescription{.location = 1, .binding = binding, .format = vk::Format::eR16G16Snorm, .offset = offsetof(MeshVertex, normal)},
+        vk::VertexInputAttributeDescription{.location = 2, .binding = binding, .format = vk::Format::eR16G16Sfloat, .offset = offsetof(MeshVertex, uv)}
+    };
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "gpu_buffer.hpp"
+#include "mesh_format.hpp"
+#include "render_context.hpp"
+
+#include <math/math.hpp>
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <vulkan/vulkan.hpp>
+
+struct Resource;
+
+// A mesh in the cooker's format, see mesh_format.hpp. Loading validates the header and the indices and copies
+// each section from the resource into its buffer as is; nothing is decoded or converted on the device.
+//
+// The buffers live in device local memory. load() copies the sections into staging and records the copies into
+// cmd, so staging has to stay alive until cmd has executed; the caller destroys it after that, e.g. once the
+// frame's fence was waited on.
+//
+// Vertices are 16 bytes with quantized positions, so pipelines take vertexBinding() and vertexAttributes()
+// and multiply dequantize() into the model matrix. Normals come octahedral encoded in attribute 1, see
+// decodeOctahedral in cooked_mesh.glsl.
+struct CookedMesh {
+    GpuBuffer vertices;
+    GpuBuffer indices;
+    // MeshMeshlet array, as a storage buffer for culling clusters in compute
+    GpuBuffer meshlets;
+    vk::IndexType index_type = vk::IndexType::eUint16;
+    uint32_t vertex_count = 0;
+    uint32_t index_count = 0;
+    uint32_t meshlet_count = 0;
+    // maps the unorm positions to model space
+    Mat4 dequantize;
+    Vec3 center;
+    float radius = 0.0f;
+
+    static auto load(vk::CommandBuffer cmd, const RenderContext& context, const Resource& resource, GpuBuffer& staging) -> std::optional<CookedMesh>;
+
+    void destroy(VmaAllocator allocator) noexcept;
+
+    // binds the vertex and index buffers and draws every index
+    void draw(vk::CommandBuffer cmd, uint32_t instance_count = 1) const;
+
+    static auto vertexBinding(uint32_t binding = 0) noexcept -> vk::VertexInputBindingDescription;
+    // position, normal and uv at locations 0, 1 and 2
+    static auto vertexAttributes(uint32_t binding = 0) noexcept -> std::array<vk::VertexInputAttributeDescription, 3>;
+};
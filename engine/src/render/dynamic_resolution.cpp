@@ -0,0 +1,51 @@
+#include "dynamic_resolution.hpp"
+
+#include <cmath>
+#include <algorithm>
+
+DynamicResolution::DynamicResolution() : DynamicResolution(Settings{}) {}
+
+DynamicResolution::DynamicResolution(Settings settings) : config(settings), current(settings.max_scale) {}
+
+auto DynamicResolution::_quantize(float scale) const noexcept -> float {
+    const auto steps = std::floor(scale / config.step + 1e-3f);
+    return std::clamp(steps * config.step, config.min_scale, config.max_scale);
+}
+
+auto DynamicResolution::update(double gpu_ms) noexcept -> float {
+    if (smoothed == 0.0) {
+        smoothed = gpu_ms;
+    } else {
+        const auto weight = gpu_ms > smoothed ? 0.5 : 0.1;
+        smoothed += (gpu_ms - smoothed) * weight;
+    }
+
+    if (settle > 0) {
+        settle--;
+        return current;
+    }
+
+    if (smoothed > config.target_ms) {
+        // frame time follows the pixel count, which goes with the square of the scale
+        const auto fit = current * static_cast<float>(std::sqrt(config.target_ms / smoothed));
+        const auto next = std::min(_quantize(fit), _quantize(current - config.step));
+        headroom_frames = 0;
+        if (next != current) {
+            current = next;
+            smoothed = config.target_ms;
+            settle = config.settle_frames;
+        }
+        return current;
+    }
+
+    if (smoothed < config.target_ms * config.headroom && current < config.max_scale) {
+        if (++headroom_frames >= config.raise_frames) {
+            current = _quantize(current + config.step);
+            headroom_frames = 0;
+            settle = config.settle_frames;
+        }
+    } else {
+        headroom_frames = 0;
+    }
+    return current;
+}
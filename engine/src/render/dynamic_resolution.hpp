@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+
+// Picks the render scale from measured GPU frame times. Over budget the scale drops at once to where the
+// time should fit, assuming it is proportional to the pixel count; with headroom for a while it climbs back
+// one step at a time. Scales are multiples of step so that the resolution doesn't change every frame.
+struct DynamicResolution {
+    struct Settings {
+        float min_scale = 0.5f;
+        float max_scale = 1.0f;
+        float step = 0.05f;
+        double target_ms = 14.0;
+        // the scale only goes up while the smoothed time stays below target_ms * headroom
+        double headroom = 0.85;
+        uint32_t raise_frames = 30;
+        // measurements lag behind by the frames in flight, changes wait this long before they are judged
+        uint32_t settle_frames = 3;
+    };
+
+    DynamicResolution();
+    explicit DynamicResolution(Settings settings);
+
+    // feed one GPU frame time in milliseconds, returns the scale to render the next frame at
+    auto update(double gpu_ms) noexcept -> float;
+
+    [[nodiscard]] auto scale() const noexcept -> float {
+        return current;
+    }
+
+    // smoothed, rises fast and falls slowly
+    [[nodiscard]] auto gpuTime() const noexcept -> double {
+        return smoothed;
+    }
+
+    [[nodiscard]] auto settings() const noexcept -> const Settings& {
+        return config;
+    }
+
+private:
+    auto _quantize(float scale) const noexcept -> float;
+
+    Settings config;
+    float current;
+    double smoothed = 0.0;
+    uint32_t headroom_frames = 0;
+    uint32_t settle = 0;
+};
@@ -0,0 +1,35 @@
+#include "gpu_buffer.hpp"
+
+#include <debug.hpp>
+
+auto GpuBuffer::create(VmaAllocator allocator, vk::DeviceSize size, vk::BufferUsageFlags usage, VmaMemoryUsage memory) -> GpuBuffer {
+    const auto buffer_info = static_cast<VkBufferCreateInfo>(vk::BufferCreateInfo{
+        .size = size,
+        .usage = usage,
+        .sharingMode = vk::SharingMode::eExclusive
+    });
+    const auto mappable = memory == VMA_MEMORY_USAGE_CPU_ONLY || memory == VMA_MEMORY_USAGE_CPU_TO_GPU || memory == VMA_MEMORY_USAGE_GPU_TO_CPU;
+    const auto allocation_info = VmaAllocationCreateInfo{
+        .flags = mappable ? VMA_ALLOCATION_CREATE_MAPPED_BIT : VmaAllocationCreateFlags{},
+        .usage = memory
+    };
+
+    auto result = GpuBuffer{};
+    auto buffer = VkBuffer{};
+    auto info = VmaAllocationInfo{};
+    if (vmaCreateBuffer(allocator, &buffer_info, &allocation_info, &buffer, &result.allocation, &info) != VK_SUCCESS) {
+        Debug{"render"}.error("could not allocate a buffer of {} bytes", size);
+        return GpuBuffer{};
+    }
+    result.buffer = buffer;
+    result.mapped = info.pMappedData;
+    result.size = size;
+    return result;
+}
+
+void GpuBuffer::destroy(VmaAllocator allocator) noexcept {
+    if (buffer) {
+        vmaDestroyBuffer(allocator, buffer, allocation);
+    }
+    *this = GpuBuffer{};
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstddef>
+#include <vk_mem_alloc.hpp>
+#include <vulkan/vulkan.hpp>
+
+// A buffer with its VMA allocation. Host visible usages are persistently mapped.
+struct GpuBuffer {
+    vk::Buffer buffer;
+    VmaAllocation allocation = nullptr;
+    void* mapped = nullptr;
+    vk::DeviceSize size = 0;
+
+    static auto create(VmaAllocator allocator, vk::DeviceSize size, vk::BufferUsageFlags usage, VmaMemoryUsage memory) -> GpuBuffer;
+
+    void destroy(VmaAllocator allocator) noexcept;
+
+    [[nodiscard]] explicit operator bool() const noexcept {
+        return static_cast<bool>(buffer);
+    }
+};
@@ -0,0 +1,843 @@
+#include "gpu_scene.hpp"
+#include "shader.hpp"
+
+#include <debug.hpp>
+#include <math/geometry.hpp>
+#include <resources/resource_system.hpp>
+
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+namespace {
+    constexpr uint32_t NO_MESH = ~0u;
+    constexpr uint32_t CULL_GROUP_SIZE = 64;
+    constexpr uint32_t REDUCE_GROUP_SIZE = 8;
+
+    enum Binding : uint32_t {
+        eParams,
+        eInstances,
+        eMeshes,
+        eCommands,
+        eBases,
+        eVisible,
+        eDraws,
+        eCount,
+        ePyramid
+    };
+
+    struct ReduceSizes {
+        uint32_t source_width;
+        uint32_t source_height;
+        uint32_t target_width;
+        uint32_t target_height;
+    };
+
+    auto groups(uint32_t count, uint32_t size) noexcept -> uint32_t {
+        return (count + size - 1) / size;
+    }
+
+    void flush(VmaAllocator allocator, const GpuBuffer& buffer, vk::DeviceSize offset, vk::DeviceSize size) {
+        vmaFlushAllocation(allocator, buffer.allocation, offset, size);
+    }
+
+    void memoryBarrier(vk::CommandBuffer cmd, vk::PipelineStageFlags src_stage, vk::AccessFlags src_access, vk::PipelineStageFlags dst_stage, vk::AccessFlags dst_access) {
+        const auto barrier = vk::MemoryBarrier{
+            .srcAccessMask = src_access,
+            .dstAccessMask = dst_access
+        };
+        cmd.pipelineBarrier(src_stage, dst_stage, {}, barrier, nullptr, nullptr);
+    }
+}
+
+GpuScene::GpuScene(const RenderContext& context) : GpuScene(context, Settings{}) {}
+
+GpuScene::GpuScene(const RenderContext& context, Settings settings) : context(context), settings(settings) {
+    vertices = GpuBuffer::create(context.allocator, settings.max_vertices * sizeof(GpuSceneVertex), vk::BufferUsageFlagBits::eVertexBuffer, VMA_MEMORY_USAGE_CPU_TO_GPU);
+    indices = GpuBuffer::create(context.allocator, settings.max_indices * sizeof(uint32_t), vk::BufferUsageFlagBits::eIndexBuffer, VMA_MEMORY_USAGE_CPU_TO_GPU);
+    meshes = GpuBuffer::create(context.allocator, settings.max_meshes * sizeof(GpuMesh), vk::BufferUsageFlagBits::eStorageBuffer, VMA_MEMORY_USAGE_CPU_TO_GPU);
+
+    _createLayouts();
+    _createPipelines();
+    _createPyramid();
+    _createFrames();
+
+    instance_data.reserve(settings.max_instances);
+
+    const auto shaders = std::vector<std::string>{"gpu_cull.comp", "gpu_compact.comp", "depth_reduce.comp", "gpu_scene.vert", "gpu_scene.frag"};
+    shader_watch = watchShaders(shaders, [this] {
+        reloadPipelines(context.device, std::array{&cull_pipeline, &compact_pipeline, &reduce_pipeline, &draw_pipeline}, [this] {
+            _createPipelines();
+        });
+    });
+}
+
+GpuScene::~GpuScene() {
+    ResourceSystem::unsubscribe(shader_watch);
+    const auto device = context.device;
+    device.waitIdle();
+
+    for (auto& frame : frames) {
+        frame.params.destroy(context.allocator);
+        frame.instances.destroy(context.allocator);
+        frame.slots.destroy(context.allocator);
+        frame.bases.destroy(context.allocator);
+        frame.commands.destroy(context.allocator);
+        frame.draws.destroy(context.allocator);
+        frame.count.destroy(context.allocator);
+        frame.visible.destroy(context.allocator);
+    }
+    _destroyPyramid();
+
+    vertices.destroy(context.allocator);
+    indices.destroy(context.allocator);
+    meshes.destroy(context.allocator);
+
+    device.destroySampler(sampler);
+    device.destroyPipeline(draw_pipeline);
+    device.destroyPipeline(reduce_pipeline);
+    device.destroyPipeline(compact_pipeline);
+    device.destroyPipeline(cull_pipeline);
+    device.destroyPipelineLayout(draw_layout);
+    device.destroyPipelineLayout(reduce_pipeline_layout);
+    device.destroyPipelineLayout(cull_layout);
+    device.destroyDescriptorSetLayout(reduce_layout);
+    device.destroyDescriptorSetLayout(scene_layout);
+    device.destroyDescriptorPool(pool);
+}
+
+void GpuScene::_createLayouts() {
+    const auto compute = vk::ShaderStageFlagBits::eCompute;
+    const auto shared = vk::ShaderStageFlagBits::eCompute | vk::ShaderStageFlagBits::eVertex;
+    const auto storage = vk::DescriptorType::eStorageBuffer;
+
+    const auto scene_bindings = std::array{
+        vk::DescriptorSetLayoutBinding{.binding = eParams, .descriptorType = vk::DescriptorType::eUniformBuffer, .descriptorCount = 1, .stageFlags = shared},
+        vk::DescriptorSetLayoutBinding{.binding = eInstances, .descriptorType = storage, .descriptorCount = 1, .stageFlags = shared},
+        vk::DescriptorSetLayoutBinding{.binding = eMeshes, .descriptorType = storage, .descriptorCount = 1, .stageFlags = compute},
+        vk::DescriptorSetLayoutBinding{.binding = eCommands, .descriptorType = storage, .descriptorCount = 1, .stageFlags = compute},
+        vk::DescriptorSetLayoutBinding{.binding = eBases, .descriptorType = storage, .descriptorCount = 1, .stageFlags = compute},
+        vk::DescriptorSetLayoutBinding{.binding = eVisible, .descriptorType = storage, .descriptorCount = 1, .stageFlags = shared},
+        vk::DescriptorSetLayoutBinding{.binding = eDraws, .descriptorType = storage, .descriptorCount = 1, .stageFlags = compute},
+        vk::DescriptorSetLayoutBinding{.binding = eCount, .descriptorType = storage, .descriptorCount = 1, .stageFlags = compute},
+        vk::DescriptorSetLayoutBinding{.binding = ePyramid, .descriptorType = vk::DescriptorType::eCombinedImageSampler, .descriptorCount = 1, .stageFlags = compute}
+    };
+    scene_layout = context.device.createDescriptorSetLayout(vk::DescriptorSetLayoutCreateInfo{
+        .bindingCount = static_cast<uint32_t>(scene_bindings.size()),
+        .pBindings = scene_bindings.data()
+    });
+
+    const auto reduce_bindings = std::array{
+        vk::DescriptorSetLayoutBinding{.binding = 0, .descriptorType = vk::DescriptorType::eCombinedImageSampler, .descriptorCount = 1, .stageFlags = compute},
+        vk::DescriptorSetLayoutBinding{.binding = 1, .descriptorType = vk::DescriptorType::eStorageImage, .descriptorCount = 1, .stageFlags = compute}
+    };
+    reduce_layout = context.device.createDescriptorSetLayout(vk::DescriptorSetLayoutCreateInfo{
+        .bindingCount = static_cast<uint32_t>(reduce_bindings.size()),
+        .pBindings = reduce_bindings.data()
+    });
+
+    // one scene set and one depth set per frame, one reduce set per pyramid level
+    const auto frame_count = context.image_count;
+    const auto sizes = std::array{
+        vk::DescriptorPoolSize{.type = vk::DescriptorType::eUniformBuffer, .descriptorCount = frame_count},
+        vk::DescriptorPoolSize{.type = storage, .descriptorCount = frame_count * 7},
+        vk::DescriptorPoolSize{.type = vk::DescriptorType::eCombinedImageSampler, .descriptorCount = frame_count * 2 + MAX_PYRAMID_LEVELS},
+        vk::DescriptorPoolSize{.type = vk::DescriptorType::eStorageImage, .descriptorCount = frame_count + MAX_PYRAMID_LEVELS}
+    };
+    pool = context.device.createDescriptorPool(vk::DescriptorPoolCreateInfo{
+        .maxSets = frame_count * 2 + MAX_PYRAMID_LEVELS,
+        .poolSizeCount = static_cast<uint32_t>(sizes.size()),
+        .pPoolSizes = sizes.data()
+    });
+
+    const auto scene_push = vk::PushConstantRange{
+        .stageFlags = vk::ShaderStageFlagBits::eVertex,
+        .offset = 0,
+        .size = sizeof(uint32_t)
+    };
+    cull_layout = context.device.createPipelineLayout(vk::PipelineLayoutCreateInfo{
+        .setLayoutCount = 1,
+        .pSetLayouts = &scene_layout
+    });
+    draw_layout = context.device.createPipelineLayout(vk::PipelineLayoutCreateInfo{
+        .setLayoutCount = 1,
+        .pSetLayouts = &scene_layout,
+        .pushConstantRangeCount = 1,
+        .pPushConstantRanges = &scene_push
+    });
+
+    const auto reduce_push = vk::PushConstantRange{
+        .stageFlags = compute,
+        .offset = 0,
+        .size = sizeof(ReduceSizes)
+    };
+    reduce_pipeline_layout = context.device.createPipelineLayout(vk::PipelineLayoutCreateInfo{
+        .setLayoutCount = 1,
+        .pSetLayouts = &reduce_layout,
+        .pushConstantRangeCount = 1,
+        .pPushConstantRanges = &reduce_push
+    });
+
+    sampler = context.device.createSampler(vk::SamplerCreateInfo{
+        .magFilter = vk::Filter::eNearest,
+        .minFilter = vk::Filter::eNearest,
+        .mipmapMode = vk::SamplerMipmapMode::eNearest,
+        .addressModeU = vk::SamplerAddressMode::eClampToEdge,
+        .addressModeV = vk::SamplerAddressMode::eClampToEdge,
+        .addressModeW = vk::SamplerAddressMode::eClampToEdge,
+        .maxLod = static_cast<float>(MAX_PYRAMID_LEVELS)
+    });
+}
+
+void GpuScene::_createPipelines() {
+    const auto cull_shader = loadShader(context.device, "gpu_cull.comp");
+    const auto compact_shader = loadShader(context.device, "gpu_compact.comp");
+    const auto reduce_shader = loadShader(context.device, "depth_reduce.comp");
+    const auto vertex_shader = loadShader(context.device, "gpu_scene.vert");
+    const auto fragment_shader = loadShader(context.device, "gpu_scene.frag");
+
+    const auto computePipeline = [this](vk::ShaderModule module, vk::PipelineLayout layout) {
+        if (!module) {
+            return vk::Pipeline{};
+        }
+        return context.device.createComputePipeline(nullptr, vk::ComputePipelineCreateInfo{
+            .stage = {
+                .stage = vk::ShaderStageFlagBits::eCompute,
+                .module = module,
+                .pName = "main"
+            },
+            .layout = layout
+        }).value;
+    };
+    cull_pipeline = computePipeline(cull_shader, cull_layout);
+    compact_pipeline = computePipeline(compact_shader, cull_layout);
+    reduce_pipeline = computePipeline(reduce_shader, reduce_pipeline_layout);
+
+    if (vertex_shader && fragment_shader) {
+        const auto stages = std::array{
+            vk::PipelineShaderStageCreateInfo{.stage = vk::ShaderStageFlagBits::eVertex, .module = vertex_shader, .pName = "main"},
+            vk::PipelineShaderStageCreateInfo{.stage = vk::ShaderStageFlagBits::eFragment, .module = fragment_shader, .pName = "main"}
+        };
+        const auto binding = vk::VertexInputBindingDescription{
+            .binding = 0,
+            .stride = sizeof(GpuSceneVertex),
+            .inputRate = vk::VertexInputRate::eVertex
+        };
+        const auto attributes = std::array{
+            vk::VertexInputAttributeDescription{.location = 0, .binding = 0, .format = vk::Format::eR32G32B32Sfloat, .offset = offsetof(GpuSceneVertex, position)},
+            vk::VertexInputAttributeDescription{.location = 1, .binding = 0, .format = vk::Format::eR32G32B32Sfloat, .offset = offsetof(GpuSceneVertex, normal)},
+            vk::VertexInputAttributeDescription{.location = 2, .binding = 0, .format = vk::Format::eR32G32Sfloat, .offset = offsetof(GpuSceneVertex, uv)}
+        };
+        const auto vertex_input = vk::PipelineVertexInputStateCreateInfo{
+            .vertexBindingDescriptionCount = 1,
+            .pVertexBindingDescriptions = &binding,
+            .vertexAttributeDescriptionCount = static_cast<uint32_t>(attributes.size()),
+            .pVertexAttributeDescriptions = attributes.data()
+        };
+        const auto input_assembly = vk::PipelineInputAssemblyStateCreateInfo{
+            .topology = vk::PrimitiveTopology::eTriangleList
+        };
+        const auto viewport = vk::PipelineViewportStateCreateInfo{
+            .viewportCount = 1,
+            .scissorCount = 1
+        };
+        const auto rasterization = vk::PipelineRasterizationStateCreateInfo{
+            .polygonMode = vk::PolygonMode::eFill,
+            .cullMode = vk::CullModeFlagBits::eBack,
+            .frontFace = vk::FrontFace::eCounterClockwise,
+            .lineWidth = 1.0f
+        };
+        const auto multisample = vk::PipelineMultisampleStateCreateInfo{
+            .rasterizationSamples = context.samples
+        };
+        const auto depth_stencil = vk::PipelineDepthStencilStateCreateInfo{
+            .depthTestEnable = true,
+            .depthWriteEnable = true,
+            .depthCompareOp = vk::CompareOp::eLessOrEqual
+        };
+        const auto blend_attachment = vk::PipelineColorBlendAttachmentState{
+            .blendEnable = false,
+            .colorWriteMask = vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG | vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA
+        };
+        const auto blend = vk::PipelineColorBlendStateCreateInfo{
+            .attachmentCount = 1,
+            .pAttachments = &blend_attachment
+        };
+        const auto dynamic_states = std::array{vk::DynamicState::eViewport, vk::DynamicState::eScissor};
+        const auto dynamic = vk::PipelineDynamicStateCreateInfo{
+            .dynamicStateCount = static_cast<uint32_t>(dynamic_states.size()),
+            .pDynamicStates = dynamic_states.data()
+        };
+
+        draw_pipeline = context.device.createGraphicsPipeline(nullptr, vk::GraphicsPipelineCreateInfo{
+            .stageCount = static_cast<uint32_t>(stages.size()),
+            .pStages = stages.data(),
+            .pVertexInputState = &vertex_input,
+            .pInputAssemblyState = &input_assembly,
+            .pViewportState = &viewport,
+            .pRasterizationState = &rasterization,
+            .pMultisampleState = &multisample,
+            .pDepthStencilState = &depth_stencil,
+            .pColorBlendState = &blend,
+            .pDynamicState = &dynamic,
+            .layout = draw_layout,
+            .renderPass = context.pass,
+            .subpass = 0
+        }).value;
+    }
+
+    for (const auto module : {cull_shader, compact_shader, reduce_shader, vertex_shader, fragment_shader}) {
+        context.device.destroyShaderModule(module);
+    }
+}
+
+// Sized to the largest power of two that fits in the surface, every level halves both sides down to 1x1.
+// Non power of two depth buffers are reduced into level 0 by taking the max over each texel's footprint.
+// gpu_cull.comp binds the pyramid whether occlusion is on or not, so when there is no memory for it a single
+// texel stands in. That one is never built, pyramid_ready stays false and occlusion culling is off.
+void GpuScene::_createPyramid() {
+    pyramid_surface = context.extent;
+    const auto extent = vk::Extent2D{
+        std::bit_floor(std::max(context.extent.width, 1u)),
+        std::bit_floor(std::max(context.extent.height, 1u))
+    };
+    if (!_allocatePyramid(extent)) {
+        Debug{"gpu_scene"}.error("could not allocate the depth pyramid, occlusion culling is off");
+        if (!_allocatePyramid(vk::Extent2D{1, 1})) {
+            Debug{"gpu_scene"}.error("could not allocate the fallback depth pyramid, culling is off");
+            return;
+        }
+        pyramid_fallback = true;
+    }
+
+    const auto view = [this](uint32_t level, uint32_t count) {
+        return context.device.createImageView(vk::ImageViewCreateInfo{
+            .image = pyramid,
+            .viewType = vk::ImageViewType::e2D,
+            .format = vk::Format::eR32Sfloat,
+            .subresourceRange = {
+                .aspectMask = vk::ImageAspectFlagBits::eColor,
+                .baseMipLevel = level,
+                .levelCount = count,
+                .baseArrayLayer = 0,
+                .layerCount = 1
+            }
+        });
+    };
+    pyramid_view = view(0, pyramid_level_count);
+    for (uint32_t level = 0; level < pyramid_level_count; level++) {
+        pyramid_levels[level] = view(level, 1);
+    }
+
+    // level 0 reads the depth buffer through the per frame depth set, the rest read the level above. The sets
+    // outlive the pyramid, a new one rewrites them.
+    for (uint32_t level = 1; level < pyramid_level_count; level++) {
+        if (!reduce_sets[level]) {
+            reduce_sets[level] = context.device.allocateDescriptorSets(vk::DescriptorSetAllocateInfo{
+                .descriptorPool = pool,
+                .descriptorSetCount = 1,
+                .pSetLayouts = &reduce_layout
+            }).front();
+        }
+        const auto source = vk::DescriptorImageInfo{.sampler = sampler, .imageView = pyramid_levels[level - 1], .imageLayout = vk::ImageLayout::eGeneral};
+        const auto target = vk::DescriptorImageInfo{.imageView = pyramid_levels[level], .imageLayout = vk::ImageLayout::eGeneral};
+        const auto writes = std::array{
+            vk::WriteDescriptorSet{.dstSet = reduce_sets[level], .dstBinding = 0, .descriptorCount = 1, .descriptorType = vk::DescriptorType::eCombinedImageSampler, .pImageInfo = &source},
+            vk::WriteDescriptorSet{.dstSet = reduce_sets[level], .dstBinding = 1, .descriptorCount = 1, .descriptorType = vk::DescriptorType::eStorageImage, .pImageInfo = &target}
+        };
+        context.device.updateDescriptorSets(writes, nullptr);
+    }
+}
+
+auto GpuScene::_allocatePyramid(vk::Extent2D extent) -> bool {
+    const auto level_count = std::min(
+        static_cast<uint32_t>(std::bit_width(std::max(extent.width, extent.height))),
+        MAX_PYRAMID_LEVELS
+    );
+    const auto image_info = static_cast<VkImageCreateInfo>(vk::ImageCreateInfo{
+        .imageType = vk::ImageType::e2D,
+        .format = vk::Format::eR32Sfloat,
+        .extent = {extent.width, extent.height, 1},
+        .mipLevels = level_count,
+        .arrayLayers = 1,
+        .samples = vk::SampleCountFlagBits::e1,
+        .tiling = vk::ImageTiling::eOptimal,
+        .usage = vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eStorage,
+        .sharingMode = vk::SharingMode::eExclusive,
+        .initialLayout = vk::ImageLayout::eUndefined
+    });
+    const auto allocation_info = VmaAllocationCreateInfo{
+        .usage = VMA_MEMORY_USAGE_GPU_ONLY
+    };
+    auto image = VkImage{};
+    if (vmaCreateImage(context.allocator, &image_info, &allocation_info, &image, &pyramid_allocation, nullptr) != VK_SUCCESS) {
+        return false;
+    }
+    pyramid = image;
+    pyramid_extent = extent;
+    pyramid_level_count = level_count;
+    return true;
+}
+
+void GpuScene::_destroyPyramid() noexcept {
+    for (uint32_t level = 0; level < pyramid_level_count; level++) {
+        context.device.destroyImageView(pyramid_levels[level]);
+        pyramid_levels[level] = nullptr;
+    }
+    context.device.destroyImageView(pyramid_view);
+    pyramid_view = nullptr;
+    if (pyramid) {
+        vmaDestroyImage(context.allocator, pyramid, pyramid_allocation);
+    }
+    pyramid = nullptr;
+    pyramid_allocation = nullptr;
+    pyramid_extent = vk::Extent2D{};
+    pyramid_level_count = 0;
+    pyramid_initialized = false;
+    pyramid_ready = false;
+    pyramid_fallback = false;
+}
+
+// Points every frame's scene set at the pyramid and its depth set at level 0
+void GpuScene::_writePyramidSets() {
+    if (!pyramid_view) {
+        return;
+    }
+    const auto image = vk::DescriptorImageInfo{.sampler = sampler, .imageView = pyramid_view, .imageLayout = vk::ImageLayout::eGeneral};
+    const auto target = vk::DescriptorImageInfo{.imageView = pyramid_levels[0], .imageLayout = vk::ImageLayout::eGeneral};
+    for (const auto& frame : frames) {
+        const auto writes = std::array{
+            vk::WriteDescriptorSet{.dstSet = frame.set, .dstBinding = ePyramid, .descriptorCount = 1, .descriptorType = vk::DescriptorType::eCombinedImageSampler, .pImageInfo = &image},
+            vk::WriteDescriptorSet{.dstSet = frame.depth_set, .dstBinding = 1, .descriptorCount = 1, .descriptorType = vk::DescriptorType::eStorageImage, .pImageInfo = &target}
+        };
+        context.device.updateDescriptorSets(writes, nullptr);
+    }
+}
+
+// The pyramid follows the surface. cull() and buildDepthPyramid() both check before they record anything, so
+// whichever comes first in a frame replaces it before the frame binds the sets. Resizes are rare enough to
+// wait for the frames in flight, which still read the old one.
+void GpuScene::_resizePyramid() {
+    if (context.extent == pyramid_surface) {
+        return;
+    }
+    context.device.waitIdle();
+    _destroyPyramid();
+    _createPyramid();
+    _writePyramidSets();
+}
+
+void GpuScene::_createFrames() {
+    const auto slot_capacity = settings.max_meshes * MAX_LODS;
+    const auto command_size = slot_capacity * sizeof(vk::DrawIndexedIndirectCommand);
+    const auto indirect = vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer | vk::BufferUsageFlagBits::eTransferDst;
+
+    frames.resize(context.image_count);
+    for (auto& frame : frames) {
+        frame.params = GpuBuffer::create(context.allocator, sizeof(Params), vk::BufferUsageFlagBits::eUniformBuffer, VMA_MEMORY_USAGE_CPU_TO_GPU);
+        frame.instances = GpuBuffer::create(context.allocator, settings.max_instances * sizeof(GpuInstance), vk::BufferUsageFlagBits::eStorageBuffer, VMA_MEMORY_USAGE_CPU_TO_GPU);
+        frame.slots = GpuBuffer::create(context.allocator, command_size, vk::BufferUsageFlagBits::eTransferSrc, VMA_MEMORY_USAGE_CPU_TO_GPU);
+        frame.bases = GpuBuffer::create(context.allocator, slot_capacity * sizeof(uint32_t), vk::BufferUsageFlagBits::eStorageBuffer, VMA_MEMORY_USAGE_CPU_TO_GPU);
+        frame.commands = GpuBuffer::create(context.allocator, command_size, indirect, VMA_MEMORY_USAGE_GPU_ONLY);
+        frame.draws = GpuBuffer::create(context.allocator, command_size, indirect, VMA_MEMORY_USAGE_GPU_ONLY);
+        frame.count = GpuBuffer::create(context.allocator, sizeof(uint32_t), indirect, VMA_MEMORY_USAGE_GPU_ONLY);
+        // every instance lands in one LOD slot of its mesh, and each slot has room for all of the mesh's instances
+        frame.visible = GpuBuffer::create(context.allocator, settings.max_instances * MAX_LODS * sizeof(uint32_t), vk::BufferUsageFlagBits::eStorageBuffer, VMA_MEMORY_USAGE_GPU_ONLY);
+
+        const auto layouts = std::array{scene_layout, reduce_layout};
+        const auto sets = context.device.allocateDescriptorSets(vk::DescriptorSetAllocateInfo{
+            .descriptorPool = pool,
+            .descriptorSetCount = static_cast<uint32_t>(layouts.size()),
+            .pSetLayouts = layouts.data()
+        });
+        frame.set = sets[0];
+        frame.depth_set = sets[1];
+
+        const auto buffer = [](const GpuBuffer& b) {
+            return vk::DescriptorBufferInfo{.buffer = b.buffer, .offset = 0, .range = VK_WHOLE_SIZE};
+        };
+        const auto buffers = std::array{
+            buffer(frame.params),
+            buffer(frame.instances),
+            buffer(meshes),
+            buffer(frame.commands),
+            buffer(frame.bases),
+            buffer(frame.visible),
+            buffer(frame.draws),
+            buffer(frame.count)
+        };
+        auto writes = std::vector<vk::WriteDescriptorSet>{};
+        for (uint32_t binding = eParams; binding <= eCount; binding++) {
+            writes.emplace_back(vk::WriteDescriptorSet{
+                .dstSet = frame.set,
+                .dstBinding = binding,
+                .descriptorCount = 1,
+                .descriptorType = binding == eParams ? vk::DescriptorType::eUniformBuffer : vk::DescriptorType::eStorageBuffer,
+                .pBufferInfo = &buffers[binding]
+            });
+        }
+        context.device.updateDescriptorSets(writes, nullptr);
+    }
+    _writePyramidSets();
+}
+
+auto GpuScene::addMesh(std::span<const GpuSceneVertex> mesh_vertices, std::span<const uint32_t> mesh_indices, std::span<const std::pair<uint32_t, uint32_t>> lods) -> std::optional<uint32_t> {
+    if (lods.empty() || lods.size() > MAX_LODS) {
+        Debug{"gpu_scene"}.error("meshes need 1 to {} lods, got {}", MAX_LODS, lods.size());
+        return std::nullopt;
+    }
+    if (mesh_infos.size() == settings.max_meshes
+        || vertex_count + mesh_vertices.size() > settings.max_vertices
+        || index_count + mesh_indices.size() > settings.max_indices) {
+        Debug{"gpu_scene"}.error("mesh does not fit, raise the limits in GpuScene::Settings");
+        return std::nullopt;
+    }
+    for (const auto& [first, count] : lods) {
+        if (first + count > mesh_indices.size()) {
+            Debug{"gpu_scene"}.error("lod range {}..{} is outside of the {} indices", first, first + count, mesh_indices.size());
+            return std::nullopt;
+        }
+    }
+
+    // the buffers only grow, so ranges in flight are never written
+    std::memcpy(static_cast<GpuSceneVertex*>(vertices.mapped) + vertex_count, mesh_vertices.data(), mesh_vertices.size_bytes());
+    std::memcpy(static_cast<uint32_t*>(indices.mapped) + index_count, mesh_indices.data(), mesh_indices.size_bytes());
+    flush(context.allocator, vertices, vertex_count * sizeof(GpuSceneVertex), mesh_vertices.size_bytes());
+    flush(context.allocator, indices, index_count * sizeof(uint32_t), mesh_indices.size_bytes());
+
+    auto bounds = Aabb{};
+    if (!mesh_vertices.empty()) {
+        const auto& p = mesh_vertices.front().position;
+        bounds = Aabb{{p[0], p[1], p[2]}, {p[0], p[1], p[2]}};
+    }
+    for (const auto& vertex : mesh_vertices) {
+        const auto p = Vec3{vertex.position[0], vertex.position[1], vertex.position[2]};
+        bounds = merge(bounds, Aabb{p, p});
+    }
+    const auto center = bounds.center();
+    const auto extent = bounds.max - center;
+
+    auto info = MeshInfo{
+        .first_slot = slot_count,
+        .lod_count = static_cast<uint32_t>(lods.size()),
+        .vertex_offset = static_cast<int32_t>(vertex_count),
+        .instances = 0
+    };
+    for (size_t lod = 0; lod < lods.size(); lod++) {
+        info.lods[lod] = {index_count + lods[lod].first, lods[lod].second};
+    }
+
+    const auto id = static_cast<uint32_t>(mesh_infos.size());
+    const auto gpu_mesh = GpuMesh{
+        .center = {center.x, center.y, center.z},
+        .radius = std::sqrt(extent.x * extent.x + extent.y * extent.y + extent.z * extent.z),
+        .first_slot = info.first_slot,
+        .lod_count = info.lod_count
+    };
+    std::memcpy(static_cast<GpuMesh*>(meshes.mapped) + id, &gpu_mesh, sizeof(GpuMesh));
+    flush(context.allocator, meshes, id * sizeof(GpuMesh), sizeof(GpuMesh));
+
+    mesh_infos.emplace_back(info);
+    slot_count += info.lod_count;
+    vertex_count += static_cast<uint32_t>(mesh_vertices.size());
+    index_count += static_cast<uint32_t>(mesh_indices.size());
+    _updateSlotBases();
+    return id;
+}
+
+auto GpuScene::addInstance(uint32_t mesh, const Mat4& transform) -> std::optional<uint32_t> {
+    if (mesh >= mesh_infos.size()) {
+        return std::nullopt;
+    }
+
+    auto id = uint32_t{};
+    if (!free_instances.empty()) {
+        id = free_instances.back();
+        free_instances.pop_back();
+    } else if (instance_data.size() < settings.max_instances) {
+        id = static_cast<uint32_t>(instance_data.size());
+        instance_data.emplace_back();
+    } else {
+        Debug{"gpu_scene"}.error("instance limit of {} reached", settings.max_instances);
+        return std::nullopt;
+    }
+
+    instance_data[id] = GpuInstance{.transform = transform, .mesh = mesh};
+    mesh_infos[mesh].instances++;
+    live_instances++;
+    _markDirty(id);
+    _updateSlotBases();
+    return id;
+}
+
+void GpuScene::setTransform(uint32_t instance, const Mat4& transform) {
+    instance_data[instance].transform = transform;
+    _markDirty(instance);
+}
+
+void GpuScene::removeInstance(uint32_t instance) {
+    auto& data = instance_data[instance];
+    if (data.mesh == NO_MESH) {
+        return;
+    }
+    mesh_infos[data.mesh].instances--;
+    data.mesh = NO_MESH;
+    live_instances--;
+    free_instances.emplace_back(instance);
+    _markDirty(instance);
+    _updateSlotBases();
+}
+
+void GpuScene::_markDirty(uint32_t instance) {
+    for (auto& frame : frames) {
+        if (frame.dirty_begin == frame.dirty_end) {
+            frame.dirty_begin = instance;
+            frame.dirty_end = instance + 1;
+        } else {
+            frame.dirty_begin = std::min(frame.dirty_begin, instance);
+            frame.dirty_end = std::max(frame.dirty_end, instance + 1);
+        }
+    }
+}
+
+// Each LOD slot of a mesh gets room for all of the mesh's instances in the visible list
+void GpuScene::_updateSlotBases() {
+    slot_bases.resize(slot_count);
+    auto base = uint32_t{0};
+    for (const auto& mesh : mesh_infos) {
+        for (uint32_t lod = 0; lod < mesh.lod_count; lod++) {
+            slot_bases[mesh.first_slot + lod] = base;
+            base += mesh.instances;
+        }
+    }
+    for (auto& frame : frames) {
+        frame.slots_dirty = true;
+    }
+}
+
+void GpuScene::_writeSlots(Frame& frame) {
+    // without drawIndirectFirstInstance firstInstance has to be 0, draw() pushes the base instead
+    const auto first_instance = context.draw_indirect_first_instance;
+
+    const auto commands = static_cast<vk::DrawIndexedIndirectCommand*>(frame.slots.mapped);
+    for (const auto& mesh : mesh_infos) {
+        for (uint32_t lod = 0; lod < mesh.lod_count; lod++) {
+            const auto slot = mesh.first_slot + lod;
+            commands[slot] = vk::DrawIndexedIndirectCommand{
+                .indexCount = mesh.lods[lod].second,
+                .instanceCount = 0,
+                .firstIndex = mesh.lods[lod].first,
+                .vertexOffset = mesh.vertex_offset,
+                .firstInstance = first_instance ? slot_bases[slot] : 0
+            };
+        }
+    }
+    std::memcpy(frame.bases.mapped, slot_bases.data(), slot_bases.size() * sizeof(uint32_t));
+    flush(context.allocator, frame.slots, 0, slot_count * sizeof(vk::DrawIndexedIndirectCommand));
+    flush(context.allocator, frame.bases, 0, slot_count * sizeof(uint32_t));
+    frame.slots_dirty = false;
+}
+
+void GpuScene::buildDepthPyramid(vk::CommandBuffer cmd, vk::ImageView depth, vk::ImageLayout layout, vk::Extent2D extent) {
+    _resizePyramid();
+    if (!reduce_pipeline || pyramid_level_count == 0 || pyramid_fallback || !settings.occlusion) {
+        return;
+    }
+    auto& frame = frames[context.image_index];
+
+    if (frame.depth_view != depth || frame.depth_layout != layout) {
+        const auto source = vk::DescriptorImageInfo{.sampler = sampler, .imageView = depth, .imageLayout = layout};
+        context.device.updateDescriptorSets(vk::WriteDescriptorSet{
+            .dstSet = frame.depth_set,
+            .dstBinding = 0,
+            .descriptorCount = 1,
+            .descriptorType = vk::DescriptorType::eCombinedImageSampler,
+            .pImageInfo = &source
+        }, nullptr);
+        frame.depth_view = depth;
+        frame.depth_layout = layout;
+    }
+
+    if (!pyramid_initialized) {
+        const auto barrier = vk::ImageMemoryBarrier{
+            .srcAccessMask = {},
+            .dstAccessMask = vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite,
+            .oldLayout = vk::ImageLayout::eUndefined,
+            .newLayout = vk::ImageLayout::eGeneral,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .image = pyramid,
+            .subresourceRange = {
+                .aspectMask = vk::ImageAspectFlagBits::eColor,
+                .baseMipLevel = 0,
+                .levelCount = pyramid_level_count,
+                .baseArrayLayer = 0,
+                .layerCount = 1
+            }
+        };
+        cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eComputeShader, {}, nullptr, nullptr, barrier);
+        pyramid_initialized = true;
+    }
+
+    // depth writes of the previous frame and the last cull's reads of the pyramid come first
+    memoryBarrier(
+        cmd,
+        vk::PipelineStageFlagBits::eLateFragmentTests | vk::PipelineStageFlagBits::eComputeShader,
+        vk::AccessFlagBits::eDepthStencilAttachmentWrite,
+        vk::PipelineStageFlagBits::eComputeShader,
+        vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite
+    );
+
+    cmd.bindPipeline(vk::PipelineBindPoint::eCompute, reduce_pipeline);
+    auto source = extent;
+    for (uint32_t level = 0; level < pyramid_level_count; level++) {
+        const auto target = vk::Extent2D{
+            std::max(pyramid_extent.width >> level, 1u),
+            std::max(pyramid_extent.height >> level, 1u)
+        };
+        const auto sizes = ReduceSizes{source.width, source.height, target.width, target.height};
+        const auto set = level == 0 ? frame.depth_set : reduce_sets[level];
+
+        cmd.bindDescriptorSets(vk::PipelineBindPoint::eCompute, reduce_pipeline_layout, 0, set, nullptr);
+        cmd.pushConstants(reduce_pipeline_layout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(sizes), &sizes);
+        cmd.dispatch(groups(target.width, REDUCE_GROUP_SIZE), groups(target.height, REDUCE_GROUP_SIZE), 1);
+
+        memoryBarrier(
+            cmd,
+            vk::PipelineStageFlagBits::eComputeShader,
+            vk::AccessFlagBits::eShaderWrite,
+            vk::PipelineStageFlagBits::eComputeShader,
+            vk::AccessFlagBits::eShaderRead
+        );
+        source = target;
+    }
+    pyramid_ready = true;
+}
+
+void GpuScene::cull(vk::CommandBuffer cmd, const Mat4& view_projection, const Vec3& camera) {
+    _stats.instances = live_instances;
+    _stats.draw_slots = slot_count;
+    _resizePyramid();
+    if (!cull_pipeline || !pyramid_view || slot_count == 0) {
+        return;
+    }
+    auto& frame = frames[context.image_index];
+
+    if (frame.dirty_begin != frame.dirty_end) {
+        const auto offset = frame.dirty_begin * sizeof(GpuInstance);
+        const auto size = (frame.dirty_end - frame.dirty_begin) * sizeof(GpuInstance);
+        std::memcpy(static_cast<std::byte*>(frame.instances.mapped) + offset, instance_data.data() + frame.dirty_begin, size);
+        flush(context.allocator, frame.instances, offset, size);
+        frame.dirty_begin = frame.dirty_end = 0;
+    }
+    if (frame.slots_dirty) {
+        _writeSlots(frame);
+    }
+
+    const auto frustum = Frustum::fromMatrix(view_projection);
+    auto params = Params{
+        .view_projection = view_projection,
+        .previous_view_projection = has_previous ? previous_view_projection : view_projection,
+        .camera = {camera.x, camera.y, camera.z, settings.lod_distance},
+        .instance_count = static_cast<uint32_t>(instance_data.size()),
+        .slot_count = slot_count,
+        .pyramid_width = pyramid_extent.width,
+        .pyramid_height = pyramid_extent.height,
+        .pyramid_levels = pyramid_level_count,
+        .occlusion = settings.occlusion && pyramid_ready && has_previous
+    };
+    for (size_t i = 0; i < frustum.planes.size(); i++) {
+        const auto& plane = frustum.planes[i];
+        params.planes[i][0] = plane.normal.x;
+        params.planes[i][1] = plane.normal.y;
+        params.planes[i][2] = plane.normal.z;
+        params.planes[i][3] = plane.distance;
+    }
+    std::memcpy(frame.params.mapped, &params, sizeof(params));
+    flush(context.allocator, frame.params, 0, sizeof(params));
+
+    // the last draws from these buffers are done before the reset
+    memoryBarrier(
+        cmd,
+        vk::PipelineStageFlagBits::eDrawIndirect | vk::PipelineStageFlagBits::eVertexShader,
+        {},
+        vk::PipelineStageFlagBits::eTransfer,
+        {}
+    );
+    cmd.copyBuffer(frame.slots.buffer, frame.commands.buffer, vk::BufferCopy{
+        .srcOffset = 0,
+        .dstOffset = 0,
+        .size = slot_count * sizeof(vk::DrawIndexedIndirectCommand)
+    });
+    cmd.fillBuffer(frame.count.buffer, 0, sizeof(uint32_t), 0);
+    memoryBarrier(
+        cmd,
+        vk::PipelineStageFlagBits::eTransfer,
+        vk::AccessFlagBits::eTransferWrite,
+        vk::PipelineStageFlagBits::eComputeShader,
+        vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite
+    );
+
+    cmd.bindDescriptorSets(vk::PipelineBindPoint::eCompute, cull_layout, 0, frame.set, nullptr);
+    cmd.bindPipeline(vk::PipelineBindPoint::eCompute, cull_pipeline);
+    cmd.dispatch(groups(params.instance_count, CULL_GROUP_SIZE), 1, 1);
+
+    if (context.draw_indirect_count && context.multi_draw_indirect && context.draw_indirect_first_instance && compact_pipeline) {
+        memoryBarrier(
+            cmd,
+            vk::PipelineStageFlagBits::eComputeShader,
+            vk::AccessFlagBits::eShaderWrite,
+            vk::PipelineStageFlagBits::eComputeShader,
+            vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite
+        );
+        cmd.bindPipeline(vk::PipelineBindPoint::eCompute, compact_pipeline);
+        cmd.dispatch(groups(slot_count, CULL_GROUP_SIZE), 1, 1);
+    }
+
+    memoryBarrier(
+        cmd,
+        vk::PipelineStageFlagBits::eComputeShader,
+        vk::AccessFlagBits::eShaderWrite,
+        vk::PipelineStageFlagBits::eDrawIndirect | vk::PipelineStageFlagBits::eVertexShader,
+        vk::AccessFlagBits::eIndirectCommandRead | vk::AccessFlagBits::eShaderRead
+    );
+
+    previous_view_projection = view_projection;
+    has_previous = true;
+}
+
+// Draws what the last cull() left visible. With drawIndirectCount the whole scene is one call; without it
+// every slot is drawn, empty ones included, and without multiDrawIndirect or drawIndirectFirstInstance
+// there is one indirect call per mesh LOD.
+void GpuScene::draw(vk::CommandBuffer cmd) {
+    _stats.cpu_draw_calls = 0;
+    if (!draw_pipeline || !cull_pipeline || !pyramid_view || slot_count == 0) {
+        return;
+    }
+    const auto& frame = frames[context.image_index];
+    const auto stride = static_cast<uint32_t>(sizeof(vk::DrawIndexedIndirectCommand));
+
+    cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, draw_pipeline);
+    cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, draw_layout, 0, frame.set, nullptr);
+    cmd.bindVertexBuffers(0, vertices.buffer, vk::DeviceSize{0});
+    cmd.bindIndexBuffer(indices.buffer, 0, vk::IndexType::eUint32);
+
+    if (context.multi_draw_indirect && context.draw_indirect_first_instance) {
+        const auto base = uint32_t{0};
+        cmd.pushConstants(draw_layout, vk::ShaderStageFlagBits::eVertex, 0, sizeof(base), &base);
+        if (context.draw_indirect_count && compact_pipeline) {
+            cmd.drawIndexedIndirectCount(frame.draws.buffer, 0, frame.count.buffer, 0, slot_count, stride);
+        } else {
+            cmd.drawIndexedIndirect(frame.commands.buffer, 0, slot_count, stride);
+        }
+        _stats.cpu_draw_calls = 1;
+        return;
+    }
+
+    for (uint32_t slot = 0; slot < slot_count; slot++) {
+        cmd.pushConstants(draw_layout, vk::ShaderStageFlagBits::eVertex, 0, sizeof(uint32_t), &slot_bases[slot]);
+        cmd.drawIndexedIndirect(frame.commands.buffer, slot * stride, 1, stride);
+    }
+    _stats.cpu_draw_calls = slot_count;
+}
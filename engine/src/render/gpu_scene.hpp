@@ -0,0 +1,194 @@
+#pragma once
+
+#include "gpu_buffer.hpp"
+#include "render_context.hpp"
+
+#include <math/math.hpp>
+
+#include <span>
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <optional>
+#include <vulkan/vulkan.hpp>
+
+// 32 bytes, the vertex format gpu_scene.vert reads
+struct GpuSceneVertex {
+    float position[3];
+    float normal[3];
+    float uv[2];
+};
+
+// GPU-driven renderer for large numbers of static mesh instances. Instance data lives in storage buffers;
+// every frame a compute pass culls the instances against the frustum and a Hi-Z pyramid of the previous
+// frame's depth, selects a LOD per instance and writes the indirect draws. The CPU records the same handful
+// of commands no matter how many instances there are.
+//
+// cull() and buildDepthPyramid() record compute work and go in AppMain::onPreRender, draw() goes in onRender.
+// The pyramid follows RenderContext::extent: after a resize the first of the two in a frame waits for the GPU
+// and replaces it, and occlusion stays off until a depth buffer was reduced into the new one.
+struct GpuScene {
+    static constexpr uint32_t MAX_LODS = 4;
+    static constexpr uint32_t MAX_PYRAMID_LEVELS = 16;
+
+    struct Settings {
+        uint32_t max_instances = 65536;
+        uint32_t max_meshes = 256;
+        uint32_t max_vertices = 1u << 20;
+        uint32_t max_indices = 1u << 22;
+        // distance over bounding radius at which LOD 1 starts, each further LOD starts at twice the distance
+        float lod_distance = 16.0f;
+        bool occlusion = true;
+    };
+
+    struct Stats {
+        uint32_t instances = 0;
+        uint32_t draw_slots = 0;
+        uint32_t cpu_draw_calls = 0;
+    };
+
+    explicit GpuScene(const RenderContext& context);
+    GpuScene(const RenderContext& context, Settings settings);
+    ~GpuScene();
+
+    GpuScene(const GpuScene&) = delete;
+    GpuScene& operator=(const GpuScene&) = delete;
+
+    // lods holds the index ranges of each LOD, finest first, all indexing into vertices
+    auto addMesh(std::span<const GpuSceneVertex> vertices, std::span<const uint32_t> indices, std::span<const std::pair<uint32_t, uint32_t>> lods) -> std::optional<uint32_t>;
+
+    auto addInstance(uint32_t mesh, const Mat4& transform) -> std::optional<uint32_t>;
+    void setTransform(uint32_t instance, const Mat4& transform);
+    void removeInstance(uint32_t instance);
+
+    // Reduces a depth buffer into the Hi-Z pyramid used by the next cull(). The depth image must be in
+    // layout by the time the commands execute and stay alive until they finished. The main render pass'
+    // depth is transient and never stored, occlusion needs a depth the app renders and keeps itself.
+    void buildDepthPyramid(vk::CommandBuffer cmd, vk::ImageView depth, vk::ImageLayout layout, vk::Extent2D extent);
+
+    void cull(vk::CommandBuffer cmd, const Mat4& view_projection, const Vec3& camera);
+    void draw(vk::CommandBuffer cmd);
+
+    [[nodiscard]] auto stats() const noexcept -> const Stats& {
+        return _stats;
+    }
+
+private:
+    // std140/std430 layouts shared with the shaders
+    struct GpuInstance {
+        Mat4 transform;
+        uint32_t mesh;
+        uint32_t padding[3];
+    };
+
+    struct GpuMesh {
+        float center[3];
+        float radius;
+        uint32_t first_slot;
+        uint32_t lod_count;
+        uint32_t padding[2];
+    };
+
+    struct Params {
+        Mat4 view_projection;
+        Mat4 previous_view_projection;
+        float planes[6][4];
+        float camera[4];
+        uint32_t instance_count;
+        uint32_t slot_count;
+        uint32_t pyramid_width;
+        uint32_t pyramid_height;
+        uint32_t pyramid_levels;
+        uint32_t occlusion;
+        uint32_t padding[2];
+    };
+
+    struct Frame {
+        GpuBuffer params;
+        GpuBuffer instances;
+        // draw commands with zero instances, copied over commands before culling
+        GpuBuffer slots;
+        GpuBuffer bases;
+        GpuBuffer commands;
+        GpuBuffer draws;
+        GpuBuffer count;
+        GpuBuffer visible;
+        vk::DescriptorSet set;
+        vk::DescriptorSet depth_set;
+        vk::ImageView depth_view;
+        vk::ImageLayout depth_layout = vk::ImageLayout::eUndefined;
+
+        uint32_t dirty_begin = 0;
+        uint32_t dirty_end = 0;
+        bool slots_dirty = true;
+    };
+
+    void _createLayouts();
+    void _createPipelines();
+    void _createPyramid();
+    auto _allocatePyramid(vk::Extent2D extent) -> bool;
+    void _destroyPyramid() noexcept;
+    void _writePyramidSets();
+    void _resizePyramid();
+    void _createFrames();
+    void _writeSlots(Frame& frame);
+    void _markDirty(uint32_t instance);
+    void _updateSlotBases();
+
+    const RenderContext& context;
+    Settings settings;
+    Stats _stats;
+
+    vk::DescriptorPool pool;
+    vk::DescriptorSetLayout scene_layout;
+    vk::DescriptorSetLayout reduce_layout;
+    vk::PipelineLayout cull_layout;
+    vk::PipelineLayout reduce_pipeline_layout;
+    vk::PipelineLayout draw_layout;
+    vk::Pipeline cull_pipeline;
+    vk::Pipeline compact_pipeline;
+    vk::Pipeline reduce_pipeline;
+    vk::Pipeline draw_pipeline;
+    size_t shader_watch = 0;
+    vk::Sampler sampler;
+
+    GpuBuffer vertices;
+    GpuBuffer indices;
+    GpuBuffer meshes;
+    uint32_t vertex_count = 0;
+    uint32_t index_count = 0;
+
+    vk::Image pyramid;
+    VmaAllocation pyramid_allocation = nullptr;
+    vk::ImageView pyramid_view;
+    std::array<vk::ImageView, MAX_PYRAMID_LEVELS> pyramid_levels{};
+    std::array<vk::DescriptorSet, MAX_PYRAMID_LEVELS> reduce_sets{};
+    vk::Extent2D pyramid_extent;
+    // the surface extent the pyramid was sized for
+    vk::Extent2D pyramid_surface;
+    uint32_t pyramid_level_count = 0;
+    bool pyramid_initialized = false;
+    bool pyramid_ready = false;
+    // a 1x1 stand-in bound because the real pyramid did not fit in memory
+    bool pyramid_fallback = false;
+
+    // per mesh: lod index ranges and instance count; per slot: where its visible instances start
+    struct MeshInfo {
+        uint32_t first_slot;
+        uint32_t lod_count;
+        std::array<std::pair<uint32_t, uint32_t>, MAX_LODS> lods;
+        int32_t vertex_offset;
+        uint32_t instances;
+    };
+    std::vector<MeshInfo> mesh_infos;
+    std::vector<uint32_t> slot_bases;
+    uint32_t slot_count = 0;
+
+    std::vector<GpuInstance> instance_data;
+    std::vector<uint32_t> free_instances;
+    uint32_t live_instances = 0;
+
+    std::vector<Frame> frames;
+    Mat4 previous_view_projection;
+    bool has_previous = false;
+};
@@ -0,0 +1,231 @@
+#include "gpu_skinning.hpp"
+#include "gpu_scene.hpp"
+#include "shader.hpp"
+
+#include <debug.hpp>
+#include <resources/resource_system.hpp>
+
+#include <array>
+#include <cstring>
+#include <algorithm>
+
+namespace {
+    constexpr uint32_t GROUP_SIZE = 64;
+
+    enum Binding : uint32_t {
+        eSources,
+        eMatrices,
+        eInstances,
+        eOutputs
+    };
+
+    auto groups(uint32_t count, uint32_t size) noexcept -> uint32_t {
+        return (count + size - 1) / size;
+    }
+
+    void flush(VmaAllocator allocator, const GpuBuffer& buffer, vk::DeviceSize offset, vk::DeviceSize size) {
+        vmaFlushAllocation(allocator, buffer.allocation, offset, size);
+    }
+}
+
+GpuSkinning::GpuSkinning(const RenderContext& context) : GpuSkinning(context, Settings{}) {}
+
+GpuSkinning::GpuSkinning(const RenderContext& context, Settings settings) : context(context), settings(settings) {
+    _createLayouts();
+    _createPipeline();
+    _createBuffers();
+    shader_watch = watchShaders({"skinning.comp"}, [this] {
+        reloadPipelines(context.device, std::array{&pipeline}, [this] {
+            _createPipeline();
+        });
+    });
+}
+
+GpuSkinning::~GpuSkinning() {
+    ResourceSystem::unsubscribe(shader_watch);
+    const auto device = context.device;
+    device.waitIdle();
+
+    for (auto& frame : frames) {
+        frame.matrices.destroy(context.allocator);
+        frame.instances.destroy(context.allocator);
+    }
+    sources.destroy(context.allocator);
+    outputs.destroy(context.allocator);
+
+    device.destroyPipeline(pipeline);
+    device.destroyPipelineLayout(layout);
+    device.destroyDescriptorSetLayout(set_layout);
+    device.destroyDescriptorPool(pool);
+}
+
+void GpuSkinning::_createLayouts() {
+    auto bindings = std::array<vk::DescriptorSetLayoutBinding, eOutputs + 1>{};
+    for (uint32_t binding = eSources; binding <= eOutputs; binding++) {
+        bindings[binding] = vk::DescriptorSetLayoutBinding{
+            .binding = binding,
+            .descriptorType = vk::DescriptorType::eStorageBuffer,
+            .descriptorCount = 1,
+            .stageFlags = vk::ShaderStageFlagBits::eCompute
+        };
+    }
+    set_layout = context.device.createDescriptorSetLayout(vk::DescriptorSetLayoutCreateInfo{
+        .bindingCount = static_cast<uint32_t>(bindings.size()),
+        .pBindings = bindings.data()
+    });
+
+    const auto frame_count = context.image_count;
+    const auto size = vk::DescriptorPoolSize{
+        .type = vk::DescriptorType::eStorageBuffer,
+        .descriptorCount = frame_count * static_cast<uint32_t>(bindings.size())
+    };
+    pool = context.device.createDescriptorPool(vk::DescriptorPoolCreateInfo{
+        .maxSets = frame_count,
+        .poolSizeCount = 1,
+        .pPoolSizes = &size
+    });
+
+    const auto push = vk::PushConstantRange{
+        .stageFlags = vk::ShaderStageFlagBits::eCompute,
+        .offset = 0,
+        .size = sizeof(uint32_t)
+    };
+    layout = context.device.createPipelineLayout(vk::PipelineLayoutCreateInfo{
+        .setLayoutCount = 1,
+        .pSetLayouts = &set_layout,
+        .pushConstantRangeCount = 1,
+        .pPushConstantRanges = &push
+    });
+}
+
+void GpuSkinning::_createPipeline() {
+    const auto shader = loadShader(context.device, "skinning.comp");
+    if (!shader) {
+        return;
+    }
+    pipeline = context.device.createComputePipeline(nullptr, vk::ComputePipelineCreateInfo{
+        .stage = {
+            .stage = vk::ShaderStageFlagBits::eCompute,
+            .module = shader,
+            .pName = "main"
+        },
+        .layout = layout
+    }).value;
+    context.device.destroyShaderModule(shader);
+}
+
+void GpuSkinning::_createBuffers() {
+    const auto storage = vk::BufferUsageFlagBits::eStorageBuffer;
+
+    sources = GpuBuffer::create(context.allocator, vk::DeviceSize{settings.max_source_vertices} * sizeof(SkinnedVertex), storage, VMA_MEMORY_USAGE_CPU_TO_GPU);
+    outputs = GpuBuffer::create(context.allocator, vk::DeviceSize{settings.max_output_vertices} * sizeof(GpuSceneVertex), storage | vk::BufferUsageFlagBits::eVertexBuffer, VMA_MEMORY_USAGE_GPU_ONLY);
+    if (!sources || !outputs) {
+        Debug{"skinning"}.error("could not allocate buffers for {} skinned vertices", settings.max_output_vertices);
+    }
+
+    frames.resize(context.image_count);
+    for (auto& frame : frames) {
+        frame.matrices = GpuBuffer::create(context.allocator, vk::DeviceSize{settings.max_matrices} * sizeof(Mat4), storage, VMA_MEMORY_USAGE_CPU_TO_GPU);
+        frame.instances = GpuBuffer::create(context.allocator, vk::DeviceSize{settings.max_instances} * sizeof(GpuInstance), storage, VMA_MEMORY_USAGE_CPU_TO_GPU);
+        frame.set = context.device.allocateDescriptorSets(vk::DescriptorSetAllocateInfo{
+            .descriptorPool = pool,
+            .descriptorSetCount = 1,
+            .pSetLayouts = &set_layout
+        }).front();
+
+        const auto buffer = [](const GpuBuffer& b) {
+            return vk::DescriptorBufferInfo{.buffer = b.buffer, .offset = 0, .range = VK_WHOLE_SIZE};
+        };
+        const auto buffers = std::array{
+            buffer(sources),
+            buffer(frame.matrices),
+            buffer(frame.instances),
+            buffer(outputs)
+        };
+        auto writes = std::array<vk::WriteDescriptorSet, eOutputs + 1>{};
+        for (uint32_t binding = eSources; binding <= eOutputs; binding++) {
+            writes[binding] = vk::WriteDescriptorSet{
+                .dstSet = frame.set,
+                .dstBinding = binding,
+                .descriptorCount = 1,
+                .descriptorType = vk::DescriptorType::eStorageBuffer,
+                .pBufferInfo = &buffers[binding]
+            };
+        }
+        context.device.updateDescriptorSets(writes, nullptr);
+    }
+}
+
+auto GpuSkinning::addMesh(std::span<const SkinnedVertex> vertices) -> std::optional<uint32_t> {
+    if (vertices.empty() || source_count + vertices.size() > settings.max_source_vertices) {
+        Debug{"skinning"}.error("mesh does not fit, raise max_source_vertices in GpuSkinning::Settings");
+        return std::nullopt;
+    }
+
+    // the buffer only grows, so ranges in flight are never written
+    std::memcpy(static_cast<SkinnedVertex*>(sources.mapped) + source_count, vertices.data(), vertices.size_bytes());
+    flush(context.allocator, sources, source_count * sizeof(SkinnedVertex), vertices.size_bytes());
+
+    const auto count = static_cast<uint32_t>(vertices.size());
+    meshes.emplace_back(Mesh{.first_source = source_count, .vertex_count = count});
+    source_count += count;
+    max_mesh_vertices = std::max(max_mesh_vertices, count);
+    return static_cast<uint32_t>(meshes.size() - 1);
+}
+
+auto GpuSkinning::addInstance(uint32_t mesh, uint32_t first_matrix) -> std::optional<uint32_t> {
+    if (mesh >= meshes.size()) {
+        return std::nullopt;
+    }
+    const auto& info = meshes[mesh];
+    if (instances.size() == settings.max_instances || output_count + info.vertex_count > settings.max_output_vertices) {
+        Debug{"skinning"}.error("instance does not fit, raise the limits in GpuSkinning::Settings");
+        return std::nullopt;
+    }
+
+    instances.emplace_back(GpuInstance{
+        .first_source = info.first_source,
+        .vertex_count = info.vertex_count,
+        .first_matrix = first_matrix,
+        .first_output = output_count
+    });
+    output_count += info.vertex_count;
+    return static_cast<uint32_t>(instances.size() - 1);
+}
+
+void GpuSkinning::setFirstMatrix(uint32_t instance, uint32_t first_matrix) {
+    instances[instance].first_matrix = first_matrix;
+}
+
+void GpuSkinning::skin(vk::CommandBuffer cmd, std::span<const Mat4> matrices) {
+    if (!pipeline || instances.empty()) {
+        return;
+    }
+    if (matrices.size() > settings.max_matrices) {
+        Debug{"skinning"}.warn("{} matrices, only the first {} are uploaded", matrices.size(), settings.max_matrices);
+        matrices = matrices.first(settings.max_matrices);
+    }
+    auto& frame = frames[context.image_index];
+
+    const auto matrix_bytes = matrices.size_bytes();
+    const auto instance_bytes = instances.size() * sizeof(GpuInstance);
+    std::memcpy(frame.matrices.mapped, matrices.data(), matrix_bytes);
+    std::memcpy(frame.instances.mapped, instances.data(), instance_bytes);
+    flush(context.allocator, frame.matrices, 0, matrix_bytes);
+    flush(context.allocator, frame.instances, 0, instance_bytes);
+
+    // the last frame's draws read the vertices this overwrites
+    cmd.pipelineBarrier(vk::PipelineStageFlagBits::eVertexInput, vk::PipelineStageFlagBits::eComputeShader, {}, nullptr, nullptr, nullptr);
+
+    const auto instance_count = static_cast<uint32_t>(instances.size());
+    cmd.bindPipeline(vk::PipelineBindPoint::eCompute, pipeline);
+    cmd.bindDescriptorSets(vk::PipelineBindPoint::eCompute, layout, 0, frame.set, nullptr);
+    cmd.pushConstants(layout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(instance_count), &instance_count);
+    cmd.dispatch(groups(max_mesh_vertices, GROUP_SIZE), instance_count, 1);
+
+    const auto barrier = vk::MemoryBarrier{
+        .srcAccessMask = vk::AccessFlagBits::eShaderWrite,
+        .dstAccessMask = vk::AccessFlagBits::eVertexAttributeRead
+    };
+    cmd.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eVertexInput, {}, barrier, nullptr, nullptr);
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "gpu_buffer.hpp"
+#include "render_context.hpp"
+
+#include <math/math.hpp>
+
+#include <span>
+#include <vector>
+#include <cstdint>
+#include <optional>
+#include <vulkan/vulkan.hpp>
+
+// Up to four joints per vertex, with the weights as unorm8 that sum to 255
+struct SkinnedVertex {
+    float position[3];
+    float normal[3];
+    float uv[2];
+    // one joint index per byte, the lowest byte goes with the lowest weight byte
+    uint32_t joints;
+    uint32_t weights;
+};
+
+// Skins meshes in a compute pass instead of the vertex shader. Every instance gets its own range of skinned
+// vertices in vertexBuffer(), laid out as GpuSceneVertex, so any pipeline for static meshes draws them and
+// the skinning cost is paid once per frame no matter how many passes draw the mesh. All instances are
+// skinned by a single dispatch.
+//
+// Joint indices are relative to the instance's first matrix, which is the layout AnimationSystem::matrices()
+// produces. skin() records compute work and goes in AppMain::onPreRender.
+struct GpuSkinning {
+    struct Settings {
+        uint32_t max_source_vertices = 1u << 18;
+        uint32_t max_output_vertices = 1u << 20;
+        uint32_t max_matrices = 1u << 16;
+        uint32_t max_instances = 4096;
+    };
+
+    explicit GpuSkinning(const RenderContext& context);
+    GpuSkinning(const RenderContext& context, Settings settings);
+    ~GpuSkinning();
+
+    GpuSkinning(const GpuSkinning&) = delete;
+    GpuSkinning& operator=(const GpuSkinning&) = delete;
+
+    auto addMesh(std::span<const SkinnedVertex> vertices) -> std::optional<uint32_t>;
+    auto addInstance(uint32_t mesh, uint32_t first_matrix) -> std::optional<uint32_t>;
+    void setFirstMatrix(uint32_t instance, uint32_t first_matrix);
+
+    // vertex offset of the instance's skinned vertices, indices of the mesh are relative to it
+    [[nodiscard]] auto firstVertex(uint32_t instance) const noexcept -> uint32_t {
+        return instances[instance].first_output;
+    }
+
+    void skin(vk::CommandBuffer cmd, std::span<const Mat4> matrices);
+
+    [[nodiscard]] auto vertexBuffer() const noexcept -> vk::Buffer {
+        return outputs.buffer;
+    }
+
+private:
+    // std430 layout shared with skinning.comp
+    struct GpuInstance {
+        uint32_t first_source;
+        uint32_t vertex_count;
+        uint32_t first_matrix;
+        uint32_t first_output;
+    };
+
+    struct Mesh {
+        uint32_t first_source;
+        uint32_t vertex_count;
+    };
+
+    struct Frame {
+        GpuBuffer matrices;
+        GpuBuffer instances;
+        vk::DescriptorSet set;
+    };
+
+    void _createLayouts();
+    void _createPipeline();
+    void _createBuffers();
+
+    const RenderContext& context;
+    Settings settings;
+
+    vk::DescriptorPool pool;
+    vk::DescriptorSetLayout set_layout;
+    vk::PipelineLayout layout;
+    vk::Pipeline pipeline;
+    size_t shader_watch = 0;
+
+    GpuBuffer sources;
+    GpuBuffer outputs;
+    std::vector<Frame> frames;
+
+    std::vector<Mesh> meshes;
+    std::vector<GpuInstance> instances;
+    uint32_t source_count = 0;
+    uint32_t output_count = 0;
+    // of the largest mesh, the dispatch covers this many vertices of every instance
+    uint32_t max_mesh_vertices = 0;
+};
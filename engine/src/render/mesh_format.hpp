@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+
+// On-disk layout of a cooked mesh, written by the asset cooker from .obj sources (all integers little-endian):
+//
+//   MeshHeader
+//   MeshVertex[vertex_count]     at vertices_offset
+//   indices[index_count]         at indices_offset, uint16_t or uint32_t as index_size says
+//   MeshMeshlet[meshlet_count]   at meshlets_offset
+//
+// Every section starts on a MESH_SECTION_ALIGNMENT boundary and is laid out as the GPU reads it, so loading is
+// a copy per section. Indices are ordered for the post-transform vertex cache and, at the cluster level, for
+// overdraw; vertices are in the order the indices first use them.
+
+constexpr uint32_t MESH_SECTION_ALIGNMENT = 16;
+constexpr uint32_t MESHLET_MAX_VERTICES = 64;
+constexpr uint32_t MESHLET_MAX_TRIANGLES = 124;
+
+struct MeshHeader {
+    static constexpr uint32_t MAGIC = 0x48534D4A; // "JMSH"
+    static constexpr uint32_t VERSION = 1;
+
+    uint32_t magic;
+    uint32_t version;
+    uint32_t vertex_count;
+    uint32_t index_count;
+    uint32_t meshlet_count;
+    // 2 or 4 bytes, 16 bit indices whenever the vertices allow it
+    uint32_t index_size;
+    // positions dequantize to origin + unorm * scale, the same scale on every axis so that the dequantization
+    // can go into the model matrix without skewing normals
+    float origin[3];
+    float scale;
+    // bounding sphere in model space
+    float center[3];
+    float radius;
+    uint64_t vertices_offset;
+    uint64_t indices_offset;
+    uint64_t meshlets_offset;
+};
+
+// 16 bytes, half of a float position, normal and uv
+struct MeshVertex {
+    // R16G16B16A16_UNORM, w is unused
+    uint16_t position[4];
+    // R16G16_SNORM, octahedral encoding of the unit normal
+    int16_t normal[2];
+    // R16G16_SFLOAT
+    uint16_t uv[2];
+};
+
+// A run of up to MESHLET_MAX_TRIANGLES triangles using up to MESHLET_MAX_VERTICES vertices, for culling clusters
+// instead of whole meshes. Meshlets cover the index buffer in order.
+struct MeshMeshlet {
+    uint32_t first_index;
+    uint32_t index_count;
+    // bounding sphere in model space
+    float center[3];
+    float radius;
+    // Normal cone: every triangle faces away from a camera at c when
+    // dot(center - c, cone_axis) >= cone_cutoff * length(center - c) + radius. A cutoff of 1 never culls.
+    float cone_axis[3];
+    float cone_cutoff;
+};
+
+static_assert(sizeof(MeshHeader) == 80);
+static_assert(sizeof(MeshVertex) == 16);
+static_assert(sizeof(MeshMeshlet) == 40);
@@ -0,0 +1,532 @@
+#include "particle_system.hpp"
+#include "shader.hpp"
+
+#include <debug.hpp>
+#include <resources/resource_system.hpp>
+
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+namespace {
+    constexpr uint32_t GROUP_SIZE = 64;
+    // Particle in particles.glsl
+    constexpr uint32_t PARTICLE_SIZE = 48;
+    // the sort works on blocks of 2 * SORT_GROUP_SIZE keys in shared memory
+    constexpr uint32_t SORT_GROUP_SIZE = 256;
+    constexpr uint32_t SORT_BLOCK = SORT_GROUP_SIZE * 2;
+
+    enum Binding : uint32_t {
+        eParams,
+        eEmitters,
+        eParticles,
+        eAlive,
+        eDead,
+        eCounters,
+        eKeys
+    };
+
+    // Counters in particles.glsl, written by the compute passes and read by the indirect commands
+    struct Counters {
+        uint32_t alive_count[2];
+        int32_t dead_count;
+        uint32_t sort_size;
+        vk::DispatchIndirectCommand simulate;
+        vk::DispatchIndirectCommand sort;
+        vk::DrawIndirectCommand draw;
+    };
+
+    enum ArgsMode : uint32_t {
+        eBeforeSimulate,
+        eAfterSimulate
+    };
+
+    // global passes compare keys j apart for bitonic stage k; local passes run stages k through k_last, with
+    // every j that fits in a block, in shared memory
+    struct SortPass {
+        uint32_t k;
+        uint32_t j;
+        uint32_t k_last;
+        uint32_t local;
+    };
+
+    auto groups(uint32_t count, uint32_t size) noexcept -> uint32_t {
+        return (count + size - 1) / size;
+    }
+
+    void flush(VmaAllocator allocator, const GpuBuffer& buffer, vk::DeviceSize offset, vk::DeviceSize size) {
+        vmaFlushAllocation(allocator, buffer.allocation, offset, size);
+    }
+
+    void computeBarrier(vk::CommandBuffer cmd) {
+        const auto barrier = vk::MemoryBarrier{
+            .srcAccessMask = vk::AccessFlagBits::eShaderWrite,
+            .dstAccessMask = vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite | vk::AccessFlagBits::eIndirectCommandRead
+        };
+        cmd.pipelineBarrier(
+            vk::PipelineStageFlagBits::eComputeShader,
+            vk::PipelineStageFlagBits::eComputeShader | vk::PipelineStageFlagBits::eDrawIndirect,
+            {},
+            barrier,
+            nullptr,
+            nullptr
+        );
+    }
+}
+
+ParticleSystem::ParticleSystem(const RenderContext& context) : ParticleSystem(context, Settings{}) {}
+
+ParticleSystem::ParticleSystem(const RenderContext& context, Settings settings) : context(context), settings(settings) {
+    _createLayouts();
+    _createPipelines();
+    _createBuffers();
+
+    const auto shaders = std::vector<std::string>{
+        "particle_init.comp", "particle_emit.comp", "particle_args.comp", "particle_simulate.comp",
+        "particle_keys.comp", "particle_sort.comp", "particle.vert", "particle.frag"
+    };
+    shader_watch = watchShaders(shaders, [this] {
+        const auto pipelines = std::array{
+            &init_pipeline, &emit_pipeline, &args_pipeline, &simulate_pipeline, &keys_pipeline, &sort_pipeline, &draw_pipeline
+        };
+        reloadPipelines(context.device, pipelines, [this] {
+            _createPipelines();
+        });
+    });
+}
+
+ParticleSystem::~ParticleSystem() {
+    ResourceSystem::unsubscribe(shader_watch);
+    const auto device = context.device;
+    device.waitIdle();
+
+    for (auto& frame : frames) {
+        frame.params.destroy(context.allocator);
+        frame.emitters.destroy(context.allocator);
+    }
+    particles.destroy(context.allocator);
+    alive.destroy(context.allocator);
+    dead.destroy(context.allocator);
+    counters.destroy(context.allocator);
+    keys.destroy(context.allocator);
+
+    for (const auto pipeline : {init_pipeline, emit_pipeline, args_pipeline, simulate_pipeline, keys_pipeline, sort_pipeline, draw_pipeline}) {
+        device.destroyPipeline(pipeline);
+    }
+    device.destroyPipelineLayout(draw_layout);
+    device.destroyPipelineLayout(compute_layout);
+    device.destroyDescriptorSetLayout(set_layout);
+    device.destroyDescriptorPool(pool);
+}
+
+void ParticleSystem::_createLayouts() {
+    const auto compute = vk::ShaderStageFlagBits::eCompute;
+    const auto shared = vk::ShaderStageFlagBits::eCompute | vk::ShaderStageFlagBits::eVertex;
+    const auto storage = vk::DescriptorType::eStorageBuffer;
+
+    const auto bindings = std::array{
+        vk::DescriptorSetLayoutBinding{.binding = eParams, .descriptorType = vk::DescriptorType::eUniformBuffer, .descriptorCount = 1, .stageFlags = shared},
+        vk::DescriptorSetLayoutBinding{.binding = eEmitters, .descriptorType = storage, .descriptorCount = 1, .stageFlags = compute},
+        vk::DescriptorSetLayoutBinding{.binding = eParticles, .descriptorType = storage, .descriptorCount = 1, .stageFlags = shared},
+        vk::DescriptorSetLayoutBinding{.binding = eAlive, .descriptorType = storage, .descriptorCount = 1, .stageFlags = shared},
+        vk::DescriptorSetLayoutBinding{.binding = eDead, .descriptorType = storage, .descriptorCount = 1, .stageFlags = compute},
+        vk::DescriptorSetLayoutBinding{.binding = eCounters, .descriptorType = storage, .descriptorCount = 1, .stageFlags = compute},
+        vk::DescriptorSetLayoutBinding{.binding = eKeys, .descriptorType = storage, .descriptorCount = 1, .stageFlags = shared}
+    };
+    set_layout = context.device.createDescriptorSetLayout(vk::DescriptorSetLayoutCreateInfo{
+        .bindingCount = static_cast<uint32_t>(bindings.size()),
+        .pBindings = bindings.data()
+    });
+
+    const auto frame_count = context.image_count;
+    const auto sizes = std::array{
+        vk::DescriptorPoolSize{.type = vk::DescriptorType::eUniformBuffer, .descriptorCount = frame_count},
+        vk::DescriptorPoolSize{.type = storage, .descriptorCount = frame_count * 6}
+    };
+    pool = context.device.createDescriptorPool(vk::DescriptorPoolCreateInfo{
+        .maxSets = frame_count,
+        .poolSizeCount = static_cast<uint32_t>(sizes.size()),
+        .pPoolSizes = sizes.data()
+    });
+
+    const auto push = vk::PushConstantRange{
+        .stageFlags = compute,
+        .offset = 0,
+        .size = sizeof(SortPass)
+    };
+    compute_layout = context.device.createPipelineLayout(vk::PipelineLayoutCreateInfo{
+        .setLayoutCount = 1,
+        .pSetLayouts = &set_layout,
+        .pushConstantRangeCount = 1,
+        .pPushConstantRanges = &push
+    });
+    draw_layout = context.device.createPipelineLayout(vk::PipelineLayoutCreateInfo{
+        .setLayoutCount = 1,
+        .pSetLayouts = &set_layout
+    });
+}
+
+void ParticleSystem::_createPipelines() {
+    const auto init_shader = loadShader(context.device, "particle_init.comp");
+    const auto emit_shader = loadShader(context.device, "particle_emit.comp");
+    const auto args_shader = loadShader(context.device, "particle_args.comp");
+    const auto simulate_shader = loadShader(context.device, "particle_simulate.comp");
+    const auto keys_shader = loadShader(context.device, "particle_keys.comp");
+    const auto sort_shader = loadShader(context.device, "particle_sort.comp");
+    const auto vertex_shader = loadShader(context.device, "particle.vert");
+    const auto fragment_shader = loadShader(context.device, "particle.frag");
+
+    const auto computePipeline = [this](vk::ShaderModule module) {
+        if (!module) {
+            return vk::Pipeline{};
+        }
+        return context.device.createComputePipeline(nullptr, vk::ComputePipelineCreateInfo{
+            .stage = {
+                .stage = vk::ShaderStageFlagBits::eCompute,
+                .module = module,
+                .pName = "main"
+            },
+            .layout = compute_layout
+        }).value;
+    };
+    init_pipeline = computePipeline(init_shader);
+    emit_pipeline = computePipeline(emit_shader);
+    args_pipeline = computePipeline(args_shader);
+    simulate_pipeline = computePipeline(simulate_shader);
+    keys_pipeline = computePipeline(keys_shader);
+    sort_pipeline = computePipeline(sort_shader);
+
+    if (vertex_shader && fragment_shader) {
+        const auto stages = std::array{
+            vk::PipelineShaderStageCreateInfo{.stage = vk::ShaderStageFlagBits::eVertex, .module = vertex_shader, .pName = "main"},
+            vk::PipelineShaderStageCreateInfo{.stage = vk::ShaderStageFlagBits::eFragment, .module = fragment_shader, .pName = "main"}
+        };
+        // billboards are expanded from gl_VertexIndex, there are no vertex buffers
+        const auto vertex_input = vk::PipelineVertexInputStateCreateInfo{};
+        const auto input_assembly = vk::PipelineInputAssemblyStateCreateInfo{
+            .topology = vk::PrimitiveTopology::eTriangleStrip
+        };
+        const auto viewport = vk::PipelineViewportStateCreateInfo{
+            .viewportCount = 1,
+            .scissorCount = 1
+        };
+        const auto rasterization = vk::PipelineRasterizationStateCreateInfo{
+            .polygonMode = vk::PolygonMode::eFill,
+            .cullMode = vk::CullModeFlagBits::eNone,
+            .frontFace = vk::FrontFace::eCounterClockwise,
+            .lineWidth = 1.0f
+        };
+        const auto multisample = vk::PipelineMultisampleStateCreateInfo{
+            .rasterizationSamples = context.samples
+        };
+        const auto depth_stencil = vk::PipelineDepthStencilStateCreateInfo{
+            .depthTestEnable = true,
+            .depthWriteEnable = false,
+            .depthCompareOp = vk::CompareOp::eLessOrEqual
+        };
+        // sorted particles are blended over each other, unsorted ones only add up
+        const auto blend_attachment = vk::PipelineColorBlendAttachmentState{
+            .blendEnable = true,
+            .srcColorBlendFactor = vk::BlendFactor::eSrcAlpha,
+            .dstColorBlendFactor = settings.sort ? vk::BlendFactor::eOneMinusSrcAlpha : vk::BlendFactor::eOne,
+            .colorBlendOp = vk::BlendOp::eAdd,
+            .srcAlphaBlendFactor = vk::BlendFactor::eOne,
+            .dstAlphaBlendFactor = vk::BlendFactor::eOneMinusSrcAlpha,
+            .alphaBlendOp = vk::BlendOp::eAdd,
+            .colorWriteMask = vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG | vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA
+        };
+        const auto blend = vk::PipelineColorBlendStateCreateInfo{
+            .attachmentCount = 1,
+            .pAttachments = &blend_attachment
+        };
+        const auto dynamic_states = std::array{vk::DynamicState::eViewport, vk::DynamicState::eScissor};
+        const auto dynamic = vk::PipelineDynamicStateCreateInfo{
+            .dynamicStateCount = static_cast<uint32_t>(dynamic_states.size()),
+            .pDynamicStates = dynamic_states.data()
+        };
+
+        draw_pipeline = context.device.createGraphicsPipeline(nullptr, vk::GraphicsPipelineCreateInfo{
+            .stageCount = static_cast<uint32_t>(stages.size()),
+            .pStages = stages.data(),
+            .pVertexInputState = &vertex_input,
+            .pInputAssemblyState = &input_assembly,
+            .pViewportState = &viewport,
+            .pRasterizationState = &rasterization,
+            .pMultisampleState = &multisample,
+            .pDepthStencilState = &depth_stencil,
+            .pColorBlendState = &blend,
+            .pDynamicState = &dynamic,
+            .layout = draw_layout,
+            .renderPass = context.pass,
+            .subpass = 0
+        }).value;
+    }
+
+    for (const auto module : {init_shader, emit_shader, args_shader, simulate_shader, keys_shader, sort_shader, vertex_shader, fragment_shader}) {
+        context.device.destroyShaderModule(module);
+    }
+}
+
+void ParticleSystem::_createBuffers() {
+    const auto max = settings.max_particles;
+    const auto storage = vk::BufferUsageFlagBits::eStorageBuffer;
+
+    // sorting works on whole blocks, the smallest sort is one block
+    sort_capacity = std::max(std::bit_ceil(max), SORT_BLOCK);
+    particles = GpuBuffer::create(context.allocator, vk::DeviceSize{max} * PARTICLE_SIZE, storage, VMA_MEMORY_USAGE_GPU_ONLY);
+    alive = GpuBuffer::create(context.allocator, vk::DeviceSize{max} * 2 * sizeof(uint32_t), storage, VMA_MEMORY_USAGE_GPU_ONLY);
+    dead = GpuBuffer::create(context.allocator, vk::DeviceSize{max} * sizeof(uint32_t), storage, VMA_MEMORY_USAGE_GPU_ONLY);
+    counters = GpuBuffer::create(context.allocator, sizeof(Counters), storage | vk::BufferUsageFlagBits::eIndirectBuffer, VMA_MEMORY_USAGE_GPU_ONLY);
+    if (settings.sort) {
+        keys = GpuBuffer::create(context.allocator, vk::DeviceSize{sort_capacity} * 2 * sizeof(uint32_t), storage, VMA_MEMORY_USAGE_GPU_ONLY);
+    } else {
+        // the binding still needs a buffer
+        keys = GpuBuffer::create(context.allocator, 2 * sizeof(uint32_t), storage, VMA_MEMORY_USAGE_GPU_ONLY);
+    }
+    if (!particles || !alive || !dead || !counters || !keys) {
+        Debug{"particles"}.error("could not allocate buffers for {} particles", max);
+    }
+
+    frames.resize(context.image_count);
+    for (auto& frame : frames) {
+        frame.params = GpuBuffer::create(context.allocator, sizeof(Params), vk::BufferUsageFlagBits::eUniformBuffer, VMA_MEMORY_USAGE_CPU_TO_GPU);
+        frame.emitters = GpuBuffer::create(context.allocator, settings.max_emitters * sizeof(GpuEmitter), storage, VMA_MEMORY_USAGE_CPU_TO_GPU);
+        frame.set = context.device.allocateDescriptorSets(vk::DescriptorSetAllocateInfo{
+            .descriptorPool = pool,
+            .descriptorSetCount = 1,
+            .pSetLayouts = &set_layout
+        }).front();
+
+        const auto buffer = [](const GpuBuffer& b) {
+            return vk::DescriptorBufferInfo{.buffer = b.buffer, .offset = 0, .range = VK_WHOLE_SIZE};
+        };
+        const auto buffers = std::array{
+            buffer(frame.params),
+            buffer(frame.emitters),
+            buffer(particles),
+            buffer(alive),
+            buffer(dead),
+            buffer(counters),
+            buffer(keys)
+        };
+        auto writes = std::vector<vk::WriteDescriptorSet>{};
+        for (uint32_t binding = eParams; binding <= eKeys; binding++) {
+            writes.emplace_back(vk::WriteDescriptorSet{
+                .dstSet = frame.set,
+                .dstBinding = binding,
+                .descriptorCount = 1,
+                .descriptorType = binding == eParams ? vk::DescriptorType::eUniformBuffer : vk::DescriptorType::eStorageBuffer,
+                .pBufferInfo = &buffers[binding]
+            });
+        }
+        context.device.updateDescriptorSets(writes, nullptr);
+    }
+    emitters.reserve(settings.max_emitters);
+}
+
+auto ParticleSystem::addEmitter(const ParticleEmitter& emitter) -> std::optional<uint32_t> {
+    auto id = uint32_t{};
+    if (!free_emitters.empty()) {
+        id = free_emitters.back();
+        free_emitters.pop_back();
+    } else if (emitters.size() < settings.max_emitters) {
+        id = static_cast<uint32_t>(emitters.size());
+        emitters.emplace_back();
+    } else {
+        Debug{"particles"}.error("emitter limit of {} reached", settings.max_emitters);
+        return std::nullopt;
+    }
+    emitters[id] = EmitterState{.emitter = emitter, .alive = true};
+    return id;
+}
+
+void ParticleSystem::setEmitter(uint32_t id, const ParticleEmitter& emitter) {
+    emitters[id].emitter = emitter;
+}
+
+void ParticleSystem::removeEmitter(uint32_t id) {
+    if (!emitters[id].alive) {
+        return;
+    }
+    emitters[id].alive = false;
+    free_emitters.emplace_back(id);
+}
+
+void ParticleSystem::burst(uint32_t id, uint32_t count) {
+    emitters[id].burst += count;
+}
+
+void ParticleSystem::_dispatchArgs(vk::CommandBuffer cmd, uint32_t mode) {
+    const auto pass = SortPass{.local = mode};
+    cmd.bindPipeline(vk::PipelineBindPoint::eCompute, args_pipeline);
+    cmd.pushConstants(compute_layout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(pass), &pass);
+    cmd.dispatch(1, 1, 1);
+    computeBarrier(cmd);
+    _stats.dispatches++;
+}
+
+// Bitonic sort of the keys, recorded for the largest possible count. The dispatches are sized by the alive
+// count through the indirect arguments, and passes for stages past it return right away.
+void ParticleSystem::_sort(vk::CommandBuffer cmd) {
+    const auto offset = offsetof(Counters, sort);
+    const auto record = [&](const SortPass& pass) {
+        cmd.pushConstants(compute_layout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(pass), &pass);
+        cmd.dispatchIndirect(counters.buffer, offset);
+        computeBarrier(cmd);
+        _stats.dispatches++;
+    };
+
+    cmd.bindPipeline(vk::PipelineBindPoint::eCompute, keys_pipeline);
+    cmd.dispatchIndirect(counters.buffer, offset);
+    computeBarrier(cmd);
+    _stats.dispatches++;
+
+    cmd.bindPipeline(vk::PipelineBindPoint::eCompute, sort_pipeline);
+    record(SortPass{.k = 2, .j = 0, .k_last = std::min(sort_capacity, SORT_BLOCK), .local = 1});
+    for (auto k = SORT_BLOCK * 2; k <= sort_capacity; k *= 2) {
+        for (auto j = k / 2; j >= SORT_BLOCK; j /= 2) {
+            record(SortPass{.k = k, .j = j, .k_last = k, .local = 0});
+        }
+        record(SortPass{.k = k, .j = 0, .k_last = k, .local = 1});
+    }
+}
+
+void ParticleSystem::update(vk::CommandBuffer cmd, float dt, const Mat4& view, const Mat4& projection) {
+    _stats = Stats{};
+    if (!init_pipeline || !emit_pipeline || !args_pipeline || !simulate_pipeline || (settings.sort && (!keys_pipeline || !sort_pipeline))) {
+        return;
+    }
+    auto& frame = frames[context.image_index];
+
+    // emitters only send how many particles they spawn, the GPU does the rest
+    auto gpu_emitters = static_cast<GpuEmitter*>(frame.emitters.mapped);
+    auto emit_count = uint32_t{0};
+    auto emitter_count = uint32_t{0};
+    for (auto& state : emitters) {
+        if (!state.alive) {
+            continue;
+        }
+        _stats.emitters++;
+        state.accumulator += state.emitter.rate * dt;
+        const auto spawned = static_cast<uint32_t>(state.accumulator);
+        state.accumulator -= static_cast<float>(spawned);
+        const auto count = std::min(spawned + state.burst, settings.max_particles - emit_count);
+        state.burst = 0;
+        if (count == 0) {
+            continue;
+        }
+
+        const auto& e = state.emitter;
+        gpu_emitters[emitter_count++] = GpuEmitter{
+            .position = {e.position.x, e.position.y, e.position.z},
+            .radius = e.radius,
+            .velocity = {e.velocity.x, e.velocity.y, e.velocity.z},
+            .spread = e.spread,
+            .life_min = e.life_min,
+            .life_max = std::max(e.life_max, e.life_min),
+            .size_start = e.size_start,
+            .size_end = e.size_end,
+            .color_start = e.color_start,
+            .color_end = e.color_end,
+            .first = emit_count,
+            .count = count
+        };
+        emit_count += count;
+    }
+    if (emitter_count > 0) {
+        flush(context.allocator, frame.emitters, 0, emitter_count * sizeof(GpuEmitter));
+    }
+    _stats.emitted = emit_count;
+
+    // the camera's axes are the rows of the view rotation, its position is -R^T t
+    const auto& v = view.m;
+    const auto camera = Vec3{
+        -(v[0] * v[12] + v[1] * v[13] + v[2] * v[14]),
+        -(v[4] * v[12] + v[5] * v[13] + v[6] * v[14]),
+        -(v[8] * v[12] + v[9] * v[13] + v[10] * v[14])
+    };
+    const auto params = Params{
+        .view_projection = projection * view,
+        .camera = {camera.x, camera.y, camera.z, 0.0f},
+        .right = {v[0], v[4], v[8], 0.0f},
+        .up = {v[1], v[5], v[9], 0.0f},
+        .gravity = {settings.gravity.x, settings.gravity.y, settings.gravity.z, dt},
+        .max_particles = settings.max_particles,
+        .emit_count = emit_count,
+        .emitter_count = emitter_count,
+        .seed = seed++,
+        .current = current,
+        .drag = settings.drag,
+        .sorted = settings.sort
+    };
+    std::memcpy(frame.params.mapped, &params, sizeof(params));
+    flush(context.allocator, frame.params, 0, sizeof(params));
+
+    // the previous frame's draw is done with the lists and the counters
+    const auto barrier = vk::MemoryBarrier{
+        .srcAccessMask = vk::AccessFlagBits::eShaderWrite,
+        .dstAccessMask = vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite
+    };
+    cmd.pipelineBarrier(
+        vk::PipelineStageFlagBits::eDrawIndirect | vk::PipelineStageFlagBits::eVertexShader | vk::PipelineStageFlagBits::eComputeShader,
+        vk::PipelineStageFlagBits::eComputeShader,
+        {},
+        barrier,
+        nullptr,
+        nullptr
+    );
+    cmd.bindDescriptorSets(vk::PipelineBindPoint::eCompute, compute_layout, 0, frame.set, nullptr);
+
+    if (!initialized) {
+        cmd.bindPipeline(vk::PipelineBindPoint::eCompute, init_pipeline);
+        cmd.dispatch(groups(settings.max_particles, GROUP_SIZE), 1, 1);
+        computeBarrier(cmd);
+        _stats.dispatches++;
+        initialized = true;
+    }
+
+    if (emit_count > 0) {
+        cmd.bindPipeline(vk::PipelineBindPoint::eCompute, emit_pipeline);
+        cmd.dispatch(groups(emit_count, GROUP_SIZE), 1, 1);
+        computeBarrier(cmd);
+        _stats.dispatches++;
+    }
+
+    _dispatchArgs(cmd, eBeforeSimulate);
+    cmd.bindPipeline(vk::PipelineBindPoint::eCompute, simulate_pipeline);
+    cmd.dispatchIndirect(counters.buffer, offsetof(Counters, simulate));
+    computeBarrier(cmd);
+    _stats.dispatches++;
+    _dispatchArgs(cmd, eAfterSimulate);
+
+    if (settings.sort) {
+        _sort(cmd);
+    }
+
+    const auto draw_barrier = vk::MemoryBarrier{
+        .srcAccessMask = vk::AccessFlagBits::eShaderWrite,
+        .dstAccessMask = vk::AccessFlagBits::eIndirectCommandRead | vk::AccessFlagBits::eShaderRead
+    };
+    cmd.pipelineBarrier(
+        vk::PipelineStageFlagBits::eComputeShader,
+        vk::PipelineStageFlagBits::eDrawIndirect | vk::PipelineStageFlagBits::eVertexShader,
+        {},
+        draw_barrier,
+        nullptr,
+        nullptr
+    );
+
+    current = 1 - current;
+}
+
+void ParticleSystem::draw(vk::CommandBuffer cmd) {
+    if (!draw_pipeline || !initialized) {
+        return;
+    }
+    const auto& frame = frames[context.image_index];
+
+    cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, draw_pipeline);
+    cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, draw_layout, 0, frame.set, nullptr);
+    cmd.drawIndirect(counters.buffer, offsetof(Counters, draw), 1, sizeof(vk::DrawIndirectCommand));
+}
@@ -0,0 +1,166 @@
+#pragma once
+
+#include "gpu_buffer.hpp"
+#include "render_context.hpp"
+
+#include <math/math.hpp>
+
+#include <vector>
+#include <cstdint>
+#include <optional>
+#include <vulkan/vulkan.hpp>
+
+struct ParticleEmitter {
+    Vec3 position;
+    // particles spawn uniformly inside this sphere
+    float radius = 0.0f;
+    Vec3 velocity;
+    // random velocity added in any direction, up to this length
+    float spread = 1.0f;
+    // particles per second, bursts come on top
+    float rate = 0.0f;
+    float life_min = 1.0f;
+    float life_max = 2.0f;
+    float size_start = 0.1f;
+    float size_end = 0.0f;
+    // RGBA8 as in Sprite::packColor, interpolated over the particle's life
+    uint32_t color_start = 0xffffffff;
+    uint32_t color_end = 0x00ffffff;
+};
+
+// Particles that live entirely on the GPU. Emission, simulation and the optional back to front sort are
+// compute passes over storage buffers, and the draw is an indirect one whose instance count the simulation
+// writes, so the CPU never reads back or touches a particle. Its per frame cost is the emitters and a fixed
+// number of commands.
+//
+// Dead particles are recycled through a free list. Survivors are compacted into the other half of a ping-pong
+// alive list every frame, which is what the sort and the draw read. Without sort particles are blended
+// additively, which doesn't depend on order; with it they are alpha blended back to front by a bitonic sort
+// sized to the alive count rounded up to a power of two.
+//
+// update() records compute work and goes in AppMain::onPreRender, draw() goes in onRender.
+struct ParticleSystem {
+    struct Settings {
+        uint32_t max_particles = 1u << 20;
+        uint32_t max_emitters = 256;
+        Vec3 gravity{0.0f, -9.81f, 0.0f};
+        // fraction of the velocity lost per second
+        float drag = 0.0f;
+        bool sort = false;
+    };
+
+    struct Stats {
+        uint32_t emitters = 0;
+        // requested this frame, spawns past max_particles are dropped on the GPU
+        uint32_t emitted = 0;
+        uint32_t dispatches = 0;
+    };
+
+    explicit ParticleSystem(const RenderContext& context);
+    ParticleSystem(const RenderContext& context, Settings settings);
+    ~ParticleSystem();
+
+    ParticleSystem(const ParticleSystem&) = delete;
+    ParticleSystem& operator=(const ParticleSystem&) = delete;
+
+    auto addEmitter(const ParticleEmitter& emitter) -> std::optional<uint32_t>;
+    void setEmitter(uint32_t id, const ParticleEmitter& emitter);
+    void removeEmitter(uint32_t id);
+
+    // spawns count particles from the emitter with the next update
+    void burst(uint32_t id, uint32_t count);
+
+    void update(vk::CommandBuffer cmd, float dt, const Mat4& view, const Mat4& projection);
+    void draw(vk::CommandBuffer cmd);
+
+    [[nodiscard]] auto stats() const noexcept -> const Stats& {
+        return _stats;
+    }
+
+private:
+    // std140/std430 layouts shared with the shaders in particles.glsl
+    struct Params {
+        Mat4 view_projection;
+        float camera[4];
+        float right[4];
+        float up[4];
+        // xyz gravity, w the time step
+        float gravity[4];
+        uint32_t max_particles;
+        uint32_t emit_count;
+        uint32_t emitter_count;
+        uint32_t seed;
+        // the alive list emit and simulate read, simulate writes the other one
+        uint32_t current;
+        float drag;
+        uint32_t sorted;
+        uint32_t padding;
+    };
+
+    struct GpuEmitter {
+        float position[3];
+        float radius;
+        float velocity[3];
+        float spread;
+        float life_min;
+        float life_max;
+        float size_start;
+        float size_end;
+        uint32_t color_start;
+        uint32_t color_end;
+        // the emit invocations this emitter owns
+        uint32_t first;
+        uint32_t count;
+    };
+
+    struct Frame {
+        GpuBuffer params;
+        GpuBuffer emitters;
+        vk::DescriptorSet set;
+    };
+
+    struct EmitterState {
+        ParticleEmitter emitter;
+        float accumulator = 0.0f;
+        uint32_t burst = 0;
+        bool alive = false;
+    };
+
+    void _createLayouts();
+    void _createPipelines();
+    void _createBuffers();
+    void _dispatchArgs(vk::CommandBuffer cmd, uint32_t mode);
+    void _sort(vk::CommandBuffer cmd);
+
+    const RenderContext& context;
+    Settings settings;
+    Stats _stats;
+
+    vk::DescriptorPool pool;
+    vk::DescriptorSetLayout set_layout;
+    vk::PipelineLayout compute_layout;
+    vk::PipelineLayout draw_layout;
+    vk::Pipeline init_pipeline;
+    vk::Pipeline emit_pipeline;
+    vk::Pipeline args_pipeline;
+    vk::Pipeline simulate_pipeline;
+    vk::Pipeline keys_pipeline;
+    vk::Pipeline sort_pipeline;
+    vk::Pipeline draw_pipeline;
+    size_t shader_watch = 0;
+
+    GpuBuffer particles;
+    // two lists of max_particles indices
+    GpuBuffer alive;
+    GpuBuffer dead;
+    GpuBuffer counters;
+    GpuBuffer keys;
+    uint32_t sort_capacity = 0;
+
+    std::vector<Frame> frames;
+    std::vector<EmitterState> emitters;
+    std::vector<uint32_t> free_emitters;
+    uint32_t current = 0;
+    uint32_t seed = 0;
+    bool initialized = false;
+};
@@ -0,0 +1,99 @@
+#include "radix_sort.hpp"
+
+#include <jobs/job_system.hpp>
+
+#include <array>
+#include <vector>
+#include <algorithm>
+
+namespace {
+    // below this the passes cost more than a comparison sort
+    constexpr size_t MIN_RADIX_ITEMS = 256;
+    constexpr size_t MIN_BLOCK_ITEMS = 4096;
+    constexpr size_t MAX_BLOCKS = 64;
+}
+
+void radixSort(std::span<SortItem> items, std::span<SortItem> scratch) {
+    const auto count = items.size();
+    if (count < MIN_RADIX_ITEMS) {
+        std::stable_sort(items.begin(), items.end(), [](const SortItem& a, const SortItem& b) {
+            return a.key < b.key;
+        });
+        return;
+    }
+
+    const auto blocks = std::clamp<size_t>(count / MIN_BLOCK_ITEMS, 1, std::min(MAX_BLOCKS, JobSystem::threadCount() * 4));
+    const auto block_size = (count + blocks - 1) / blocks;
+    const auto range = [&](size_t block) {
+        return std::pair{block * block_size, std::min(count, (block + 1) * block_size)};
+    };
+
+    // reused between calls; the jobs reach them through the references, thread_locals would resolve per worker
+    thread_local auto histogram_storage = std::vector<std::array<uint32_t, 256>>{};
+    thread_local auto difference_storage = std::vector<uint64_t>{};
+    auto& histograms = histogram_storage;
+    auto& differences = difference_storage;
+    histograms.resize(blocks);
+    differences.assign(blocks, 0);
+
+    // bits that differ from the first key anywhere in the input
+    const auto reference = items[0].key;
+    JobSystem::parallelFor(blocks, 1, [&](size_t begin, size_t end) {
+        for (auto block = begin; block < end; block++) {
+            auto difference = uint64_t{0};
+            const auto [first, last] = range(block);
+            for (auto i = first; i < last; i++) {
+                difference |= items[i].key ^ reference;
+            }
+            differences[block] = difference;
+        }
+    });
+    auto difference = uint64_t{0};
+    for (const auto d : differences) {
+        difference |= d;
+    }
+
+    auto source = items.data();
+    auto target = scratch.data();
+    for (uint32_t shift = 0; shift < 64; shift += 8) {
+        if (((difference >> shift) & 0xFF) == 0) {
+            continue;
+        }
+
+        JobSystem::parallelFor(blocks, 1, [&](size_t begin, size_t end) {
+            for (auto block = begin; block < end; block++) {
+                auto& histogram = histograms[block];
+                histogram.fill(0);
+                const auto [first, last] = range(block);
+                for (auto i = first; i < last; i++) {
+                    histogram[(source[i].key >> shift) & 0xFF]++;
+                }
+            }
+        });
+
+        // each block writes its items of a digit after those of the blocks before it, which keeps the sort stable
+        auto offset = uint32_t{0};
+        for (size_t digit = 0; digit < 256; digit++) {
+            for (auto& histogram : histograms) {
+                const auto n = histogram[digit];
+                histogram[digit] = offset;
+                offset += n;
+            }
+        }
+
+        JobSystem::parallelFor(blocks, 1, [&](size_t begin, size_t end) {
+            for (auto block = begin; block < end; block++) {
+                auto& histogram = histograms[block];
+                const auto [first, last] = range(block);
+                for (auto i = first; i < last; i++) {
+                    target[histogram[(source[i].key >> shift) & 0xFF]++] = source[i];
+                }
+            }
+        });
+        std::swap(source, target);
+    }
+
+    if (source != items.data()) {
+        std::copy_n(source, count, items.data());
+    }
+}
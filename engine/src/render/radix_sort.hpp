@@ -0,0 +1,14 @@
+#pragma once
+
+#include <span>
+#include <cstdint>
+
+struct SortItem {
+    uint64_t key;
+    uint32_t index;
+};
+
+// Stable LSD radix sort on the keys, a byte per pass. Blocks of items are counted and scattered on the
+// job system, and passes over bytes every key has in common are skipped, so keys that only use their
+// upper bits cost no more than the bits in use. scratch must be at least as large as items.
+void radixSort(std::span<SortItem> items, std::span<SortItem> scratch);
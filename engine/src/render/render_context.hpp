@@ -0,0 +1,59 @@
+#pragma once
+
+#include <span>
+#include <cstdint>
+#include <optional>
+#include <entity.hpp>
+#include <math/math.hpp>
+#include <vk_mem_alloc.hpp>
+#include <vulkan/vulkan.hpp>
+
+struct RenderQueue;
+struct SpriteBatch;
+struct SpatialIndex;
+
+// What onPreRender and onRender work with. The device objects are valid from onAttach to onDetach; cmd and
+// image_index only change between frames. cmd is recording outside of any render pass during onPreRender and
+// inside the main render pass during onRender. Packets pushed to queue are sorted and recorded after onRender returns.
+struct RenderContext {
+    vk::Device device;
+    vk::PhysicalDevice gpu;
+    VmaAllocator allocator = nullptr;
+    vk::RenderPass pass;
+    vk::Extent2D extent;
+    // of the main render pass' color and depth attachments, pipelines have to match it
+    vk::SampleCountFlagBits samples = vk::SampleCountFlagBits::e1;
+
+    vk::CommandBuffer cmd;
+    uint32_t image_index = 0;
+    // counts up every frame, tells per image resources a new frame from more work in the same one
+    uint64_t frame = 0;
+    // the part of the attachments this frame renders to, below extent while dynamic resolution scales down.
+    // Viewport and scissor are already set to it; sprite coordinates stay in extent's pixels.
+    vk::Extent2D render_extent;
+    // picked by the frame governor, 0 is full quality and higher tiers are the app's to define
+    uint32_t quality_tier = 0;
+    // How far the frame is between the simulation's previous and current snapshot, see AppMain::snapshots.
+    // Stays 1 while the app has no SnapshotBuffer, so blending renders the current state.
+    float alpha = 1.0f;
+    uint32_t image_count = 0;
+
+    RenderQueue* queue = nullptr;
+    // drawn after the queue, only set between onAttach and onDetach
+    SpriteBatch* sprites = nullptr;
+
+    // The app keeps the bounds of its renderable entities in spatial and sets camera to the view-projection
+    // it renders with. Right before onPreRender the engine culls spatial against camera's frustum, visible
+    // then holds the entities in view until the next frame. Nothing is culled and visible stays empty while
+    // camera is empty.
+    SpatialIndex* spatial = nullptr;
+    std::optional<Mat4> camera;
+    std::span<const Entity> visible;
+
+    // optional device features, enabled when the gpu has them
+    bool multi_draw_indirect = false;
+    bool draw_indirect_first_instance = false;
+    bool draw_indirect_count = false;
+    // cube map array views
+    bool image_cube_array = false;
+};
@@ -0,0 +1,99 @@
+#include "render_queue.hpp"
+
+#include <memory/memory_system.hpp>
+
+RenderQueue::RenderQueue() : RenderQueue(MemorySystem::frame()) {}
+
+RenderQueue::RenderQueue(Allocator& frame_allocator)
+    : packets(frame_allocator), constants(frame_allocator), constant_data(frame_allocator), order(frame_allocator), scratch(frame_allocator) {}
+
+// sized for the last frame's draws, so pushing a similar frame allocates once per array
+void RenderQueue::clear() {
+    renew(packets);
+    renew(constants);
+    renew(constant_data);
+    renew(order);
+    renew(scratch);
+    sorted = true;
+}
+
+void RenderQueue::push(const DrawPacket& packet, std::span<const std::byte> push_constants) {
+    const auto index = static_cast<uint32_t>(packets.size());
+    packets.emplace_back(packet);
+    constants.emplace_back(Constants{
+        .offset = static_cast<uint32_t>(constant_data.size()),
+        .size = static_cast<uint32_t>(push_constants.size())
+    });
+    constant_data.insert(constant_data.end(), push_constants.begin(), push_constants.end());
+
+    sorted = sorted && (order.empty() || order.back().key <= packet.key);
+    order.emplace_back(SortItem{.key = packet.key, .index = index});
+}
+
+void RenderQueue::sort() {
+    // draws pushed in key order, e.g. a single layer, need no sorting at all
+    if (sorted) {
+        return;
+    }
+    scratch.resize(order.size());
+    radixSort(order, scratch);
+    sorted = true;
+}
+
+void RenderQueue::submit(vk::CommandBuffer cmd) {
+    sort();
+
+    auto stats = Stats{};
+    auto pipeline = vk::Pipeline{};
+    auto layout = vk::PipelineLayout{};
+    auto descriptor_set = vk::DescriptorSet{};
+    auto vertex_buffer = vk::Buffer{};
+    auto vertex_buffer_offset = vk::DeviceSize{};
+    auto index_buffer = vk::Buffer{};
+    auto index_buffer_offset = vk::DeviceSize{};
+    auto index_type = vk::IndexType::eUint16;
+
+    for (const auto& item : order) {
+        const auto& packet = packets[item.index];
+
+        if (packet.pipeline != pipeline) {
+            cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, packet.pipeline);
+            pipeline = packet.pipeline;
+            stats.pipeline_binds++;
+        }
+
+        // sets bound through another layout can't be relied on, so a layout change rebinds
+        if (packet.descriptor_set && (packet.descriptor_set != descriptor_set || packet.layout != layout)) {
+            cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, packet.layout, 0, packet.descriptor_set, {});
+            descriptor_set = packet.descriptor_set;
+            stats.descriptor_binds++;
+        }
+        layout = packet.layout;
+
+        if (packet.vertex_buffer && (packet.vertex_buffer != vertex_buffer || packet.vertex_buffer_offset != vertex_buffer_offset)) {
+            cmd.bindVertexBuffers(0, packet.vertex_buffer, packet.vertex_buffer_offset);
+            vertex_buffer = packet.vertex_buffer;
+            vertex_buffer_offset = packet.vertex_buffer_offset;
+            stats.vertex_binds++;
+        }
+
+        if (const auto& range = constants[item.index]; range.size != 0) {
+            cmd.pushConstants(packet.layout, packet.push_constant_stages, 0, range.size, constant_data.data() + range.offset);
+        }
+
+        if (packet.index_buffer) {
+            if (packet.index_buffer != index_buffer || packet.index_buffer_offset != index_buffer_offset || packet.index_type != index_type) {
+                cmd.bindIndexBuffer(packet.index_buffer, packet.index_buffer_offset, packet.index_type);
+                index_buffer = packet.index_buffer;
+                index_buffer_offset = packet.index_buffer_offset;
+                index_type = packet.index_type;
+                stats.index_binds++;
+            }
+            cmd.drawIndexed(packet.count, packet.instance_count, packet.first, packet.vertex_offset, packet.first_instance);
+        } else {
+            cmd.draw(packet.count, packet.instance_count, packet.first, packet.first_instance);
+        }
+        stats.draws++;
+    }
+    last_stats = stats;
+}
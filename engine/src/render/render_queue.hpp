@@ -0,0 +1,122 @@
+#pragma once
+
+#include "radix_sort.hpp"
+
+#include <span>
+#include <memory/allocator.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <vulkan/vulkan.hpp>
+
+// 64-bit draw order. Opaque keys sort by layer, pipeline, material and then front to back, so draws that
+// share state end up next to each other; translucent keys put depth (back to front) above the state.
+struct SortKey {
+    static constexpr uint32_t LAYER_BITS = 4;
+    static constexpr uint32_t PIPELINE_BITS = 12;
+    static constexpr uint32_t MATERIAL_BITS = 24;
+    static constexpr uint32_t DEPTH_BITS = 24;
+
+    // depth is the normalized view depth, 0 at the near plane and 1 at the far plane
+    static constexpr auto opaque(uint32_t layer, uint32_t pipeline, uint32_t material, float depth) noexcept -> uint64_t {
+        return _field(layer, LAYER_BITS) << (PIPELINE_BITS + MATERIAL_BITS + DEPTH_BITS)
+            | _field(pipeline, PIPELINE_BITS) << (MATERIAL_BITS + DEPTH_BITS)
+            | _field(material, MATERIAL_BITS) << DEPTH_BITS
+            | _quantize(depth);
+    }
+
+    static constexpr auto translucent(uint32_t layer, uint32_t pipeline, uint32_t material, float depth) noexcept -> uint64_t {
+        return _field(layer, LAYER_BITS) << (PIPELINE_BITS + MATERIAL_BITS + DEPTH_BITS)
+            | (_quantize(1.0f - depth)) << (PIPELINE_BITS + MATERIAL_BITS)
+            | _field(pipeline, PIPELINE_BITS) << MATERIAL_BITS
+            | _field(material, MATERIAL_BITS);
+    }
+
+private:
+    static constexpr auto _field(uint32_t value, uint32_t bits) noexcept -> uint64_t {
+        return static_cast<uint64_t>(value) & ((uint64_t{1} << bits) - 1);
+    }
+
+    static constexpr auto _quantize(float depth) noexcept -> uint64_t {
+        constexpr auto max = static_cast<float>((1u << DEPTH_BITS) - 1);
+        return static_cast<uint64_t>(std::clamp(depth, 0.0f, 1.0f) * max);
+    }
+};
+
+struct DrawPacket {
+    uint64_t key = 0;
+
+    vk::Pipeline pipeline;
+    vk::PipelineLayout layout;
+    // bound to set 0, usually the material
+    vk::DescriptorSet descriptor_set;
+
+    vk::Buffer vertex_buffer;
+    vk::DeviceSize vertex_buffer_offset = 0;
+    // packets without an index buffer are drawn non-indexed
+    vk::Buffer index_buffer;
+    vk::DeviceSize index_buffer_offset = 0;
+    vk::IndexType index_type = vk::IndexType::eUint16;
+
+    // indices, or vertices for non-indexed packets
+    uint32_t count = 0;
+    uint32_t first = 0;
+    int32_t vertex_offset = 0;
+    uint32_t instance_count = 1;
+    uint32_t first_instance = 0;
+
+    vk::ShaderStageFlags push_constant_stages = vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment;
+};
+
+// Draws collected during onRender, sorted by key and recorded with redundant binds left out.
+// Packets are never moved, only their keys are sorted. Everything pushed lives in the frame arena
+// (MemorySystem::frame()) until clear(), which has to come after every arena reset and before the next push.
+struct RenderQueue {
+    struct Stats {
+        uint32_t draws = 0;
+        uint32_t pipeline_binds = 0;
+        uint32_t descriptor_binds = 0;
+        uint32_t vertex_binds = 0;
+        uint32_t index_binds = 0;
+    };
+
+    RenderQueue();
+    explicit RenderQueue(Allocator& frame_allocator);
+
+    void clear();
+
+    // push_constants are copied into the queue and pushed at offset 0 before the draw
+    void push(const DrawPacket& packet, std::span<const std::byte> push_constants = {});
+
+    [[nodiscard]] auto size() const noexcept -> size_t {
+        return packets.size();
+    }
+
+    [[nodiscard]] auto empty() const noexcept -> bool {
+        return packets.empty();
+    }
+
+    void sort();
+
+    // Records every packet in sorted order
+    void submit(vk::CommandBuffer cmd);
+
+    // what the last submit() recorded
+    [[nodiscard]] auto stats() const noexcept -> const Stats& {
+        return last_stats;
+    }
+
+private:
+    struct Constants {
+        uint32_t offset = 0;
+        uint32_t size = 0;
+    };
+
+    AllocatorVector<DrawPacket> packets;
+    AllocatorVector<Constants> constants;
+    AllocatorVector<std::byte> constant_data;
+    AllocatorVector<SortItem> order;
+    AllocatorVector<SortItem> scratch;
+    bool sorted = true;
+    Stats last_stats{};
+};
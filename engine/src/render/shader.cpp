@@ -0,0 +1,32 @@
+#include "shader.hpp"
+
+#include <debug.hpp>
+#include <resources/resource.hpp>
+#include <resources/resource_system.hpp>
+
+#include <algorithm>
+#include <fmt/format.h>
+
+auto loadShader(vk::Device device, std::string_view name) -> vk::ShaderModule {
+    const auto code = ResourceSystem::get(fmt::format("shaders/{}.spv", name));
+    if (!code || code->size() % sizeof(uint32_t) != 0) {
+        Debug{"render"}.error("shader {} is missing", name);
+        return vk::ShaderModule{};
+    }
+    return device.createShaderModule(vk::ShaderModuleCreateInfo{
+        .codeSize = code->size(),
+        .pCode = reinterpret_cast<const uint32_t*>(code->bytes())
+    });
+}
+
+auto watchShaders(std::vector<std::string> names, std::function<void()> reload) -> size_t {
+    for (auto& name : names) {
+        name = fmt::format("shaders/{}.spv", name);
+    }
+    return ResourceSystem::subscribe([names = std::move(names), reload = std::move(reload)](const std::string& filename) {
+        if (std::find(names.begin(), names.end(), filename) != names.end()) {
+            Debug{"render"}.info("reloading {}", filename);
+            reload();
+        }
+    });
+}
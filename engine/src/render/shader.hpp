@@ -0,0 +1,45 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <utility>
+#include <functional>
+#include <string_view>
+#include <vulkan/vulkan.hpp>
+
+// Loads "shaders/<name>.spv" from the resource packs, the Android build compiles src/main/shaders there.
+// Returns a null module if the shader is missing.
+auto loadShader(vk::Device device, std::string_view name) -> vk::ShaderModule;
+
+// Calls reload from ResourceSystem::update() once for every change to one of the named shaders, e.g. when the
+// directory pack sees a recompiled .spv. Pipelines keep the code they were created from, so the owner waits
+// for the device and creates them again with loadShader(). The id goes to ResourceSystem::unsubscribe.
+auto watchShaders(std::vector<std::string> names, std::function<void()> reload) -> size_t;
+
+// For watchShaders handlers: waits for the device and creates the pipelines again with create, which assigns
+// them through the pointers. When a pipeline that existed before doesn't come out, e.g. because a shader was
+// caught half written, the previous ones are kept.
+template<size_t N, typename Create>
+void reloadPipelines(vk::Device device, const std::array<vk::Pipeline*, N>& pipelines, Create&& create) {
+    device.waitIdle();
+    auto previous = std::array<vk::Pipeline, N>{};
+    for (size_t i = 0; i < N; i++) {
+        previous[i] = std::exchange(*pipelines[i], vk::Pipeline{});
+    }
+    create();
+
+    auto complete = true;
+    for (size_t i = 0; i < N; i++) {
+        complete = complete && (*pipelines[i] || !previous[i]);
+    }
+    for (size_t i = 0; i < N; i++) {
+        if (complete) {
+            device.destroyPipeline(previous[i]);
+        } else {
+            device.destroyPipeline(*pipelines[i]);
+            *pipelines[i] = previous[i];
+        }
+    }
+}
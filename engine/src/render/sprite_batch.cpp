@@ -0,0 +1,313 @@
+#include "sprite_batch.hpp"
+#include "render_context.hpp"
+#include "shader.hpp"
+
+#include <debug.hpp>
+#include <memory/memory_system.hpp>
+#include <resources/resource_system.hpp>
+
+#include <array>
+
+namespace {
+    struct SpriteConstants {
+        float scale[2];
+        // sprites are read through the order buffer when they had to be sorted
+        uint32_t indirect;
+        uint32_t padding;
+    };
+
+    auto spriteKey(uint8_t layer, uint32_t texture) noexcept -> uint64_t {
+        return static_cast<uint64_t>(layer) << 32 | texture;
+    }
+}
+
+SpriteBatch::SpriteBatch(const RenderContext& context) : SpriteBatch(context, Settings{}) {}
+
+SpriteBatch::SpriteBatch(const RenderContext& context, Settings settings)
+    : context(context), settings(settings), runs(MemorySystem::frame()), keys(MemorySystem::frame()), scratch(MemorySystem::frame()) {
+    const auto frame_bindings = std::array{
+        vk::DescriptorSetLayoutBinding{.binding = 0, .descriptorType = vk::DescriptorType::eStorageBuffer, .descriptorCount = 1, .stageFlags = vk::ShaderStageFlagBits::eVertex},
+        vk::DescriptorSetLayoutBinding{.binding = 1, .descriptorType = vk::DescriptorType::eStorageBuffer, .descriptorCount = 1, .stageFlags = vk::ShaderStageFlagBits::eVertex}
+    };
+    frame_layout = context.device.createDescriptorSetLayout(vk::DescriptorSetLayoutCreateInfo{
+        .bindingCount = static_cast<uint32_t>(frame_bindings.size()),
+        .pBindings = frame_bindings.data()
+    });
+
+    const auto texture_binding = vk::DescriptorSetLayoutBinding{
+        .binding = 0,
+        .descriptorType = vk::DescriptorType::eCombinedImageSampler,
+        .descriptorCount = 1,
+        .stageFlags = vk::ShaderStageFlagBits::eFragment
+    };
+    texture_layout = context.device.createDescriptorSetLayout(vk::DescriptorSetLayoutCreateInfo{
+        .bindingCount = 1,
+        .pBindings = &texture_binding
+    });
+
+    const auto sizes = std::array{
+        vk::DescriptorPoolSize{.type = vk::DescriptorType::eStorageBuffer, .descriptorCount = context.image_count * 2},
+        vk::DescriptorPoolSize{.type = vk::DescriptorType::eCombinedImageSampler, .descriptorCount = settings.max_textures}
+    };
+    pool = context.device.createDescriptorPool(vk::DescriptorPoolCreateInfo{
+        .maxSets = context.image_count + settings.max_textures,
+        .poolSizeCount = static_cast<uint32_t>(sizes.size()),
+        .pPoolSizes = sizes.data()
+    });
+
+    const auto set_layouts = std::array{frame_layout, texture_layout};
+    const auto push_constants = vk::PushConstantRange{
+        .stageFlags = vk::ShaderStageFlagBits::eVertex,
+        .offset = 0,
+        .size = sizeof(SpriteConstants)
+    };
+    layout = context.device.createPipelineLayout(vk::PipelineLayoutCreateInfo{
+        .setLayoutCount = static_cast<uint32_t>(set_layouts.size()),
+        .pSetLayouts = set_layouts.data(),
+        .pushConstantRangeCount = 1,
+        .pPushConstantRanges = &push_constants
+    });
+
+    sampler = context.device.createSampler(vk::SamplerCreateInfo{
+        .magFilter = vk::Filter::eLinear,
+        .minFilter = vk::Filter::eLinear,
+        .mipmapMode = vk::SamplerMipmapMode::eLinear,
+        .addressModeU = vk::SamplerAddressMode::eClampToEdge,
+        .addressModeV = vk::SamplerAddressMode::eClampToEdge,
+        .addressModeW = vk::SamplerAddressMode::eClampToEdge,
+        .maxLod = VK_LOD_CLAMP_NONE
+    });
+
+    frames.resize(context.image_count);
+    for (auto& f : frames) {
+        f.sprites = GpuBuffer::create(context.allocator, settings.max_sprites * sizeof(Sprite), vk::BufferUsageFlagBits::eStorageBuffer, VMA_MEMORY_USAGE_CPU_TO_GPU);
+        f.order = GpuBuffer::create(context.allocator, settings.max_sprites * sizeof(uint32_t), vk::BufferUsageFlagBits::eStorageBuffer, VMA_MEMORY_USAGE_CPU_TO_GPU);
+        f.set = context.device.allocateDescriptorSets(vk::DescriptorSetAllocateInfo{
+            .descriptorPool = pool,
+            .descriptorSetCount = 1,
+            .pSetLayouts = &frame_layout
+        }).front();
+
+        const auto buffers = std::array{
+            vk::DescriptorBufferInfo{.buffer = f.sprites.buffer, .offset = 0, .range = VK_WHOLE_SIZE},
+            vk::DescriptorBufferInfo{.buffer = f.order.buffer, .offset = 0, .range = VK_WHOLE_SIZE}
+        };
+        const auto writes = std::array{
+            vk::WriteDescriptorSet{.dstSet = f.set, .dstBinding = 0, .descriptorCount = 1, .descriptorType = vk::DescriptorType::eStorageBuffer, .pBufferInfo = &buffers[0]},
+            vk::WriteDescriptorSet{.dstSet = f.set, .dstBinding = 1, .descriptorCount = 1, .descriptorType = vk::DescriptorType::eStorageBuffer, .pBufferInfo = &buffers[1]}
+        };
+        context.device.updateDescriptorSets(writes, nullptr);
+    }
+
+    _createPipeline();
+    shader_watch = watchShaders({"sprite.vert", "sprite.frag"}, [this] {
+        reloadPipelines(context.device, std::array{&pipeline}, [this] {
+            _createPipeline();
+        });
+    });
+}
+
+SpriteBatch::~SpriteBatch() {
+    ResourceSystem::unsubscribe(shader_watch);
+    context.device.waitIdle();
+
+    for (auto& f : frames) {
+        f.sprites.destroy(context.allocator);
+        f.order.destroy(context.allocator);
+    }
+    context.device.destroySampler(sampler);
+    context.device.destroyPipeline(pipeline);
+    context.device.destroyPipelineLayout(layout);
+    context.device.destroyDescriptorSetLayout(texture_layout);
+    context.device.destroyDescriptorSetLayout(frame_layout);
+    context.device.destroyDescriptorPool(pool);
+}
+
+void SpriteBatch::_createPipeline() {
+    const auto vertex_shader = loadShader(context.device, "sprite.vert");
+    const auto fragment_shader = loadShader(context.device, "sprite.frag");
+    if (!vertex_shader || !fragment_shader) {
+        context.device.destroyShaderModule(vertex_shader);
+        context.device.destroyShaderModule(fragment_shader);
+        return;
+    }
+
+    const auto stages = std::array{
+        vk::PipelineShaderStageCreateInfo{.stage = vk::ShaderStageFlagBits::eVertex, .module = vertex_shader, .pName = "main"},
+        vk::PipelineShaderStageCreateInfo{.stage = vk::ShaderStageFlagBits::eFragment, .module = fragment_shader, .pName = "main"}
+    };
+    // quads are generated from gl_VertexIndex, there are no vertex buffers
+    const auto vertex_input = vk::PipelineVertexInputStateCreateInfo{};
+    const auto input_assembly = vk::PipelineInputAssemblyStateCreateInfo{
+        .topology = vk::PrimitiveTopology::eTriangleStrip
+    };
+    const auto viewport = vk::PipelineViewportStateCreateInfo{
+        .viewportCount = 1,
+        .scissorCount = 1
+    };
+    const auto rasterization = vk::PipelineRasterizationStateCreateInfo{
+        .polygonMode = vk::PolygonMode::eFill,
+        .cullMode = vk::CullModeFlagBits::eNone,
+        .frontFace = vk::FrontFace::eCounterClockwise,
+        .lineWidth = 1.0f
+    };
+    const auto multisample = vk::PipelineMultisampleStateCreateInfo{
+        .rasterizationSamples = context.samples
+    };
+    const auto depth_stencil = vk::PipelineDepthStencilStateCreateInfo{
+        .depthTestEnable = false,
+        .depthWriteEnable = false
+    };
+    const auto blend_attachment = vk::PipelineColorBlendAttachmentState{
+        .blendEnable = true,
+        .srcColorBlendFactor = vk::BlendFactor::eSrcAlpha,
+        .dstColorBlendFactor = vk::BlendFactor::eOneMinusSrcAlpha,
+        .colorBlendOp = vk::BlendOp::eAdd,
+        .srcAlphaBlendFactor = vk::BlendFactor::eOne,
+        .dstAlphaBlendFactor = vk::BlendFactor::eOneMinusSrcAlpha,
+        .alphaBlendOp = vk::BlendOp::eAdd,
+        .colorWriteMask = vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG | vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA
+    };
+    const auto blend = vk::PipelineColorBlendStateCreateInfo{
+        .attachmentCount = 1,
+        .pAttachments = &blend_attachment
+    };
+    const auto dynamic_states = std::array{vk::DynamicState::eViewport, vk::DynamicState::eScissor};
+    const auto dynamic = vk::PipelineDynamicStateCreateInfo{
+        .dynamicStateCount = static_cast<uint32_t>(dynamic_states.size()),
+        .pDynamicStates = dynamic_states.data()
+    };
+
+    pipeline = context.device.createGraphicsPipeline(nullptr, vk::GraphicsPipelineCreateInfo{
+        .stageCount = static_cast<uint32_t>(stages.size()),
+        .pStages = stages.data(),
+        .pVertexInputState = &vertex_input,
+        .pInputAssemblyState = &input_assembly,
+        .pViewportState = &viewport,
+        .pRasterizationState = &rasterization,
+        .pMultisampleState = &multisample,
+        .pDepthStencilState = &depth_stencil,
+        .pColorBlendState = &blend,
+        .pDynamicState = &dynamic,
+        .layout = layout,
+        .renderPass = context.pass,
+        .subpass = 0
+    }).value;
+
+    context.device.destroyShaderModule(vertex_shader);
+    context.device.destroyShaderModule(fragment_shader);
+}
+
+auto SpriteBatch::addTexture(vk::ImageView view, vk::ImageLayout image_layout) -> std::optional<uint32_t> {
+    if (textures.size() == settings.max_textures) {
+        Debug{"sprites"}.error("texture limit of {} reached", settings.max_textures);
+        return std::nullopt;
+    }
+    const auto set = context.device.allocateDescriptorSets(vk::DescriptorSetAllocateInfo{
+        .descriptorPool = pool,
+        .descriptorSetCount = 1,
+        .pSetLayouts = &texture_layout
+    }).front();
+    const auto image = vk::DescriptorImageInfo{.sampler = sampler, .imageView = view, .imageLayout = image_layout};
+    context.device.updateDescriptorSets(vk::WriteDescriptorSet{
+        .dstSet = set,
+        .dstBinding = 0,
+        .descriptorCount = 1,
+        .descriptorType = vk::DescriptorType::eCombinedImageSampler,
+        .pImageInfo = &image
+    }, nullptr);
+
+    textures.emplace_back(set);
+    return static_cast<uint32_t>(textures.size() - 1);
+}
+
+void SpriteBatch::begin(uint32_t image_index) {
+    frame = &frames[image_index];
+    mapped = static_cast<Sprite*>(frame->sprites.mapped);
+    // keys only fill up once pushes go out of order, so they get room for all of the last frame's sprites
+    keys = AllocatorVector<SortItem>(keys.get_allocator());
+    keys.reserve(count);
+    count = 0;
+    renew(runs);
+    renew(scratch);
+    sorted = true;
+}
+
+void SpriteBatch::push(uint32_t texture, uint8_t layer, const Sprite& sprite) {
+    if (count == settings.max_sprites || mapped == nullptr) {
+        return;
+    }
+    const auto key = spriteKey(layer, texture);
+    if (sorted) {
+        if (runs.empty() || runs.back().key != key) {
+            if (!runs.empty() && key < runs.back().key) {
+                _unsort();
+            } else {
+                runs.emplace_back(Run{.key = key, .first = count, .count = 0});
+            }
+        }
+    }
+    if (sorted) {
+        runs.back().count++;
+    } else {
+        keys.emplace_back(SortItem{.key = key, .index = count});
+    }
+    mapped[count++] = sprite;
+}
+
+void SpriteBatch::_unsort() {
+    keys.resize(count);
+    for (const auto& run : runs) {
+        for (uint32_t i = run.first; i < run.first + run.count; i++) {
+            keys[i] = SortItem{.key = run.key, .index = i};
+        }
+    }
+    runs.clear();
+    sorted = false;
+}
+
+void SpriteBatch::submit(vk::CommandBuffer cmd, vk::Extent2D extent) {
+    last_stats = Stats{.sprites = count, .sorted = sorted};
+    if (count == 0 || !pipeline || frame == nullptr) {
+        return;
+    }
+    vmaFlushAllocation(context.allocator, frame->sprites.allocation, 0, count * sizeof(Sprite));
+
+    // sprites pushed in order, e.g. all in one layer from one atlas, are drawn from where they were written
+    if (!sorted) {
+        scratch.resize(keys.size());
+        radixSort(keys, scratch);
+        const auto order = static_cast<uint32_t*>(frame->order.mapped);
+        for (uint32_t i = 0; i < count; i++) {
+            order[i] = keys[i].index;
+            if (runs.empty() || runs.back().key != keys[i].key) {
+                runs.emplace_back(Run{.key = keys[i].key, .first = i, .count = 0});
+            }
+            runs.back().count++;
+        }
+        vmaFlushAllocation(context.allocator, frame->order.allocation, 0, count * sizeof(uint32_t));
+    }
+
+    const auto constants = SpriteConstants{
+        .scale = {2.0f / static_cast<float>(extent.width), 2.0f / static_cast<float>(extent.height)},
+        .indirect = sorted ? 0u : 1u
+    };
+    cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline);
+    cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, layout, 0, frame->set, nullptr);
+    cmd.pushConstants(layout, vk::ShaderStageFlagBits::eVertex, 0, sizeof(constants), &constants);
+
+    // runs that only differ in layer share a texture and are drawn together
+    for (size_t r = 0; r < runs.size();) {
+        const auto texture = static_cast<uint32_t>(runs[r].key);
+        const auto first = runs[r].first;
+        auto instances = uint32_t{0};
+        for (; r < runs.size() && static_cast<uint32_t>(runs[r].key) == texture; r++) {
+            instances += runs[r].count;
+        }
+        if (texture < textures.size()) {
+            cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, layout, 1, textures[texture], nullptr);
+            cmd.draw(4, instances, 0, first);
+            last_stats.batches++;
+        }
+    }
+}
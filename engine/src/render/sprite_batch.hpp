@@ -0,0 +1,121 @@
+#pragma once
+
+#include "gpu_buffer.hpp"
+#include "radix_sort.hpp"
+
+#include <vector>
+#include <cstdint>
+#include <optional>
+#include <vulkan/vulkan.hpp>
+#include <memory/allocator.hpp>
+
+struct RenderContext;
+
+// 32 bytes, read by sprite.vert straight from the mapped buffer. Positions and sizes are in pixels from
+// the top left corner of the surface, the sprite rotates around its center.
+struct Sprite {
+    float position[2];
+    float size[2];
+    // texture rectangle corners packed with packUv
+    uint32_t uv_min = 0;
+    uint32_t uv_max = 0xffffffff;
+    // RGBA8, multiplied with the texture
+    uint32_t color = 0xffffffff;
+    float rotation = 0.0f;
+
+    static constexpr auto packUv(float u, float v) noexcept -> uint32_t {
+        return static_cast<uint32_t>(u * 65535.0f + 0.5f) | static_cast<uint32_t>(v * 65535.0f + 0.5f) << 16;
+    }
+
+    static constexpr auto packColor(uint8_t r, uint8_t g, uint8_t b, uint8_t a) noexcept -> uint32_t {
+        return uint32_t{r} | uint32_t{g} << 8 | uint32_t{b} << 16 | uint32_t{a} << 24;
+    }
+};
+
+// Draws 2D sprites on top of the frame. Sprites go straight into a mapped per-frame buffer; at submit they
+// are ordered by layer and then texture, keeping push order within both, and every run of one texture is a
+// single instanced draw. Textures are meant to be atlases so that runs stay long.
+//
+// The engine owns one, reachable through RenderContext::sprites. Push during onRender, it is recorded after
+// the render queue, inside the main render pass. The sort keys live in the frame arena between begin() and
+// the arena's reset at the end of the frame.
+struct SpriteBatch {
+    struct Settings {
+        uint32_t max_sprites = 1u << 17;
+        uint32_t max_textures = 64;
+    };
+
+    struct Stats {
+        uint32_t sprites = 0;
+        uint32_t batches = 0;
+        bool sorted = false;
+    };
+
+    explicit SpriteBatch(const RenderContext& context);
+    SpriteBatch(const RenderContext& context, Settings settings);
+    ~SpriteBatch();
+
+    SpriteBatch(const SpriteBatch&) = delete;
+    SpriteBatch& operator=(const SpriteBatch&) = delete;
+
+    // The view has to stay valid while the batch is alive, textures are never removed
+    auto addTexture(vk::ImageView view, vk::ImageLayout layout) -> std::optional<uint32_t>;
+
+    // Starts a frame writing into the buffers of swapchain image image_index
+    void begin(uint32_t image_index);
+
+    // Sprites past max_sprites are dropped. Lower layers are drawn first.
+    void push(uint32_t texture, uint8_t layer, const Sprite& sprite);
+
+    void submit(vk::CommandBuffer cmd, vk::Extent2D extent);
+
+    [[nodiscard]] auto size() const noexcept -> uint32_t {
+        return count;
+    }
+
+    // what the last submit() recorded
+    [[nodiscard]] auto stats() const noexcept -> const Stats& {
+        return last_stats;
+    }
+
+private:
+    struct Frame {
+        GpuBuffer sprites;
+        GpuBuffer order;
+        vk::DescriptorSet set;
+    };
+
+    // consecutive sprites with the same key
+    struct Run {
+        uint64_t key;
+        uint32_t first;
+        uint32_t count;
+    };
+
+    void _createPipeline();
+    void _unsort();
+
+    const RenderContext& context;
+    Settings settings;
+
+    vk::DescriptorPool pool;
+    vk::DescriptorSetLayout frame_layout;
+    vk::DescriptorSetLayout texture_layout;
+    vk::PipelineLayout layout;
+    vk::Pipeline pipeline;
+    vk::Sampler sampler;
+    size_t shader_watch = 0;
+
+    std::vector<Frame> frames;
+    std::vector<vk::DescriptorSet> textures;
+
+    Frame* frame = nullptr;
+    Sprite* mapped = nullptr;
+    uint32_t count = 0;
+    // while pushes arrive in key order only runs are kept, keys are filled in once they don't
+    AllocatorVector<Run> runs;
+    AllocatorVector<SortItem> keys;
+    AllocatorVector<SortItem> scratch;
+    bool sorted = true;
+    Stats last_stats{};
+};
@@ -0,0 +1,461 @@
+#include "texture_loader.hpp"
+
+#include <debug.hpp>
+#include <resources/resource.hpp>
+#include <resources/resource_system.hpp>
+
+#include <cstring>
+#include <algorithm>
+#include <fmt/format.h>
+
+namespace {
+    // 2^15 texels on a side is past any gpu's limit
+    constexpr uint32_t MAX_LEVELS = 16;
+    // every block size divides this, as does the 4 buffer copies need
+    constexpr vk::DeviceSize STAGING_ALIGNMENT = 16;
+
+    constexpr uint8_t KTX2_IDENTIFIER[12] = {0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+
+    // KTX2 file layout, all integers little-endian. The level index follows the header with one entry per
+    // level, the largest level first.
+    struct Ktx2Header {
+        uint8_t identifier[12];
+        uint32_t vk_format;
+        uint32_t type_size;
+        uint32_t pixel_width;
+        uint32_t pixel_height;
+        uint32_t pixel_depth;
+        // 0 for textures that aren't arrays
+        uint32_t layer_count;
+        uint32_t face_count;
+        // 0 asks the loader to generate mips, which compressed textures can't have done
+        uint32_t level_count;
+        uint32_t supercompression_scheme;
+        uint32_t dfd_offset;
+        uint32_t dfd_length;
+        uint32_t kvd_offset;
+        uint32_t kvd_length;
+        uint64_t sgd_offset;
+        uint64_t sgd_length;
+    };
+
+    struct Ktx2Level {
+        uint64_t offset;
+        uint64_t length;
+        uint64_t uncompressed_length;
+    };
+
+    static_assert(sizeof(Ktx2Header) == 80);
+    static_assert(sizeof(Ktx2Level) == 24);
+
+    struct Block {
+        TextureLoader::Family family;
+        uint32_t width;
+        uint32_t height;
+        uint32_t bytes;
+    };
+
+    auto blockOf(vk::Format format) noexcept -> std::optional<Block> {
+        using F = vk::Format;
+        const auto value = static_cast<uint32_t>(format);
+        const auto in = [value](F first, F last) {
+            return value >= static_cast<uint32_t>(first) && value <= static_cast<uint32_t>(last);
+        };
+
+        if (in(F::eBc1RgbUnormBlock, F::eBc1RgbaSrgbBlock) || in(F::eBc4UnormBlock, F::eBc4SnormBlock)) {
+            return Block{TextureLoader::eBc, 4, 4, 8};
+        }
+        if (in(F::eBc2UnormBlock, F::eBc7SrgbBlock)) {
+            return Block{TextureLoader::eBc, 4, 4, 16};
+        }
+        if (in(F::eEtc2R8G8B8UnormBlock, F::eEtc2R8G8B8A1SrgbBlock) || in(F::eEacR11UnormBlock, F::eEacR11SnormBlock)) {
+            return Block{TextureLoader::eEtc2, 4, 4, 8};
+        }
+        if (in(F::eEtc2R8G8B8A8UnormBlock, F::eEtc2R8G8B8A8SrgbBlock) || in(F::eEacR11G11UnormBlock, F::eEacR11G11SnormBlock)) {
+            return Block{TextureLoader::eEtc2, 4, 4, 16};
+        }
+        if (in(F::eAstc4x4UnormBlock, F::eAstc12x12SrgbBlock)) {
+            // footprints in the order of the formats, each comes as UNORM and SRGB
+            constexpr uint8_t footprints[][2] = {
+                {4, 4}, {5, 4}, {5, 5}, {6, 5}, {6, 6}, {8, 5}, {8, 6},
+                {8, 8}, {10, 5}, {10, 6}, {10, 8}, {10, 10}, {12, 10}, {12, 12}
+            };
+            const auto& footprint = footprints[(value - static_cast<uint32_t>(F::eAstc4x4UnormBlock)) / 2];
+            return Block{TextureLoader::eAstc, footprint[0], footprint[1], 16};
+        }
+        return std::nullopt;
+    }
+
+    auto levelSize(const Block& block, uint32_t width, uint32_t height, uint32_t level, uint32_t layers) noexcept -> uint64_t {
+        const auto w = std::max(width >> level, 1u);
+        const auto h = std::max(height >> level, 1u);
+        const auto blocks_x = (w + block.width - 1) / block.width;
+        const auto blocks_y = (h + block.height - 1) / block.height;
+        return uint64_t{blocks_x} * blocks_y * block.bytes * layers;
+    }
+
+    auto align(vk::DeviceSize value, vk::DeviceSize alignment) noexcept -> vk::DeviceSize {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    auto extension(TextureLoader::Family family) noexcept -> const char* {
+        switch (family) {
+        case TextureLoader::eAstc:
+            return "astc";
+        case TextureLoader::eBc:
+            return "bc";
+        case TextureLoader::eEtc2:
+            return "etc2";
+        }
+        return "";
+    }
+}
+
+struct TextureLoader::Layout {
+    vk::Format format = vk::Format::eUndefined;
+    Block block{};
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t levels = 0;
+    // array layers times faces
+    uint32_t layers = 0;
+    bool cube = false;
+    bool array = false;
+    std::array<Ktx2Level, MAX_LEVELS> index{};
+    // staging bytes for every level
+    vk::DeviceSize total = 0;
+};
+
+auto TextureLoader::_parse(const Resource& resource) -> std::optional<Layout> {
+    auto header = Ktx2Header{};
+    if (resource.size() < sizeof(header)) {
+        Debug{"textures"}.error("not a KTX2 file, only {} bytes", resource.size());
+        return std::nullopt;
+    }
+    std::memcpy(&header, resource.bytes(), sizeof(header));
+    if (std::memcmp(header.identifier, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) != 0) {
+        Debug{"textures"}.error("not a KTX2 file");
+        return std::nullopt;
+    }
+
+    const auto format = static_cast<vk::Format>(header.vk_format);
+    const auto block = blockOf(format);
+    if (!block) {
+        Debug{"textures"}.error("{} is not a BC, ASTC or ETC2 format", vk::to_string(format));
+        return std::nullopt;
+    }
+    if (header.supercompression_scheme != 0) {
+        Debug{"textures"}.error("supercompressed KTX2 files need decoding, which the loader doesn't do");
+        return std::nullopt;
+    }
+    const auto levels = std::max(header.level_count, 1u);
+    const auto cube = header.face_count == 6;
+    if (header.pixel_width == 0 || header.pixel_height == 0 || header.pixel_depth != 0
+        || (header.face_count != 1 && !cube) || (cube && header.pixel_width != header.pixel_height)
+        || levels > MAX_LEVELS || (header.pixel_width | header.pixel_height) >> (levels - 1) == 0) {
+        Debug{"textures"}.error("only 2D textures, arrays and cube maps with up to {} levels are supported", MAX_LEVELS);
+        return std::nullopt;
+    }
+
+    auto layout = Layout{
+        .format = format,
+        .block = *block,
+        .width = header.pixel_width,
+        .height = header.pixel_height,
+        .levels = levels,
+        .layers = std::max(header.layer_count, 1u) * header.face_count,
+        .cube = cube,
+        .array = header.layer_count > 0
+    };
+    const auto index_end = sizeof(Ktx2Header) + uint64_t{levels} * sizeof(Ktx2Level);
+    if (resource.size() < index_end) {
+        Debug{"textures"}.error("KTX2 level index is cut off");
+        return std::nullopt;
+    }
+
+    // check every level before anything is allocated
+    for (uint32_t level = 0; level < levels; level++) {
+        auto& entry = layout.index[level];
+        std::memcpy(&entry, resource.bytes() + sizeof(Ktx2Header) + level * sizeof(Ktx2Level), sizeof(entry));
+        const auto expected = levelSize(*block, layout.width, layout.height, level, layout.layers);
+        if (entry.length != expected || entry.offset > resource.size() || entry.length > resource.size() - entry.offset) {
+            Debug{"textures"}.error("KTX2 level {} has {} bytes at {}, expected {} within the file", level, entry.length, entry.offset, expected);
+            return std::nullopt;
+        }
+        layout.total = align(layout.total, STAGING_ALIGNMENT) + entry.length;
+    }
+    return layout;
+}
+
+void Texture::destroy(vk::Device device, VmaAllocator allocator) noexcept {
+    if (view) {
+        device.destroyImageView(view);
+    }
+    if (image) {
+        vmaDestroyImage(allocator, image, allocation);
+    }
+    *this = Texture{};
+}
+
+TextureLoader::TextureLoader(const RenderContext& context) : TextureLoader(context, Settings{}) {}
+
+TextureLoader::TextureLoader(const RenderContext& context, Settings settings) : context(context), settings(settings) {
+    resource_watch = ResourceSystem::subscribe([this](const std::string& filename) {
+        const auto loaded = std::any_of(watched.begin(), watched.end(), [&filename](const Watched& item) {
+            return item.filename == filename;
+        });
+        if (loaded && std::find(changed.begin(), changed.end(), filename) == changed.end()) {
+            changed.emplace_back(filename);
+        }
+    });
+
+    // the formats every gpu with the family's device feature samples
+    const auto representatives = std::array{
+        std::pair{eAstc, vk::Format::eAstc4x4UnormBlock},
+        std::pair{eBc, vk::Format::eBc1RgbaUnormBlock},
+        std::pair{eEtc2, vk::Format::eEtc2R8G8B8A8UnormBlock}
+    };
+    for (const auto& [family, format] : representatives) {
+        if (supports(format)) {
+            supported_families[family_count++] = family;
+        }
+    }
+    if (family_count == 0) {
+        Debug{"textures"}.warn("the gpu samples none of the BC, ASTC and ETC2 formats");
+    }
+
+    frames.resize(context.image_count);
+    for (auto& frame : frames) {
+        frame.staging = GpuBuffer::create(context.allocator, settings.staging_size, vk::BufferUsageFlagBits::eTransferSrc, VMA_MEMORY_USAGE_CPU_ONLY);
+    }
+}
+
+TextureLoader::~TextureLoader() {
+    ResourceSystem::unsubscribe(resource_watch);
+    context.device.waitIdle();
+    for (auto& frame : frames) {
+        frame.staging.destroy(context.allocator);
+        for (auto& buffer : frame.overflow) {
+            buffer.destroy(context.allocator);
+        }
+    }
+}
+
+auto TextureLoader::supports(vk::Format format) const -> bool {
+    return static_cast<bool>(context.gpu.getFormatProperties(format).optimalTilingFeatures & vk::FormatFeatureFlagBits::eSampledImage);
+}
+
+auto TextureLoader::_stage(vk::DeviceSize size) -> std::pair<const GpuBuffer*, vk::DeviceSize> {
+    auto& frame = frames[context.image_index];
+    // the last frame on this image finished before its command buffer was reset
+    if (frame.frame != context.frame) {
+        for (auto& buffer : frame.overflow) {
+            buffer.destroy(context.allocator);
+        }
+        frame.overflow.clear();
+        frame.used = 0;
+        frame.frame = context.frame;
+    }
+
+    const auto offset = align(frame.used, STAGING_ALIGNMENT);
+    if (frame.staging && offset + size <= frame.staging.size) {
+        frame.used = offset + size;
+        return {&frame.staging, offset};
+    }
+
+    auto buffer = GpuBuffer::create(context.allocator, size, vk::BufferUsageFlagBits::eTransferSrc, VMA_MEMORY_USAGE_CPU_ONLY);
+    if (!buffer) {
+        return {nullptr, 0};
+    }
+    frame.overflow.emplace_back(buffer);
+    return {&frame.overflow.back(), 0};
+}
+
+auto TextureLoader::load(vk::CommandBuffer cmd, const Resource& resource) -> std::optional<Texture> {
+    const auto layout = _parse(resource);
+    if (!layout) {
+        return std::nullopt;
+    }
+    if (!supports(layout->format)) {
+        Debug{"textures"}.error("the gpu can't sample {}", vk::to_string(layout->format));
+        return std::nullopt;
+    }
+    if (layout->cube && layout->array && !context.image_cube_array) {
+        Debug{"textures"}.error("the gpu can't sample cube map arrays");
+        return std::nullopt;
+    }
+
+    const auto image_info = static_cast<VkImageCreateInfo>(vk::ImageCreateInfo{
+        .flags = layout->cube ? vk::ImageCreateFlagBits::eCubeCompatible : vk::ImageCreateFlags{},
+        .imageType = vk::ImageType::e2D,
+        .format = layout->format,
+        .extent = {layout->width, layout->height, 1},
+        .mipLevels = layout->levels,
+        .arrayLayers = layout->layers,
+        .samples = vk::SampleCountFlagBits::e1,
+        .tiling = vk::ImageTiling::eOptimal,
+        .usage = vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst,
+        .sharingMode = vk::SharingMode::eExclusive,
+        .initialLayout = vk::ImageLayout::eUndefined
+    });
+    const auto allocation_info = VmaAllocationCreateInfo{
+        .usage = VMA_MEMORY_USAGE_GPU_ONLY
+    };
+    auto texture = Texture{
+        .format = layout->format,
+        .extent = {layout->width, layout->height},
+        .levels = layout->levels,
+        .layers = layout->layers
+    };
+    auto image = VkImage{};
+    if (vmaCreateImage(context.allocator, &image_info, &allocation_info, &image, &texture.allocation, nullptr) != VK_SUCCESS) {
+        Debug{"textures"}.error("could not allocate a {}x{} {} texture", layout->width, layout->height, vk::to_string(layout->format));
+        return std::nullopt;
+    }
+    texture.image = image;
+
+    if (!_upload(cmd, resource, *layout, texture.image, vk::ImageLayout::eUndefined)) {
+        texture.destroy(context.device, context.allocator);
+        return std::nullopt;
+    }
+
+    const auto range = vk::ImageSubresourceRange{
+        .aspectMask = vk::ImageAspectFlagBits::eColor,
+        .baseMipLevel = 0,
+        .levelCount = layout->levels,
+        .baseArrayLayer = 0,
+        .layerCount = layout->layers
+    };
+    auto view_type = layout->cube ? vk::ImageViewType::eCube : vk::ImageViewType::e2D;
+    if (layout->array) {
+        view_type = layout->cube ? vk::ImageViewType::eCubeArray : vk::ImageViewType::e2DArray;
+    }
+    texture.view = context.device.createImageView(vk::ImageViewCreateInfo{
+        .image = texture.image,
+        .viewType = view_type,
+        .format = layout->format,
+        .subresourceRange = range
+    });
+    return texture;
+}
+
+// Levels go from the resource to staging memory as they are, each with one copy region. The image comes from
+// old_layout and is left in ShaderReadOnlyOptimal; a reload waits for the shaders that sampled the old contents.
+auto TextureLoader::_upload(vk::CommandBuffer cmd, const Resource& resource, const Layout& layout, vk::Image image, vk::ImageLayout old_layout) -> bool {
+    const auto [staging, base] = _stage(layout.total);
+    if (staging == nullptr) {
+        Debug{"textures"}.error("could not allocate {} bytes of staging memory", layout.total);
+        return false;
+    }
+
+    auto regions = std::array<vk::BufferImageCopy, MAX_LEVELS>{};
+    auto offset = base;
+    for (uint32_t level = 0; level < layout.levels; level++) {
+        const auto& entry = layout.index[level];
+        offset = align(offset, STAGING_ALIGNMENT);
+        std::memcpy(static_cast<char*>(staging->mapped) + offset, resource.bytes() + entry.offset, entry.length);
+        regions[level] = vk::BufferImageCopy{
+            .bufferOffset = offset,
+            .bufferRowLength = 0,
+            .bufferImageHeight = 0,
+            .imageSubresource = {
+                .aspectMask = vk::ImageAspectFlagBits::eColor,
+                .mipLevel = level,
+                .baseArrayLayer = 0,
+                .layerCount = layout.layers
+            },
+            .imageOffset = {0, 0, 0},
+            .imageExtent = {std::max(layout.width >> level, 1u), std::max(layout.height >> level, 1u), 1}
+        };
+        offset += entry.length;
+    }
+    vmaFlushAllocation(context.allocator, staging->allocation, base, layout.total);
+
+    const auto shader_stages = vk::PipelineStageFlagBits::eVertexShader | vk::PipelineStageFlagBits::eFragmentShader | vk::PipelineStageFlagBits::eComputeShader;
+    const auto range = vk::ImageSubresourceRange{
+        .aspectMask = vk::ImageAspectFlagBits::eColor,
+        .baseMipLevel = 0,
+        .levelCount = layout.levels,
+        .baseArrayLayer = 0,
+        .layerCount = layout.layers
+    };
+    const auto to_transfer = vk::ImageMemoryBarrier{
+        .srcAccessMask = {},
+        .dstAccessMask = vk::AccessFlagBits::eTransferWrite,
+        .oldLayout = old_layout,
+        .newLayout = vk::ImageLayout::eTransferDstOptimal,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = image,
+        .subresourceRange = range
+    };
+    const auto src_stages = old_layout == vk::ImageLayout::eUndefined ? vk::PipelineStageFlags{vk::PipelineStageFlagBits::eTopOfPipe} : shader_stages;
+    cmd.pipelineBarrier(src_stages, vk::PipelineStageFlagBits::eTransfer, {}, nullptr, nullptr, to_transfer);
+    cmd.copyBufferToImage(staging->buffer, image, vk::ImageLayout::eTransferDstOptimal, vk::ArrayProxy<const vk::BufferImageCopy>{layout.levels, regions.data()});
+    const auto to_shader = vk::ImageMemoryBarrier{
+        .srcAccessMask = vk::AccessFlagBits::eTransferWrite,
+        .dstAccessMask = vk::AccessFlagBits::eShaderRead,
+        .oldLayout = vk::ImageLayout::eTransferDstOptimal,
+        .newLayout = vk::ImageLayout::eShaderReadOnlyOptimal,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = image,
+        .subresourceRange = range
+    };
+    cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, shader_stages, {}, nullptr, nullptr, to_shader);
+    return true;
+}
+
+auto TextureLoader::load(vk::CommandBuffer cmd, const std::string& name) -> std::optional<Texture> {
+    for (const auto family : families()) {
+        auto filename = fmt::format("{}.{}.ktx2", name, extension(family));
+        const auto resource = ResourceSystem::get(filename);
+        if (!resource) {
+            continue;
+        }
+        auto texture = load(cmd, *resource);
+        if (texture) {
+            watched.emplace_back(Watched{.filename = std::move(filename), .texture = *texture});
+        }
+        return texture;
+    }
+    Debug{"textures"}.error("{} has no variant in a format the gpu samples", name);
+    return std::nullopt;
+}
+
+void TextureLoader::destroy(Texture& texture) noexcept {
+    std::erase_if(watched, [&texture](const Watched& item) {
+        return item.texture.image == texture.image;
+    });
+    texture.destroy(context.device, context.allocator);
+}
+
+// Contents are replaced in the same image, so views and descriptor sets stay valid. A file that changed its
+// format, size or number of levels or layers would need a new image, which is left to a restart.
+void TextureLoader::update(vk::CommandBuffer cmd) {
+    if (changed.empty()) {
+        return;
+    }
+    for (const auto& filename : changed) {
+        const auto resource = ResourceSystem::get(filename);
+        const auto layout = resource ? _parse(*resource) : std::nullopt;
+        if (!layout) {
+            continue;
+        }
+        for (const auto& item : watched) {
+            if (item.filename != filename) {
+                continue;
+            }
+            const auto& texture = item.texture;
+            if (layout->format != texture.format || layout->width != texture.extent.width || layout->height != texture.extent.height
+                || layout->levels != texture.levels || layout->layers != texture.layers) {
+                Debug{"textures"}.warn("{} changed its format or shape, restart to reload it", filename);
+                continue;
+            }
+            if (_upload(cmd, *resource, *layout, texture.image, vk::ImageLayout::eShaderReadOnlyOptimal)) {
+                Debug{"textures"}.info("reloaded {}", filename);
+            }
+        }
+    }
+    changed.clear();
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "gpu_buffer.hpp"
+#include "render_context.hpp"
+
+#include <span>
+#include <array>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <utility>
+#include <optional>
+#include <vk_mem_alloc.hpp>
+#include <vulkan/vulkan.hpp>
+
+struct Resource;
+
+// A sampled image with all of its mip levels, in ShaderReadOnlyOptimal once the upload commands executed
+struct Texture {
+    vk::Image image;
+    VmaAllocation allocation = nullptr;
+    vk::ImageView view;
+    vk::Format format = vk::Format::eUndefined;
+    vk::Extent2D extent;
+    uint32_t levels = 0;
+    // array layers times faces
+    uint32_t layers = 0;
+
+    void destroy(vk::Device device, VmaAllocator allocator) noexcept;
+
+    [[nodiscard]] explicit operator bool() const noexcept {
+        return static_cast<bool>(image);
+    }
+};
+
+// Loads block compressed textures from KTX2 containers: BC on desktop GPUs, ASTC and ETC2 on mobile ones.
+// The GPU samples these formats as they are, so a level is copied from the resource into staging memory
+// exactly once and goes to the image with a buffer to image copy, with no decoding and nothing allocated per
+// level. 2D textures, arrays and cube maps are supported, cube map arrays where the GPU has imageCubeArray;
+// supercompressed files (Basis, zstd) are not.
+//
+// load() records the upload into cmd and goes in AppMain::onPreRender. Staging memory is per swapchain image
+// and reused once that image comes around again; a frame that uploads more than staging_size gets a one-off
+// buffer for the rest.
+//
+// Textures loaded by name are uploaded again when their file changes in a resource pack, e.g. the directory
+// pack during development. The new contents go into the same image at the next update(), so views and
+// descriptor sets that refer to it need no changes. Those textures are destroyed through the loader.
+struct TextureLoader {
+    enum Family : uint8_t {
+        eAstc,
+        eBc,
+        eEtc2
+    };
+
+    struct Settings {
+        vk::DeviceSize staging_size = vk::DeviceSize{16} << 20;
+    };
+
+    explicit TextureLoader(const RenderContext& context);
+    TextureLoader(const RenderContext& context, Settings settings);
+    ~TextureLoader();
+
+    TextureLoader(const TextureLoader&) = delete;
+    TextureLoader& operator=(const TextureLoader&) = delete;
+
+    // the compression families the gpu samples, in the order load(cmd, name) tries them
+    [[nodiscard]] auto families() const noexcept -> std::span<const Family> {
+        return {supported_families.data(), family_count};
+    }
+
+    // whether the gpu can sample format from an optimally tiled image
+    [[nodiscard]] auto supports(vk::Format format) const -> bool;
+
+    auto load(vk::CommandBuffer cmd, const Resource& resource) -> std::optional<Texture>;
+
+    // Loads the first of "<name>.astc.ktx2", "<name>.bc.ktx2" and "<name>.etc2.ktx2" that the gpu supports
+    // and the resource packs have, so every platform gets the variant it can sample.
+    auto load(vk::CommandBuffer cmd, const std::string& name) -> std::optional<Texture>;
+
+    // Records the uploads of textures whose files changed since the last call, goes in AppMain::onPreRender
+    void update(vk::CommandBuffer cmd);
+
+    // destroys the texture and stops reloading it
+    void destroy(Texture& texture) noexcept;
+
+private:
+    struct Frame {
+        GpuBuffer staging;
+        vk::DeviceSize used = 0;
+        uint64_t frame = 0;
+        // uploads that did not fit into staging, freed with it
+        std::vector<GpuBuffer> overflow;
+    };
+
+    struct Watched {
+        std::string filename;
+        Texture texture;
+    };
+
+    // what a KTX2 file holds once its header and level index checked out
+    struct Layout;
+
+    static auto _parse(const Resource& resource) -> std::optional<Layout>;
+    auto _stage(vk::DeviceSize size) -> std::pair<const GpuBuffer*, vk::DeviceSize>;
+    auto _upload(vk::CommandBuffer cmd, const Resource& resource, const Layout& layout, vk::Image image, vk::ImageLayout old_layout) -> bool;
+
+    const RenderContext& context;
+    Settings settings;
+    std::vector<Frame> frames;
+    std::array<Family, 3> supported_families{};
+    size_t family_count = 0;
+    std::vector<Watched> watched;
+    std::vector<std::string> changed;
+    size_t resource_watch = 0;
+};
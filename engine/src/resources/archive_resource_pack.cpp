@@ -0,0 +1,353 @@
+#include "archive_resource_pack.hpp"
+#include "pack_format.hpp"
+#include "resource_stream.hpp"
+#include "resource.hpp"
+
+#include <debug.hpp>
+#include <compression/lz4.hpp>
+#include <jobs/job_system.hpp>
+
+#include <span>
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+
+#if _WIN32
+#elif __ANDROID__
+#include <android/asset_manager.h>
+#endif
+
+namespace {
+    // entries with fewer blocks than this are decoded on the calling thread
+    constexpr size_t MIN_BLOCKS_PER_JOB = 4;
+}
+
+struct ArchiveResourcePack::Impl {
+    Debug logger{"resources"};
+
+    std::mutex mutex;
+#if __ANDROID__
+    AAsset* asset = nullptr;
+#else
+    std::ifstream file;
+#endif
+
+    PackHeader header{};
+    std::vector<PackEntry> entries;
+    std::vector<PackBlock> blocks;
+    std::vector<char> names;
+
+    Impl() = default;
+
+    ~Impl() {
+#if __ANDROID__
+        if (asset != nullptr) {
+            AAsset_close(asset);
+        }
+#endif
+    }
+
+    auto open(const std::string& filename) -> bool {
+#if __ANDROID__
+        extern auto AndroidPlatform_getAssets() -> AAssetManager*;
+
+        asset = AAssetManager_open(AndroidPlatform_getAssets(), filename.c_str(), AASSET_MODE_RANDOM);
+        return asset != nullptr;
+#else
+        file.open(filename, std::ios::binary);
+        return file.is_open();
+#endif
+    }
+
+    auto read(uint64_t offset, std::span<char> bytes) -> bool {
+        std::lock_guard lock{mutex};
+#if __ANDROID__
+        if (AAsset_seek64(asset, static_cast<off64_t>(offset), SEEK_SET) < 0) {
+            return false;
+        }
+        size_t total = 0;
+        while (total < bytes.size()) {
+            const auto count = AAsset_read(asset, bytes.data() + total, bytes.size() - total);
+            if (count <= 0) {
+                return false;
+            }
+            total += static_cast<size_t>(count);
+        }
+        return true;
+#else
+        file.clear();
+        file.seekg(static_cast<std::streamoff>(offset));
+        file.read(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+        return file.good();
+#endif
+    }
+
+    template<typename T>
+    auto readArray(uint64_t offset, std::vector<T>& out, size_t count) -> bool {
+        out.resize(count);
+        return read(offset, std::span(reinterpret_cast<char*>(out.data()), count * sizeof(T)));
+    }
+
+    auto fileSize() -> uint64_t {
+        std::lock_guard lock{mutex};
+#if __ANDROID__
+        return static_cast<uint64_t>(AAsset_getLength64(asset));
+#else
+        file.clear();
+        file.seekg(0, std::ios::end);
+        const auto size = file.tellg();
+        return size < 0 ? 0 : static_cast<uint64_t>(size);
+#endif
+    }
+
+    auto loadIndex() -> bool {
+        if (!read(0, std::span(reinterpret_cast<char*>(&header), sizeof(PackHeader)))) {
+            return false;
+        }
+        if (header.magic != PackHeader::MAGIC || header.version != PackHeader::VERSION) {
+            return false;
+        }
+        const auto size = fileSize();
+        if (!within(header.entries_offset, uint64_t{header.entry_count} * sizeof(PackEntry), size)
+            || !within(header.blocks_offset, uint64_t{header.block_count} * sizeof(PackBlock), size)
+            || !within(header.names_offset, header.names_size, size)) {
+            return false;
+        }
+        return readArray(header.entries_offset, entries, header.entry_count)
+            && readArray(header.blocks_offset, blocks, header.block_count)
+            && readArray(header.names_offset, names, header.names_size)
+            && validIndex(size);
+    }
+
+    // offset + count fits in size, without overflowing
+    static auto within(uint64_t offset, uint64_t count, uint64_t size) noexcept -> bool {
+        return offset <= size && count <= size - offset;
+    }
+
+    // Everything get(), open() and the streams index with is checked here once, so a truncated or corrupt pack
+    // is rejected as a whole instead of reading out of bounds later
+    auto validIndex(uint64_t size) const -> bool {
+        const auto sorted = std::is_sorted(entries.begin(), entries.end(), [](const PackEntry& a, const PackEntry& b) {
+            return a.path_hash < b.path_hash;
+        });
+        if (!sorted) {
+            return false;
+        }
+        for (const auto& entry : entries) {
+            if (!within(entry.name_offset, entry.name_size, names.size())) {
+                return false;
+            }
+            if (!entry.compressed()) {
+                if (entry.compressed_size != entry.uncompressed_size || !within(entry.offset, entry.uncompressed_size, size)) {
+                    return false;
+                }
+                continue;
+            }
+            if (!validBlocks(entry, size)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Every block but the last holds block_size bytes and the blocks add up to the entry. Each one has to lie
+    // inside the entry's payload, and fit the block_size buffers the streams decode through.
+    auto validBlocks(const PackEntry& entry, uint64_t size) const -> bool {
+        if (header.block_size == 0 || !within(entry.first_block, entry.block_count, blocks.size())) {
+            return false;
+        }
+        if (!within(entry.offset, entry.compressed_size, size) || blocks[entry.first_block].offset != entry.offset) {
+            return false;
+        }
+        const auto expected = (entry.uncompressed_size + header.block_size - 1) / header.block_size;
+        if (expected != entry.block_count) {
+            return false;
+        }
+        auto remaining = entry.uncompressed_size;
+        for (uint32_t i = 0; i < entry.block_count; i++) {
+            const auto& block = blocks[entry.first_block + i];
+            if (block.uncompressed_size != std::min<uint64_t>(remaining, header.block_size)
+                || block.compressed_size > header.block_size
+                || block.offset < entry.offset
+                || !within(block.offset - entry.offset, block.compressed_size, entry.compressed_size)) {
+                return false;
+            }
+            remaining -= block.uncompressed_size;
+        }
+        return true;
+    }
+
+    auto find(const std::string& filename) const -> const PackEntry* {
+        const auto hash = packPathHash(filename);
+        auto it = std::lower_bound(entries.begin(), entries.end(), hash, [](const PackEntry& entry, uint64_t hash) {
+            return entry.path_hash < hash;
+        });
+        for (; it != entries.end() && it->path_hash == hash; ++it) {
+            if (std::string_view(names.data() + it->name_offset, it->name_size) == filename) {
+                return &*it;
+            }
+        }
+        return nullptr;
+    }
+
+    static auto decodeBlock(const PackBlock& block, const char* src, char* dst) -> bool {
+        const auto input = std::span(src, block.compressed_size);
+        const auto output = std::span(dst, block.uncompressed_size);
+        if (!block.compressed()) {
+            std::copy(input.begin(), input.end(), output.begin());
+            return true;
+        }
+        const auto size = LZ4::decompress(input, output);
+        return size.has_value() && *size == block.uncompressed_size;
+    }
+
+    auto decodeBlocks(const PackEntry& entry, size_t first, size_t last, const char* src, char* dst) const -> bool {
+        const auto base = blocks[entry.first_block].offset;
+        for (size_t i = first; i < last; i++) {
+            const auto& block = blocks[entry.first_block + i];
+            if (!decodeBlock(block, src + (block.offset - base), dst + i * header.block_size)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Blocks are independent, so large entries are split into contiguous block ranges and decoded on the job system
+    auto decode(const PackEntry& entry, const char* src, char* dst) const -> bool {
+        const auto count = static_cast<size_t>(entry.block_count);
+        auto success = std::atomic<bool>{true};
+        JobSystem::parallelFor(count, MIN_BLOCKS_PER_JOB, [&](size_t first, size_t last) {
+            if (!decodeBlocks(entry, first, last, src, dst)) {
+                success.store(false, std::memory_order_relaxed);
+            }
+        });
+        return success.load(std::memory_order_relaxed);
+    }
+};
+
+namespace {
+    struct ArchiveResourceStream : ResourceStream {
+        ArchiveResourceStream(ArchiveResourcePack::Impl& pack, const PackEntry& entry) : pack(pack), entry(entry) {
+            if (entry.compressed()) {
+                block = std::make_unique<char[]>(pack.header.block_size);
+                scratch = std::make_unique<char[]>(pack.header.block_size);
+            }
+        }
+
+        [[nodiscard]] auto size() const noexcept -> size_t override {
+            return static_cast<size_t>(entry.uncompressed_size);
+        }
+
+        [[nodiscard]] auto tell() const noexcept -> size_t override {
+            return position;
+        }
+
+        auto seek(size_t offset) -> bool override {
+            if (offset > size()) {
+                return false;
+            }
+            position = offset;
+            return true;
+        }
+
+        auto read(std::span<char> bytes) -> size_t override {
+            const auto count = std::min(bytes.size(), size() - position);
+            if (count == 0) {
+                return 0;
+            }
+            if (!entry.compressed()) {
+                if (!pack.read(entry.offset + position, bytes.first(count))) {
+                    return 0;
+                }
+                position += count;
+                return count;
+            }
+
+            size_t total = 0;
+            while (total < count) {
+                const auto index = position / pack.header.block_size;
+                if (index != current_block && !load(index)) {
+                    break;
+                }
+                const auto& info = pack.blocks[entry.first_block + index];
+                const auto offset = position - index * pack.header.block_size;
+                const auto chunk = std::min<size_t>(count - total, info.uncompressed_size - offset);
+                std::copy_n(block.get() + offset, chunk, bytes.data() + total);
+                total += chunk;
+                position += chunk;
+            }
+            return total;
+        }
+
+    private:
+        auto load(size_t index) -> bool {
+            const auto& info = pack.blocks[entry.first_block + index];
+            if (!pack.read(info.offset, std::span(scratch.get(), info.compressed_size))) {
+                return false;
+            }
+            if (!ArchiveResourcePack::Impl::decodeBlock(info, scratch.get(), block.get())) {
+                return false;
+            }
+            current_block = index;
+            return true;
+        }
+
+        ArchiveResourcePack::Impl& pack;
+        PackEntry entry;
+        size_t position = 0;
+        size_t current_block = SIZE_MAX;
+        std::unique_ptr<char[]> block;
+        std::unique_ptr<char[]> scratch;
+    };
+}
+
+auto ArchiveResourcePack::load(const std::string& filename) -> std::unique_ptr<ArchiveResourcePack> {
+    auto impl = std::make_unique<Impl>();
+    if (!impl->open(filename)) {
+        impl->logger.error("could not open resource pack: {}", filename);
+        return nullptr;
+    }
+    if (!impl->loadIndex()) {
+        impl->logger.error("invalid resource pack: {}", filename);
+        return nullptr;
+    }
+    return std::unique_ptr<ArchiveResourcePack>(new ArchiveResourcePack(std::move(impl)));
+}
+
+ArchiveResourcePack::ArchiveResourcePack(std::unique_ptr<Impl> impl) : impl(std::move(impl)) {}
+ArchiveResourcePack::~ArchiveResourcePack() = default;
+
+auto ArchiveResourcePack::get(const std::string& filename) -> std::optional<Resource> {
+    const auto entry = impl->find(filename);
+    if (entry == nullptr) {
+        return std::nullopt;
+    }
+
+    auto resource = Resource(static_cast<size_t>(entry->uncompressed_size), static_cast<size_t>(entry->compressed_size));
+    if (!entry->compressed()) {
+        if (!impl->read(entry->offset, std::span(resource.bytes_for_write(), resource.size()))) {
+            return std::nullopt;
+        }
+        return resource;
+    }
+
+    auto compressed = std::make_unique<char[]>(static_cast<size_t>(entry->compressed_size));
+    if (!impl->read(entry->offset, std::span(compressed.get(), static_cast<size_t>(entry->compressed_size)))) {
+        return std::nullopt;
+    }
+    if (!impl->decode(*entry, compressed.get(), resource.bytes_for_write())) {
+        impl->logger.error("corrupted resource: {}", filename);
+        return std::nullopt;
+    }
+    return resource;
+}
+
+auto ArchiveResourcePack::open(const std::string& filename) -> std::unique_ptr<ResourceStream> {
+    const auto entry = impl->find(filename);
+    if (entry == nullptr) {
+        return nullptr;
+    }
+    return std::make_unique<ArchiveResourceStream>(*impl, *entry);
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "resource_pack.hpp"
+
+#include <memory>
+
+// Reads files from a pack archive produced by the asset cooker, see pack_format.hpp
+struct ArchiveResourcePack : ResourcePack {
+    struct Impl;
+
+    static auto load(const std::string& filename) -> std::unique_ptr<ArchiveResourcePack>;
+
+    ~ArchiveResourcePack() override;
+
+    auto get(const std::string& filename) -> std::optional<Resource> override;
+
+    // Compressed entries are decoded one block at a time; the stream must not outlive the pack
+    auto open(const std::string& filename) -> std::unique_ptr<ResourceStream> override;
+
+private:
+    explicit ArchiveResourcePack(std::unique_ptr<Impl> impl);
+
+    std::unique_ptr<Impl> impl;
+};
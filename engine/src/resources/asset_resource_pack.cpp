@@ -0,0 +1,85 @@
+#include "asset_resource_pack.hpp"
+#include "resource_stream.hpp"
+#include "resource.hpp"
+
+#if _WIN32
+#else
+#include <android/asset_manager.h>
+#endif
+
+#if _WIN32
+#else
+namespace {
+    // AASSET_MODE_STREAMING lets the platform read ahead sequentially instead of mapping the whole asset
+    struct AssetResourceStream : ResourceStream {
+        explicit AssetResourceStream(AAsset* asset) : asset(asset), length(static_cast<size_t>(AAsset_getLength64(asset))) {}
+
+        ~AssetResourceStream() override {
+            AAsset_close(asset);
+        }
+
+        [[nodiscard]] auto size() const noexcept -> size_t override {
+            return length;
+        }
+
+        [[nodiscard]] auto tell() const noexcept -> size_t override {
+            return position;
+        }
+
+        auto seek(size_t offset) -> bool override {
+            if (offset > length || AAsset_seek64(asset, static_cast<off64_t>(offset), SEEK_SET) < 0) {
+                return false;
+            }
+            position = offset;
+            return true;
+        }
+
+        auto read(std::span<char> bytes) -> size_t override {
+            const auto count = AAsset_read(asset, bytes.data(), bytes.size());
+            if (count <= 0) {
+                return 0;
+            }
+            position += static_cast<size_t>(count);
+            return static_cast<size_t>(count);
+        }
+
+    private:
+        AAsset* asset;
+        size_t length;
+        size_t position = 0;
+    };
+}
+#endif
+
+auto AssetResourcePack::get(const std::string& filename) -> std::optional<Resource> {
+#if _WIN32
+    return std::nullopt;
+#else
+    extern auto AndroidPlatform_getAssets() -> AAssetManager*;
+
+    auto assets = AndroidPlatform_getAssets();
+    auto asset = AAssetManager_open(assets, filename.c_str(), AASSET_MODE_BUFFER);
+    if (asset == nullptr) {
+        return std::nullopt;
+    }
+
+    auto resource = Resource(static_cast<size_t>(AAsset_getLength(asset)));
+    AAsset_read(asset, resource.bytes_for_write(), resource.size());
+    AAsset_close(asset);
+    return resource;
+#endif
+}
+
+auto AssetResourcePack::open(const std::string& filename) -> std::unique_ptr<ResourceStream> {
+#if _WIN32
+    return nullptr;
+#else
+    extern auto AndroidPlatform_getAssets() -> AAssetManager*;
+
+    auto asset = AAssetManager_open(AndroidPlatform_getAssets(), filename.c_str(), AASSET_MODE_STREAMING);
+    if (asset == nullptr) {
+        return nullptr;
+    }
+    return std::make_unique<AssetResourceStream>(asset);
+#endif
+}
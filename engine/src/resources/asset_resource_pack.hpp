@@ -0,0 +1,9 @@
+#pragma once
+
+#include "resource_pack.hpp"
+
+// Reads files straight from the application assets (the APK on Android)
+struct AssetResourcePack : ResourcePack {
+    auto get(const std::string& filename) -> std::optional<Resource> override;
+    auto open(const std::string& filename) -> std::unique_ptr<ResourceStream> override;
+};
@@ -0,0 +1,269 @@
+#include "directory_resource_pack.hpp"
+#include "resource_stream.hpp"
+#include "resource.hpp"
+
+#include <debug.hpp>
+
+#include <fstream>
+#include <filesystem>
+#include <unordered_map>
+
+#if __linux__
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/inotify.h>
+#endif
+
+namespace {
+#if __linux__
+    // pread() keeps the stream position in user space, posix_fadvise() tells the kernel how far to read ahead
+    struct FileResourceStream : ResourceStream {
+        FileResourceStream(int fd, size_t length) : fd(fd), length(length) {
+            posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+        }
+
+        ~FileResourceStream() override {
+            close(fd);
+        }
+
+        [[nodiscard]] auto size() const noexcept -> size_t override {
+            return length;
+        }
+
+        [[nodiscard]] auto tell() const noexcept -> size_t override {
+            return position;
+        }
+
+        auto seek(size_t offset) -> bool override {
+            if (offset > length) {
+                return false;
+            }
+            position = offset;
+            return true;
+        }
+
+        auto read(std::span<char> bytes) -> size_t override {
+            const auto count = pread(fd, bytes.data(), bytes.size(), static_cast<off_t>(position));
+            if (count <= 0) {
+                return 0;
+            }
+            position += static_cast<size_t>(count);
+            return static_cast<size_t>(count);
+        }
+
+        void readahead(size_t size) override {
+            posix_fadvise(fd, static_cast<off_t>(position), static_cast<off_t>(size), POSIX_FADV_WILLNEED);
+        }
+
+    private:
+        int fd;
+        size_t length;
+        size_t position = 0;
+    };
+#else
+    struct FileResourceStream : ResourceStream {
+        FileResourceStream(std::ifstream file, size_t length) : file(std::move(file)), length(length) {}
+
+        [[nodiscard]] auto size() const noexcept -> size_t override {
+            return length;
+        }
+
+        [[nodiscard]] auto tell() const noexcept -> size_t override {
+            return position;
+        }
+
+        auto seek(size_t offset) -> bool override {
+            if (offset > length) {
+                return false;
+            }
+            file.clear();
+            file.seekg(static_cast<std::streamoff>(offset));
+            position = offset;
+            return true;
+        }
+
+        auto read(std::span<char> bytes) -> size_t override {
+            file.read(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+            const auto count = static_cast<size_t>(file.gcount());
+            position += count;
+            return count;
+        }
+
+    private:
+        std::ifstream file;
+        size_t length;
+        size_t position = 0;
+    };
+#endif
+}
+
+struct DirectoryResourcePack::Impl {
+    Debug logger{"resources"};
+    std::filesystem::path root;
+
+#if __linux__
+    int fd = -1;
+    // watch descriptor -> directory relative to the root ("" for the root itself)
+    std::unordered_map<int, std::string> watches;
+
+    explicit Impl(std::filesystem::path root) : root(std::move(root)) {
+        fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (fd < 0) {
+            logger.error("inotify_init1 failed: {}", strerror(errno));
+            return;
+        }
+        watch("");
+
+        auto ec = std::error_code{};
+        for (auto it = std::filesystem::recursive_directory_iterator(this->root, ec); it != std::filesystem::recursive_directory_iterator(); it.increment(ec)) {
+            if (it->is_directory()) {
+                watch(std::filesystem::relative(it->path(), this->root).generic_string());
+            }
+        }
+    }
+
+    ~Impl() {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+
+    void watch(const std::string& directory) {
+        const auto path = (root / directory).string();
+        const auto mask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE | IN_DELETE;
+        const auto wd = inotify_add_watch(fd, path.c_str(), mask);
+        if (wd < 0) {
+            logger.error("could not watch {}: {}", path, strerror(errno));
+            return;
+        }
+        watches[wd] = directory;
+    }
+
+    // A directory moved out of the tree keeps its watches, which would go on reporting its files under the old
+    // path; they are removed along with the watches of every directory below it
+    void unwatch(const std::string& directory) {
+        for (auto it = watches.begin(); it != watches.end();) {
+            const auto& path = it->second;
+            if (path == directory || (path.starts_with(directory) && path.size() > directory.size() && path[directory.size()] == '/')) {
+                inotify_rm_watch(fd, it->first);
+                it = watches.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    void poll(std::vector<std::string>& changed) {
+        if (fd < 0) {
+            return;
+        }
+
+        alignas(inotify_event) char buffer[4096];
+        while (true) {
+            const auto length = read(fd, buffer, sizeof(buffer));
+            if (length <= 0) {
+                break;
+            }
+            for (auto ptr = buffer; ptr < buffer + length;) {
+                const auto event = reinterpret_cast<const inotify_event*>(ptr);
+                ptr += sizeof(inotify_event) + event->len;
+
+                if (event->mask & IN_IGNORED) {
+                    watches.erase(event->wd);
+                    continue;
+                }
+                const auto it = watches.find(event->wd);
+                if (it == watches.end() || event->len == 0) {
+                    continue;
+                }
+
+                const auto filename = it->second.empty()
+                    ? std::string(event->name)
+                    : it->second + "/" + event->name;
+
+                if (event->mask & IN_ISDIR) {
+                    if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+                        watch(filename);
+                        // files may have landed in the directory before the watch was added
+                        auto ec = std::error_code{};
+                        for (const auto& item : std::filesystem::recursive_directory_iterator(root / filename, ec)) {
+                            if (item.is_directory()) {
+                                watch(std::filesystem::relative(item.path(), root).generic_string());
+                            } else {
+                                changed.emplace_back(std::filesystem::relative(item.path(), root).generic_string());
+                            }
+                        }
+                    } else if (event->mask & IN_MOVED_FROM) {
+                        unwatch(filename);
+                        changed.emplace_back(filename);
+                    } else if (event->mask & IN_DELETE) {
+                        changed.emplace_back(filename);
+                    }
+                    continue;
+                }
+                // IN_CREATE is followed by IN_CLOSE_WRITE once the file is written
+                if (event->mask & IN_CREATE) {
+                    continue;
+                }
+                changed.emplace_back(filename);
+            }
+        }
+    }
+#else
+    explicit Impl(std::filesystem::path root) : root(std::move(root)) {}
+
+    void poll(std::vector<std::string>& changed) {}
+#endif
+};
+
+DirectoryResourcePack::DirectoryResourcePack(const std::string &directory) {
+    impl = std::make_unique<Impl>(directory);
+}
+
+DirectoryResourcePack::~DirectoryResourcePack() = default;
+
+auto DirectoryResourcePack::get(const std::string& filename) -> std::optional<Resource> {
+    auto file = std::ifstream(impl->root / filename, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        return std::nullopt;
+    }
+
+    auto resource = Resource(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(resource.bytes_for_write(), static_cast<std::streamsize>(resource.size()));
+    if (!file) {
+        return std::nullopt;
+    }
+    return resource;
+}
+
+auto DirectoryResourcePack::open(const std::string& filename) -> std::unique_ptr<ResourceStream> {
+    const auto path = impl->root / filename;
+#if __linux__
+    const auto fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return nullptr;
+    }
+    struct stat info{};
+    if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+        close(fd);
+        return nullptr;
+    }
+    return std::make_unique<FileResourceStream>(fd, static_cast<size_t>(info.st_size));
+#else
+    auto file = std::ifstream(path, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        return nullptr;
+    }
+    const auto length = static_cast<size_t>(file.tellg());
+    file.seekg(0);
+    return std::make_unique<FileResourceStream>(std::move(file), length);
+#endif
+}
+
+void DirectoryResourcePack::poll(std::vector<std::string>& changed) {
+    impl->poll(changed);
+}
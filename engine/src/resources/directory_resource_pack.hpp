@@ -0,0 +1,21 @@
+#pragma once
+
+#include "resource_pack.hpp"
+
+#include <memory>
+
+// Reads loose files from a directory. On Linux the directory is watched with inotify and poll() reports edited files,
+// which makes it the pack to use for hot reload during development.
+struct DirectoryResourcePack : ResourcePack {
+    struct Impl;
+
+    explicit DirectoryResourcePack(const std::string& directory);
+    ~DirectoryResourcePack() override;
+
+    auto get(const std::string& filename) -> std::optional<Resource> override;
+    auto open(const std::string& filename) -> std::unique_ptr<ResourceStream> override;
+    void poll(std::vector<std::string>& changed) override;
+
+private:
+    std::unique_ptr<Impl> impl;
+};
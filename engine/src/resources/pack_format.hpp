@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+// On-disk layout of a resource pack archive (all integers little-endian):
+//
+//   PackHeader
+//   PackEntry[entry_count]   sorted by path_hash
+//   PackBlock[block_count]
+//   names                    entry paths, not null-terminated
+//   payloads
+//
+// Stored entries keep their bytes at PackEntry::offset. Compressed entries are split into independent
+// LZ4 blocks of PackHeader::block_size uncompressed bytes, so any block can be decoded on its own.
+
+struct PackHeader {
+    static constexpr uint32_t MAGIC = 0x4B41504A; // "JPAK"
+    static constexpr uint32_t VERSION = 1;
+
+    uint32_t magic;
+    uint32_t version;
+    uint32_t entry_count;
+    uint32_t block_count;
+    uint32_t block_size;
+    uint32_t reserved;
+    uint64_t entries_offset;
+    uint64_t blocks_offset;
+    uint64_t names_offset;
+    uint64_t names_size;
+};
+
+struct PackEntry {
+    uint64_t path_hash;
+    uint64_t offset;
+    uint64_t compressed_size;
+    uint64_t uncompressed_size;
+    uint32_t first_block;
+    uint32_t block_count;
+    uint32_t name_offset;
+    uint32_t name_size;
+
+    [[nodiscard]] auto compressed() const noexcept -> bool {
+        return block_count != 0;
+    }
+};
+
+struct PackBlock {
+    uint64_t offset;
+    // a block that did not shrink is stored as is, with compressed_size == uncompressed_size
+    uint32_t compressed_size;
+    uint32_t uncompressed_size;
+
+    [[nodiscard]] auto compressed() const noexcept -> bool {
+        return compressed_size != uncompressed_size;
+    }
+};
+
+static_assert(sizeof(PackHeader) == 56);
+static_assert(sizeof(PackEntry) == 48);
+static_assert(sizeof(PackBlock) == 16);
+
+// 64-bit FNV-1a of the entry path, e.g. "shaders/tri.vert.spv"
+constexpr auto packPathHash(std::string_view path) noexcept -> uint64_t {
+    uint64_t hash = 0xCBF29CE484222325ull;
+    for (const auto c : path) {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 0x100000001B3ull;
+    }
+    return hash;
+}
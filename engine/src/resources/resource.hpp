@@ -1,9 +1,13 @@
 #pragma once
 
 #include <memory>
+#include <algorithm>
 
 struct Resource {
-    friend struct ResourcePack;
+    friend struct AssetResourcePack;
+    friend struct ArchiveResourcePack;
+    friend struct DirectoryResourcePack;
+    friend struct ResourceManager;
 
     Resource() = default;
 
@@ -11,6 +15,15 @@ struct Resource {
         return _size;
     }
 
+    [[nodiscard]] auto uncompressed_size() const noexcept -> size_t {
+        return _size;
+    }
+
+    // number of bytes the resource occupies in its pack, equal to size() for stored entries
+    [[nodiscard]] auto compressed_size() const noexcept -> size_t {
+        return _compressed_size;
+    }
+
     [[nodiscard]] auto bytes() const noexcept -> const char* {
         return _data.get();
     }
@@ -20,12 +33,22 @@ struct Resource {
     }
 
 private:
-    explicit Resource(size_t size) : _data(std::make_unique<char[]>(size)), _size(size) {}
+    explicit Resource(size_t size) : Resource(size, size) {}
+    explicit Resource(size_t size, size_t compressed_size)
+        : _data(std::make_unique<char[]>(size)), _size(size), _compressed_size(compressed_size) {}
 
     [[nodiscard]] auto bytes_for_write() noexcept -> char* {
         return _data.get();
     }
 
+    // the cache keeps one copy and hands out others
+    [[nodiscard]] auto copy() const -> Resource {
+        auto result = Resource(_size, _compressed_size);
+        std::copy_n(_data.get(), _size, result._data.get());
+        return result;
+    }
+
     std::unique_ptr<char[]> _data = nullptr;
     size_t _size = 0;
-};
\ No newline at end of file
+    size_t _compressed_size = 0;
+};
@@ -1,16 +1,174 @@
 #include "resource_manager.hpp"
 #include "resource_pack.hpp"
+#include "resource_stream.hpp"
 #include "resource.hpp"
 
+#include <algorithm>
+
+ResourceManager::ResourceManager() : ResourceManager(Settings{}) {}
+ResourceManager::ResourceManager(Settings settings) : settings(settings) {}
+ResourceManager::~ResourceManager() = default;
+
 void ResourceManager::emplace(std::unique_ptr<ResourcePack> &&pack) {
+    std::unique_lock packs_lock{packs_mutex};
     packs.emplace_back(std::move(pack));
+
+    // a file may now come from the new pack
+    std::lock_guard lock{mutex};
+    index.clear();
+    cache.clear();
+    cache_size = 0;
+    generation++;
 }
 
+// the lock is only held for the index and the cache, reads from the packs run concurrently
 auto ResourceManager::get(const std::string &filename) -> std::optional<Resource> {
+    if (const auto cached = _cached(filename)) {
+        return cached->copy();
+    }
+
+    std::shared_lock packs_lock{packs_mutex};
+    auto read_generation = uint64_t{0};
+    {
+        std::lock_guard lock{mutex};
+        read_generation = generation;
+    }
+    if (const auto pack = _find(filename)) {
+        if (auto resource = pack->get(filename)) {
+            _cache(filename, *resource, read_generation);
+            return resource;
+        }
+    }
     for (auto& pack : packs) {
         if (auto resource = pack->get(filename)) {
+            _remember(filename, pack.get());
+            _cache(filename, *resource, read_generation);
             return resource;
         }
     }
     return std::nullopt;
 }
+
+auto ResourceManager::open(const std::string &filename) -> std::unique_ptr<ResourceStream> {
+    std::shared_lock packs_lock{packs_mutex};
+    if (const auto pack = _find(filename)) {
+        if (auto stream = pack->open(filename)) {
+            return stream;
+        }
+    }
+    for (auto& pack : packs) {
+        if (auto stream = pack->open(filename)) {
+            _remember(filename, pack.get());
+            return stream;
+        }
+    }
+    return nullptr;
+}
+
+auto ResourceManager::_find(const std::string& filename) -> ResourcePack* {
+    std::lock_guard lock{mutex};
+    const auto it = index.find(filename);
+    return it != index.end() ? it->second : nullptr;
+}
+
+void ResourceManager::_remember(const std::string& filename, ResourcePack* pack) {
+    std::lock_guard lock{mutex};
+    index.insert_or_assign(filename, pack);
+}
+
+auto ResourceManager::_cached(const std::string& filename) -> std::shared_ptr<const Resource> {
+    std::lock_guard lock{mutex};
+    const auto it = cache.find(filename);
+    if (it == cache.end()) {
+        return nullptr;
+    }
+    it->second.last_used = ++cache_clock;
+    return it->second.resource;
+}
+
+// Evicts the least recently used files until the new one fits. The cache holds a few dozen files at most,
+// so a scan is cheaper than keeping them in order.
+void ResourceManager::_cache(const std::string& filename, const Resource& resource, uint64_t read_generation) {
+    if (resource.size() > settings.cache_budget / 4) {
+        return;
+    }
+    auto copy = std::make_shared<const Resource>(resource.copy());
+
+    std::lock_guard lock{mutex};
+    if (read_generation != generation || cache.contains(filename)) {
+        return;
+    }
+    while (cache_size + resource.size() > settings.cache_budget && !cache.empty()) {
+        const auto oldest = std::min_element(cache.begin(), cache.end(), [](const auto& a, const auto& b) {
+            return a.second.last_used < b.second.last_used;
+        });
+        cache_size -= oldest->second.resource->size();
+        cache.erase(oldest);
+    }
+    cache_size += resource.size();
+    cache.emplace(filename, CacheEntry{.resource = std::move(copy), .last_used = ++cache_clock});
+}
+
+// A name without a file of its own is a directory that went away and stands for everything under it
+void ResourceManager::_invalidate(const std::string& filename) {
+    const auto under = [&filename](const std::string& name) {
+        return name == filename || (name.size() > filename.size() && name.starts_with(filename) && name[filename.size()] == '/');
+    };
+    std::erase_if(index, [&](const auto& item) {
+        return under(item.first);
+    });
+    std::erase_if(cache, [&](const auto& item) {
+        if (!under(item.first)) {
+            return false;
+        }
+        cache_size -= item.second.resource->size();
+        return true;
+    });
+}
+
+auto ResourceManager::subscribe(Listener listener) -> size_t {
+    std::lock_guard lock{mutex};
+    const auto id = next_listener_id++;
+    listeners.emplace(id, std::move(listener));
+    return id;
+}
+
+void ResourceManager::unsubscribe(size_t id) {
+    std::lock_guard lock{mutex};
+    listeners.erase(id);
+}
+
+void ResourceManager::update() {
+    changed.clear();
+    {
+        std::shared_lock packs_lock{packs_mutex};
+        for (auto& pack : packs) {
+            pack->poll(changed);
+        }
+    }
+    if (changed.empty()) {
+        return;
+    }
+
+    // editors usually emit several events per save
+    std::sort(changed.begin(), changed.end());
+    changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+
+    // listeners run without the lock, they reload through get() and may subscribe or unsubscribe
+    auto notify = std::vector<Listener>{};
+    {
+        std::lock_guard lock{mutex};
+        for (const auto& filename : changed) {
+            _invalidate(filename);
+        }
+        generation++;
+        for (const auto& [_, listener] : listeners) {
+            notify.emplace_back(listener);
+        }
+    }
+    for (const auto& filename : changed) {
+        for (const auto& listener : notify) {
+            listener(filename);
+        }
+    }
+}
@@ -1,16 +1,73 @@
 #pragma once
 
+#include <mutex>
 #include <vector>
 #include <memory>
 #include <string>
+#include <cstdint>
 #include <optional>
+#include <functional>
+#include <shared_mutex>
+#include <unordered_map>
 
 struct Resource;
 struct ResourcePack;
+struct ResourceStream;
 struct ResourceManager {
+    using Listener = std::function<void(const std::string& filename)>;
+
+    struct Settings {
+        // bytes of recently read files kept around, files over a quarter of it are never kept
+        size_t cache_budget = size_t{32} << 20;
+    };
+
+    ResourceManager();
+    explicit ResourceManager(Settings settings);
+    ~ResourceManager();
+
     void emplace(std::unique_ptr<ResourcePack>&& pack);
+
+    // get and open may be called from any thread, e.g. from jobs streaming data in the background.
+    // get serves files read recently from the cache, open always goes to the packs.
     auto get(const std::string& filename) -> std::optional<Resource>;
+    auto open(const std::string& filename) -> std::unique_ptr<ResourceStream>;
+
+    // Listeners are called from update() with the name of every file that changed in any pack
+    auto subscribe(Listener listener) -> size_t;
+    void unsubscribe(size_t id);
+
+    // Polls the packs for changes, drops the changed files from the index and the cache and notifies listeners
+    void update();
 
 private:
+    struct CacheEntry {
+        std::shared_ptr<const Resource> resource;
+        uint64_t last_used = 0;
+    };
+
+    Settings settings;
+
+    // packs are read under a shared lock, emplace waits for the reads in flight
+    std::shared_mutex packs_mutex;
     std::vector<std::unique_ptr<ResourcePack>> packs;
-};
\ No newline at end of file
+
+    // guards everything below
+    std::mutex mutex;
+    // filename -> pack that served it last time, so lookups don't probe every pack
+    std::unordered_map<std::string, ResourcePack*> index;
+    std::unordered_map<std::string, CacheEntry> cache;
+    size_t cache_size = 0;
+    uint64_t cache_clock = 0;
+    // bumped whenever files are invalidated, a read that started before must not land in the cache
+    uint64_t generation = 0;
+    std::unordered_map<size_t, Listener> listeners;
+    size_t next_listener_id = 0;
+
+    std::vector<std::string> changed;
+
+    auto _find(const std::string& filename) -> ResourcePack*;
+    void _remember(const std::string& filename, ResourcePack* pack);
+    auto _cached(const std::string& filename) -> std::shared_ptr<const Resource>;
+    void _cache(const std::string& filename, const Resource& resource, uint64_t read_generation);
+    void _invalidate(const std::string& filename);
+};
@@ -1,26 +1,45 @@
 #include "resource_pack.hpp"
+#include "resource_stream.hpp"
 #include "resource.hpp"
 
-#if _WIN32
-#else
-#include <android/asset_manager.h>
-#endif
-
-auto ResourcePack::get(const std::string& filename) -> std::optional<Resource> {
-#if _WIN32
-    return std::nullopt;
-#else
-    extern auto AndroidPlatform_getAssets() -> AAssetManager*;
-
-    auto assets = AndroidPlatform_getAssets();
-    auto asset = AAssetManager_open(assets, filename.c_str(), AASSET_MODE_BUFFER);
-    if (asset == nullptr) {
-        return std::nullopt;
-    }
+#include <algorithm>
+
+namespace {
+    struct MemoryResourceStream : ResourceStream {
+        explicit MemoryResourceStream(Resource&& resource) : resource(std::move(resource)) {}
+
+        [[nodiscard]] auto size() const noexcept -> size_t override {
+            return resource.size();
+        }
+
+        [[nodiscard]] auto tell() const noexcept -> size_t override {
+            return position;
+        }
 
-    auto resource = Resource(static_cast<size_t>(AAsset_getLength(asset)));
-    AAsset_read(asset, resource.bytes_for_write(), resource.size());
-    AAsset_close(asset);
-    return resource;
-#endif
-}
\ No newline at end of file
+        auto seek(size_t offset) -> bool override {
+            if (offset > resource.size()) {
+                return false;
+            }
+            position = offset;
+            return true;
+        }
+
+        auto read(std::span<char> bytes) -> size_t override {
+            const auto count = std::min(bytes.size(), resource.size() - position);
+            std::copy_n(resource.bytes() + position, count, bytes.data());
+            position += count;
+            return count;
+        }
+
+    private:
+        Resource resource;
+        size_t position = 0;
+    };
+}
+
+auto ResourcePack::open(const std::string &filename) -> std::unique_ptr<ResourceStream> {
+    if (auto resource = get(filename)) {
+        return std::make_unique<MemoryResourceStream>(std::move(*resource));
+    }
+    return nullptr;
+}
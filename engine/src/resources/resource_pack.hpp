@@ -1,9 +1,21 @@
 #pragma once
 
 #include <string>
+#include <vector>
+#include <memory>
 #include <optional>
 
 struct Resource;
+struct ResourceStream;
 struct ResourcePack {
-    auto get(const std::string& filename) -> std::optional<Resource>;
-};
\ No newline at end of file
+    virtual ~ResourcePack() = default;
+
+    virtual auto get(const std::string& filename) -> std::optional<Resource> = 0;
+
+    // Opens the file for chunked reads; the default implementation loads the whole file with get()
+    virtual auto open(const std::string& filename) -> std::unique_ptr<ResourceStream>;
+
+    // Appends the files that were created, modified or removed since the last call; packs that never change do nothing.
+    // A directory that was removed or moved away is reported by its own name and stands for every file under it.
+    virtual void poll(std::vector<std::string>& changed) {}
+};
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <span>
+#include <cstddef>
+#include <functional>
+
+// Sequential reader over a single resource. Memory use is bounded by the buffers the caller passes to read(),
+// plus at most one pack block for compressed archive entries.
+struct ResourceStream {
+    virtual ~ResourceStream() = default;
+
+    [[nodiscard]] virtual auto size() const noexcept -> size_t = 0;
+    [[nodiscard]] virtual auto tell() const noexcept -> size_t = 0;
+
+    virtual auto seek(size_t offset) -> bool = 0;
+
+    // Returns the number of bytes copied into bytes, 0 once the end of the resource is reached or on error
+    virtual auto read(std::span<char> bytes) -> size_t = 0;
+
+    // Hints that the next size bytes will be read soon so the backend can start fetching them
+    virtual void readahead(size_t size) {}
+
+    [[nodiscard]] auto eof() const noexcept -> bool {
+        return tell() >= size();
+    }
+
+    // Reads the remainder of the resource through buffer, calling fn with each filled chunk
+    auto readChunks(std::span<char> buffer, const std::function<void(std::span<const char>)>& fn) -> size_t {
+        size_t total = 0;
+        while (!eof()) {
+            readahead(buffer.size());
+            const auto count = read(buffer);
+            if (count == 0) {
+                break;
+            }
+            fn(buffer.first(count));
+            total += count;
+        }
+        return total;
+    }
+};
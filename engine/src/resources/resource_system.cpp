@@ -0,0 +1,35 @@
+#include "resource_system.hpp"
+#include "resource_manager.hpp"
+#include "resource_pack.hpp"
+#include "resource_stream.hpp"
+#include "resource.hpp"
+
+std::unique_ptr<ResourceManager> ResourceSystem::impl;
+
+void ResourceSystem::initialize() {
+    impl = std::make_unique<ResourceManager>();
+}
+
+void ResourceSystem::update() {
+    impl->update();
+}
+
+void ResourceSystem::emplace(std::unique_ptr<ResourcePack>&& pack) {
+    impl->emplace(std::move(pack));
+}
+
+auto ResourceSystem::get(const std::string &filename) -> std::optional<Resource> {
+    return impl->get(filename);
+}
+
+auto ResourceSystem::open(const std::string &filename) -> std::unique_ptr<ResourceStream> {
+    return impl->open(filename);
+}
+
+auto ResourceSystem::subscribe(std::function<void(const std::string &)> listener) -> size_t {
+    return impl->subscribe(std::move(listener));
+}
+
+void ResourceSystem::unsubscribe(size_t id) {
+    impl->unsubscribe(id);
+}
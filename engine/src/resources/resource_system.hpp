@@ -0,0 +1,28 @@
+#pragma once
+
+#include <string>
+#include <memory>
+#include <optional>
+#include <functional>
+
+struct Resource;
+struct ResourcePack;
+struct ResourceStream;
+struct ResourceManager;
+struct ResourceSystem {
+    friend struct JellyEngine;
+    friend void EngineMain(int argc, char** argv);
+
+    static void emplace(std::unique_ptr<ResourcePack>&& pack);
+    static auto get(const std::string& filename) -> std::optional<Resource>;
+    static auto open(const std::string& filename) -> std::unique_ptr<ResourceStream>;
+
+    static auto subscribe(std::function<void(const std::string& filename)> listener) -> size_t;
+    static void unsubscribe(size_t id);
+
+private:
+    static void initialize();
+    static void update();
+
+    static std::unique_ptr<ResourceManager> impl;
+};
@@ -1,7 +1,144 @@
 #include "scene.hpp"
-#include "entity.hpp"
 
-auto Scene::createEntity() -> std::shared_ptr<Entity> {
-    entities.emplace_back(std::make_shared<Entity>());
-    return entities.back();
-}
\ No newline at end of file
+#include <algorithm>
+
+Scene::Scene() {
+    _getArchetype({});
+}
+
+Scene::Scene(SharedLibrary library) : Scene() {
+    this->library.emplace(std::move(library));
+}
+
+Scene::~Scene() = default;
+
+void Scene::destroyEntity(Entity entity) {
+    destroyEntities(std::span(&entity, 1));
+}
+
+void Scene::destroyEntities(std::span<const Entity> entities) {
+    auto rows = std::vector<std::pair<Archetype*, size_t>>{};
+    rows.reserve(entities.size());
+    for (const auto entity : entities) {
+        if (alive(entity)) {
+            const auto& record = records[entity.index];
+            rows.emplace_back(record.archetype, record.row);
+            transform_hierarchy.destroy(entity);
+        }
+    }
+
+    // removing the highest rows first means the row moved into a hole is never one that is about to be destroyed
+    std::sort(rows.begin(), rows.end(), std::greater{});
+    rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+
+    for (const auto& [archetype, row] : rows) {
+        const auto index = archetype->entity(row).index;
+        const auto moved = archetype->remove(row);
+        if (moved.valid()) {
+            records[moved.index].row = row;
+        }
+
+        auto& record = records[index];
+        record.archetype = nullptr;
+        record.generation = record.generation == UINT32_MAX ? 1 : record.generation + 1;
+        free_indices.emplace_back(index);
+    }
+}
+
+auto Scene::alive(Entity entity) const noexcept -> bool {
+    return entity.index < records.size()
+        && records[entity.index].generation == entity.generation
+        && records[entity.index].archetype != nullptr;
+}
+
+auto Scene::_getArchetype(std::span<const ComponentType* const> types) -> Archetype* {
+    auto ids = std::vector<ComponentId>{};
+    for (const auto type : types) {
+        ids.emplace_back(type->id);
+    }
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+
+    if (const auto it = archetype_index.find(ids); it != archetype_index.end()) {
+        return it->second;
+    }
+
+    auto unique = std::vector<const ComponentType*>{};
+    for (const auto type : types) {
+        if (std::find(unique.begin(), unique.end(), type) == unique.end()) {
+            unique.emplace_back(type);
+        }
+    }
+    const auto archetype = archetypes.emplace_back(std::make_unique<Archetype>(std::move(unique))).get();
+    archetype_index.emplace(std::move(ids), archetype);
+    return archetype;
+}
+
+auto Scene::_addEdge(Archetype* archetype, const ComponentType& type) -> Archetype* {
+    if (const auto it = archetype->add_edges.find(type.id); it != archetype->add_edges.end()) {
+        return it->second;
+    }
+    auto types = std::vector<const ComponentType*>{};
+    for (const auto& column : archetype->componentColumns()) {
+        types.emplace_back(column.type);
+    }
+    types.emplace_back(&type);
+
+    const auto target = _getArchetype(types);
+    archetype->add_edges.emplace(type.id, target);
+    target->remove_edges.emplace(type.id, archetype);
+    return target;
+}
+
+auto Scene::_removeEdge(Archetype* archetype, const ComponentType& type) -> Archetype* {
+    if (const auto it = archetype->remove_edges.find(type.id); it != archetype->remove_edges.end()) {
+        return it->second;
+    }
+    auto types = std::vector<const ComponentType*>{};
+    for (const auto& column : archetype->componentColumns()) {
+        if (column.type != &type) {
+            types.emplace_back(column.type);
+        }
+    }
+
+    const auto target = _getArchetype(types);
+    archetype->remove_edges.emplace(type.id, target);
+    target->add_edges.emplace(type.id, archetype);
+    return target;
+}
+
+auto Scene::_createEntities(Archetype* archetype, std::span<Entity> out) -> size_t {
+    const auto first = archetype->allocate(out.size());
+    for (size_t i = 0; i < out.size(); i++) {
+        uint32_t index;
+        if (!free_indices.empty()) {
+            index = free_indices.back();
+            free_indices.pop_back();
+        } else {
+            index = static_cast<uint32_t>(records.size());
+            records.emplace_back();
+        }
+
+        auto& record = records[index];
+        record.archetype = archetype;
+        record.row = first + i;
+
+        out[i] = Entity{.index = index, .generation = record.generation};
+        archetype->entity(first + i) = out[i];
+    }
+    return first;
+}
+
+void Scene::_move(Entity entity, Archetype* archetype) {
+    auto& record = records[entity.index];
+    const auto row = archetype->allocate(1);
+    archetype->entity(row) = entity;
+    archetype->copy(row, *record.archetype, record.row);
+
+    const auto moved = record.archetype->remove(record.row);
+    if (moved.valid()) {
+        records[moved.index].row = record.row;
+    }
+    record.archetype = archetype;
+    record.row = row;
+}
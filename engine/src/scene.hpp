@@ -1,19 +1,176 @@
 #pragma once
 
+#include <map>
+#include <span>
 #include <memory>
 #include <vector>
+#include <cassert>
+#include <optional>
+#include <filesystem>
+#include <entity.hpp>
 #include <shared_library.hpp>
+#include <ecs/query.hpp>
+#include <ecs/snapshot_view.hpp>
+#include <transform/transform_hierarchy.hpp>
 
-struct Entity;
-
+// Entities and their components, stored per archetype (see ecs/archetype.hpp)
 struct Scene {
-    friend struct Engine;
+    Scene();
+    explicit Scene(SharedLibrary library);
+    ~Scene();
+
+    Scene(const Scene&) = delete;
+    auto operator=(const Scene&) -> Scene& = delete;
+
+    template<Component... Ts>
+    auto createEntity(const Ts&... components) -> Entity {
+        auto entity = Entity{};
+        createEntities(std::span(&entity, 1), components...);
+        return entity;
+    }
+
+    // Creates out.size() entities sharing the same initial components in one allocation pass
+    template<Component... Ts>
+    void createEntities(std::span<Entity> out, const Ts&... components) {
+        const auto types = std::array<const ComponentType*, sizeof...(Ts)>{&ComponentType::of<Ts>()...};
+        const auto archetype = _getArchetype(types);
+        const auto first = _createEntities(archetype, out);
+        (_fill(archetype, first, out.size(), components), ...);
+    }
+
+    void destroyEntity(Entity entity);
+
+    // Destroys in one pass; every row vacated by the batch is filled at most once
+    void destroyEntities(std::span<const Entity> entities);
+
+    [[nodiscard]] auto alive(Entity entity) const noexcept -> bool;
+
+    [[nodiscard]] auto size() const noexcept -> size_t {
+        return records.size() - free_indices.size();
+    }
+
+    // Handles of destroyed entities are a bug in the caller: they assert in debug builds and are ignored
+    // otherwise, add and get return nullptr for them.
+    template<Component T>
+    auto add(Entity entity, const T& value = T{}) -> T* {
+        assert(alive(entity));
+        if (!alive(entity)) {
+            return nullptr;
+        }
+        const auto& type = ComponentType::of<T>();
+        auto& record = records[entity.index];
+        auto column = record.archetype->find(type.id);
+        if (column < 0) {
+            _move(entity, _addEdge(record.archetype, type));
+            column = record.archetype->find(type.id);
+        }
+        return new (record.archetype->component(record.row, static_cast<size_t>(column))) T(value);
+    }
+
+    template<Component T>
+    void remove(Entity entity) {
+        assert(alive(entity));
+        if (!alive(entity)) {
+            return;
+        }
+        const auto& type = ComponentType::of<T>();
+        const auto& record = records[entity.index];
+        if (record.archetype->find(type.id) >= 0) {
+            _move(entity, _removeEdge(record.archetype, type));
+        }
+    }
+
+    template<Component T>
+    [[nodiscard]] auto get(Entity entity) const noexcept -> T* {
+        assert(alive(entity));
+        if (!alive(entity)) {
+            return nullptr;
+        }
+        const auto& record = records[entity.index];
+        const auto column = record.archetype->find(ComponentType::of<T>().id);
+        if (column < 0) {
+            return nullptr;
+        }
+        return reinterpret_cast<T*>(record.archetype->component(record.row, static_cast<size_t>(column)));
+    }
+
+    template<Component T>
+    [[nodiscard]] auto has(Entity entity) const noexcept -> bool {
+        assert(alive(entity));
+        return alive(entity) && records[entity.index].archetype->find(ComponentType::of<T>().id) >= 0;
+    }
 
-    auto createEntity() -> std::shared_ptr<Entity>;
+    // Parent/child transforms of the scene's entities. Destroying an entity removes its node, the nodes of its
+    // descendants go at the next update() while the entities themselves stay. Transforms aren't part of
+    // snapshots, loading one keeps the nodes of the entities that are still alive afterwards.
+    [[nodiscard]] auto transforms() noexcept -> TransformHierarchy& {
+        return transform_hierarchy;
+    }
+
+    [[nodiscard]] auto transforms() const noexcept -> const TransformHierarchy& {
+        return transform_hierarchy;
+    }
+
+    // Queries are cheap to keep around: they remember matching archetypes between uses
+    template<typename... Ts>
+    [[nodiscard]] auto query() const -> Query<Ts...> {
+        return Query<Ts...>(archetypes);
+    }
+
+    template<typename... Ts, typename Fn>
+    void each(Fn&& fn) {
+        query<Ts...>().each(std::forward<Fn>(fn));
+    }
+
+    // Writes every entity with its components as raw column arrays in one sequential pass (see ecs/snapshot_format.hpp)
+    void saveSnapshot(std::vector<std::byte>& out) const;
+    auto saveSnapshot(const std::filesystem::path& path) const -> bool;
+
+    // Replaces the contents of the scene, entity handles stay valid. Columns are copied chunk by chunk,
+    // nothing is parsed per entity. Fails without touching the scene when the snapshot is malformed or
+    // refers to a component type this build hasn't registered with ComponentType::of.
+    // Archetypes are kept, so queries made before the load stay usable.
+    auto loadSnapshot(std::span<const std::byte> bytes) -> bool;
+    auto loadSnapshot(const SnapshotView& view) -> bool;
+
+    // Maps the file instead of reading it where the platform allows
+    auto loadSnapshot(const std::filesystem::path& path) -> bool;
+
+    // Creates out.size() entities from rows [first, first + out.size()) of a snapshot table, for adding
+    // snapshot contents in slices. The entities get new handles, components holding handles to other
+    // entities of the snapshot have to be remapped by the caller.
+    void instantiate(const SnapshotView::Table& table, size_t first, std::span<Entity> out);
 
 private:
-    explicit Scene(SharedLibrary library) : library(std::move(library)) {}
+    struct Record {
+        Archetype* archetype = nullptr;
+        size_t row = 0;
+        uint32_t generation = 1;
+    };
+
+    auto _getArchetype(std::span<const ComponentType* const> types) -> Archetype*;
+    auto _addEdge(Archetype* archetype, const ComponentType& type) -> Archetype*;
+    auto _removeEdge(Archetype* archetype, const ComponentType& type) -> Archetype*;
+    auto _createEntities(Archetype* archetype, std::span<Entity> out) -> size_t;
+    void _move(Entity entity, Archetype* archetype);
+
+    template<typename Sink>
+    void _writeSnapshot(Sink&& sink) const;
+
+    template<Component T>
+    void _fill(Archetype* archetype, size_t first, size_t count, const T& value) {
+        const auto column = static_cast<size_t>(archetype->find(ComponentType::of<T>().id));
+        for (size_t row = first; row < first + count; row++) {
+            new (archetype->component(row, column)) T(value);
+        }
+    }
+
+    std::optional<SharedLibrary> library;
+
+    std::vector<Record> records;
+    std::vector<uint32_t> free_indices;
+    std::vector<std::unique_ptr<Archetype>> archetypes;
+    std::map<std::vector<ComponentId>, Archetype*> archetype_index;
 
-    SharedLibrary library;
-    std::vector<std::shared_ptr<Entity>> entities;
-};
\ No newline at end of file
+    TransformHierarchy transform_hierarchy;
+};
@@ -0,0 +1,259 @@
+#include "scene.hpp"
+
+#include <debug.hpp>
+#include <ecs/snapshot_view.hpp>
+
+#include <array>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+#include <unordered_set>
+
+#if !_WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace {
+    auto alignUp(uint64_t value, uint64_t alignment) noexcept -> uint64_t {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+    // Copies count packed elements into rows [row, row + count) of a column, or of the entity handles without one
+    void copyRows(const Archetype& archetype, std::optional<size_t> column, size_t row, const std::byte* source, size_t count) {
+        const auto size = column ? archetype.componentColumns()[*column].type->size : sizeof(Entity);
+        const auto capacity = archetype.chunkCapacity();
+        while (count > 0) {
+            const auto chunk = row / capacity;
+            const auto offset = row % capacity;
+            const auto n = std::min(count, capacity - offset);
+            const auto target = column ? archetype.column(chunk, *column) : reinterpret_cast<std::byte*>(archetype.entities(chunk));
+            std::memcpy(target + offset * size, source, n * size);
+            source += n * size;
+            row += n;
+            count -= n;
+        }
+    }
+}
+
+template<typename Sink>
+void Scene::_writeSnapshot(Sink&& sink) const {
+    auto header = SnapshotHeader{};
+    auto type_table = std::vector<SnapshotType>{};
+    auto type_indices = std::vector<uint32_t>{};
+    auto entries = std::vector<SnapshotArchetype>{};
+    auto type_lookup = std::unordered_map<const ComponentType*, uint32_t>{};
+    auto archetype_lookup = std::unordered_map<const Archetype*, uint32_t>{};
+
+    for (const auto& archetype : archetypes) {
+        archetype_lookup.emplace(archetype.get(), static_cast<uint32_t>(entries.size()));
+
+        auto& entry = entries.emplace_back();
+        entry.first_type_index = static_cast<uint32_t>(type_indices.size());
+        entry.type_count = static_cast<uint32_t>(archetype->componentColumns().size());
+        entry.entity_count = archetype->size();
+
+        for (const auto& column : archetype->componentColumns()) {
+            const auto [it, inserted] = type_lookup.try_emplace(column.type, static_cast<uint32_t>(type_table.size()));
+            if (inserted) {
+                type_table.emplace_back(SnapshotType{
+                    .hash = column.type->hash,
+                    .size = static_cast<uint32_t>(column.type->size),
+                    .align = static_cast<uint32_t>(column.type->align)
+                });
+            }
+            type_indices.emplace_back(it->second);
+        }
+    }
+
+    // every offset is known before the first byte is written
+    header.type_count = static_cast<uint32_t>(type_table.size());
+    header.archetype_count = static_cast<uint32_t>(entries.size());
+    header.record_count = records.size();
+
+    auto offset = uint64_t{sizeof(SnapshotHeader)};
+    header.types_offset = offset;
+    offset += type_table.size() * sizeof(SnapshotType);
+    header.type_indices_offset = offset;
+    offset = alignUp(offset + type_indices.size() * sizeof(uint32_t), alignof(SnapshotArchetype));
+    header.archetypes_offset = offset;
+    offset += entries.size() * sizeof(SnapshotArchetype);
+    header.records_offset = offset;
+    offset += records.size() * sizeof(SnapshotRecord);
+
+    for (auto& entry : entries) {
+        offset = alignUp(offset, SNAPSHOT_ALIGN);
+        entry.data_offset = offset;
+        offset += entry.entity_count * sizeof(Entity);
+        for (uint32_t i = 0; i < entry.type_count; i++) {
+            offset = alignUp(offset, SNAPSHOT_ALIGN);
+            offset += entry.entity_count * type_table[type_indices[entry.first_type_index + i]].size;
+        }
+    }
+    header.size = offset;
+
+    auto position = uint64_t{0};
+    const auto emit = [&](const void* data, size_t size) {
+        if (size != 0) {
+            sink(static_cast<const std::byte*>(data), size);
+            position += size;
+        }
+    };
+    const auto pad = [&](uint64_t alignment) {
+        static constexpr auto zeros = std::array<std::byte, SNAPSHOT_ALIGN>{};
+        emit(zeros.data(), alignUp(position, alignment) - position);
+    };
+
+    emit(&header, sizeof(header));
+    emit(type_table.data(), type_table.size() * sizeof(SnapshotType));
+    emit(type_indices.data(), type_indices.size() * sizeof(uint32_t));
+    pad(alignof(SnapshotArchetype));
+    emit(entries.data(), entries.size() * sizeof(SnapshotArchetype));
+
+    for (const auto& record : records) {
+        const auto snapshot = SnapshotRecord{
+            .archetype = record.archetype != nullptr ? archetype_lookup.at(record.archetype) : SNAPSHOT_NO_ARCHETYPE,
+            .generation = record.generation,
+            .row = record.row
+        };
+        emit(&snapshot, sizeof(snapshot));
+    }
+
+    for (const auto& archetype : archetypes) {
+        pad(SNAPSHOT_ALIGN);
+        for (size_t chunk = 0; chunk < archetype->chunkCount(); chunk++) {
+            emit(archetype->entities(chunk), archetype->chunkSize(chunk) * sizeof(Entity));
+        }
+        const auto columns = archetype->componentColumns();
+        for (size_t column = 0; column < columns.size(); column++) {
+            pad(SNAPSHOT_ALIGN);
+            for (size_t chunk = 0; chunk < archetype->chunkCount(); chunk++) {
+                emit(archetype->column(chunk, column), archetype->chunkSize(chunk) * columns[column].type->size);
+            }
+        }
+    }
+}
+
+void Scene::saveSnapshot(std::vector<std::byte>& out) const {
+    out.clear();
+    _writeSnapshot([&out](const std::byte* data, size_t size) {
+        out.insert(out.end(), data, data + size);
+    });
+}
+
+auto Scene::saveSnapshot(const std::filesystem::path& path) const -> bool {
+    auto file = std::ofstream(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        Debug{"scene"}.error("could not open {} for writing", path.string());
+        return false;
+    }
+    _writeSnapshot([&file](const std::byte* data, size_t size) {
+        file.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(size));
+    });
+    return file.good();
+}
+
+auto Scene::loadSnapshot(std::span<const std::byte> bytes) -> bool {
+    const auto view = SnapshotView::parse(bytes);
+    return view.has_value() && loadSnapshot(*view);
+}
+
+auto Scene::loadSnapshot(const SnapshotView& view) -> bool {
+    // resolve everything first, the scene is only cleared once the load can't fail
+    auto targets = std::vector<Archetype*>{};
+    auto seen = std::unordered_set<Archetype*>{};
+    for (const auto& table : view.tables) {
+        const auto archetype = _getArchetype(table.types);
+        if (!seen.emplace(archetype).second || archetype->componentColumns().size() != table.types.size()) {
+            Debug{"scene"}.error("snapshot archetype {} is a duplicate", targets.size());
+            return false;
+        }
+        targets.emplace_back(archetype);
+    }
+
+    for (const auto& archetype : archetypes) {
+        archetype->clear();
+    }
+
+    for (size_t i = 0; i < view.tables.size(); i++) {
+        const auto& table = view.tables[i];
+        const auto archetype = targets[i];
+        archetype->allocate(table.size);
+
+        copyRows(*archetype, std::nullopt, 0, table.entities, table.size);
+        for (size_t t = 0; t < table.types.size(); t++) {
+            copyRows(*archetype, static_cast<size_t>(archetype->find(table.types[t]->id)), 0, table.columns[t], table.size);
+        }
+    }
+
+    records.resize(view.recordCount());
+    free_indices.clear();
+    for (size_t i = 0; i < view.recordCount(); i++) {
+        const auto snapshot = view.record(i);
+        auto& record = records[i];
+        record.archetype = snapshot.archetype != SNAPSHOT_NO_ARCHETYPE ? targets[snapshot.archetype] : nullptr;
+        record.row = snapshot.row;
+        record.generation = snapshot.generation;
+    }
+
+    // lowest indices are reused first
+    for (auto i = records.size(); i > 0; i--) {
+        if (records[i - 1].archetype == nullptr) {
+            free_indices.emplace_back(static_cast<uint32_t>(i - 1));
+        }
+    }
+    transform_hierarchy.retain([this](Entity entity) {
+        return alive(entity);
+    });
+    return true;
+}
+
+void Scene::instantiate(const SnapshotView::Table& table, size_t first, std::span<Entity> out) {
+    const auto archetype = _getArchetype(table.types);
+    const auto row = _createEntities(archetype, out);
+    for (size_t t = 0; t < table.types.size(); t++) {
+        const auto size = table.types[t]->size;
+        copyRows(*archetype, static_cast<size_t>(archetype->find(table.types[t]->id)), row, table.columns[t] + first * size, out.size());
+    }
+}
+
+auto Scene::loadSnapshot(const std::filesystem::path& path) -> bool {
+#if _WIN32
+    auto file = std::ifstream(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        Debug{"scene"}.error("could not open {}", path.string());
+        return false;
+    }
+    auto bytes = std::vector<std::byte>(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    return file.good() && loadSnapshot(bytes);
+#else
+    const auto fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        Debug{"scene"}.error("could not open {}", path.string());
+        return false;
+    }
+    struct stat info{};
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        close(fd);
+        return false;
+    }
+
+    const auto size = static_cast<size_t>(info.st_size);
+    const auto data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        Debug{"scene"}.error("could not map {}", path.string());
+        return false;
+    }
+    madvise(data, size, MADV_SEQUENTIAL);
+
+    const auto loaded = loadSnapshot(std::span(static_cast<const std::byte*>(data), size));
+    munmap(data, size);
+    return loaded;
+#endif
+}
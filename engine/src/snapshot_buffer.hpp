@@ -0,0 +1,111 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <algorithm>
+
+// The part of a SnapshotBuffer the engine drives without knowing the state type: it publishes after every
+// fixed tick on the simulation thread, and acquires once per frame before onPreRender, handing alpha() to the
+// renderer through RenderContext::alpha.
+struct SnapshotChannel {
+    using Clock = std::chrono::steady_clock;
+
+    virtual ~SnapshotChannel() = default;
+
+    virtual void publish(Clock::time_point time) noexcept = 0;
+    virtual auto acquire() noexcept -> bool = 0;
+    [[nodiscard]] virtual auto alpha(Clock::time_point now) const noexcept -> float = 0;
+};
+
+// Hands state from the simulation thread to the render thread without locking or copying.
+// The writer fills write() and calls publish(); the reader calls acquire() once per frame and interpolates
+// between previous() and current(). Four slots are used: one being written, one published and two held by
+// the reader, so neither side ever waits for the other. Snapshots published between two acquire() calls
+// are skipped, only the newest one is kept. write() hands back an older slot, so it has to be filled completely.
+//
+// An app that returns its buffer from AppMain::snapshots() only fills write() in onFixedUpdate, the engine
+// publishes and acquires it.
+template<typename T>
+struct SnapshotBuffer final : SnapshotChannel {
+    struct Snapshot {
+        T state{};
+        uint64_t sequence = 0;
+        Clock::time_point time{};
+    };
+
+    SnapshotBuffer() = default;
+
+    explicit SnapshotBuffer(const T& initial) {
+        for (auto& slot : slots) {
+            slot.state = initial;
+        }
+    }
+
+    SnapshotBuffer(const SnapshotBuffer&) = delete;
+    auto operator=(const SnapshotBuffer&) -> SnapshotBuffer& = delete;
+
+    // writer side
+
+    auto write() noexcept -> T& {
+        return slots[back].state;
+    }
+
+    void publish(Clock::time_point time = Clock::now()) noexcept override {
+        auto& slot = slots[back];
+        slot.sequence = ++sequence;
+        slot.time = time;
+        back = ready.exchange(back | FRESH, std::memory_order_acq_rel) & INDEX;
+    }
+
+    // reader side
+
+    // Takes the newest published snapshot, the old current one becomes previous(). Returns false if nothing new arrived.
+    auto acquire() noexcept -> bool override {
+        if ((ready.load(std::memory_order_relaxed) & FRESH) == 0) {
+            return false;
+        }
+        const auto fresh = ready.exchange(front_previous, std::memory_order_acq_rel) & INDEX;
+        front_previous = front_current;
+        front_current = fresh;
+        return true;
+    }
+
+    [[nodiscard]] auto previous() const noexcept -> const Snapshot& {
+        return slots[front_previous];
+    }
+
+    [[nodiscard]] auto current() const noexcept -> const Snapshot& {
+        return slots[front_current];
+    }
+
+    // How far `now` is past current(), measured in the interval between previous() and current() and clamped to [0, 1].
+    // Rendering lerp(previous, current, alpha) stays one snapshot behind the simulation but never extrapolates.
+    [[nodiscard]] auto alpha(Clock::time_point now = Clock::now()) const noexcept -> float override {
+        const auto& a = previous();
+        const auto& b = current();
+        if (a.sequence == 0 || b.time <= a.time) {
+            return 1.0f;
+        }
+        const auto t = std::chrono::duration<float>(now - b.time) / std::chrono::duration<float>(b.time - a.time);
+        return std::clamp(t, 0.0f, 1.0f);
+    }
+
+private:
+    static constexpr uint32_t INDEX = 0b011;
+    static constexpr uint32_t FRESH = 0b100;
+
+    std::array<Snapshot, 4> slots{};
+
+    // owned by the writer
+    uint32_t back = 0;
+    uint64_t sequence = 0;
+
+    // shared, the published slot plus the FRESH bit while the reader hasn't taken it
+    alignas(64) std::atomic<uint32_t> ready{1};
+
+    // owned by the reader
+    alignas(64) uint32_t front_previous = 2;
+    uint32_t front_current = 3;
+};
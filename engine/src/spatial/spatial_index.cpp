@@ -0,0 +1,359 @@
+#include "spatial_index.hpp"
+
+#include <math/simd.hpp>
+
+#include <limits>
+#include <algorithm>
+
+namespace {
+    // how far ahead of the expected displacement the fat box reaches
+    constexpr float DISPLACEMENT_MULTIPLIER = 2.0f;
+}
+
+SpatialIndex::SpatialIndex(float margin) : margin(margin) {}
+
+void SpatialIndex::insert(Entity entity, const Aabb& box) {
+    if (leaves.contains(entity)) {
+        move(entity, box);
+        return;
+    }
+    const auto leaf = _allocateNode();
+    auto& node = nodes[static_cast<size_t>(leaf)];
+    node.box = box.expanded(margin);
+    node.entity = entity;
+    node.height = 0;
+    _insertLeaf(leaf);
+    leaves.emplace(entity, leaf);
+}
+
+void SpatialIndex::remove(Entity entity) {
+    const auto it = leaves.find(entity);
+    if (it == leaves.end()) {
+        return;
+    }
+    _removeLeaf(it->second);
+    _freeNode(it->second);
+    leaves.erase(it);
+}
+
+auto SpatialIndex::move(Entity entity, const Aabb& box, const Vec3& displacement) -> bool {
+    const auto it = leaves.find(entity);
+    if (it == leaves.end()) {
+        insert(entity, box);
+        return true;
+    }
+    const auto leaf = it->second;
+    if (nodes[static_cast<size_t>(leaf)].box.contains(box)) {
+        return false;
+    }
+
+    auto fat = box.expanded(margin);
+    const auto d = displacement * DISPLACEMENT_MULTIPLIER;
+    (d.x < 0.0f ? fat.min.x : fat.max.x) += d.x;
+    (d.y < 0.0f ? fat.min.y : fat.max.y) += d.y;
+    (d.z < 0.0f ? fat.min.z : fat.max.z) += d.z;
+
+    _removeLeaf(leaf);
+    nodes[static_cast<size_t>(leaf)].box = fat;
+    _insertLeaf(leaf);
+    return true;
+}
+
+auto SpatialIndex::height() const noexcept -> int32_t {
+    return root == NONE ? 0 : nodes[static_cast<size_t>(root)].height;
+}
+
+void SpatialIndex::cullFrustum(const Frustum& frustum, std::vector<Entity>& out) const {
+    constexpr auto W = SimdFloat::WIDTH;
+
+    if (root == NONE) {
+        return;
+    }
+
+    // reused between calls, so steady-state culling doesn't allocate
+    thread_local auto current = std::vector<int32_t>{};
+    thread_local auto next = std::vector<int32_t>{};
+    current.assign(1, root);
+
+    while (!current.empty()) {
+        next.clear();
+        for (size_t begin = 0; begin < current.size(); begin += W) {
+            const auto count = std::min(W, current.size() - begin);
+
+            // missing lanes repeat the first node, their results are ignored
+            alignas(32) float bounds[6][W];
+            for (size_t lane = 0; lane < W; lane++) {
+                const auto& box = nodes[static_cast<size_t>(current[begin + (lane < count ? lane : 0)])].box;
+                bounds[0][lane] = box.min.x;
+                bounds[1][lane] = box.min.y;
+                bounds[2][lane] = box.min.z;
+                bounds[3][lane] = box.max.x;
+                bounds[4][lane] = box.max.y;
+                bounds[5][lane] = box.max.z;
+            }
+            const auto min_x = SimdFloat::load(bounds[0]);
+            const auto min_y = SimdFloat::load(bounds[1]);
+            const auto min_z = SimdFloat::load(bounds[2]);
+            const auto max_x = SimdFloat::load(bounds[3]);
+            const auto max_y = SimdFloat::load(bounds[4]);
+            const auto max_z = SimdFloat::load(bounds[5]);
+
+            // per plane, the box corner furthest along the normal decides whether the box is outside,
+            // the nearest corner whether it is inside
+            auto farthest = SimdFloat::broadcast(std::numeric_limits<float>::max());
+            auto nearest = SimdFloat::broadcast(std::numeric_limits<float>::max());
+            for (const auto& plane : frustum.planes) {
+                const auto nx = SimdFloat::broadcast(plane.normal.x);
+                const auto ny = SimdFloat::broadcast(plane.normal.y);
+                const auto nz = SimdFloat::broadcast(plane.normal.z);
+                const auto d = SimdFloat::broadcast(plane.distance);
+
+                const auto ax = nx * min_x, bx = nx * max_x;
+                const auto ay = ny * min_y, by = ny * max_y;
+                const auto az = nz * min_z, bz = nz * max_z;
+                farthest = min(farthest, max(ax, bx) + max(ay, by) + max(az, bz) + d);
+                nearest = min(nearest, min(ax, bx) + min(ay, by) + min(az, bz) + d);
+            }
+
+            alignas(32) float outer[W];
+            alignas(32) float inner[W];
+            farthest.store(outer);
+            nearest.store(inner);
+
+            for (size_t lane = 0; lane < count; lane++) {
+                if (outer[lane] < 0.0f) {
+                    continue;
+                }
+                const auto& node = nodes[static_cast<size_t>(current[begin + lane])];
+                if (node.leaf()) {
+                    out.emplace_back(node.entity);
+                } else if (inner[lane] >= 0.0f) {
+                    _collectLeaves(current[begin + lane], out);
+                } else {
+                    next.emplace_back(node.child1);
+                    next.emplace_back(node.child2);
+                }
+            }
+        }
+        std::swap(current, next);
+    }
+}
+
+auto SpatialIndex::_intersectRay(const Aabb& box, const Vec3& origin, const Vec3& inv, float max_distance, float& distance) -> bool {
+    const auto tx1 = (box.min.x - origin.x) * inv.x, tx2 = (box.max.x - origin.x) * inv.x;
+    const auto ty1 = (box.min.y - origin.y) * inv.y, ty2 = (box.max.y - origin.y) * inv.y;
+    const auto tz1 = (box.min.z - origin.z) * inv.z, tz2 = (box.max.z - origin.z) * inv.z;
+
+    const auto enter = std::max({std::min(tx1, tx2), std::min(ty1, ty2), std::min(tz1, tz2), 0.0f});
+    const auto exit = std::min({std::max(tx1, tx2), std::max(ty1, ty2), std::max(tz1, tz2), max_distance});
+    distance = enter;
+    return enter <= exit;
+}
+
+auto SpatialIndex::_allocateNode() -> int32_t {
+    if (free_list == NONE) {
+        nodes.emplace_back();
+        return static_cast<int32_t>(nodes.size() - 1);
+    }
+    const auto index = free_list;
+    free_list = nodes[static_cast<size_t>(index)].parent;
+    nodes[static_cast<size_t>(index)] = Node{};
+    return index;
+}
+
+void SpatialIndex::_freeNode(int32_t index) {
+    auto& node = nodes[static_cast<size_t>(index)];
+    node.parent = free_list;
+    node.height = -1;
+    free_list = index;
+}
+
+// Descends towards the sibling that grows the tree's surface area the least
+void SpatialIndex::_insertLeaf(int32_t leaf) {
+    auto& leaf_node = nodes[static_cast<size_t>(leaf)];
+    if (root == NONE) {
+        root = leaf;
+        leaf_node.parent = NONE;
+        return;
+    }
+
+    const auto box = leaf_node.box;
+    auto index = root;
+    while (!nodes[static_cast<size_t>(index)].leaf()) {
+        const auto& node = nodes[static_cast<size_t>(index)];
+        const auto area = node.box.perimeter();
+        const auto combined = merge(node.box, box).perimeter();
+
+        // cost of making a new parent for this node and the new leaf, and the cost pushed down to the children
+        const auto cost = 2.0f * combined;
+        const auto inheritance = 2.0f * (combined - area);
+
+        const auto descend = [&](int32_t child) {
+            const auto& c = nodes[static_cast<size_t>(child)];
+            const auto merged = merge(box, c.box).perimeter();
+            return (c.leaf() ? merged : merged - c.box.perimeter()) + inheritance;
+        };
+        const auto cost1 = descend(node.child1);
+        const auto cost2 = descend(node.child2);
+        if (cost < cost1 && cost < cost2) {
+            break;
+        }
+        index = cost1 < cost2 ? node.child1 : node.child2;
+    }
+
+    const auto sibling = index;
+    const auto old_parent = nodes[static_cast<size_t>(sibling)].parent;
+    const auto new_parent = _allocateNode();
+    {
+        auto& node = nodes[static_cast<size_t>(new_parent)];
+        node.parent = old_parent;
+        node.box = merge(box, nodes[static_cast<size_t>(sibling)].box);
+        node.height = nodes[static_cast<size_t>(sibling)].height + 1;
+        node.child1 = sibling;
+        node.child2 = leaf;
+    }
+    if (old_parent == NONE) {
+        root = new_parent;
+    } else {
+        auto& parent = nodes[static_cast<size_t>(old_parent)];
+        (parent.child1 == sibling ? parent.child1 : parent.child2) = new_parent;
+    }
+    nodes[static_cast<size_t>(sibling)].parent = new_parent;
+    nodes[static_cast<size_t>(leaf)].parent = new_parent;
+
+    _refit(new_parent);
+}
+
+void SpatialIndex::_removeLeaf(int32_t leaf) {
+    if (leaf == root) {
+        root = NONE;
+        return;
+    }
+
+    const auto parent = nodes[static_cast<size_t>(leaf)].parent;
+    const auto grand_parent = nodes[static_cast<size_t>(parent)].parent;
+    const auto sibling = nodes[static_cast<size_t>(parent)].child1 == leaf
+        ? nodes[static_cast<size_t>(parent)].child2
+        : nodes[static_cast<size_t>(parent)].child1;
+
+    _freeNode(parent);
+    if (grand_parent == NONE) {
+        root = sibling;
+        nodes[static_cast<size_t>(sibling)].parent = NONE;
+        return;
+    }
+
+    auto& node = nodes[static_cast<size_t>(grand_parent)];
+    (node.child1 == parent ? node.child1 : node.child2) = sibling;
+    nodes[static_cast<size_t>(sibling)].parent = grand_parent;
+    _refit(grand_parent);
+}
+
+// Rebalances and recomputes boxes and heights from index up to the root
+void SpatialIndex::_refit(int32_t index) {
+    while (index != NONE) {
+        index = _balance(index);
+
+        auto& node = nodes[static_cast<size_t>(index)];
+        const auto& child1 = nodes[static_cast<size_t>(node.child1)];
+        const auto& child2 = nodes[static_cast<size_t>(node.child2)];
+        node.height = 1 + std::max(child1.height, child2.height);
+        node.box = merge(child1.box, child2.box);
+
+        index = node.parent;
+    }
+}
+
+// If one child of a is more than one level taller than the other, rotates the taller child up in place of a.
+// Returns the index of the node that now sits where a was.
+auto SpatialIndex::_balance(int32_t ia) -> int32_t {
+    auto& a = nodes[static_cast<size_t>(ia)];
+    if (a.leaf() || a.height < 2) {
+        return ia;
+    }
+
+    const auto ib = a.child1;
+    const auto ic = a.child2;
+    auto& b = nodes[static_cast<size_t>(ib)];
+    auto& c = nodes[static_cast<size_t>(ic)];
+
+    const auto replace = [this, ia](Node& up, int32_t iup) {
+        if (up.parent == NONE) {
+            root = iup;
+            return;
+        }
+        auto& parent = nodes[static_cast<size_t>(up.parent)];
+        (parent.child1 == ia ? parent.child1 : parent.child2) = iup;
+    };
+
+    const auto balance = c.height - b.height;
+    if (balance > 1) {
+        const auto i_f = c.child1;
+        const auto ig = c.child2;
+        auto& f = nodes[static_cast<size_t>(i_f)];
+        auto& g = nodes[static_cast<size_t>(ig)];
+
+        c.child1 = ia;
+        c.parent = a.parent;
+        a.parent = ic;
+        replace(c, ic);
+
+        if (f.height > g.height) {
+            c.child2 = i_f;
+            a.child2 = ig;
+            g.parent = ia;
+            a.box = merge(b.box, g.box);
+            c.box = merge(a.box, f.box);
+            a.height = 1 + std::max(b.height, g.height);
+            c.height = 1 + std::max(a.height, f.height);
+        } else {
+            c.child2 = ig;
+            a.child2 = i_f;
+            f.parent = ia;
+            a.box = merge(b.box, f.box);
+            c.box = merge(a.box, g.box);
+            a.height = 1 + std::max(b.height, f.height);
+            c.height = 1 + std::max(a.height, g.height);
+        }
+        return ic;
+    }
+
+    if (balance < -1) {
+        const auto id = b.child1;
+        const auto ie = b.child2;
+        auto& d = nodes[static_cast<size_t>(id)];
+        auto& e = nodes[static_cast<size_t>(ie)];
+
+        b.child1 = ia;
+        b.parent = a.parent;
+        a.parent = ib;
+        replace(b, ib);
+
+        if (d.height > e.height) {
+            b.child2 = id;
+            a.child1 = ie;
+            e.parent = ia;
+            a.box = merge(c.box, e.box);
+            b.box = merge(a.box, d.box);
+            a.height = 1 + std::max(c.height, e.height);
+            b.height = 1 + std::max(a.height, d.height);
+        } else {
+            b.child2 = ie;
+            a.child1 = id;
+            d.parent = ia;
+            a.box = merge(c.box, d.box);
+            b.box = merge(a.box, e.box);
+            a.height = 1 + std::max(c.height, d.height);
+            b.height = 1 + std::max(a.height, e.height);
+        }
+        return ib;
+    }
+    return ia;
+}
+
+void SpatialIndex::_collectLeaves(int32_t index, std::vector<Entity>& out) const {
+    _traverse([](const Aabb&) { return true; }, [&out](Entity entity) {
+        out.emplace_back(entity);
+        return true;
+    }, index);
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <entity.hpp>
+#include <math/geometry.hpp>
+
+#include <array>
+#include <vector>
+#include <cassert>
+#include <cstdint>
+#include <unordered_map>
+
+// Dynamic AABB tree over scene entities. Leaves store a fattened box, so an entity that moves a little
+// doesn't touch the tree at all; one that leaves its fat box is reinserted, and the path to the root is
+// refitted and rebalanced with tree rotations.
+//
+// Query callbacks return false to stop the query early.
+struct SpatialIndex {
+    // margin added around every box on insertion
+    explicit SpatialIndex(float margin = 0.1f);
+
+    void insert(Entity entity, const Aabb& box);
+    void remove(Entity entity);
+
+    // displacement is the expected movement until the next update, the fat box is extended towards it.
+    // Returns true if the entity had to be reinserted.
+    auto move(Entity entity, const Aabb& box, const Vec3& displacement = {}) -> bool;
+
+    [[nodiscard]] auto contains(Entity entity) const noexcept -> bool {
+        return leaves.contains(entity);
+    }
+
+    [[nodiscard]] auto size() const noexcept -> size_t {
+        return leaves.size();
+    }
+
+    template<typename Fn>
+    void queryAabb(const Aabb& box, Fn&& fn) const {
+        _traverse([&box](const Aabb& node) { return node.overlaps(box); }, fn);
+    }
+
+    template<typename Fn>
+    void querySphere(const Vec3& center, float radius, Fn&& fn) const {
+        const auto radius2 = radius * radius;
+        _traverse([&](const Aabb& node) { return node.distanceSquared(center) <= radius2; }, fn);
+    }
+
+    // Visits entities whose box the ray hits within max_distance, fn(entity, distance to the box)
+    template<typename Fn>
+    void queryRay(const Vec3& origin, const Vec3& direction, float max_distance, Fn&& fn) const {
+        const auto inv = Vec3{1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z};
+        auto distance = 0.0f;
+        _traverse([&](const Aabb& node) {
+            return _intersectRay(node, origin, inv, max_distance, distance);
+        }, [&](Entity entity) {
+            // the leaf test ran last, so distance belongs to this entity's box
+            return fn(entity, distance);
+        });
+    }
+
+    // Appends every entity whose box intersects the frustum. Nodes are tested breadth-first in batches of
+    // SimdFloat::WIDTH against all six planes; subtrees that are fully inside are taken without further tests.
+    void cullFrustum(const Frustum& frustum, std::vector<Entity>& out) const;
+
+    // Height of the tree, 0 for a single leaf
+    [[nodiscard]] auto height() const noexcept -> int32_t;
+
+private:
+    static constexpr int32_t NONE = -1;
+    static constexpr size_t MAX_DEPTH = 256;
+
+    struct Node {
+        Aabb box{};
+        Entity entity{};
+        int32_t parent = NONE;
+        int32_t child1 = NONE;
+        int32_t child2 = NONE;
+        // leaves are 0, free nodes -1
+        int32_t height = -1;
+
+        [[nodiscard]] auto leaf() const noexcept -> bool {
+            return child1 == NONE;
+        }
+    };
+
+    template<typename Test, typename Fn>
+    void _traverse(Test&& test, Fn&& fn) const {
+        _traverse(test, fn, root);
+    }
+
+    template<typename Test, typename Fn>
+    void _traverse(Test&& test, Fn&& fn, int32_t start) const {
+        if (start == NONE) {
+            return;
+        }
+        // rotations keep the tree balanced, so the depth stays far below the stack size
+        auto stack = std::array<int32_t, MAX_DEPTH>{};
+        size_t top = 0;
+        stack[top++] = start;
+        while (top != 0) {
+            const auto& node = nodes[static_cast<size_t>(stack[--top])];
+            if (!test(node.box)) {
+                continue;
+            }
+            if (node.leaf()) {
+                if (!fn(node.entity)) {
+                    return;
+                }
+            } else {
+                assert(top + 2 <= MAX_DEPTH);
+                stack[top++] = node.child1;
+                stack[top++] = node.child2;
+            }
+        }
+    }
+
+    static auto _intersectRay(const Aabb& box, const Vec3& origin, const Vec3& inv, float max_distance, float& distance) -> bool;
+
+    auto _allocateNode() -> int32_t;
+    void _freeNode(int32_t index);
+    void _insertLeaf(int32_t leaf);
+    void _removeLeaf(int32_t leaf);
+    auto _balance(int32_t index) -> int32_t;
+    void _refit(int32_t index);
+    void _collectLeaves(int32_t index, std::vector<Entity>& out) const;
+
+    float margin;
+    int32_t root = NONE;
+    int32_t free_list = NONE;
+    std::vector<Node> nodes;
+    std::unordered_map<Entity, int32_t> leaves;
+};
@@ -0,0 +1,402 @@
+#include "transform_hierarchy.hpp"
+
+#include <math/simd.hpp>
+#include <jobs/job_system.hpp>
+
+#include <cassert>
+#include <algorithm>
+
+namespace {
+    // levels smaller than this are updated on the calling thread
+    constexpr size_t PARALLEL_LEVEL_SIZE = 4096;
+    constexpr size_t BATCHES_PER_JOB = 64;
+
+    constexpr int32_t DEPTH_UNKNOWN = -2;
+    constexpr int32_t DEPTH_REMOVED = -1;
+}
+
+auto TransformHierarchy::create(Entity entity, Entity parent, const Transform& local) -> bool {
+    assert(entity.valid());
+    if (!entity.valid() || has(entity)) {
+        return false;
+    }
+    if (entity.index >= records.size()) {
+        records.resize(entity.index + 1);
+    }
+    if (!has(parent)) {
+        parent = {};
+    }
+
+    // a node left by an earlier entity at this index is dropped by the next rebuild
+    const auto dense = static_cast<uint32_t>(ids.size());
+    auto& record = records[entity.index];
+    record.dense = dense;
+    record.generation = entity.generation;
+    record.parent = parent;
+    record.alive = true;
+
+    ids.emplace_back(entity.index);
+    parents.emplace_back(NO_PARENT);
+    for (auto& channel : locals) {
+        channel.emplace_back();
+    }
+    worlds.emplace_back();
+    dirty.emplace_back();
+
+    setLocal(entity, local);
+    structure_dirty = true;
+    return true;
+}
+
+void TransformHierarchy::destroy(Entity entity) {
+    if (!has(entity)) {
+        return;
+    }
+    records[entity.index].alive = false;
+    structure_dirty = true;
+}
+
+auto TransformHierarchy::has(Entity entity) const noexcept -> bool {
+    return entity.valid() && entity.index < records.size() && records[entity.index].alive
+        && records[entity.index].generation == entity.generation;
+}
+
+auto TransformHierarchy::_find(Entity entity) const noexcept -> std::optional<uint32_t> {
+    assert(has(entity));
+    if (!has(entity)) {
+        return std::nullopt;
+    }
+    return records[entity.index].dense;
+}
+
+auto TransformHierarchy::setParent(Entity entity, Entity parent) -> bool {
+    const auto dense = _find(entity);
+    if (!dense) {
+        return false;
+    }
+    if (!has(parent)) {
+        parent = {};
+    }
+    for (auto ancestor = parent; ancestor.valid(); ancestor = records[ancestor.index].parent) {
+        if (ancestor == entity) {
+            return false;
+        }
+    }
+    records[entity.index].parent = parent;
+    _markDirty(*dense);
+    structure_dirty = true;
+    return true;
+}
+
+auto TransformHierarchy::parent(Entity entity) const noexcept -> Entity {
+    const auto dense = _find(entity);
+    return dense ? records[entity.index].parent : Entity{};
+}
+
+void TransformHierarchy::setLocal(Entity entity, const Transform& local) {
+    const auto dense = _find(entity);
+    if (!dense) {
+        return;
+    }
+    locals[ePositionX][*dense] = local.position.x;
+    locals[ePositionY][*dense] = local.position.y;
+    locals[ePositionZ][*dense] = local.position.z;
+    locals[eRotationX][*dense] = local.rotation.x;
+    locals[eRotationY][*dense] = local.rotation.y;
+    locals[eRotationZ][*dense] = local.rotation.z;
+    locals[eRotationW][*dense] = local.rotation.w;
+    locals[eScaleX][*dense] = local.scale.x;
+    locals[eScaleY][*dense] = local.scale.y;
+    locals[eScaleZ][*dense] = local.scale.z;
+    _markDirty(*dense);
+}
+
+void TransformHierarchy::setPosition(Entity entity, const Vec3& position) {
+    const auto dense = _find(entity);
+    if (!dense) {
+        return;
+    }
+    locals[ePositionX][*dense] = position.x;
+    locals[ePositionY][*dense] = position.y;
+    locals[ePositionZ][*dense] = position.z;
+    _markDirty(*dense);
+}
+
+void TransformHierarchy::setRotation(Entity entity, const Quat& rotation) {
+    const auto dense = _find(entity);
+    if (!dense) {
+        return;
+    }
+    locals[eRotationX][*dense] = rotation.x;
+    locals[eRotationY][*dense] = rotation.y;
+    locals[eRotationZ][*dense] = rotation.z;
+    locals[eRotationW][*dense] = rotation.w;
+    _markDirty(*dense);
+}
+
+void TransformHierarchy::setScale(Entity entity, const Vec3& scale) {
+    const auto dense = _find(entity);
+    if (!dense) {
+        return;
+    }
+    locals[eScaleX][*dense] = scale.x;
+    locals[eScaleY][*dense] = scale.y;
+    locals[eScaleZ][*dense] = scale.z;
+    _markDirty(*dense);
+}
+
+auto TransformHierarchy::local(Entity entity) const noexcept -> Transform {
+    const auto dense = _find(entity);
+    if (!dense) {
+        return Transform{};
+    }
+    return Transform{
+        .position = {locals[ePositionX][*dense], locals[ePositionY][*dense], locals[ePositionZ][*dense]},
+        .rotation = {locals[eRotationX][*dense], locals[eRotationY][*dense], locals[eRotationZ][*dense], locals[eRotationW][*dense]},
+        .scale = {locals[eScaleX][*dense], locals[eScaleY][*dense], locals[eScaleZ][*dense]}
+    };
+}
+
+auto TransformHierarchy::world(Entity entity) const noexcept -> const Mat4& {
+    static constexpr auto identity = Mat4::identity();
+    const auto dense = _find(entity);
+    return dense ? worlds[*dense] : identity;
+}
+
+void TransformHierarchy::update() {
+    if (structure_dirty) {
+        _rebuild();
+    }
+    if (!any_dirty) {
+        return;
+    }
+    for (size_t level = 0; level + 1 < levels.size(); level++) {
+        _updateLevel(levels[level], levels[level + 1], level == 0);
+    }
+    std::fill(dirty.begin(), dirty.end(), 0);
+    any_dirty = false;
+}
+
+// Sorts the nodes by depth, with the children of a level ordered like their parents, and drops the nodes
+// whose ancestor was destroyed.
+void TransformHierarchy::_rebuild() {
+    const auto count = ids.size();
+
+    auto depths = std::vector<int32_t>(count, DEPTH_UNKNOWN);
+    auto stack = std::vector<size_t>{};
+    auto parent_of = std::vector<size_t>(count, NO_PARENT);
+    int32_t max_depth = -1;
+
+    for (size_t i = 0; i < count; i++) {
+        auto j = i;
+        while (depths[j] == DEPTH_UNKNOWN) {
+            const auto& record = records[ids[j]];
+            // the slot of a destroyed node, its record may belong to a newer node already
+            if (!record.alive || record.dense != j) {
+                depths[j] = DEPTH_REMOVED;
+                break;
+            }
+            if (!record.parent.valid()) {
+                depths[j] = 0;
+                break;
+            }
+            const auto& parent = records[record.parent.index];
+            if (!parent.alive || parent.generation != record.parent.generation) {
+                depths[j] = DEPTH_REMOVED;
+                break;
+            }
+            parent_of[j] = parent.dense;
+            stack.emplace_back(j);
+            j = parent.dense;
+        }
+        while (!stack.empty()) {
+            const auto k = stack.back();
+            stack.pop_back();
+            depths[k] = depths[j] == DEPTH_REMOVED ? DEPTH_REMOVED : depths[j] + 1;
+            j = k;
+        }
+        max_depth = std::max(max_depth, depths[i]);
+    }
+
+    // free the descendants of destroyed nodes
+    for (size_t i = 0; i < count; i++) {
+        auto& record = records[ids[i]];
+        if (depths[i] == DEPTH_REMOVED && record.alive && record.dense == i) {
+            record.alive = false;
+        }
+    }
+
+    // counting sort by depth keeps the previous order within a level
+    levels.assign(static_cast<size_t>(max_depth + 2), 0);
+    for (size_t i = 0; i < count; i++) {
+        if (depths[i] >= 0) {
+            levels[static_cast<size_t>(depths[i]) + 1]++;
+        }
+    }
+    for (size_t level = 1; level < levels.size(); level++) {
+        levels[level] += levels[level - 1];
+    }
+    auto order = std::vector<size_t>(levels.back());
+    auto cursor = levels;
+    for (size_t i = 0; i < count; i++) {
+        if (depths[i] >= 0) {
+            order[cursor[static_cast<size_t>(depths[i])]++] = i;
+        }
+    }
+
+    // then group every level by the new position of the parent, so siblings end up next to each other
+    auto positions = std::vector<size_t>(count, 0);
+    for (size_t level = 0; level + 1 < levels.size(); level++) {
+        const auto first = order.begin() + static_cast<ptrdiff_t>(levels[level]);
+        const auto last = order.begin() + static_cast<ptrdiff_t>(levels[level + 1]);
+        if (level > 0) {
+            std::stable_sort(first, last, [&](size_t a, size_t b) {
+                return positions[parent_of[a]] < positions[parent_of[b]];
+            });
+        }
+        for (auto it = first; it != last; ++it) {
+            positions[*it] = static_cast<size_t>(it - order.begin());
+        }
+    }
+
+    auto new_ids = std::vector<uint32_t>(order.size());
+    auto new_parents = std::vector<uint32_t>(order.size());
+    auto new_worlds = std::vector<Mat4>(order.size());
+    auto new_dirty = std::vector<uint8_t>(order.size());
+    for (size_t n = 0; n < order.size(); n++) {
+        const auto old = order[n];
+        new_ids[n] = ids[old];
+        new_parents[n] = parent_of[old] == NO_PARENT ? NO_PARENT : static_cast<uint32_t>(positions[parent_of[old]]);
+        new_worlds[n] = worlds[old];
+        new_dirty[n] = dirty[old];
+        records[new_ids[n]].dense = static_cast<uint32_t>(n);
+    }
+    for (auto& channel : locals) {
+        auto values = std::vector<float>(order.size());
+        for (size_t n = 0; n < order.size(); n++) {
+            values[n] = channel[order[n]];
+        }
+        channel = std::move(values);
+    }
+    ids = std::move(new_ids);
+    parents = std::move(new_parents);
+    worlds = std::move(new_worlds);
+    dirty = std::move(new_dirty);
+
+    structure_dirty = false;
+}
+
+void TransformHierarchy::_updateLevel(size_t begin, size_t end, bool roots) {
+    const auto width = SimdFloat::WIDTH;
+    const auto batches = (end - begin + width - 1) / width;
+
+    const auto update = [this, begin, end, roots, width](size_t first, size_t last) {
+        for (size_t batch = first; batch < last; batch++) {
+            const auto offset = begin + batch * width;
+            _updateBatch(offset, std::min(width, end - offset), roots);
+        }
+    };
+    if (end - begin < PARALLEL_LEVEL_SIZE) {
+        update(0, batches);
+    } else {
+        JobSystem::parallelFor(batches, BATCHES_PER_JOB, update);
+    }
+}
+
+// Computes up to SimdFloat::WIDTH world matrices at once, one node per lane. Only the upper 3x4 part
+// is computed, the bottom row of an affine transform never changes.
+void TransformHierarchy::_updateBatch(size_t begin, size_t count, bool roots) {
+    constexpr auto W = SimdFloat::WIDTH;
+
+    uint8_t changed = 0;
+    for (size_t lane = 0; lane < count; lane++) {
+        const auto i = begin + lane;
+        if (!roots) {
+            dirty[i] |= dirty[parents[i]];
+        }
+        changed |= dirty[i];
+    }
+    if (changed == 0) {
+        return;
+    }
+
+    // a partial batch at the end of a level is padded with identity transforms
+    alignas(32) float padded[eChannelCount][W];
+    const float* channels[eChannelCount];
+    for (size_t c = 0; c < eChannelCount; c++) {
+        if (count == W) {
+            channels[c] = &locals[c][begin];
+            continue;
+        }
+        const auto fill = (c == eRotationW || c >= eScaleX) ? 1.0f : 0.0f;
+        std::fill(std::begin(padded[c]), std::end(padded[c]), fill);
+        std::copy_n(&locals[c][begin], count, padded[c]);
+        channels[c] = padded[c];
+    }
+
+    const auto one = SimdFloat::broadcast(1.0f);
+    const auto two = SimdFloat::broadcast(2.0f);
+
+    const auto x = SimdFloat::load(channels[eRotationX]);
+    const auto y = SimdFloat::load(channels[eRotationY]);
+    const auto z = SimdFloat::load(channels[eRotationZ]);
+    const auto w = SimdFloat::load(channels[eRotationW]);
+    const auto sx = SimdFloat::load(channels[eScaleX]);
+    const auto sy = SimdFloat::load(channels[eScaleY]);
+    const auto sz = SimdFloat::load(channels[eScaleZ]);
+
+    const auto xx = x * x, yy = y * y, zz = z * z;
+    const auto xy = x * y, xz = x * z, yz = y * z;
+    const auto wx = w * x, wy = w * y, wz = w * z;
+
+    // local[column][row]
+    const SimdFloat local[4][3] = {
+        {(one - two * (yy + zz)) * sx, two * (xy + wz) * sx, two * (xz - wy) * sx},
+        {two * (xy - wz) * sy, (one - two * (xx + zz)) * sy, two * (yz + wx) * sy},
+        {two * (xz + wy) * sz, two * (yz - wx) * sz, (one - two * (xx + yy)) * sz},
+        {SimdFloat::load(channels[ePositionX]), SimdFloat::load(channels[ePositionY]), SimdFloat::load(channels[ePositionZ])}
+    };
+
+    alignas(32) float result[4][3][W];
+    if (roots) {
+        for (size_t c = 0; c < 4; c++) {
+            for (size_t r = 0; r < 3; r++) {
+                local[c][r].store(result[c][r]);
+            }
+        }
+    } else {
+        alignas(32) float gathered[4][3][W] = {};
+        for (size_t lane = 0; lane < count; lane++) {
+            const auto& parent = worlds[parents[begin + lane]].m;
+            for (size_t c = 0; c < 4; c++) {
+                for (size_t r = 0; r < 3; r++) {
+                    gathered[c][r][lane] = parent[c * 4 + r];
+                }
+            }
+        }
+        SimdFloat parent[4][3];
+        for (size_t c = 0; c < 4; c++) {
+            for (size_t r = 0; r < 3; r++) {
+                parent[c][r] = SimdFloat::load(gathered[c][r]);
+            }
+        }
+        for (size_t c = 0; c < 4; c++) {
+            for (size_t r = 0; r < 3; r++) {
+                auto value = madd(parent[0][r], local[c][0], madd(parent[1][r], local[c][1], parent[2][r] * local[c][2]));
+                if (c == 3) {
+                    value = value + parent[3][r];
+                }
+                value.store(result[c][r]);
+            }
+        }
+    }
+
+    for (size_t lane = 0; lane < count; lane++) {
+        auto& world = worlds[begin + lane].m;
+        for (size_t c = 0; c < 4; c++) {
+            for (size_t r = 0; r < 3; r++) {
+                world[c * 4 + r] = result[c][r][lane];
+            }
+        }
+    }
+}
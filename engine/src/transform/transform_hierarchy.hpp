@@ -0,0 +1,110 @@
+#pragma once
+
+#include <entity.hpp>
+#include <math/math.hpp>
+
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <optional>
+
+// Parent/child transforms of Scene entities, stored as flat arrays sorted by depth, so every parent comes before
+// its children and siblings sit next to each other. update() walks the arrays once, level by level, and
+// recomputes world matrices only for nodes whose local transform or an ancestor's changed, SimdFloat::WIDTH nodes
+// at a time. Large levels are split across the JobSystem.
+//
+// Every Scene owns one (Scene::transforms()) and removes the node of an entity it destroys. Nodes are looked up
+// by entity index, so a handle from before the entity was destroyed never reaches the new entity's node.
+// Calls with an entity that has no node assert in debug builds and are ignored otherwise.
+//
+// Structural changes (create, destroy, setParent) only mark the order stale; it is rebuilt by the next update().
+// World matrices are valid after update() until the next change.
+struct TransformHierarchy {
+    // Gives entity a node under parent, or a root node if parent has none. Returns false if it already has one.
+    auto create(Entity entity, Entity parent = {}, const Transform& local = {}) -> bool;
+
+    // Removes the node and, at the next update(), the nodes of all of its descendants
+    void destroy(Entity entity);
+
+    [[nodiscard]] auto has(Entity entity) const noexcept -> bool;
+
+    // Removes the nodes of the entities keep returns false for, like destroy()
+    template<typename Fn>
+    void retain(Fn&& keep) {
+        for (uint32_t index = 0; index < records.size(); index++) {
+            auto& record = records[index];
+            if (record.alive && !keep(Entity{.index = index, .generation = record.generation})) {
+                record.alive = false;
+                structure_dirty = true;
+            }
+        }
+    }
+
+    // Returns false if entity has no node or parent is entity itself or one of its descendants.
+    // A parent without a node makes entity a root.
+    auto setParent(Entity entity, Entity parent) -> bool;
+
+    // an invalid entity for roots
+    [[nodiscard]] auto parent(Entity entity) const noexcept -> Entity;
+
+    void setLocal(Entity entity, const Transform& local);
+    void setPosition(Entity entity, const Vec3& position);
+    void setRotation(Entity entity, const Quat& rotation);
+    void setScale(Entity entity, const Vec3& scale);
+
+    [[nodiscard]] auto local(Entity entity) const noexcept -> Transform;
+
+    // the identity for entities without a node
+    [[nodiscard]] auto world(Entity entity) const noexcept -> const Mat4&;
+
+    [[nodiscard]] auto size() const noexcept -> size_t {
+        return ids.size();
+    }
+
+    void update();
+
+private:
+    static constexpr uint32_t NO_PARENT = UINT32_MAX;
+
+    // local transform components, one array each
+    enum Channel : size_t {
+        ePositionX, ePositionY, ePositionZ,
+        eRotationX, eRotationY, eRotationZ, eRotationW,
+        eScaleX, eScaleY, eScaleZ,
+        eChannelCount
+    };
+
+    // indexed by Entity::index
+    struct Record {
+        uint32_t dense = 0;
+        uint32_t generation = 0;
+        Entity parent{};
+        bool alive = false;
+    };
+
+    // dense index of the entity's node, asserts that there is one
+    [[nodiscard]] auto _find(Entity entity) const noexcept -> std::optional<uint32_t>;
+
+    void _markDirty(uint32_t dense) {
+        dirty[dense] = 1;
+        any_dirty = true;
+    }
+
+    void _rebuild();
+    void _updateLevel(size_t begin, size_t end, bool roots);
+    void _updateBatch(size_t begin, size_t count, bool roots);
+
+    std::vector<Record> records;
+
+    // dense arrays, ordered by depth after _rebuild()
+    std::vector<uint32_t> ids;
+    std::vector<uint32_t> parents;
+    std::array<std::vector<float>, eChannelCount> locals;
+    std::vector<Mat4> worlds;
+    std::vector<uint8_t> dirty;
+    // start of every depth level plus the end of the last one
+    std::vector<size_t> levels;
+
+    bool structure_dirty = false;
+    bool any_dirty = false;
+};
@@ -0,0 +1,127 @@
+#include "chunk_section.hpp"
+
+#include <numeric>
+#include <algorithm>
+
+namespace {
+    auto bitsFor(size_t palette_size) noexcept -> uint32_t {
+        if (palette_size <= 1) {
+            return 0;
+        }
+        auto bits = uint32_t{1};
+        while ((size_t{1} << bits) < palette_size) {
+            bits *= 2;
+        }
+        return bits;
+    }
+}
+
+ChunkSection::ChunkSection() : palette{AIR}, counts{VOLUME} {}
+
+auto ChunkSection::set(int x, int y, int z, BlockId block) -> bool {
+    const auto i = index(x, y, z);
+    const auto old = _read(i);
+    if (palette[old] == block) {
+        return false;
+    }
+
+    auto entry = static_cast<uint32_t>(std::find(palette.begin(), palette.end(), block) - palette.begin());
+    if (entry == palette.size()) {
+        // reuse an entry nothing refers to anymore before growing
+        entry = static_cast<uint32_t>(std::find(counts.begin(), counts.end(), uint16_t{0}) - counts.begin());
+        if (entry == counts.size()) {
+            palette.emplace_back(block);
+            counts.emplace_back(0);
+            if (const auto needed = bitsFor(palette.size()); needed != bits) {
+                auto identity = std::vector<uint32_t>(palette.size());
+                std::iota(identity.begin(), identity.end(), 0u);
+                _repack(needed, identity);
+            }
+        } else {
+            palette[entry] = block;
+        }
+    }
+
+    counts[old]--;
+    counts[entry]++;
+    _write(i, entry);
+    return true;
+}
+
+void ChunkSection::decode(std::span<BlockId, VOLUME> out) const noexcept {
+    if (bits == 0) {
+        std::fill(out.begin(), out.end(), palette[0]);
+        return;
+    }
+    const auto per_word = 64 / bits;
+    const auto mask = (uint64_t{1} << bits) - 1;
+    for (size_t w = 0; w < words.size(); w++) {
+        auto word = words[w];
+        for (size_t j = 0; j < per_word; j++) {
+            out[w * per_word + j] = palette[word & mask];
+            word >>= bits;
+        }
+    }
+}
+
+void ChunkSection::compact() {
+    auto remap = std::vector<uint32_t>(palette.size(), 0);
+    auto new_palette = std::vector<BlockId>{};
+    auto new_counts = std::vector<uint16_t>{};
+    for (size_t i = 0; i < palette.size(); i++) {
+        if (counts[i] != 0) {
+            remap[i] = static_cast<uint32_t>(new_palette.size());
+            new_palette.emplace_back(palette[i]);
+            new_counts.emplace_back(counts[i]);
+        }
+    }
+    if (new_palette.size() == palette.size()) {
+        return;
+    }
+
+    _repack(bitsFor(new_palette.size()), remap);
+    palette = std::move(new_palette);
+    counts = std::move(new_counts);
+    palette.shrink_to_fit();
+    counts.shrink_to_fit();
+}
+
+auto ChunkSection::empty() const noexcept -> bool {
+    for (size_t i = 0; i < palette.size(); i++) {
+        if (palette[i] == AIR) {
+            return counts[i] == VOLUME;
+        }
+    }
+    return false;
+}
+
+auto ChunkSection::memoryUsage() const noexcept -> size_t {
+    return palette.capacity() * sizeof(BlockId) + counts.capacity() * sizeof(uint16_t) + words.capacity() * sizeof(uint64_t);
+}
+
+void ChunkSection::_write(size_t i, uint32_t value) noexcept {
+    const auto bit = i * bits;
+    const auto mask = ((uint64_t{1} << bits) - 1) << (bit % 64);
+    auto& word = words[bit / 64];
+    word = (word & ~mask) | (static_cast<uint64_t>(value) << (bit % 64));
+}
+
+void ChunkSection::_repack(uint32_t new_bits, std::span<const uint32_t> remap) {
+    auto old_words = std::move(words);
+    const auto old_bits = bits;
+
+    words.assign(new_bits * VOLUME / 64, 0);
+    bits = new_bits;
+    if (new_bits == 0) {
+        words.shrink_to_fit();
+        return;
+    }
+    for (size_t i = 0; i < VOLUME; i++) {
+        auto value = uint32_t{0};
+        if (old_bits != 0) {
+            const auto bit = i * old_bits;
+            value = static_cast<uint32_t>((old_words[bit / 64] >> (bit % 64)) & ((uint64_t{1} << old_bits) - 1));
+        }
+        _write(i, remap[value]);
+    }
+}
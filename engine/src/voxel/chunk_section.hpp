@@ -0,0 +1,70 @@
+#pragma once
+
+#include <span>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+using BlockId = uint16_t;
+
+// block 0 is air, every other block is an opaque cube
+inline constexpr BlockId AIR = 0;
+
+// 16x16x16 blocks, stored as indices into a palette of the distinct blocks in the section.
+// Indices are bit-packed with the fewest bits that fit the palette (0, 1, 2, 4, 8 or 16, so no index
+// straddles two words); a section of one block type stores no indices at all.
+struct ChunkSection {
+    static constexpr int SIZE = 16;
+    static constexpr int VOLUME = SIZE * SIZE * SIZE;
+
+    ChunkSection();
+
+    [[nodiscard]] static constexpr auto index(int x, int y, int z) noexcept -> size_t {
+        return static_cast<size_t>((y * SIZE + z) * SIZE + x);
+    }
+
+    [[nodiscard]] auto get(int x, int y, int z) const noexcept -> BlockId {
+        return palette[_read(index(x, y, z))];
+    }
+
+    // Returns false if the block was already there
+    auto set(int x, int y, int z, BlockId block) -> bool;
+
+    // Writes all blocks in index() order
+    void decode(std::span<BlockId, VOLUME> out) const noexcept;
+
+    // Drops palette entries that are no longer used and shrinks the indices to match
+    void compact();
+
+    // true if every block is air
+    [[nodiscard]] auto empty() const noexcept -> bool;
+
+    [[nodiscard]] auto bitsPerBlock() const noexcept -> uint32_t {
+        return bits;
+    }
+
+    [[nodiscard]] auto paletteSize() const noexcept -> size_t {
+        return palette.size();
+    }
+
+    // heap bytes owned by the section
+    [[nodiscard]] auto memoryUsage() const noexcept -> size_t;
+
+private:
+    [[nodiscard]] auto _read(size_t i) const noexcept -> uint32_t {
+        if (bits == 0) {
+            return 0;
+        }
+        const auto bit = i * bits;
+        return static_cast<uint32_t>((words[bit / 64] >> (bit % 64)) & ((uint64_t{1} << bits) - 1));
+    }
+
+    void _write(size_t i, uint32_t value) noexcept;
+    void _repack(uint32_t new_bits, std::span<const uint32_t> remap);
+
+    std::vector<BlockId> palette;
+    // number of blocks using each palette entry, unused entries are reused before the palette grows
+    std::vector<uint16_t> counts;
+    std::vector<uint64_t> words;
+    uint32_t bits = 0;
+};
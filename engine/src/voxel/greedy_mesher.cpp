@@ -0,0 +1,95 @@
+#include "greedy_mesher.hpp"
+
+#include <array>
+
+namespace {
+    constexpr auto N = ChunkSection::SIZE;
+
+    auto pack(const std::array<int, 3>& p, Face face, BlockId block) noexcept -> VoxelVertex {
+        return VoxelVertex{
+            .position_face = static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[1]) << 5 | static_cast<uint32_t>(p[2]) << 10
+                | static_cast<uint32_t>(face) << 15,
+            .block = block
+        };
+    }
+}
+
+void meshSection(const PaddedSection& section, VoxelMesh& mesh) {
+    auto mask = std::array<BlockId, N * N>{};
+    constexpr auto strides = std::array<ptrdiff_t, 3>{1, PaddedSection::SIZE * PaddedSection::SIZE, PaddedSection::SIZE};
+
+    for (int axis = 0; axis < 3; axis++) {
+        // u and v follow axis cyclically, so u x v points along +axis
+        const auto u = (axis + 1) % 3;
+        const auto v = (axis + 2) % 3;
+
+        for (int direction = 1; direction >= -1; direction -= 2) {
+            const auto face = static_cast<Face>(axis * 2 + (direction > 0 ? 0 : 1));
+
+            const auto offset = direction * strides[axis];
+
+            for (int slice = 0; slice < N; slice++) {
+                for (int b = 0; b < N; b++) {
+                    const auto row = section.blocks + PaddedSection::index(0, 0, 0) + slice * strides[axis] + b * strides[v];
+                    for (int a = 0; a < N; a++) {
+                        const auto block = row + a * strides[u];
+                        mask[b * N + a] = block[offset] == AIR ? *block : AIR;
+                    }
+                }
+
+                for (int b = 0; b < N; b++) {
+                    for (int a = 0; a < N;) {
+                        const auto block = mask[b * N + a];
+                        if (block == AIR) {
+                            a++;
+                            continue;
+                        }
+
+                        auto width = 1;
+                        while (a + width < N && mask[b * N + a + width] == block) {
+                            width++;
+                        }
+                        auto height = 1;
+                        for (; b + height < N; height++) {
+                            auto row = &mask[(b + height) * N + a];
+                            auto same = true;
+                            for (int k = 0; k < width && same; k++) {
+                                same = row[k] == block;
+                            }
+                            if (!same) {
+                                break;
+                            }
+                        }
+                        for (int h = 0; h < height; h++) {
+                            std::fill_n(&mask[(b + h) * N + a], width, AIR);
+                        }
+
+                        auto corner = std::array<int, 3>{};
+                        corner[axis] = slice + (direction > 0 ? 1 : 0);
+                        const auto base = static_cast<uint16_t>(mesh.vertices.size());
+                        const auto emit = [&](int du, int dv) {
+                            corner[u] = a + du;
+                            corner[v] = b + dv;
+                            mesh.vertices.emplace_back(pack(corner, face, block));
+                        };
+                        emit(0, 0);
+                        emit(width, 0);
+                        emit(width, height);
+                        emit(0, height);
+
+                        if (direction > 0) {
+                            mesh.indices.insert(mesh.indices.end(), {
+                                base, uint16_t(base + 1), uint16_t(base + 2), base, uint16_t(base + 2), uint16_t(base + 3)
+                            });
+                        } else {
+                            mesh.indices.insert(mesh.indices.end(), {
+                                base, uint16_t(base + 2), uint16_t(base + 1), base, uint16_t(base + 3), uint16_t(base + 2)
+                            });
+                        }
+                        a += width;
+                    }
+                }
+            }
+        }
+    }
+}
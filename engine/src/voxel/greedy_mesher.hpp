@@ -0,0 +1,52 @@
+#pragma once
+
+#include "chunk_section.hpp"
+
+#include <span>
+#include <vector>
+#include <cstdint>
+
+// 8 bytes per vertex. position_face packs x, y and z relative to the section origin (0..16, 5 bits each)
+// and the face direction (3 bits, see Face); block holds the BlockId. Texture coordinates follow from the
+// position and the face, so merged quads tile their texture in the shader.
+struct VoxelVertex {
+    uint32_t position_face;
+    uint32_t block;
+};
+
+enum class Face : uint32_t {
+    PositiveX,
+    NegativeX,
+    PositiveY,
+    NegativeY,
+    PositiveZ,
+    NegativeZ
+};
+
+struct VoxelMesh {
+    std::vector<VoxelVertex> vertices;
+    // counter-clockwise triangles seen from outside, a section never needs more than 65536 vertices
+    std::vector<uint16_t> indices;
+
+    void clear() noexcept {
+        vertices.clear();
+        indices.clear();
+    }
+};
+
+// Section blocks with a one block border taken from the neighbouring sections, so faces on the section
+// boundary are culled against them. Only the six face neighbours matter; edges and corners are ignored.
+struct PaddedSection {
+    static constexpr int SIZE = ChunkSection::SIZE + 2;
+    static constexpr int VOLUME = SIZE * SIZE * SIZE;
+
+    [[nodiscard]] static constexpr auto index(int x, int y, int z) noexcept -> size_t {
+        return static_cast<size_t>(((y + 1) * SIZE + (z + 1)) * SIZE + (x + 1));
+    }
+
+    BlockId blocks[VOLUME];
+};
+
+// Emits a face wherever a block touches air and merges coplanar faces of the same block into
+// rectangles, slice by slice for each of the six directions. Appends to mesh.
+void meshSection(const PaddedSection& section, VoxelMesh& mesh);
@@ -0,0 +1,202 @@
+#include "voxel_world.hpp"
+
+#include <jobs/job_system.hpp>
+
+#include <algorithm>
+
+namespace {
+    constexpr auto S = ChunkSection::SIZE;
+
+    // floor division and modulo, so negative coordinates map to the chunk below
+    constexpr auto chunkOf(int32_t v) noexcept -> int32_t {
+        return v >= 0 ? v / S : (v - S + 1) / S;
+    }
+
+    constexpr auto localOf(int32_t v) noexcept -> int {
+        return static_cast<int>(v - chunkOf(v) * S);
+    }
+}
+
+auto VoxelChunk::memoryUsage() const noexcept -> size_t {
+    auto bytes = sizeof(VoxelChunk);
+    for (const auto& section : sections) {
+        bytes += section.memoryUsage();
+    }
+    return bytes;
+}
+
+auto VoxelWorld::get(int32_t x, int32_t y, int32_t z) const noexcept -> BlockId {
+    if (y < 0 || y >= VoxelChunk::HEIGHT) {
+        return AIR;
+    }
+    const auto it = chunks.find(ChunkCoord{chunkOf(x), chunkOf(z)});
+    if (it == chunks.end()) {
+        return AIR;
+    }
+    return it->second->sections[y / S].get(localOf(x), y % S, localOf(z));
+}
+
+void VoxelWorld::set(int32_t x, int32_t y, int32_t z, BlockId block) {
+    if (y < 0 || y >= VoxelChunk::HEIGHT) {
+        return;
+    }
+    const auto coord = ChunkCoord{chunkOf(x), chunkOf(z)};
+    const auto lx = localOf(x);
+    const auto ly = y % S;
+    const auto lz = localOf(z);
+    const auto section = y / S;
+    if (!createChunk(coord).sections[section].set(lx, ly, lz, block)) {
+        return;
+    }
+
+    _markDirty(coord, section);
+    if (lx == 0 || lx == S - 1) {
+        _markDirty({coord.x + (lx == 0 ? -1 : 1), coord.z}, section);
+    }
+    if (lz == 0 || lz == S - 1) {
+        _markDirty({coord.x, coord.z + (lz == 0 ? -1 : 1)}, section);
+    }
+    if (ly == 0 && section > 0) {
+        _markDirty(coord, section - 1);
+    }
+    if (ly == S - 1 && section < VoxelChunk::SECTIONS - 1) {
+        _markDirty(coord, section + 1);
+    }
+}
+
+auto VoxelWorld::chunk(ChunkCoord coord) const noexcept -> const VoxelChunk* {
+    const auto it = chunks.find(coord);
+    return it != chunks.end() ? it->second.get() : nullptr;
+}
+
+auto VoxelWorld::createChunk(ChunkCoord coord) -> VoxelChunk& {
+    auto& chunk = chunks[coord];
+    if (!chunk) {
+        chunk = std::make_unique<VoxelChunk>();
+        _markNeighbours(coord);
+    }
+    return *chunk;
+}
+
+void VoxelWorld::removeChunk(ChunkCoord coord) {
+    if (chunks.erase(coord) > 0) {
+        _markNeighbours(coord);
+    }
+}
+
+auto VoxelWorld::memoryUsage() const noexcept -> size_t {
+    auto bytes = size_t{0};
+    for (const auto& [_, chunk] : chunks) {
+        bytes += chunk->memoryUsage();
+    }
+    return bytes;
+}
+
+void VoxelWorld::markDirty(ChunkCoord coord) {
+    if (const auto it = chunks.find(coord); it != chunks.end()) {
+        it->second->dirty = (1u << VoxelChunk::SECTIONS) - 1;
+    }
+}
+
+void VoxelWorld::remeshDirty(std::vector<SectionMesh>& out) {
+    const auto first = out.size();
+    for (const auto& [coord, chunk] : chunks) {
+        for (int32_t section = 0; section < VoxelChunk::SECTIONS; section++) {
+            if (chunk->dirty & (1u << section)) {
+                out.emplace_back(SectionMesh{.chunk = coord, .section = section, .mesh = {}});
+            }
+        }
+        chunk->dirty = 0;
+    }
+
+    JobSystem::parallelFor(out.size() - first, 1, [this, &out, first](size_t begin, size_t end) {
+        thread_local auto padded = std::make_unique<PaddedSection>();
+        for (auto i = first + begin; i < first + end; i++) {
+            auto& result = out[i];
+            result.mesh.clear();
+            // an empty section has no faces, the neighbours own the faces against it
+            if (chunks.at(result.chunk)->sections[result.section].empty()) {
+                continue;
+            }
+            gather(result.chunk, result.section, *padded);
+            meshSection(*padded, result.mesh);
+        }
+    });
+
+    // edits leave unused palette entries behind
+    for (auto i = first; i < out.size(); i++) {
+        chunks.at(out[i].chunk)->sections[out[i].section].compact();
+    }
+}
+
+void VoxelWorld::gather(ChunkCoord coord, int32_t section, PaddedSection& out) const noexcept {
+    std::fill(std::begin(out.blocks), std::end(out.blocks), AIR);
+
+    const auto center = chunk(coord);
+    if (center == nullptr) {
+        return;
+    }
+
+    auto blocks = std::array<BlockId, ChunkSection::VOLUME>{};
+    center->sections[section].decode(blocks);
+    for (int y = 0; y < S; y++) {
+        for (int z = 0; z < S; z++) {
+            std::copy_n(&blocks[ChunkSection::index(0, y, z)], S, &out.blocks[PaddedSection::index(0, y, z)]);
+        }
+    }
+
+    // visits the 16x16 positions of one border face
+    const auto border = [](auto&& fn) {
+        for (int j = 0; j < S; j++) {
+            for (int i = 0; i < S; i++) {
+                fn(i, j);
+            }
+        }
+    };
+    if (const auto west = chunk({coord.x - 1, coord.z})) {
+        const auto& source = west->sections[section];
+        border([&](int i, int j) { out.blocks[PaddedSection::index(-1, j, i)] = source.get(S - 1, j, i); });
+    }
+    if (const auto east = chunk({coord.x + 1, coord.z})) {
+        const auto& source = east->sections[section];
+        border([&](int i, int j) { out.blocks[PaddedSection::index(S, j, i)] = source.get(0, j, i); });
+    }
+    if (const auto north = chunk({coord.x, coord.z - 1})) {
+        const auto& source = north->sections[section];
+        border([&](int i, int j) { out.blocks[PaddedSection::index(i, j, -1)] = source.get(i, j, S - 1); });
+    }
+    if (const auto south = chunk({coord.x, coord.z + 1})) {
+        const auto& source = south->sections[section];
+        border([&](int i, int j) { out.blocks[PaddedSection::index(i, j, S)] = source.get(i, j, 0); });
+    }
+    if (section > 0) {
+        const auto& source = center->sections[section - 1];
+        border([&](int i, int j) { out.blocks[PaddedSection::index(i, -1, j)] = source.get(i, S - 1, j); });
+    }
+    if (section < VoxelChunk::SECTIONS - 1) {
+        const auto& source = center->sections[section + 1];
+        border([&](int i, int j) { out.blocks[PaddedSection::index(i, S, j)] = source.get(i, 0, j); });
+    }
+}
+
+// The neighbours meshed their faces against what was at coord before, air while there was no chunk. Only their
+// sections with blocks have faces on the border.
+void VoxelWorld::_markNeighbours(ChunkCoord coord) {
+    for (const auto neighbour : {ChunkCoord{coord.x - 1, coord.z}, ChunkCoord{coord.x + 1, coord.z}, ChunkCoord{coord.x, coord.z - 1}, ChunkCoord{coord.x, coord.z + 1}}) {
+        const auto it = chunks.find(neighbour);
+        if (it == chunks.end()) {
+            continue;
+        }
+        for (int32_t section = 0; section < VoxelChunk::SECTIONS; section++) {
+            if (!it->second->sections[section].empty()) {
+                it->second->dirty |= 1u << section;
+            }
+        }
+    }
+}
+
+void VoxelWorld::_markDirty(ChunkCoord coord, int32_t section) {
+    if (const auto it = chunks.find(coord); it != chunks.end()) {
+        it->second->dirty |= 1u << section;
+    }
+}
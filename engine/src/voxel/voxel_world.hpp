@@ -0,0 +1,78 @@
+#pragma once
+
+#include "chunk_section.hpp"
+#include "greedy_mesher.hpp"
+
+#include <array>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+
+struct ChunkCoord {
+    int32_t x = 0;
+    int32_t z = 0;
+
+    constexpr auto operator==(const ChunkCoord&) const noexcept -> bool = default;
+};
+
+template<>
+struct std::hash<ChunkCoord> {
+    auto operator()(const ChunkCoord& chunk) const noexcept -> size_t {
+        return std::hash<uint64_t>{}((static_cast<uint64_t>(static_cast<uint32_t>(chunk.x)) << 32) | static_cast<uint32_t>(chunk.z));
+    }
+};
+
+// A column of 16x16x16 sections. Edits mark the section dirty, and its neighbour too when the block is
+// on the boundary, since the neighbour's faces against it change. For the same reason, creating or removing
+// a chunk marks the sections of the chunks next to it that have blocks.
+struct VoxelChunk {
+    static constexpr int SECTIONS = 16;
+    static constexpr int HEIGHT = SECTIONS * ChunkSection::SIZE;
+
+    std::array<ChunkSection, SECTIONS> sections;
+    uint32_t dirty = 0;
+
+    // heap bytes plus the chunk itself
+    [[nodiscard]] auto memoryUsage() const noexcept -> size_t;
+};
+
+struct SectionMesh {
+    ChunkCoord chunk;
+    int32_t section = 0;
+    VoxelMesh mesh;
+};
+
+struct VoxelWorld {
+    // chunks are created on first write, reads outside any chunk return air
+    [[nodiscard]] auto get(int32_t x, int32_t y, int32_t z) const noexcept -> BlockId;
+    void set(int32_t x, int32_t y, int32_t z, BlockId block);
+
+    [[nodiscard]] auto chunk(ChunkCoord coord) const noexcept -> const VoxelChunk*;
+    auto createChunk(ChunkCoord coord) -> VoxelChunk&;
+    void removeChunk(ChunkCoord coord);
+
+    [[nodiscard]] auto chunkCount() const noexcept -> size_t {
+        return chunks.size();
+    }
+
+    [[nodiscard]] auto memoryUsage() const noexcept -> size_t;
+
+    // Marks every section of the chunk dirty, e.g. after filling it through createChunk
+    void markDirty(ChunkCoord coord);
+
+    // Meshes every dirty section on the job system, compacts their palettes and clears the dirty flags.
+    // Returns one mesh per dirty section, empty meshes included so the caller can drop stale ones.
+    // The world must not be modified until it returns.
+    void remeshDirty(std::vector<SectionMesh>& out);
+
+    // Copies a section and the faces of its neighbours into a padded block array
+    void gather(ChunkCoord coord, int32_t section, PaddedSection& out) const noexcept;
+
+private:
+    void _markDirty(ChunkCoord coord, int32_t section);
+    void _markNeighbours(ChunkCoord coord);
+
+    std::unordered_map<ChunkCoord, std::unique_ptr<VoxelChunk>> chunks;
+};
@@ -0,0 +1,251 @@
+#include "world_streamer.hpp"
+
+#include <debug.hpp>
+#include <jobs/job_system.hpp>
+#include <memory/memory_system.hpp>
+#include <memory/pool_allocator.hpp>
+#include <resources/resource.hpp>
+#include <resources/resource_system.hpp>
+
+#include <cmath>
+#include <optional>
+#include <algorithm>
+#include <unordered_map>
+
+namespace {
+    struct Cell {
+        CellCoord coord;
+        CellState state = CellState::Loading;
+        float distance = 0.0f;
+        std::string path;
+
+        // written by the job, read once it is done
+        JobHandle io;
+        std::optional<Resource> resource;
+        std::optional<SnapshotView> view;
+
+        // next row to instantiate
+        size_t table = 0;
+        size_t row = 0;
+        std::vector<Entity> entities;
+        bool announced = false;
+    };
+}
+
+struct WorldStreamer::Impl {
+    using Callback = std::function<void(CellCoord cell, std::span<const Entity> entities)>;
+
+    Debug logger{"world"};
+
+    Scene& scene;
+    Settings settings;
+    // cells come and go as the camera moves, the pool recycles them instead of going back to the heap
+    Pool<Cell> cell_pool{MemorySystem::heap(), 16};
+    std::unordered_map<CellCoord, Cell*> cells;
+    std::vector<std::pair<float, CellCoord>> candidates;
+    std::vector<Cell*> work;
+
+    Callback loaded;
+    Callback unloading;
+
+    Impl(Scene& scene, Settings settings) : scene(scene), settings(std::move(settings)) {}
+
+    ~Impl() {
+        for (const auto& [_, cell] : cells) {
+            JobSystem::wait(cell->io);
+            cell_pool.destroy(cell);
+        }
+    }
+
+    // distance on the xz plane from the position to the closest point of the cell
+    auto _distance(CellCoord cell, const Vec3& position) const noexcept -> float {
+        const auto min_x = static_cast<float>(cell.x) * settings.cell_size;
+        const auto min_z = static_cast<float>(cell.z) * settings.cell_size;
+        const auto dx = std::max({min_x - position.x, 0.0f, position.x - (min_x + settings.cell_size)});
+        const auto dz = std::max({min_z - position.z, 0.0f, position.z - (min_z + settings.cell_size)});
+        return std::sqrt(dx * dx + dz * dz);
+    }
+
+    void _load(CellCoord coord, float distance) {
+        auto cell = cells.emplace(coord, cell_pool.create()).first->second;
+        cell->coord = coord;
+        cell->distance = distance;
+        cell->path = fmt::format(fmt::runtime(settings.cell_path), coord.x, coord.z);
+        cell->io = JobSystem::schedule([cell] {
+            cell->resource = ResourceSystem::get(cell->path);
+            if (cell->resource) {
+                cell->view = SnapshotView::parse(std::span(reinterpret_cast<const std::byte*>(cell->resource->bytes()), cell->resource->size()));
+            }
+        });
+    }
+
+    void _unload(Cell& cell) {
+        if (cell.announced && unloading) {
+            unloading(cell.coord, cell.entities);
+        }
+        cell.state = CellState::Unloading;
+    }
+
+    // Creates one batch of entities, returns false once the cell is complete
+    auto _instantiate(Cell& cell) -> bool {
+        const auto& tables = cell.view->tables;
+        while (cell.table < tables.size() && cell.row == tables[cell.table].size) {
+            cell.table++;
+            cell.row = 0;
+        }
+        if (cell.table == tables.size()) {
+            cell.state = CellState::Loaded;
+            cell.view.reset();
+            cell.resource.reset();
+            cell.announced = true;
+            if (loaded) {
+                loaded(cell.coord, cell.entities);
+            }
+            return false;
+        }
+
+        const auto& table = tables[cell.table];
+        const auto count = std::min(settings.batch_size, table.size - cell.row);
+        const auto first = cell.entities.size();
+        cell.entities.resize(first + count);
+        scene.instantiate(table, cell.row, std::span(cell.entities).subspan(first, count));
+        cell.row += count;
+        return true;
+    }
+
+    // Destroys one batch of entities, returns false once the cell is empty
+    auto _destroy(Cell& cell) -> bool {
+        if (cell.entities.empty()) {
+            return false;
+        }
+        const auto count = std::min(settings.batch_size, cell.entities.size());
+        const auto first = cell.entities.size() - count;
+        scene.destroyEntities(std::span(cell.entities).subspan(first, count));
+        cell.entities.resize(first);
+        return true;
+    }
+};
+
+WorldStreamer::WorldStreamer(Scene& scene) : WorldStreamer(scene, Settings{}) {}
+
+WorldStreamer::WorldStreamer(Scene& scene, Settings settings) {
+    impl = std::make_unique<Impl>(scene, std::move(settings));
+}
+
+WorldStreamer::~WorldStreamer() = default;
+
+void WorldStreamer::update(const Vec3& camera) {
+    const auto deadline = std::chrono::steady_clock::now() + impl->settings.frame_budget;
+    const auto& settings = impl->settings;
+
+    auto loading = size_t{0};
+    for (const auto& [coord, cell] : impl->cells) {
+        cell->distance = impl->_distance(coord, camera);
+        if (cell->state == CellState::Loading && JobSystem::done(cell->io)) {
+            if (cell->view) {
+                cell->state = CellState::Instantiating;
+                cell->entities.reserve(cell->view->entityCount());
+            } else {
+                // worlds can have holes; the cell stays empty until it leaves the range, so it isn't requested every frame
+                if (!cell->resource) {
+                    impl->logger.debug("world cell {} doesn't exist", cell->path);
+                }
+                cell->state = CellState::Loaded;
+                cell->resource.reset();
+            }
+        }
+        if (cell->distance > settings.unload_radius && cell->state != CellState::Unloading) {
+            impl->_unload(*cell);
+        }
+        if (!JobSystem::done(cell->io)) {
+            loading++;
+        }
+    }
+
+    // request missing cells in range, nearest first
+    impl->candidates.clear();
+    const auto center = cellAt(camera);
+    const auto reach = static_cast<int32_t>(std::ceil(settings.load_radius / settings.cell_size));
+    for (auto z = center.z - reach; z <= center.z + reach; z++) {
+        for (auto x = center.x - reach; x <= center.x + reach; x++) {
+            const auto coord = CellCoord{x, z};
+            const auto distance = impl->_distance(coord, camera);
+            if (distance <= settings.load_radius && !impl->cells.contains(coord)) {
+                impl->candidates.emplace_back(distance, coord);
+            }
+        }
+    }
+    std::sort(impl->candidates.begin(), impl->candidates.end(), [](const auto& a, const auto& b) {
+        return a.first < b.first;
+    });
+    for (const auto& [distance, coord] : impl->candidates) {
+        if (loading >= settings.max_loading_cells || impl->cells.size() >= settings.max_resident_cells) {
+            break;
+        }
+        impl->_load(coord, distance);
+        loading++;
+    }
+
+    // unloads go first since they free memory, then the nearest cells are filled in
+    impl->work.clear();
+    for (const auto& [_, cell] : impl->cells) {
+        if (cell->state == CellState::Unloading || cell->state == CellState::Instantiating) {
+            impl->work.emplace_back(cell);
+        }
+    }
+    std::sort(impl->work.begin(), impl->work.end(), [](const Cell* a, const Cell* b) {
+        if ((a->state == CellState::Unloading) != (b->state == CellState::Unloading)) {
+            return a->state == CellState::Unloading;
+        }
+        return a->distance < b->distance;
+    });
+
+    auto first_batch = true;
+    const auto in_budget = [&] {
+        return std::exchange(first_batch, false) || std::chrono::steady_clock::now() < deadline;
+    };
+    for (const auto cell : impl->work) {
+        if (cell->state == CellState::Unloading) {
+            while (in_budget() && impl->_destroy(*cell)) {}
+            // a cell that went out of range while loading is dropped once its job finished
+            if (cell->entities.empty() && JobSystem::done(cell->io)) {
+                impl->cells.erase(cell->coord);
+                impl->cell_pool.destroy(cell);
+            }
+        } else {
+            while (in_budget() && impl->_instantiate(*cell)) {}
+        }
+        if (std::chrono::steady_clock::now() >= deadline) {
+            break;
+        }
+    }
+}
+
+auto WorldStreamer::cellAt(const Vec3& position) const noexcept -> CellCoord {
+    return CellCoord{
+        static_cast<int32_t>(std::floor(position.x / impl->settings.cell_size)),
+        static_cast<int32_t>(std::floor(position.z / impl->settings.cell_size))
+    };
+}
+
+auto WorldStreamer::state(CellCoord cell) const -> CellState {
+    const auto it = impl->cells.find(cell);
+    return it != impl->cells.end() ? it->second->state : CellState::Unloaded;
+}
+
+auto WorldStreamer::entities(CellCoord cell) const -> std::span<const Entity> {
+    const auto it = impl->cells.find(cell);
+    return it != impl->cells.end() ? std::span<const Entity>(it->second->entities) : std::span<const Entity>{};
+}
+
+auto WorldStreamer::residentCells() const noexcept -> size_t {
+    return impl->cells.size();
+}
+
+void WorldStreamer::onCellLoaded(std::function<void(CellCoord cell, std::span<const Entity> entities)> callback) {
+    impl->loaded = std::move(callback);
+}
+
+void WorldStreamer::onCellUnloading(std::function<void(CellCoord cell, std::span<const Entity> entities)> callback) {
+    impl->unloading = std::move(callback);
+}
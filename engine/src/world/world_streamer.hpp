@@ -0,0 +1,87 @@
+#pragma once
+
+#include <scene.hpp>
+#include <math/math.hpp>
+
+#include <span>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <cstdint>
+#include <functional>
+
+// Square cell of the world on the xz plane
+struct CellCoord {
+    int32_t x = 0;
+    int32_t z = 0;
+
+    constexpr auto operator==(const CellCoord&) const noexcept -> bool = default;
+};
+
+template<>
+struct std::hash<CellCoord> {
+    auto operator()(const CellCoord& cell) const noexcept -> size_t {
+        return std::hash<uint64_t>{}((static_cast<uint64_t>(static_cast<uint32_t>(cell.x)) << 32) | static_cast<uint32_t>(cell.z));
+    }
+};
+
+enum class CellState {
+    Unloaded,
+    // the snapshot is being read and parsed by a job
+    Loading,
+    // entities are being created a batch at a time
+    Instantiating,
+    Loaded,
+    // entities are being destroyed a batch at a time
+    Unloading
+};
+
+// Streams a world that is split into cells around the camera. Every cell is a Scene snapshot (see
+// Scene::saveSnapshot) in the resource packs. Cells in range are read and parsed by jobs, then added to
+// the scene in batches until the frame budget is spent; cells out of range are removed the same way.
+// The number of resident cells is capped, so memory doesn't depend on the size of the world.
+struct WorldStreamer {
+    struct Settings {
+        float cell_size = 64.0f;
+        // a cell is loaded once its closest point is within load_radius of the camera and unloaded past
+        // unload_radius, the gap keeps cells on the border from flickering in and out
+        float load_radius = 128.0f;
+        float unload_radius = 192.0f;
+        size_t max_resident_cells = 36;
+        size_t max_loading_cells = 4;
+        // time update() may spend creating and destroying entities, at least one batch runs every frame
+        std::chrono::microseconds frame_budget{1000};
+        size_t batch_size = 256;
+        // resource name, formatted with the cell's x and z
+        std::string cell_path = "cells/{}_{}.snap";
+    };
+
+    explicit WorldStreamer(Scene& scene);
+    WorldStreamer(Scene& scene, Settings settings);
+    ~WorldStreamer();
+
+    WorldStreamer(const WorldStreamer&) = delete;
+    auto operator=(const WorldStreamer&) -> WorldStreamer& = delete;
+
+    // Call once per frame from the thread that owns the scene
+    void update(const Vec3& camera);
+
+    [[nodiscard]] auto cellAt(const Vec3& position) const noexcept -> CellCoord;
+    [[nodiscard]] auto state(CellCoord cell) const -> CellState;
+
+    // entities of a cell that have been added to the scene so far
+    [[nodiscard]] auto entities(CellCoord cell) const -> std::span<const Entity>;
+
+    // cells that are loading, loaded or not yet fully unloaded
+    [[nodiscard]] auto residentCells() const noexcept -> size_t;
+
+    // Called once a cell is fully instantiated, e.g. to register its entities with RenderContext::spatial
+    void onCellLoaded(std::function<void(CellCoord cell, std::span<const Entity> entities)> callback);
+
+    // Called before a cell's entities are destroyed
+    void onCellUnloading(std::function<void(CellCoord cell, std::span<const Entity> entities)> callback);
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl;
+};
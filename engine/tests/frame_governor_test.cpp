@@ -0,0 +1,51 @@
+#include <frame_governor.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+    void check(bool condition, const char* what) {
+        if (!condition) {
+            std::fprintf(stderr, "failed: %s\n", what);
+            std::exit(1);
+        }
+    }
+
+    void run(FrameGovernor& governor, int frames, double work_ms, float thermal) {
+        for (int i = 0; i < frames; i++) {
+            auto sample = FrameGovernor::Sample{.dt = 1.0 / 60.0, .cpu_ms = work_ms, .gpu_ms = work_ms};
+            if (i % 60 == 0) {
+                sample.thermal = thermal;
+            }
+            governor.update(sample);
+        }
+    }
+}
+
+int main() {
+    // one allowed rate and no quality tiers: there is no level to fall back to, even when hot or slow
+    {
+        auto governor = FrameGovernor(FrameGovernor::Settings{.frame_rates = {60.0}, .max_quality_tier = 0});
+        check(governor.maxLevel() == 0, "a single rate without tiers has one level");
+        run(governor, 120, 8.0, 0.85f);
+        check(governor.level() == 0 && governor.policy().target_fps == 60.0, "warm stays at the only level");
+        run(governor, 120, 8.0, 0.99f);
+        check(governor.level() == 0 && governor.policy().quality_tier == 0, "hot stays at the only level");
+        run(governor, 600, 40.0, 0.99f);
+        check(governor.level() == 0, "slow frames stay at the only level");
+    }
+
+    // the defaults still step down under thermal pressure and come back once cooled
+    {
+        auto governor = FrameGovernor{};
+        run(governor, 120, 8.0, 0.2f);
+        check(governor.level() == 0, "a light, cool load runs at full rate");
+        run(governor, 60, 8.0, 0.99f);
+        check(governor.level() == governor.maxLevel(), "past thermal_severe the governor goes to its last level");
+        run(governor, 6000, 8.0, 0.2f);
+        check(governor.level() == 0, "once cooled it comes back to full rate");
+    }
+
+    std::puts("frame_governor: ok");
+    return 0;
+}
@@ -0,0 +1,122 @@
+#include <scene.hpp>
+#include <ecs/snapshot_view.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace {
+    struct Position {
+        float x = 0.0f;
+        float y = 0.0f;
+    };
+
+    struct Health {
+        int value = 100;
+    };
+
+    void check(bool condition, const char* what) {
+        if (!condition) {
+            std::fprintf(stderr, "failed: %s\n", what);
+            std::exit(1);
+        }
+    }
+
+    auto header(const std::vector<std::byte>& bytes) -> SnapshotHeader {
+        auto value = SnapshotHeader{};
+        std::memcpy(&value, bytes.data(), sizeof(value));
+        return value;
+    }
+
+    auto record(const std::vector<std::byte>& bytes, size_t index) -> SnapshotRecord {
+        auto value = SnapshotRecord{};
+        std::memcpy(&value, bytes.data() + header(bytes).records_offset + index * sizeof(value), sizeof(value));
+        return value;
+    }
+
+    void setRecord(std::vector<std::byte>& bytes, size_t index, const SnapshotRecord& value) {
+        std::memcpy(bytes.data() + header(bytes).records_offset + index * sizeof(value), &value, sizeof(value));
+    }
+
+    // a scene with two archetypes and a dead index in between
+    auto snapshot() -> std::vector<std::byte> {
+        auto scene = Scene{};
+        scene.createEntity(Position{1.0f, 2.0f});
+        const auto dead = scene.createEntity(Position{}, Health{});
+        scene.createEntity(Position{3.0f, 4.0f}, Health{50});
+        scene.createEntity(Position{5.0f, 6.0f});
+        scene.destroyEntities(std::span(&dead, 1));
+
+        auto bytes = std::vector<std::byte>{};
+        scene.saveSnapshot(bytes);
+        return bytes;
+    }
+
+    // parsing has to fail, and loading must leave the scene as it was
+    void checkRejected(const std::vector<std::byte>& bytes, const char* what) {
+        check(!SnapshotView::parse(bytes).has_value(), what);
+
+        auto scene = Scene{};
+        const auto entity = scene.createEntity(Position{7.0f, 8.0f});
+        check(!scene.loadSnapshot(std::span<const std::byte>(bytes)), what);
+        check(scene.size() == 1 && scene.alive(entity), what);
+    }
+}
+
+int main() {
+    const auto valid = snapshot();
+    {
+        const auto view = SnapshotView::parse(valid);
+        check(view.has_value() && view->recordCount() == 4 && view->entityCount() == 3, "a saved snapshot parses");
+        auto scene = Scene{};
+        check(scene.loadSnapshot(*view) && scene.size() == 3, "a saved snapshot loads");
+    }
+
+    // records 0 and 3 live in the same archetype, at rows 0 and 1
+    check(record(valid, 0).archetype == record(valid, 3).archetype, "records 0 and 3 share a table");
+
+    {
+        auto bytes = valid;
+        auto swapped = record(bytes, 0);
+        swapped.row = record(bytes, 3).row;
+        setRecord(bytes, 0, swapped);
+        checkRejected(bytes, "a record pointing at another entity's row");
+    }
+    {
+        auto bytes = valid;
+        auto stale = record(bytes, 2);
+        stale.generation++;
+        setRecord(bytes, 2, stale);
+        checkRejected(bytes, "a record whose generation differs from its row's entity");
+    }
+    {
+        auto bytes = valid;
+        auto zero = record(bytes, 1);
+        zero.generation = 0;
+        setRecord(bytes, 1, zero);
+        checkRejected(bytes, "a dead record with generation 0");
+    }
+    {
+        auto bytes = valid;
+        auto orphan = record(bytes, 3);
+        orphan.archetype = SNAPSHOT_NO_ARCHETYPE;
+        setRecord(bytes, 3, orphan);
+        checkRejected(bytes, "a row no record points to");
+    }
+    {
+        auto bytes = valid;
+        auto out_of_range = record(bytes, 0);
+        out_of_range.row = 1000;
+        setRecord(bytes, 0, out_of_range);
+        checkRejected(bytes, "a row past the end of its table");
+    }
+    {
+        auto bytes = valid;
+        bytes.resize(header(bytes).records_offset + sizeof(SnapshotRecord));
+        checkRejected(bytes, "a snapshot truncated in its records");
+    }
+
+    std::puts("snapshot_view: ok");
+    return 0;
+}
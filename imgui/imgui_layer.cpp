@@ -8,9 +8,15 @@ void ImGuiLayer::AutoClose::operator()(ImGuiContext *p) {
     ImGui::DestroyContext(p);
 }
 
-ImGuiLayer::ImGuiLayer() {
+ImGuiLayer::ImGuiLayer() : ImGuiLayer(nullptr, nullptr) {}
+
+ImGuiLayer::ImGuiLayer(AllocFn alloc, FreeFn free, void* user_data) {
     IMGUI_CHECKVERSION();
 
+    if (alloc != nullptr && free != nullptr) {
+        ImGui::SetAllocatorFunctions(alloc, free, user_data);
+    }
+
     ctx.reset(ImGui::CreateContext());
 
     auto& io = ctx->IO;
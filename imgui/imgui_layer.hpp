@@ -1,10 +1,16 @@
 #pragma once
 
 #include <memory>
+#include <cstddef>
 
 struct ImGuiContext;
 struct ImGuiLayer {
+    using AllocFn = void* (*)(size_t size, void* user_data);
+    using FreeFn = void (*)(void* ptr, void* user_data);
+
     ImGuiLayer();
+    // routes ImGui's allocations through the given functions, they must outlive every ImGui context
+    ImGuiLayer(AllocFn alloc, FreeFn free, void* user_data = nullptr);
     ~ImGuiLayer();
 
     void update(float dt);
@@ -1,11 +1,80 @@
 #include <app.hpp>
+#include <debug.hpp>
 #include <engine.hpp>
+#include <jobs/job_system.hpp>
 #include <input/input_system.hpp>
+#include <memory/memory_system.hpp>
+#include <resources/resource_system.hpp>
+#include <resources/archive_resource_pack.hpp>
+#include <resources/directory_resource_pack.hpp>
 
 #include <span>
 #include <memory>
+#include <charconv>
+#include <cstdint>
+#include <cstdlib>
+#include <optional>
+#include <filesystem>
+#include <string_view>
+#include <system_error>
 #include <fmt/format.h>
 
+struct Options {
+    // 0 runs until the window is closed
+    uint32_t frames = 0;
+    uint32_t warmup = 100;
+    std::filesystem::path output = "benchmark.json";
+};
+
+namespace {
+    void usage() {
+        Debug{"sandbox"}.error("usage: sandbox [--frames <n> [--warmup <n>] [--output <file.json|file.csv>]]");
+    }
+
+    // the whole argument as a decimal count, so "-1", "10x" and values past uint32_t are rejected
+    auto parseCount(std::string_view arg) noexcept -> std::optional<uint32_t> {
+        auto count = uint32_t{0};
+        const auto [end, error] = std::from_chars(arg.data(), arg.data() + arg.size(), count);
+        if (error != std::errc{} || end != arg.data() + arg.size()) {
+            return std::nullopt;
+        }
+        return count;
+    }
+
+    auto parseOptions(int argc, char** argv) -> std::optional<Options> {
+        auto options = Options{};
+        for (int i = 1; i < argc; i++) {
+            const auto arg = std::string_view(argv[i]);
+            if ((arg == "--frames" || arg == "--warmup") && i + 1 < argc) {
+                const auto count = parseCount(argv[++i]);
+                if (!count) {
+                    Debug{"sandbox"}.error("{} takes a count, not \"{}\"", arg, argv[i]);
+                    usage();
+                    return std::nullopt;
+                }
+                (arg == "--frames" ? options.frames : options.warmup) = *count;
+            } else if (arg == "--output" && i + 1 < argc) {
+                options.output = argv[++i];
+            } else {
+                usage();
+                return std::nullopt;
+            }
+        }
+        return options;
+    }
+
+    // The build puts assets.pack next to the executable, which is not where it is started from when run from
+    // an IDE or another directory. /proc/self/exe is exact on Linux, elsewhere argv[0] has the path.
+    auto executableDirectory(const char* argv0) -> std::filesystem::path {
+        auto error = std::error_code{};
+        auto path = std::filesystem::canonical("/proc/self/exe", error);
+        if (error) {
+            path = std::filesystem::absolute(argv0, error);
+        }
+        return error ? std::filesystem::path{} : path.parent_path();
+    }
+}
+
 struct GameApp : AppMain {
     void onAttach() override {}
     void onDetach() override {}
@@ -14,8 +83,25 @@ struct GameApp : AppMain {
 };
 
 void EngineMain(int argc, char** argv) {
+    const auto options = parseOptions(argc, argv);
+    if (!options) {
+        std::exit(1);
+    }
+
     // todo: module system
+    MemorySystem::initialize();
+    JobSystem::initialize();
     InputSystem::initialize();
+    ResourceSystem::initialize();
+    // loose files come first, so edited assets show up without cooking the pack again
+    ResourceSystem::emplace(std::make_unique<DirectoryResourcePack>("assets"));
+    const auto pack_path = executableDirectory(argv[0]) / "assets.pack";
+    if (std::filesystem::exists(pack_path)) {
+        if (auto pack = ArchiveResourcePack::load(pack_path.string())) {
+            ResourceSystem::emplace(std::move(pack));
+        }
+    }
     JellyEngine::initialize();
+    JellyEngine::setBenchmark(options->frames, options->warmup, options->output);
     JellyEngine::run(GameApp{});
 }
\ No newline at end of file
@@ -1,6 +1,11 @@
 #include <app.hpp>
 #include <engine.hpp>
+#include <jobs/job_system.hpp>
 #include <input/input_system.hpp>
+#include <memory/memory_system.hpp>
+#include <resources/resource_system.hpp>
+#include <resources/asset_resource_pack.hpp>
+#include <resources/archive_resource_pack.hpp>
 
 #include <fmt/format.h>
 
@@ -13,7 +18,14 @@ struct GameApp : AppMain {
 
 void EngineMain(int argc, char** argv) {
     // todo: module system
+    MemorySystem::initialize();
+    JobSystem::initialize();
     InputSystem::initialize();
+    ResourceSystem::initialize();
+    if (auto pack = ArchiveResourcePack::load("assets.pack")) {
+        ResourceSystem::emplace(std::move(pack));
+    }
+    ResourceSystem::emplace(std::make_unique<AssetResourcePack>());
     JellyEngine::initialize();
     JellyEngine::run(GameApp{});
 }
\ No newline at end of file
@@ -0,0 +1,489 @@
+#include "mesh_cooker.hpp"
+
+#include <compression/lz4.hpp>
+#include <render/mesh_format.hpp>
+#include <resources/pack_format.hpp>
+
+#include <span>
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <charconv>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <optional>
+#include <algorithm>
+#include <filesystem>
+#include <unordered_map>
+
+namespace fs = std::filesystem;
+
+struct Options {
+    fs::path source;
+    fs::path output;
+    bool compress = false;
+    uint32_t align = 16;
+    uint32_t block_size = 64 * 1024;
+};
+
+// Per-file state remembered between runs in "<output>.cache"
+struct CacheRecord {
+    uint64_t content_hash = 0;
+    uint64_t size = 0;
+    int64_t mtime = 0;
+};
+
+struct CookedBlock {
+    uint32_t offset;
+    uint32_t compressed_size;
+    uint32_t uncompressed_size;
+};
+
+struct CookedFile {
+    std::string path;
+    fs::path source;
+    CacheRecord record;
+    uint64_t uncompressed_size = 0;
+    std::vector<char> payload;
+    std::vector<CookedBlock> blocks;
+};
+
+// Entries of the previous pack, so unchanged files are copied instead of recompressed
+struct PreviousPack {
+    std::ifstream file;
+    PackHeader header{};
+    std::unordered_map<std::string, PackEntry> entries;
+    std::vector<PackBlock> blocks;
+};
+
+namespace {
+    auto usage() -> int {
+        std::cerr << "usage: cooker <source-dir> <output.pack> [--compress] [--align <bytes>] [--block-size <bytes>]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // the whole argument as a positive decimal number of bytes
+    auto parseBytes(std::string_view arg) -> std::optional<uint32_t> {
+        auto value = uint32_t{0};
+        const auto [end, error] = std::from_chars(arg.data(), arg.data() + arg.size(), value);
+        if (error != std::errc{} || end != arg.data() + arg.size() || value == 0) {
+            return std::nullopt;
+        }
+        return value;
+    }
+
+    auto parseOptions(int argc, char** argv) -> std::optional<Options> {
+        auto options = Options{};
+        auto positional = std::vector<std::string>{};
+        for (int i = 1; i < argc; i++) {
+            const auto arg = std::string_view(argv[i]);
+            if (arg == "--compress") {
+                options.compress = true;
+            } else if ((arg == "--align" || arg == "--block-size") && i + 1 < argc) {
+                const auto bytes = parseBytes(argv[++i]);
+                if (!bytes.has_value()) {
+                    std::cerr << arg << " takes a positive number of bytes, not \"" << argv[i] << "\"" << std::endl;
+                    return std::nullopt;
+                }
+                (arg == "--align" ? options.align : options.block_size) = *bytes;
+            } else if (!arg.starts_with("--")) {
+                positional.emplace_back(arg);
+            } else {
+                return std::nullopt;
+            }
+        }
+        if ((options.align & (options.align - 1)) != 0) {
+            std::cerr << "--align has to be a power of two, not " << options.align << std::endl;
+            return std::nullopt;
+        }
+        if (positional.size() != 2) {
+            return std::nullopt;
+        }
+        options.source = positional[0];
+        options.output = positional[1];
+        return options;
+    }
+
+    auto readFile(const fs::path& path) -> std::optional<std::vector<char>> {
+        auto file = std::ifstream(path, std::ios::binary | std::ios::ate);
+        if (!file) {
+            return std::nullopt;
+        }
+        auto bytes = std::vector<char>(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        file.read(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+        if (!file) {
+            return std::nullopt;
+        }
+        return bytes;
+    }
+
+    auto contentHash(std::span<const char> bytes) -> uint64_t {
+        return packPathHash(std::string_view(bytes.data(), bytes.size()));
+    }
+
+    auto modificationTime(const fs::path& path) -> int64_t {
+        return static_cast<int64_t>(fs::last_write_time(path).time_since_epoch().count());
+    }
+
+    auto alignUp(uint64_t value, uint64_t alignment) -> uint64_t {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+    auto cachePath(const Options& options) -> fs::path {
+        auto path = options.output;
+        path += ".cache";
+        return path;
+    }
+
+    // The first line records the settings, a change in any of them invalidates every record
+    auto settingsLine(const Options& options) -> std::string {
+        std::ostringstream line;
+        line << "jelly-cooker " << PackHeader::VERSION << ' ' << MeshHeader::VERSION << ' ' << options.compress << ' ' << options.block_size << ' ' << options.align;
+        return line.str();
+    }
+
+    auto loadCache(const Options& options) -> std::unordered_map<std::string, CacheRecord> {
+        auto records = std::unordered_map<std::string, CacheRecord>{};
+        auto file = std::ifstream(cachePath(options));
+        auto line = std::string{};
+        if (!std::getline(file, line) || line != settingsLine(options)) {
+            return records;
+        }
+        while (std::getline(file, line)) {
+            auto stream = std::istringstream(line);
+            auto record = CacheRecord{};
+            auto path = std::string{};
+            stream >> record.content_hash >> record.size >> record.mtime;
+            stream.ignore(1);
+            std::getline(stream, path);
+            if (stream.fail() || path.empty()) {
+                continue;
+            }
+            records.emplace(std::move(path), record);
+        }
+        return records;
+    }
+
+    void saveCache(const Options& options, const std::vector<CookedFile>& files) {
+        auto file = std::ofstream(cachePath(options), std::ios::trunc);
+        file << settingsLine(options) << '\n';
+        for (const auto& cooked : files) {
+            file << cooked.record.content_hash << ' ' << cooked.record.size << ' ' << cooked.record.mtime << ' ' << cooked.path << '\n';
+        }
+    }
+
+    // offset + count fits in size, without overflowing
+    auto within(uint64_t offset, uint64_t count, uint64_t size) -> bool {
+        return offset <= size && count <= size - offset;
+    }
+
+    // the parts of an entry that reusePayload copies have to lie within the previous pack
+    auto validEntry(const PackEntry& entry, size_t names_size, const std::vector<PackBlock>& blocks, uint64_t size) -> bool {
+        if (!within(entry.name_offset, entry.name_size, names_size)
+            || !within(entry.first_block, entry.block_count, blocks.size())
+            || !within(entry.offset, entry.compressed_size, size)) {
+            return false;
+        }
+        for (uint32_t i = 0; i < entry.block_count; i++) {
+            const auto& block = blocks[entry.first_block + i];
+            if (block.offset < entry.offset || !within(block.offset - entry.offset, block.compressed_size, entry.compressed_size)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    auto loadPreviousPack(const Options& options) -> std::optional<PreviousPack> {
+        auto pack = PreviousPack{};
+        pack.file.open(options.output, std::ios::binary);
+        if (!pack.file.read(reinterpret_cast<char*>(&pack.header), sizeof(PackHeader))) {
+            return std::nullopt;
+        }
+        if (pack.header.magic != PackHeader::MAGIC || pack.header.version != PackHeader::VERSION) {
+            return std::nullopt;
+        }
+
+        pack.file.seekg(0, std::ios::end);
+        const auto size = static_cast<uint64_t>(pack.file.tellg());
+        if (!within(pack.header.entries_offset, uint64_t{pack.header.entry_count} * sizeof(PackEntry), size)
+            || !within(pack.header.blocks_offset, uint64_t{pack.header.block_count} * sizeof(PackBlock), size)
+            || !within(pack.header.names_offset, pack.header.names_size, size)) {
+            return std::nullopt;
+        }
+
+        auto entries = std::vector<PackEntry>(pack.header.entry_count);
+        auto names = std::vector<char>(pack.header.names_size);
+        pack.blocks.resize(pack.header.block_count);
+
+        pack.file.seekg(static_cast<std::streamoff>(pack.header.entries_offset));
+        pack.file.read(reinterpret_cast<char*>(entries.data()), static_cast<std::streamsize>(entries.size() * sizeof(PackEntry)));
+        pack.file.seekg(static_cast<std::streamoff>(pack.header.blocks_offset));
+        pack.file.read(reinterpret_cast<char*>(pack.blocks.data()), static_cast<std::streamsize>(pack.blocks.size() * sizeof(PackBlock)));
+        pack.file.seekg(static_cast<std::streamoff>(pack.header.names_offset));
+        pack.file.read(names.data(), static_cast<std::streamsize>(names.size()));
+        if (!pack.file) {
+            return std::nullopt;
+        }
+
+        for (const auto& entry : entries) {
+            if (!validEntry(entry, names.size(), pack.blocks, size)) {
+                std::cerr << options.output.generic_string() << " is corrupt, cooking everything again" << std::endl;
+                return std::nullopt;
+            }
+            pack.entries.emplace(std::string(names.data() + entry.name_offset, entry.name_size), entry);
+        }
+        return pack;
+    }
+
+    auto reusePayload(PreviousPack& pack, CookedFile& cooked) -> bool {
+        const auto it = pack.entries.find(cooked.path);
+        if (it == pack.entries.end()) {
+            return false;
+        }
+        const auto& entry = it->second;
+        cooked.uncompressed_size = entry.uncompressed_size;
+        cooked.payload.resize(static_cast<size_t>(entry.compressed_size));
+        pack.file.clear();
+        pack.file.seekg(static_cast<std::streamoff>(entry.offset));
+        pack.file.read(cooked.payload.data(), static_cast<std::streamsize>(cooked.payload.size()));
+        if (!pack.file) {
+            cooked.payload.clear();
+            return false;
+        }
+        for (uint32_t i = 0; i < entry.block_count; i++) {
+            const auto& block = pack.blocks[entry.first_block + i];
+            cooked.blocks.emplace_back(CookedBlock{
+                .offset = static_cast<uint32_t>(block.offset - entry.offset),
+                .compressed_size = block.compressed_size,
+                .uncompressed_size = block.uncompressed_size
+            });
+        }
+        return true;
+    }
+
+    // Splits the file into independent blocks; the entry is stored as is when compression doesn't pay off
+    void cook(const Options& options, CookedFile& cooked, std::vector<char> bytes) {
+        cooked.uncompressed_size = bytes.size();
+        if (!options.compress || bytes.empty()) {
+            cooked.payload = std::move(bytes);
+            return;
+        }
+
+        auto scratch = std::vector<char>(LZ4::compressBound(options.block_size));
+        for (size_t offset = 0; offset < bytes.size(); offset += options.block_size) {
+            const auto input = std::span(bytes).subspan(offset, std::min<size_t>(options.block_size, bytes.size() - offset));
+            const auto size = LZ4::compress(input, scratch);
+            const auto block = CookedBlock{
+                .offset = static_cast<uint32_t>(cooked.payload.size()),
+                .compressed_size = static_cast<uint32_t>(size < input.size() ? size : input.size()),
+                .uncompressed_size = static_cast<uint32_t>(input.size())
+            };
+            if (size < input.size()) {
+                cooked.payload.insert(cooked.payload.end(), scratch.begin(), scratch.begin() + static_cast<ptrdiff_t>(size));
+            } else {
+                cooked.payload.insert(cooked.payload.end(), input.begin(), input.end());
+            }
+            cooked.blocks.emplace_back(block);
+        }
+
+        if (cooked.payload.size() >= bytes.size() - bytes.size() / 16) {
+            cooked.blocks.clear();
+            cooked.payload = std::move(bytes);
+        }
+    }
+
+    auto writePack(const Options& options, std::vector<CookedFile>& files) -> bool {
+        std::sort(files.begin(), files.end(), [](const CookedFile& a, const CookedFile& b) {
+            return packPathHash(a.path) < packPathHash(b.path);
+        });
+
+        auto entries = std::vector<PackEntry>{};
+        auto blocks = std::vector<PackBlock>{};
+        auto names = std::string{};
+
+        size_t block_count = 0;
+        for (const auto& cooked : files) {
+            block_count += cooked.blocks.size();
+            names += cooked.path;
+        }
+
+        auto header = PackHeader{
+            .magic = PackHeader::MAGIC,
+            .version = PackHeader::VERSION,
+            .entry_count = static_cast<uint32_t>(files.size()),
+            .block_count = static_cast<uint32_t>(block_count),
+            .block_size = options.block_size,
+            .reserved = 0,
+            .entries_offset = sizeof(PackHeader),
+            .blocks_offset = sizeof(PackHeader) + files.size() * sizeof(PackEntry),
+            .names_offset = sizeof(PackHeader) + files.size() * sizeof(PackEntry) + block_count * sizeof(PackBlock),
+            .names_size = names.size()
+        };
+
+        auto offset = header.names_offset + header.names_size;
+        uint32_t name_offset = 0;
+        for (const auto& cooked : files) {
+            offset = alignUp(offset, options.align);
+            entries.emplace_back(PackEntry{
+                .path_hash = packPathHash(cooked.path),
+                .offset = offset,
+                .compressed_size = cooked.payload.size(),
+                .uncompressed_size = cooked.uncompressed_size,
+                .first_block = static_cast<uint32_t>(blocks.size()),
+                .block_count = static_cast<uint32_t>(cooked.blocks.size()),
+                .name_offset = name_offset,
+                .name_size = static_cast<uint32_t>(cooked.path.size())
+            });
+            for (const auto& block : cooked.blocks) {
+                blocks.emplace_back(PackBlock{
+                    .offset = offset + block.offset,
+                    .compressed_size = block.compressed_size,
+                    .uncompressed_size = block.uncompressed_size
+                });
+            }
+            offset += cooked.payload.size();
+            name_offset += static_cast<uint32_t>(cooked.path.size());
+        }
+
+        auto temporary = options.output;
+        temporary += ".tmp";
+
+        auto file = std::ofstream(temporary, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(PackHeader));
+        file.write(reinterpret_cast<const char*>(entries.data()), static_cast<std::streamsize>(entries.size() * sizeof(PackEntry)));
+        file.write(reinterpret_cast<const char*>(blocks.data()), static_cast<std::streamsize>(blocks.size() * sizeof(PackBlock)));
+        file.write(names.data(), static_cast<std::streamsize>(names.size()));
+
+        const auto padding = std::vector<char>(options.align, 0);
+        for (size_t i = 0; i < files.size(); i++) {
+            const auto position = static_cast<uint64_t>(file.tellp());
+            file.write(padding.data(), static_cast<std::streamsize>(entries[i].offset - position));
+            file.write(files[i].payload.data(), static_cast<std::streamsize>(files[i].payload.size()));
+        }
+        file.close();
+        if (!file) {
+            return false;
+        }
+
+        auto ec = std::error_code{};
+        fs::rename(temporary, options.output, ec);
+        return !ec;
+    }
+}
+
+auto main(int argc, char** argv) -> int {
+    const auto options = parseOptions(argc, argv);
+    if (!options.has_value()) {
+        return usage();
+    }
+    if (!fs::is_directory(options->source)) {
+        std::cerr << "not a directory: " << options->source << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    auto cache = loadCache(*options);
+    auto previous = fs::exists(options->output) ? loadPreviousPack(*options) : std::nullopt;
+
+    auto files = std::vector<CookedFile>{};
+    // pack path to the source it comes from, "a.obj" and "a.mesh" would both become "a.mesh"
+    auto sources = std::unordered_map<std::string, fs::path>{};
+    for (const auto& item : fs::recursive_directory_iterator(options->source)) {
+        if (!item.is_regular_file()) {
+            continue;
+        }
+        auto& cooked = files.emplace_back();
+        cooked.source = item.path();
+        // meshes are cooked into the engine's format and take its extension
+        auto path = fs::relative(item.path(), options->source);
+        if (path.extension() == ".obj") {
+            path.replace_extension(".mesh");
+        }
+        cooked.path = path.generic_string();
+        if (const auto [it, inserted] = sources.emplace(cooked.path, cooked.source); !inserted) {
+            std::cerr << it->second << " and " << cooked.source << " both go into the pack as " << cooked.path << std::endl;
+            return EXIT_FAILURE;
+        }
+        cooked.record.size = static_cast<uint64_t>(item.file_size());
+        cooked.record.mtime = modificationTime(item.path());
+    }
+
+    // files are hashed and compressed in parallel, unchanged ones are taken from the previous pack
+    auto next = std::atomic<size_t>{0};
+    auto failed = std::atomic<bool>{false};
+    auto changed = std::atomic<size_t>{0};
+    auto previous_mutex = std::mutex{};
+    auto reuse = [&](CookedFile& cooked) {
+        std::lock_guard lock{previous_mutex};
+        return previous && reusePayload(*previous, cooked);
+    };
+    auto worker = [&] {
+        for (size_t i = next++; i < files.size(); i = next++) {
+            auto& cooked = files[i];
+            const auto it = cache.find(cooked.path);
+            const auto cached = it != cache.end() ? &it->second : nullptr;
+
+            if (cached && cached->size == cooked.record.size && cached->mtime == cooked.record.mtime) {
+                cooked.record.content_hash = cached->content_hash;
+                if (reuse(cooked)) {
+                    continue;
+                }
+            }
+
+            auto bytes = readFile(cooked.source);
+            if (!bytes.has_value()) {
+                std::cerr << "could not read " << cooked.source << std::endl;
+                failed = true;
+                continue;
+            }
+            cooked.record.content_hash = contentHash(*bytes);
+            if (cached && cached->content_hash == cooked.record.content_hash) {
+                if (reuse(cooked)) {
+                    continue;
+                }
+            }
+            if (cooked.source.extension() == ".obj") {
+                auto mesh = cookMesh(*bytes);
+                if (!mesh.has_value()) {
+                    std::cerr << "could not cook mesh " << cooked.source << std::endl;
+                    failed = true;
+                    continue;
+                }
+                *bytes = std::move(*mesh);
+            }
+            cook(*options, cooked, std::move(*bytes));
+            changed++;
+        }
+    };
+
+    const auto threads = std::max(std::thread::hardware_concurrency(), 1u);
+    auto workers = std::vector<std::thread>{};
+    for (uint32_t i = 1; i < threads; i++) {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : workers) {
+        thread.join();
+    }
+    if (failed) {
+        return EXIT_FAILURE;
+    }
+
+    if (previous && changed == 0 && previous->entries.size() == files.size()) {
+        std::cout << options->output.generic_string() << " is up to date" << std::endl;
+        return EXIT_SUCCESS;
+    }
+    previous.reset();
+
+    if (!writePack(*options, files)) {
+        std::cerr << "could not write " << options->output << std::endl;
+        return EXIT_FAILURE;
+    }
+    saveCache(*options, files);
+
+    std::cout << options->output.generic_string() << ": " << files.size() << " entries, " << changed << " cooked" << std::endl;
+    return EXIT_SUCCESS;
+}
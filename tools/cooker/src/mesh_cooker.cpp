@@ -0,0 +1,593 @@
+#include "mesh_cooker.hpp"
+
+#include <math/math.hpp>
+#include <render/mesh_format.hpp>
+
+#include <array>
+#include <cmath>
+#include <limits>
+#include <cstdlib>
+#include <cstring>
+#include <numeric>
+#include <charconv>
+#include <iostream>
+#include <algorithm>
+#include <string_view>
+#include <unordered_map>
+
+namespace {
+    struct Vertex {
+        Vec3 position{};
+        Vec3 normal{};
+        float uv[2] = {0.0f, 0.0f};
+    };
+
+    struct Mesh {
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+    };
+
+    // position, uv and normal index of a face corner, -1 when the corner has none
+    using Corner = std::array<int32_t, 3>;
+
+    struct CornerHash {
+        auto operator()(const Corner& c) const noexcept -> size_t {
+            return static_cast<size_t>(c[0]) * 73856093u ^ static_cast<size_t>(c[1]) * 19349663u ^ static_cast<size_t>(c[2]) * 83492791u;
+        }
+    };
+
+    auto nextToken(std::string_view& line) -> std::string_view {
+        const auto begin = line.find_first_not_of(" \t\r");
+        if (begin == std::string_view::npos) {
+            line = {};
+            return {};
+        }
+        line.remove_prefix(begin);
+        const auto end = std::min(line.find_first_of(" \t\r"), line.size());
+        const auto token = line.substr(0, end);
+        line.remove_prefix(end);
+        return token;
+    }
+
+    auto parseFloat(std::string_view token) -> float {
+        char buffer[64] = {};
+        std::memcpy(buffer, token.data(), std::min(token.size(), sizeof(buffer) - 1));
+        return std::strtof(buffer, nullptr);
+    }
+
+    // OBJ indices count from 1, negative ones from the end
+    auto resolveIndex(std::string_view token, size_t count) -> int32_t {
+        auto value = 0;
+        if (token.empty() || std::from_chars(token.data(), token.data() + token.size(), value).ec != std::errc{}) {
+            return -1;
+        }
+        const auto index = value > 0 ? value - 1 : static_cast<int32_t>(count) + value;
+        return index >= 0 && static_cast<size_t>(index) < count ? index : -1;
+    }
+
+    auto parseObj(std::span<const char> obj) -> std::optional<Mesh> {
+        auto positions = std::vector<Vec3>{};
+        auto normals = std::vector<Vec3>{};
+        auto uvs = std::vector<std::array<float, 2>>{};
+        auto unique = std::unordered_map<Corner, uint32_t, CornerHash>{};
+        auto corners = std::vector<Corner>{};
+        auto mesh = Mesh{};
+        // of every vertex, to smooth computed normals across uv seams
+        auto position_of = std::vector<int32_t>{};
+        auto missing_normals = false;
+
+        auto text = std::string_view(obj.data(), obj.size());
+        while (!text.empty()) {
+            const auto end = std::min(text.find('\n'), text.size());
+            auto line = text.substr(0, end);
+            text.remove_prefix(std::min(end + 1, text.size()));
+
+            const auto type = nextToken(line);
+            if (type == "v") {
+                const auto x = parseFloat(nextToken(line));
+                const auto y = parseFloat(nextToken(line));
+                const auto z = parseFloat(nextToken(line));
+                positions.emplace_back(Vec3{x, y, z});
+            } else if (type == "vn") {
+                const auto x = parseFloat(nextToken(line));
+                const auto y = parseFloat(nextToken(line));
+                const auto z = parseFloat(nextToken(line));
+                normals.emplace_back(Vec3{x, y, z});
+            } else if (type == "vt") {
+                const auto u = parseFloat(nextToken(line));
+                const auto v = parseFloat(nextToken(line));
+                uvs.emplace_back(std::array{u, 1.0f - v});
+            } else if (type == "f") {
+                corners.clear();
+                for (auto token = nextToken(line); !token.empty(); token = nextToken(line)) {
+                    auto corner = Corner{-1, -1, -1};
+                    const auto counts = std::array{positions.size(), uvs.size(), normals.size()};
+                    for (size_t i = 0; i < 3 && !token.empty(); i++) {
+                        const auto slash = std::min(token.find('/'), token.size());
+                        corner[i] = resolveIndex(token.substr(0, slash), counts[i]);
+                        token.remove_prefix(std::min(slash + 1, token.size()));
+                    }
+                    if (corner[0] < 0) {
+                        std::cerr << "face refers to a vertex that doesn't exist" << std::endl;
+                        return std::nullopt;
+                    }
+                    corners.emplace_back(corner);
+                }
+
+                auto face = std::vector<uint32_t>{};
+                for (const auto& corner : corners) {
+                    const auto [it, inserted] = unique.try_emplace(corner, static_cast<uint32_t>(mesh.vertices.size()));
+                    if (inserted) {
+                        auto vertex = Vertex{.position = positions[corner[0]]};
+                        if (corner[1] >= 0) {
+                            vertex.uv[0] = uvs[corner[1]][0];
+                            vertex.uv[1] = uvs[corner[1]][1];
+                        }
+                        if (corner[2] >= 0) {
+                            vertex.normal = normals[corner[2]];
+                        } else {
+                            missing_normals = true;
+                        }
+                        mesh.vertices.emplace_back(vertex);
+                        position_of.emplace_back(corner[0]);
+                    }
+                    face.emplace_back(it->second);
+                }
+                for (size_t i = 2; i < face.size(); i++) {
+                    const auto a = face[0], b = face[i - 1], c = face[i];
+                    if (a != b && b != c && a != c) {
+                        mesh.indices.insert(mesh.indices.end(), {a, b, c});
+                    }
+                }
+            }
+        }
+
+        if (missing_normals) {
+            // area weighted face normals, summed per position
+            auto sums = std::vector<Vec3>(positions.size());
+            for (size_t i = 0; i < mesh.indices.size(); i += 3) {
+                const auto& a = mesh.vertices[mesh.indices[i]].position;
+                const auto& b = mesh.vertices[mesh.indices[i + 1]].position;
+                const auto& c = mesh.vertices[mesh.indices[i + 2]].position;
+                const auto normal = cross(b - a, c - a);
+                for (size_t k = 0; k < 3; k++) {
+                    auto& sum = sums[position_of[mesh.indices[i + k]]];
+                    sum = sum + normal;
+                }
+            }
+            for (const auto& [corner, vertex] : unique) {
+                if (corner[2] < 0) {
+                    mesh.vertices[vertex].normal = sums[corner[0]];
+                }
+            }
+        }
+        for (auto& vertex : mesh.vertices) {
+            const auto l = length(vertex.normal);
+            vertex.normal = l > 0.0f ? vertex.normal * (1.0f / l) : Vec3{0.0f, 0.0f, 1.0f};
+        }
+        return mesh;
+    }
+
+    // Tom Forsyth's linear-speed vertex cache optimisation: triangles are emitted greedily by a score that favours
+    // vertices in a simulated LRU cache and vertices with few triangles left.
+    constexpr uint32_t CACHE_SIZE = 32;
+
+    auto vertexScore(int32_t cache_position, uint32_t remaining) -> float {
+        if (remaining == 0) {
+            return -1.0f;
+        }
+        auto score = 0.0f;
+        if (cache_position >= 0) {
+            // the last triangle's vertices get a fixed score so that strips don't run forever
+            score = cache_position < 3 ? 0.75f : std::pow(1.0f - static_cast<float>(cache_position - 3) / (CACHE_SIZE - 3), 1.5f);
+        }
+        return score + 2.0f / std::sqrt(static_cast<float>(remaining));
+    }
+
+    void optimizeVertexCache(std::vector<uint32_t>& indices, size_t vertex_count) {
+        const auto triangle_count = indices.size() / 3;
+        if (triangle_count == 0) {
+            return;
+        }
+
+        // triangles of every vertex, the live ones at the front of each range
+        auto remaining = std::vector<uint32_t>(vertex_count, 0);
+        for (const auto index : indices) {
+            remaining[index]++;
+        }
+        auto offsets = std::vector<uint32_t>(vertex_count + 1, 0);
+        std::partial_sum(remaining.begin(), remaining.end(), offsets.begin() + 1);
+        auto adjacency = std::vector<uint32_t>(indices.size());
+        auto fill = std::vector<uint32_t>(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < indices.size(); i++) {
+            adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+        }
+
+        auto cache_position = std::vector<int32_t>(vertex_count, -1);
+        auto vertex_scores = std::vector<float>(vertex_count);
+        for (size_t v = 0; v < vertex_count; v++) {
+            vertex_scores[v] = vertexScore(-1, remaining[v]);
+        }
+        auto triangle_scores = std::vector<float>(triangle_count);
+        for (size_t t = 0; t < triangle_count; t++) {
+            triangle_scores[t] = vertex_scores[indices[t * 3]] + vertex_scores[indices[t * 3 + 1]] + vertex_scores[indices[t * 3 + 2]];
+        }
+        auto emitted = std::vector<bool>(triangle_count, false);
+
+        auto result = std::vector<uint32_t>{};
+        result.reserve(indices.size());
+        auto cache = std::vector<uint32_t>{};
+        auto next_cache = std::vector<uint32_t>{};
+        constexpr auto NONE = std::numeric_limits<size_t>::max();
+        auto best = static_cast<size_t>(std::max_element(triangle_scores.begin(), triangle_scores.end()) - triangle_scores.begin());
+        size_t scan = 0;
+
+        for (size_t n = 0; n < triangle_count; n++) {
+            if (best == NONE) {
+                // nothing in the cache has triangles left, continue with the next unemitted one
+                while (emitted[scan]) {
+                    scan++;
+                }
+                best = scan;
+            }
+            emitted[best] = true;
+            const auto triangle = std::array{indices[best * 3], indices[best * 3 + 1], indices[best * 3 + 2]};
+            result.insert(result.end(), triangle.begin(), triangle.end());
+
+            for (const auto v : triangle) {
+                const auto begin = adjacency.begin() + offsets[v];
+                const auto end = begin + remaining[v];
+                const auto it = std::find(begin, end, static_cast<uint32_t>(best));
+                std::iter_swap(it, end - 1);
+                remaining[v]--;
+            }
+
+            next_cache.assign(triangle.begin(), triangle.end());
+            for (const auto v : cache) {
+                if (v != triangle[0] && v != triangle[1] && v != triangle[2]) {
+                    next_cache.emplace_back(v);
+                }
+            }
+            std::swap(cache, next_cache);
+            for (size_t i = 0; i < cache.size(); i++) {
+                const auto v = cache[i];
+                cache_position[v] = i < CACHE_SIZE ? static_cast<int32_t>(i) : -1;
+                vertex_scores[v] = vertexScore(cache_position[v], remaining[v]);
+            }
+
+            best = NONE;
+            auto best_score = -1.0f;
+            for (const auto v : cache) {
+                for (auto i = offsets[v]; i < offsets[v] + remaining[v]; i++) {
+                    const auto t = adjacency[i];
+                    triangle_scores[t] = vertex_scores[indices[t * 3]] + vertex_scores[indices[t * 3 + 1]] + vertex_scores[indices[t * 3 + 2]];
+                    if (triangle_scores[t] > best_score) {
+                        best_score = triangle_scores[t];
+                        best = t;
+                    }
+                }
+            }
+            cache.resize(std::min<size_t>(cache.size(), CACHE_SIZE));
+        }
+        indices = std::move(result);
+    }
+
+    // Overdraw: the cache optimised order is cut where the simulated cache starts over, which keeps the cache hit
+    // rate, and the pieces are drawn outward facing first, so they tend to hide what comes later. This is the
+    // cluster sort of Sander, Nehab and Barczak, "Fast triangle reordering for vertex locality and reduced overdraw".
+    void optimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices) {
+        constexpr uint32_t FIFO_SIZE = 16;
+        const auto triangle_count = indices.size() / 3;
+
+        auto cluster_starts = std::vector<size_t>{};
+        auto stamps = std::vector<uint32_t>(vertices.size(), 0);
+        auto time = FIFO_SIZE + 1;
+        for (size_t t = 0; t < triangle_count; t++) {
+            auto misses = 0;
+            for (size_t k = 0; k < 3; k++) {
+                const auto v = indices[t * 3 + k];
+                if (time - stamps[v] > FIFO_SIZE) {
+                    stamps[v] = time++;
+                    misses++;
+                }
+            }
+            if (t == 0 || misses == 3) {
+                cluster_starts.emplace_back(t);
+            }
+        }
+        cluster_starts.emplace_back(triangle_count);
+
+        struct Cluster {
+            size_t first;
+            size_t count;
+            float key;
+        };
+        auto clusters = std::vector<Cluster>{};
+        auto mesh_centroid = Vec3{};
+        auto mesh_area = 0.0f;
+        auto centroids = std::vector<Vec3>{};
+        auto normals = std::vector<Vec3>{};
+        for (size_t c = 0; c + 1 < cluster_starts.size(); c++) {
+            auto centroid = Vec3{};
+            auto normal = Vec3{};
+            auto area = 0.0f;
+            for (auto t = cluster_starts[c]; t < cluster_starts[c + 1]; t++) {
+                const auto& a = vertices[indices[t * 3]].position;
+                const auto& b = vertices[indices[t * 3 + 1]].position;
+                const auto& d = vertices[indices[t * 3 + 2]].position;
+                const auto n = cross(b - a, d - a);
+                const auto triangle_area = length(n);
+                centroid = centroid + (a + b + d) * (triangle_area / 3.0f);
+                normal = normal + n;
+                area += triangle_area;
+            }
+            mesh_centroid = mesh_centroid + centroid;
+            mesh_area += area;
+            centroids.emplace_back(area > 0.0f ? centroid * (1.0f / area) : vertices[indices[cluster_starts[c] * 3]].position);
+            normals.emplace_back(normal);
+            clusters.emplace_back(Cluster{.first = cluster_starts[c], .count = cluster_starts[c + 1] - cluster_starts[c], .key = 0.0f});
+        }
+        if (mesh_area > 0.0f) {
+            mesh_centroid = mesh_centroid * (1.0f / mesh_area);
+        }
+        for (size_t c = 0; c < clusters.size(); c++) {
+            const auto l = length(normals[c]);
+            clusters[c].key = l > 0.0f ? dot(centroids[c] - mesh_centroid, normals[c]) / l : 0.0f;
+        }
+        std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster& a, const Cluster& b) {
+            return a.key > b.key;
+        });
+
+        auto result = std::vector<uint32_t>{};
+        result.reserve(indices.size());
+        for (const auto& cluster : clusters) {
+            const auto begin = indices.begin() + static_cast<ptrdiff_t>(cluster.first * 3);
+            result.insert(result.end(), begin, begin + static_cast<ptrdiff_t>(cluster.count * 3));
+        }
+        indices = std::move(result);
+    }
+
+    // Vertices in the order the indices first use them, which makes vertex fetches mostly sequential.
+    // Unreferenced vertices are dropped.
+    void optimizeVertexFetch(Mesh& mesh) {
+        constexpr auto UNUSED = std::numeric_limits<uint32_t>::max();
+        auto remap = std::vector<uint32_t>(mesh.vertices.size(), UNUSED);
+        auto vertices = std::vector<Vertex>{};
+        vertices.reserve(mesh.vertices.size());
+        for (auto& index : mesh.indices) {
+            if (remap[index] == UNUSED) {
+                remap[index] = static_cast<uint32_t>(vertices.size());
+                vertices.emplace_back(mesh.vertices[index]);
+            }
+            index = remap[index];
+        }
+        mesh.vertices = std::move(vertices);
+    }
+
+    auto buildMeshlets(const Mesh& mesh) -> std::vector<MeshMeshlet> {
+        auto meshlets = std::vector<MeshMeshlet>{};
+        // the meshlet a vertex was last counted in, offset by one so that 0 means none
+        auto owner = std::vector<uint32_t>(mesh.vertices.size(), 0);
+        const auto triangle_count = static_cast<uint32_t>(mesh.indices.size() / 3);
+
+        auto finish = [&](uint32_t first, uint32_t end) {
+            auto lo = mesh.vertices[mesh.indices[first * 3]].position;
+            auto hi = lo;
+            auto axis = Vec3{};
+            for (auto i = first * 3; i < end * 3; i++) {
+                const auto& p = mesh.vertices[mesh.indices[i]].position;
+                lo = Vec3{std::min(lo.x, p.x), std::min(lo.y, p.y), std::min(lo.z, p.z)};
+                hi = Vec3{std::max(hi.x, p.x), std::max(hi.y, p.y), std::max(hi.z, p.z)};
+            }
+            const auto center = (lo + hi) * 0.5f;
+            auto radius = 0.0f;
+            auto triangle_normals = std::vector<Vec3>{};
+            for (auto t = first; t < end; t++) {
+                const auto& a = mesh.vertices[mesh.indices[t * 3]].position;
+                const auto& b = mesh.vertices[mesh.indices[t * 3 + 1]].position;
+                const auto& c = mesh.vertices[mesh.indices[t * 3 + 2]].position;
+                radius = std::max({radius, length(a - center), length(b - center), length(c - center)});
+                const auto n = cross(b - a, c - a);
+                const auto l = length(n);
+                if (l > 0.0f) {
+                    triangle_normals.emplace_back(n * (1.0f / l));
+                    axis = axis + triangle_normals.back();
+                }
+            }
+
+            // the cone is only worth testing while it is well under a half space
+            auto cutoff = 1.0f;
+            const auto axis_length = length(axis);
+            if (axis_length > 0.0f) {
+                axis = axis * (1.0f / axis_length);
+                auto min_dot = 1.0f;
+                for (const auto& n : triangle_normals) {
+                    min_dot = std::min(min_dot, dot(n, axis));
+                }
+                if (min_dot > 0.1f) {
+                    cutoff = std::sqrt(1.0f - min_dot * min_dot);
+                }
+            }
+            meshlets.emplace_back(MeshMeshlet{
+                .first_index = first * 3,
+                .index_count = (end - first) * 3,
+                .center = {center.x, center.y, center.z},
+                .radius = radius,
+                .cone_axis = {axis.x, axis.y, axis.z},
+                .cone_cutoff = cutoff
+            });
+        };
+
+        uint32_t first = 0;
+        uint32_t vertex_count = 0;
+        for (uint32_t t = 0; t < triangle_count; t++) {
+            const auto id = static_cast<uint32_t>(meshlets.size()) + 1;
+            auto added = 0u;
+            for (size_t k = 0; k < 3; k++) {
+                added += owner[mesh.indices[t * 3 + k]] != id ? 1 : 0;
+            }
+            if (t - first == MESHLET_MAX_TRIANGLES || vertex_count + added > MESHLET_MAX_VERTICES) {
+                finish(first, t);
+                first = t;
+                vertex_count = 0;
+            }
+            const auto current = static_cast<uint32_t>(meshlets.size()) + 1;
+            for (size_t k = 0; k < 3; k++) {
+                auto& o = owner[mesh.indices[t * 3 + k]];
+                if (o != current) {
+                    o = current;
+                    vertex_count++;
+                }
+            }
+        }
+        if (first < triangle_count) {
+            finish(first, triangle_count);
+        }
+        return meshlets;
+    }
+
+    // round to nearest even, out of range values become infinity and tiny ones subnormal or zero
+    auto toHalf(float value) -> uint16_t {
+        auto bits = uint32_t{};
+        std::memcpy(&bits, &value, sizeof(bits));
+        const auto sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+        const auto biased = static_cast<int32_t>((bits >> 23) & 0xff);
+        auto mantissa = bits & 0x7fffff;
+        if (biased == 0xff) {
+            return sign | 0x7c00 | (mantissa != 0 ? 0x200 : 0);
+        }
+        const auto exponent = biased - 127 + 15;
+        if (exponent >= 31) {
+            return sign | 0x7c00;
+        }
+        if (exponent <= 0) {
+            if (exponent < -10) {
+                return sign;
+            }
+            mantissa |= 0x800000;
+            const auto shift = static_cast<uint32_t>(14 - exponent);
+            auto half = mantissa >> shift;
+            const auto rest = mantissa & ((1u << shift) - 1);
+            const auto halfway = 1u << (shift - 1);
+            if (rest > halfway || (rest == halfway && (half & 1) != 0)) {
+                half++;
+            }
+            return static_cast<uint16_t>(sign | half);
+        }
+        auto half = static_cast<uint32_t>(exponent) << 10 | mantissa >> 13;
+        const auto rest = mantissa & 0x1fff;
+        // a carry out of the mantissa rounds up into the exponent, and into infinity past the largest half
+        if (rest > 0x1000 || (rest == 0x1000 && (half & 1) != 0)) {
+            half++;
+        }
+        return static_cast<uint16_t>(sign | half);
+    }
+
+    auto toSnorm16(float value) -> int16_t {
+        return static_cast<int16_t>(std::lround(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+    }
+
+    // the normal goes onto the octahedron |x| + |y| + |z| = 1, whose lower half is folded over the diagonals
+    auto encodeOctahedral(const Vec3& n) -> std::array<int16_t, 2> {
+        const auto l1 = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+        auto x = n.x / l1;
+        auto y = n.y / l1;
+        if (n.z < 0.0f) {
+            const auto folded_x = (1.0f - std::abs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+            const auto folded_y = (1.0f - std::abs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+            x = folded_x;
+            y = folded_y;
+        }
+        return {toSnorm16(x), toSnorm16(y)};
+    }
+
+    auto alignUp(uint64_t value, uint64_t alignment) -> uint64_t {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+    auto serialize(const Mesh& mesh, const std::vector<MeshMeshlet>& meshlets) -> std::vector<char> {
+        auto lo = mesh.vertices.front().position;
+        auto hi = lo;
+        for (const auto& vertex : mesh.vertices) {
+            const auto& p = vertex.position;
+            lo = Vec3{std::min(lo.x, p.x), std::min(lo.y, p.y), std::min(lo.z, p.z)};
+            hi = Vec3{std::max(hi.x, p.x), std::max(hi.y, p.y), std::max(hi.z, p.z)};
+        }
+        const auto extent = hi - lo;
+        const auto scale = std::max({extent.x, extent.y, extent.z}) > 0.0f ? std::max({extent.x, extent.y, extent.z}) : 1.0f;
+        const auto center = (lo + hi) * 0.5f;
+        auto radius = 0.0f;
+        for (const auto& vertex : mesh.vertices) {
+            radius = std::max(radius, length(vertex.position - center));
+        }
+
+        const auto index_size = mesh.vertices.size() <= 0x10000 ? 2u : 4u;
+        auto header = MeshHeader{
+            .magic = MeshHeader::MAGIC,
+            .version = MeshHeader::VERSION,
+            .vertex_count = static_cast<uint32_t>(mesh.vertices.size()),
+            .index_count = static_cast<uint32_t>(mesh.indices.size()),
+            .meshlet_count = static_cast<uint32_t>(meshlets.size()),
+            .index_size = index_size,
+            .origin = {lo.x, lo.y, lo.z},
+            .scale = scale,
+            .center = {center.x, center.y, center.z},
+            .radius = radius,
+            .vertices_offset = alignUp(sizeof(MeshHeader), MESH_SECTION_ALIGNMENT),
+            .indices_offset = 0,
+            .meshlets_offset = 0
+        };
+        header.indices_offset = alignUp(header.vertices_offset + mesh.vertices.size() * sizeof(MeshVertex), MESH_SECTION_ALIGNMENT);
+        header.meshlets_offset = alignUp(header.indices_offset + mesh.indices.size() * index_size, MESH_SECTION_ALIGNMENT);
+
+        auto bytes = std::vector<char>(header.meshlets_offset + meshlets.size() * sizeof(MeshMeshlet), 0);
+        std::memcpy(bytes.data(), &header, sizeof(header));
+
+        auto out = reinterpret_cast<MeshVertex*>(bytes.data() + header.vertices_offset);
+        for (const auto& vertex : mesh.vertices) {
+            const auto unit = (vertex.position - lo) * (1.0f / scale);
+            const auto quantize = [](float value) {
+                return static_cast<uint16_t>(std::lround(std::clamp(value, 0.0f, 1.0f) * 65535.0f));
+            };
+            const auto normal = encodeOctahedral(vertex.normal);
+            *out++ = MeshVertex{
+                .position = {quantize(unit.x), quantize(unit.y), quantize(unit.z), 0},
+                .normal = {normal[0], normal[1]},
+                .uv = {toHalf(vertex.uv[0]), toHalf(vertex.uv[1])}
+            };
+        }
+
+        auto indices = bytes.data() + header.indices_offset;
+        for (const auto index : mesh.indices) {
+            if (index_size == 2) {
+                const auto narrow = static_cast<uint16_t>(index);
+                std::memcpy(indices, &narrow, sizeof(narrow));
+            } else {
+                std::memcpy(indices, &index, sizeof(index));
+            }
+            indices += index_size;
+        }
+
+        if (!meshlets.empty()) {
+            std::memcpy(bytes.data() + header.meshlets_offset, meshlets.data(), meshlets.size() * sizeof(MeshMeshlet));
+        }
+        return bytes;
+    }
+}
+
+auto cookMesh(std::span<const char> obj) -> std::optional<std::vector<char>> {
+    auto mesh = parseObj(obj);
+    if (!mesh) {
+        return std::nullopt;
+    }
+    if (mesh->indices.empty()) {
+        std::cerr << "mesh has no triangles" << std::endl;
+        return std::nullopt;
+    }
+
+    optimizeVertexCache(mesh->indices, mesh->vertices.size());
+    optimizeOverdraw(mesh->indices, mesh->vertices);
+    optimizeVertexFetch(*mesh);
+    const auto meshlets = buildMeshlets(*mesh);
+    return serialize(*mesh, meshlets);
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <span>
+#include <vector>
+#include <optional>
+
+// Cooks a Wavefront .obj into the engine's mesh format, see render/mesh_format.hpp. Polygons are triangulated
+// as fans, missing normals are computed from the faces, and the texture v axis is flipped to Vulkan's. The
+// indices are reordered for the post-transform cache and then, cluster by cluster, for overdraw; the vertices
+// follow the indices and are quantized last.
+auto cookMesh(std::span<const char> obj) -> std::optional<std::vector<char>>;
@@ -0,0 +1,151 @@
+#include <jobs/job_system.hpp>
+#include <voxel/voxel_world.hpp>
+
+#include <cmath>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <iostream>
+#include <optional>
+#include <algorithm>
+
+struct Options {
+    int32_t chunks = 16;
+    size_t edits = 1000;
+    size_t threads = 0;
+};
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    enum : BlockId {
+        STONE = 1,
+        DIRT,
+        GRASS,
+        SAND,
+        WATER,
+        ORE
+    };
+
+    auto usage() -> int {
+        std::cerr << "usage: voxel-bench [--chunks <n per side>] [--edits <n>] [--threads <n>]" << std::endl;
+        return 1;
+    }
+
+    auto parseOptions(int argc, char** argv) -> std::optional<Options> {
+        auto options = Options{};
+        for (int i = 1; i < argc; i++) {
+            const auto arg = std::string(argv[i]);
+            if (arg == "--chunks" && i + 1 < argc) {
+                options.chunks = std::stoi(argv[++i]);
+            } else if (arg == "--edits" && i + 1 < argc) {
+                options.edits = std::stoul(argv[++i]);
+            } else if (arg == "--threads" && i + 1 < argc) {
+                options.threads = std::stoul(argv[++i]);
+            } else {
+                return std::nullopt;
+            }
+        }
+        return options;
+    }
+
+    auto hash(int32_t x, int32_t y, int32_t z) noexcept -> uint32_t {
+        auto h = static_cast<uint32_t>(x) * 73856093u ^ static_cast<uint32_t>(y) * 19349663u ^ static_cast<uint32_t>(z) * 83492791u;
+        h ^= h >> 13;
+        h *= 0x5BD1E995u;
+        return h ^ (h >> 15);
+    }
+
+    // rolling hills with beaches, lakes and scattered ore, roughly what a survival world looks like
+    void generate(VoxelWorld& world, ChunkCoord coord) {
+        auto& chunk = world.createChunk(coord);
+        constexpr auto S = ChunkSection::SIZE;
+        for (int z = 0; z < S; z++) {
+            for (int x = 0; x < S; x++) {
+                const auto wx = coord.x * S + x;
+                const auto wz = coord.z * S + z;
+                const auto height = static_cast<int>(64.0 + 10.0 * std::sin(wx * 0.045) * std::cos(wz * 0.06) + 4.0 * std::sin((wx + wz) * 0.13));
+                for (int y = 0; y < std::max(height, 62); y++) {
+                    auto block = BlockId{STONE};
+                    if (y >= height) {
+                        block = WATER;
+                    } else if (y == height - 1) {
+                        block = height <= 63 ? SAND : GRASS;
+                    } else if (y >= height - 4) {
+                        block = DIRT;
+                    } else if (hash(wx, y, wz) % 97 == 0) {
+                        block = ORE;
+                    }
+                    chunk.sections[y / S].set(x, y % S, z, block);
+                }
+            }
+        }
+        world.markDirty(coord);
+    }
+
+    auto microseconds(Clock::duration d) -> double {
+        return std::chrono::duration<double, std::micro>(d).count();
+    }
+}
+
+void EngineMain(int argc, char** argv) {
+    const auto options = parseOptions(argc, argv);
+    if (!options) {
+        std::exit(usage());
+    }
+    JobSystem::initialize(options->threads);
+
+    auto world = VoxelWorld{};
+    for (int32_t z = 0; z < options->chunks; z++) {
+        for (int32_t x = 0; x < options->chunks; x++) {
+            generate(world, {x, z});
+        }
+    }
+
+    auto meshes = std::vector<SectionMesh>{};
+    const auto start = Clock::now();
+    world.remeshDirty(meshes);
+    const auto elapsed = Clock::now() - start;
+
+    auto vertices = size_t{0};
+    auto indices = size_t{0};
+    for (const auto& mesh : meshes) {
+        vertices += mesh.mesh.vertices.size();
+        indices += mesh.mesh.indices.size();
+    }
+
+    const auto chunk_count = world.chunkCount();
+    std::cout << "threads:          " << JobSystem::threadCount() << "\n";
+    std::cout << "chunks:           " << chunk_count << " (" << meshes.size() << " sections)\n";
+    std::cout << "memory per chunk: " << world.memoryUsage() / chunk_count << " bytes\n";
+    std::cout << "full mesh:        " << microseconds(elapsed) / 1000.0 << " ms, "
+              << static_cast<double>(chunk_count) / std::chrono::duration<double>(elapsed).count() << " chunks/s\n";
+    std::cout << "mesh size:        " << vertices << " vertices, " << indices / 6 << " quads, "
+              << (vertices * sizeof(VoxelVertex) + indices * sizeof(uint16_t)) / chunk_count << " bytes per chunk\n";
+
+    // dig or place single blocks around the surface and remesh after each one, like a player would
+    auto latencies = std::vector<double>{};
+    for (size_t i = 0; i < options->edits; i++) {
+        const auto side = options->chunks * ChunkSection::SIZE;
+        const auto x = static_cast<int32_t>(hash(static_cast<int32_t>(i), 1, 2) % side);
+        const auto z = static_cast<int32_t>(hash(static_cast<int32_t>(i), 3, 4) % side);
+        const auto y = static_cast<int32_t>(56 + hash(static_cast<int32_t>(i), 5, 6) % 16);
+        world.set(x, y, z, world.get(x, y, z) == AIR ? BlockId{STONE} : AIR);
+
+        meshes.clear();
+        const auto edit_start = Clock::now();
+        world.remeshDirty(meshes);
+        latencies.emplace_back(microseconds(Clock::now() - edit_start));
+    }
+    if (!latencies.empty()) {
+        std::sort(latencies.begin(), latencies.end());
+        std::cout << "edit remesh:      median " << latencies[latencies.size() / 2] << " us, p99 "
+                  << latencies[latencies.size() * 99 / 100] << " us, max " << latencies.back() << " us\n";
+    }
+}
+
+auto main(int argc, char** argv) -> int {
+    EngineMain(argc, argv);
+    return 0;
+}